@@ -351,6 +351,10 @@ endif()
 if(QT_BUILD OR ANDROID)
 	# We want the core PCSX2 library.
 	set(PCSX2_CORE TRUE)
+elseif(BUILD_REPLAY_LOADERS)
+	# The GS runner links against the core library instead of the wx executable.
+	message(STATUS "BUILD_REPLAY_LOADERS builds the core PCSX2 library, the wx frontend is skipped")
+	set(PCSX2_CORE TRUE)
 endif()
 
 # Default symbol visibility to hidden, that way we don't go through the PLT for intra-library calls.
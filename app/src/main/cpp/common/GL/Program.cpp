@@ -31,7 +31,7 @@ Program::~Program()
 	Destroy();
 }
 
-GLuint Program::CompileShader(GLenum type, const std::string_view source)
+GLuint Program::CompileShader(GLenum type, const std::string_view source, bool wait /* = true */)
 {
 	GLuint id = glCreateShader(type);
 
@@ -39,6 +39,8 @@ GLuint Program::CompileShader(GLenum type, const std::string_view source)
 	std::array<GLint, 1> source_lengths = {{static_cast<GLint>(source.size())}};
 	glShaderSource(id, static_cast<GLsizei>(sources.size()), sources.data(), source_lengths.data());
 	glCompileShader(id);
+	if (!wait)
+		return id;
 
 	GLint status = GL_FALSE;
 	glGetShaderiv(id, GL_COMPILE_STATUS, &status);
@@ -84,12 +86,12 @@ void Program::ResetLastProgram()
 }
 
 bool Program::Compile(const std::string_view vertex_shader, const std::string_view geometry_shader,
-	const std::string_view fragment_shader)
+	const std::string_view fragment_shader, bool wait /* = true */)
 {
 	GLuint vertex_shader_id = 0;
 	if (!vertex_shader.empty())
 	{
-		vertex_shader_id = CompileShader(GL_VERTEX_SHADER, vertex_shader);
+		vertex_shader_id = CompileShader(GL_VERTEX_SHADER, vertex_shader, wait);
 		if (vertex_shader_id == 0)
 			return false;
 	}
@@ -97,7 +99,7 @@ bool Program::Compile(const std::string_view vertex_shader, const std::string_vi
 	GLuint geometry_shader_id = 0;
 	if (!geometry_shader.empty())
 	{
-		geometry_shader_id = CompileShader(GL_GEOMETRY_SHADER, geometry_shader);
+		geometry_shader_id = CompileShader(GL_GEOMETRY_SHADER, geometry_shader, wait);
 		if (geometry_shader_id == 0)
 			return false;
 	}
@@ -105,7 +107,7 @@ bool Program::Compile(const std::string_view vertex_shader, const std::string_vi
 	GLuint fragment_shader_id = 0;
 	if (!fragment_shader.empty())
 	{
-		fragment_shader_id = CompileShader(GL_FRAGMENT_SHADER, fragment_shader);
+		fragment_shader_id = CompileShader(GL_FRAGMENT_SHADER, fragment_shader, wait);
 		if (fragment_shader_id == 0)
 		{
 			glDeleteShader(vertex_shader_id);
@@ -212,6 +214,12 @@ void Program::BindFragDataIndexed(GLuint color_number /*= 0*/, const char* name
 }
 
 bool Program::Link()
+{
+	StartLink();
+	return FinishLink();
+}
+
+void Program::StartLink()
 {
 	glLinkProgram(m_program_id);
 
@@ -221,7 +229,49 @@ bool Program::Link()
 	if (m_fragment_shader_id != 0)
 		glDeleteShader(m_fragment_shader_id);
 	m_fragment_shader_id = 0;
+}
+
+bool Program::IsLinkComplete() const
+{
+	if (!GLAD_GL_KHR_parallel_shader_compile && !GLAD_GL_ARB_parallel_shader_compile)
+		return true;
+
+	GLint complete = GL_FALSE;
+	glGetProgramiv(m_program_id, GL_COMPLETION_STATUS_KHR, &complete);
+	return (complete == GL_TRUE);
+}
+
+// Shaders compiled without waiting never had their status checked, so a link failure
+// is the first chance to report why they didn't compile.
+static void LogAttachedShaderErrors(GLuint program_id)
+{
+	std::array<GLuint, 3> shader_ids;
+	GLsizei count = 0;
+	glGetAttachedShaders(program_id, static_cast<GLsizei>(shader_ids.size()), &count, shader_ids.data());
+
+	for (GLsizei i = 0; i < count; i++)
+	{
+		GLint status = GL_FALSE;
+		glGetShaderiv(shader_ids[i], GL_COMPILE_STATUS, &status);
 
+		GLint info_log_length = 0;
+		glGetShaderiv(shader_ids[i], GL_INFO_LOG_LENGTH, &info_log_length);
+		if (status == GL_TRUE && info_log_length <= 0)
+			continue;
+
+		std::string info_log;
+		info_log.resize(info_log_length + 1);
+		glGetShaderInfoLog(shader_ids[i], info_log_length, &info_log_length, &info_log[0]);
+
+		if (status == GL_TRUE)
+			Console.Warning("Shader compiled with warnings:\n%s", info_log.c_str());
+		else
+			Console.Error("Shader failed to compile:\n%s", info_log.c_str());
+	}
+}
+
+bool Program::FinishLink()
+{
 	GLint status = GL_FALSE;
 	glGetProgramiv(m_program_id, GL_LINK_STATUS, &status);
 
@@ -241,6 +291,7 @@ bool Program::Link()
 		else
 		{
 			Console.Error("Program failed to link:\n%s", info_log.c_str());
+			LogAttachedShaderErrors(m_program_id);
 			glDeleteProgram(m_program_id);
 			m_program_id = 0;
 			return false;
@@ -13,13 +13,15 @@ public:
   Program(Program&& prog);
   ~Program();
 
-  static GLuint CompileShader(GLenum type, const std::string_view source);
+  /// With wait=false the compile status isn't queried, so drivers with KHR_parallel_shader_compile can
+  /// return immediately. Compile errors then show up as a link failure.
+  static GLuint CompileShader(GLenum type, const std::string_view source, bool wait = true);
   static void ResetLastProgram();
 
   bool IsValid() const { return m_program_id != 0; }
 
   bool Compile(const std::string_view vertex_shader, const std::string_view geometry_shader,
-               const std::string_view fragment_shader);
+               const std::string_view fragment_shader, bool wait = true);
 
   bool CreateFromBinary(const void* data, u32 data_length, u32 data_format);
 
@@ -34,6 +36,12 @@ public:
 
   bool Link();
 
+  /// Link() split in two for KHR_parallel_shader_compile: StartLink() doesn't wait for the driver, and
+  /// FinishLink() checks the result, blocking only if IsLinkComplete() didn't return true yet.
+  void StartLink();
+  bool IsLinkComplete() const;
+  bool FinishLink();
+
   void Bind() const;
 
   void Destroy();
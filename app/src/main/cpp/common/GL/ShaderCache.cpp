@@ -213,9 +213,15 @@ void ShaderCache::Close()
 {
 	m_index.clear();
 	if (m_index_file)
+	{
 		std::fclose(m_index_file);
+		m_index_file = nullptr;
+	}
 	if (m_blob_file)
+	{
 		std::fclose(m_blob_file);
+		m_blob_file = nullptr;
+	}
 }
 
 bool ShaderCache::Recreate()
@@ -286,14 +292,38 @@ std::optional<Program> ShaderCache::GetProgram(const std::string_view vertex_sha
 	const std::string_view geometry_shader,
 	const std::string_view fragment_shader, const PreLinkCallback& callback)
 {
-	if (!m_program_binary_supported || !m_blob_file)
+	if (!CanCachePrograms())
 		return CompileProgram(vertex_shader, geometry_shader, fragment_shader, callback, false);
 
 	const auto key = GetCacheKey(vertex_shader, geometry_shader, fragment_shader);
+	bool found;
+	std::optional<Program> prog = GetCachedProgram(key, &found);
+	if (prog)
+		return prog;
+	else if (!found)
+		return CompileAndAddProgram(key, vertex_shader, geometry_shader, fragment_shader, callback);
+	else
+		return CompileProgram(vertex_shader, geometry_shader, fragment_shader, callback, false);
+}
+
+bool ShaderCache::CanCachePrograms()
+{
+	std::unique_lock lock(m_mutex);
+	return m_program_binary_supported && m_blob_file;
+}
+
+std::optional<Program> ShaderCache::GetCachedProgram(const CacheIndexKey& key, bool* found)
+{
+	std::unique_lock lock(m_mutex);
+	*found = false;
+	if (!m_blob_file)
+		return std::nullopt;
+
 	auto iter = m_index.find(key);
 	if (iter == m_index.end())
-		return CompileAndAddProgram(key, vertex_shader, geometry_shader, fragment_shader, callback);
+		return std::nullopt;
 
+	*found = true;
 	std::vector<u8> data(iter->second.blob_size);
 	if (std::fseek(m_blob_file, iter->second.file_offset, SEEK_SET) != 0 ||
 		std::fread(data.data(), 1, iter->second.blob_size, m_blob_file) != iter->second.blob_size)
@@ -301,7 +331,7 @@ std::optional<Program> ShaderCache::GetProgram(const std::string_view vertex_sha
 #ifdef PCSX2_DEBUG
 		Console.Error("Read blob from file failed");
 #endif
-		return {};
+		return std::nullopt;
 	}
 
 	Program prog;
@@ -311,10 +341,9 @@ std::optional<Program> ShaderCache::GetProgram(const std::string_view vertex_sha
 	Console.Warning(
 		"Failed to create program from binary, this may be due to a driver or GPU Change. Recreating cache.");
 #endif
-	if (!Recreate())
-		return CompileProgram(vertex_shader, geometry_shader, fragment_shader, callback, false);
-	else
-		return CompileAndAddProgram(key, vertex_shader, geometry_shader, fragment_shader, callback);
+	// Not found if the cache could be recreated, so the program gets added back.
+	*found = !Recreate();
+	return std::nullopt;
 }
 
 bool ShaderCache::GetProgram(Program* out_program, const std::string_view vertex_shader,
@@ -350,6 +379,43 @@ std::optional<Program> ShaderCache::CompileProgram(const std::string_view& verte
 	return std::optional<Program>(std::move(prog));
 }
 
+std::optional<Program> ShaderCache::StartProgram(const std::string_view vertex_shader,
+	const std::string_view geometry_shader, const std::string_view fragment_shader, bool* pending)
+{
+	*pending = false;
+	const bool cache = CanCachePrograms();
+	if (cache)
+	{
+		bool found;
+		std::optional<Program> prog = GetCachedProgram(GetCacheKey(vertex_shader, geometry_shader, fragment_shader), &found);
+		if (prog)
+			return prog;
+	}
+
+	Program prog;
+	if (!prog.Compile(vertex_shader, geometry_shader, fragment_shader, false))
+		return std::nullopt;
+
+	if (cache)
+		prog.SetBinaryRetrievableHint();
+
+	prog.StartLink();
+	*pending = true;
+	return std::optional<Program>(std::move(prog));
+}
+
+bool ShaderCache::FinishProgram(Program& program, const std::string_view vertex_shader,
+	const std::string_view geometry_shader, const std::string_view fragment_shader)
+{
+	if (!program.FinishLink())
+		return false;
+
+	if (CanCachePrograms())
+		AddProgram(GetCacheKey(vertex_shader, geometry_shader, fragment_shader), program);
+
+	return true;
+}
+
 std::optional<Program> ShaderCache::CompileAndAddProgram(const CacheIndexKey& key,
 	const std::string_view& vertex_shader,
 	const std::string_view& geometry_shader,
@@ -360,13 +426,25 @@ std::optional<Program> ShaderCache::CompileAndAddProgram(const CacheIndexKey& ke
 	if (!prog)
 		return std::nullopt;
 
+	AddProgram(key, *prog);
+	return prog;
+}
+
+void ShaderCache::AddProgram(const CacheIndexKey& key, Program& prog)
+{
 	std::vector<u8> prog_data;
 	u32 prog_format = 0;
-	if (!prog->GetBinary(&prog_data, &prog_format))
-		return std::nullopt;
+	if (!prog.GetBinary(&prog_data, &prog_format))
+		return;
+
+	std::unique_lock lock(m_mutex);
+
+	// Another thread may have built the same program meanwhile.
+	if (m_index.find(key) != m_index.end())
+		return;
 
 	if (!m_blob_file || std::fseek(m_blob_file, 0, SEEK_END) != 0)
-		return prog;
+		return;
 
 	CacheIndexData data{};
 	data.file_offset = static_cast<u32>(std::ftell(m_blob_file));
@@ -394,10 +472,9 @@ std::optional<Program> ShaderCache::CompileAndAddProgram(const CacheIndexKey& ke
 #ifdef PCSX2_DEBUG
 		Console.Error("Failed to write shader blob to file");
 #endif
-		return prog;
+		return;
 	}
 
 	m_index.emplace(key, data);
-	return prog;
 }
 } // namespace GL
@@ -4,6 +4,7 @@
 #include "common/GL/Program.h"
 #include <cstdio>
 #include <functional>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -27,6 +28,14 @@ public:
 	bool GetProgram(Program* out_program, const std::string_view vertex_shader, const std::string_view geometry_shader,
 		const std::string_view fragment_shader, const PreLinkCallback& callback = {});
 
+	/// GetProgram() for KHR_parallel_shader_compile. Cached programs come back linked. Otherwise *pending is set
+	/// and the link is left running: poll Program::IsLinkComplete() and hand it to FinishProgram() with the
+	/// same sources, which checks the result and adds the binary to the cache.
+	std::optional<Program> StartProgram(const std::string_view vertex_shader, const std::string_view geometry_shader,
+		const std::string_view fragment_shader, bool* pending);
+	bool FinishProgram(Program& program, const std::string_view vertex_shader, const std::string_view geometry_shader,
+		const std::string_view fragment_shader);
+
 private:
 	static constexpr u32 FILE_VERSION = 3;
 
@@ -84,11 +93,17 @@ private:
 	std::optional<Program> CompileAndAddProgram(const CacheIndexKey& key, const std::string_view& vertex_shader,
 		const std::string_view& geometry_shader,
 		const std::string_view& fragment_shader, const PreLinkCallback& callback);
+	// Recreate() can close the blob file from another thread, so check under the lock.
+	bool CanCachePrograms();
+	std::optional<Program> GetCachedProgram(const CacheIndexKey& key, bool* found);
+	void AddProgram(const CacheIndexKey& key, Program& prog);
 
 	std::string m_base_path;
 	std::FILE* m_index_file = nullptr;
 	std::FILE* m_blob_file = nullptr;
 
+	// The index and files are shared by the threads building programs on shared contexts.
+	std::mutex m_mutex;
 	CacheIndex m_index;
 	u32 m_version = 0;
 	bool m_program_binary_supported = false;
@@ -0,0 +1,134 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+/// Bounded lock-free multi-producer/multi-consumer queue (Dmitry Vyukov's design).
+/// Every slot carries a sequence number which tells producers and consumers whose turn it is, so the
+/// only shared writes are the two cursors. Elements are constructed in place, the queue never allocates
+/// after construction. Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class MPMCQueue
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+	static constexpr size_t CACHE_LINE_SIZE = 64;
+
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		alignas(T) unsigned char storage[sizeof(T)];
+
+		T* get() { return reinterpret_cast<T*>(storage); }
+	};
+
+public:
+	MPMCQueue()
+		: m_cells(new Cell[Capacity])
+	{
+		for (size_t i = 0; i < Capacity; i++)
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	~MPMCQueue()
+	{
+		const size_t end = m_enqueue_pos.load(std::memory_order_relaxed);
+		for (size_t pos = m_dequeue_pos.load(std::memory_order_relaxed); pos != end; pos++)
+			m_cells[pos & (Capacity - 1)].get()->~T();
+	}
+
+	MPMCQueue(const MPMCQueue&) = delete;
+	MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+	/// Returns false if the queue is full, value is left untouched in that case.
+	template <typename U>
+	bool try_push(U&& value)
+	{
+		size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+		Cell* cell;
+		for (;;)
+		{
+			cell = &m_cells[pos & (Capacity - 1)];
+			const size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos);
+			if (diff == 0)
+			{
+				if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = m_enqueue_pos.load(std::memory_order_relaxed);
+			}
+		}
+
+		new (cell->get()) T(std::forward<U>(value));
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// Returns false if the queue is empty.
+	bool try_pop(T& value)
+	{
+		size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+		Cell* cell;
+		for (;;)
+		{
+			cell = &m_cells[pos & (Capacity - 1)];
+			const size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos + 1);
+			if (diff == 0)
+			{
+				if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = m_dequeue_pos.load(std::memory_order_relaxed);
+			}
+		}
+
+		T* item = cell->get();
+		value = std::move(*item);
+		item->~T();
+		cell->sequence.store(pos + Capacity, std::memory_order_release);
+		return true;
+	}
+
+	/// Only a hint while other threads are pushing or popping.
+	bool empty() const
+	{
+		return m_dequeue_pos.load(std::memory_order_acquire) >= m_enqueue_pos.load(std::memory_order_acquire);
+	}
+
+private:
+	std::unique_ptr<Cell[]> m_cells;
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_enqueue_pos{0};
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_dequeue_pos{0};
+};
@@ -283,6 +283,11 @@ void Threading::WorkSema::WaitForWork()
 }
 
 void Threading::WorkSema::WaitForWorkWithSpin()
+{
+    WaitForWorkWithSpin(SPIN_TIME_NS);
+}
+
+bool Threading::WorkSema::WaitForWorkWithSpin(u32 spin_ns)
 {
     s32 value = m_state.load(std::memory_order_relaxed);
     pxAssert(!IsDead(value));
@@ -297,13 +302,15 @@ void Threading::WorkSema::WaitForWorkWithSpin()
         }
     }
     u32 waited = 0;
+    bool slept = false;
     while (value < 0)
     {
-        if (waited > SPIN_TIME_NS)
+        if (waited >= spin_ns)
         {
             if (!m_state.compare_exchange_weak(value, STATE_SLEEPING, std::memory_order_relaxed))
                 continue;
             m_sema.Wait();
+            slept = true;
             break;
         }
         waited += ShortSpin();
@@ -311,6 +318,7 @@ void Threading::WorkSema::WaitForWorkWithSpin()
     }
     // Clear back to STATE_RUNNING_0 (but preserve waiting empty flag)
     m_state.fetch_and(STATE_FLAG_WAITING_EMPTY, std::memory_order_acquire);
+    return slept;
 }
 
 bool Threading::WorkSema::WaitForEmpty()
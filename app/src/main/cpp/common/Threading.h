@@ -601,6 +601,9 @@ namespace Threading
         void WaitForWork();
         /// Wait for work to be added to the queue, spinning for a bit before sleeping the thread
         void WaitForWorkWithSpin();
+        /// Wait for work to be added to the queue, spinning for up to `spin_ns` before sleeping the thread
+        /// Returns true if the thread had to sleep
+        bool WaitForWorkWithSpin(u32 spin_ns);
         /// Wait for the worker thread to finish processing all entries in the queue or die
         /// Returns false if the thread is dead
         bool WaitForEmpty();
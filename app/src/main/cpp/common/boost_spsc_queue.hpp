@@ -44,6 +44,8 @@
 // ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 // DEALINGS IN THE SOFTWARE.
 
+#pragma once
+
 #include <atomic>
 
 template <typename T, size_t max_size>
@@ -6,6 +6,7 @@
 #include "common/pxStreams.h"
 #include "pcsx2/GS.h"
 #include "pcsx2/VMManager.h"
+#include "pcsx2/SaveState.h"
 #include "pcsx2/HostDisplay.h"
 #include "PAD/Host/PAD.h"
 #include "PAD/Host/KeyStatus.h"
@@ -16,8 +17,6 @@
 #include "Frontend/InputManager.h"
 #include "common/Timer.h"
 #include "common/Vulkan/Context.h"
-#include <wx/wfstream.h>
-#include <wx/zipstrm.h>
 #include <future>
 
 
@@ -238,6 +237,23 @@ Java_kr_co_iefriends_pcsx2_NativeApp_renderGpu(JNIEnv *env, jclass clazz,
 }
 
 
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_kr_co_iefriends_pcsx2_NativeApp_startCapture(JNIEnv *env, jclass clazz) {
+    if (!VMManager::HasValidVM()) {
+        return false;
+    }
+    return GetMTGS().BeginCapture();
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_kr_co_iefriends_pcsx2_NativeApp_stopCapture(JNIEnv *env, jclass clazz) {
+    if (VMManager::HasValidVM()) {
+        GetMTGS().EndCapture();
+    }
+}
+
 extern "C"
 JNIEXPORT void JNICALL
 Java_kr_co_iefriends_pcsx2_NativeApp_onNativeSurfaceCreated(JNIEnv *env, jclass clazz) {
@@ -553,6 +569,32 @@ Java_kr_co_iefriends_pcsx2_NativeApp_loadStateFromSlot(JNIEnv *env, jclass clazz
     return ret.get();
 }
 
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_kr_co_iefriends_pcsx2_NativeApp_rewind(JNIEnv *env, jclass clazz, jint p_steps) {
+    if (!VMManager::HasValidVM()) {
+        return false;
+    }
+
+    std::future<bool> ret = std::async([p_steps]
+    {
+        if(VMManager::GetState() != VMState::Paused) {
+            VMManager::SetPaused(true);
+        }
+
+        // wait 5 sec
+        for (int i = 0; i < 5; ++i) {
+            if (s_execute_exit) {
+                return VMManager::RewindState(static_cast<u32>(p_steps));
+            }
+            sleep(1);
+        }
+        return false;
+    });
+
+    return ret.get();
+}
+
 extern "C"
 JNIEXPORT jstring JNICALL
 Java_kr_co_iefriends_pcsx2_NativeApp_getGamePathSlot(JNIEnv *env, jclass clazz, jint slot) {
@@ -583,36 +625,10 @@ Java_kr_co_iefriends_pcsx2_NativeApp_getImageSlot(JNIEnv *env, jclass clazz, jin
             _filename = VMManager::GetSaveStateFileName(_serial.c_str(), _crc, slot);
         }
         if(!_filename.empty()) {
-            std::unique_ptr<wxFFileInputStream> woot(new wxFFileInputStream(_filename));
-            if (woot->IsOk()) {
-                std::unique_ptr<pxInputStream> reader(
-                        new pxInputStream(_filename, new wxZipInputStream(woot.get())));
-                woot.release();
-
-                if (reader->IsOk()) {
-                    auto *gzreader = (wxZipInputStream *) reader->GetWxStreamBase();
-                    while (true) {
-                        std::unique_ptr<wxZipEntry> entry(gzreader->GetNextEntry());
-                        if (!entry) {
-                            break;
-                        }
-                        if (entry->GetName().CmpNoCase("Screenshot.png") == 0) {
-                            if (gzreader->OpenEntry(*entry)) {
-                                if (gzreader->CanRead()) {
-                                    int _fileSize = (int) entry->GetSize();
-                                    unsigned char _cBuffer[_fileSize];
-                                    gzreader->Read(_cBuffer, _fileSize);
-                                    ////
-                                    retArr = env->NewByteArray(_fileSize);
-                                    env->SetByteArrayRegion(retArr, 0, _fileSize,
-                                                            (jbyte *) _cBuffer);
-                                }
-                            }
-                            break;
-                        }
-                    }
-                }
-                reader->Close();
+            std::vector<u8> _png;
+            if (SaveState_ReadScreenshot(_filename, &_png)) {
+                retArr = env->NewByteArray((jsize) _png.size());
+                env->SetByteArrayRegion(retArr, 0, (jsize) _png.size(), (jbyte *) _png.data());
             }
         }
     }
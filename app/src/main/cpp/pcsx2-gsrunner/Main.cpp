@@ -0,0 +1,464 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Replays a GS dump without a window and reports renderer performance as JSON.
+// Usage: pcsx2-gsrunner [-renderer sw|null] [-loop N] [-threads N] [-o report.json] <dump.gs[.xz|.zst]>
+
+#include "PrecompiledHeader.h"
+
+#include "common/FileSystem.h"
+#include "common/StringUtil.h"
+#include "common/Timer.h"
+
+#include "Frontend/INISettingsInterface.h"
+#include "Frontend/InputManager.h"
+#include "GS.h"
+#include "GS/GS.h"
+#include "GS/GSDump.h"
+#include "GS/GSLzma.h"
+#include "GS/GSPerfMon.h"
+#include "GS/Renderers/SW/GSRendererSW.h"
+#include "Host.h"
+#include "HostDisplay.h"
+#include "HostSettings.h"
+#include "MemoryTypes.h"
+#include "VMManager.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	// Everything the GS draws is thrown away, so none of this talks to a GPU.
+	class NullHostDisplay final : public HostDisplay
+	{
+	public:
+		RenderAPI GetRenderAPI() const override { return RenderAPI::None; }
+		void* GetRenderDevice() const override { return nullptr; }
+		void* GetRenderContext() const override { return nullptr; }
+		void* GetRenderSurface() const override { return nullptr; }
+
+		bool HasRenderDevice() const override { return true; }
+		bool HasRenderSurface() const override { return false; }
+
+		bool CreateRenderDevice(const WindowInfo& wi, std::string_view adapter_name, VsyncMode vsync, bool threaded_presentation, bool debug_device) override
+		{
+			m_window_info = wi;
+			return true;
+		}
+		bool InitializeRenderDevice(std::string_view shader_cache_directory, bool debug_device) override { return true; }
+		bool MakeRenderContextCurrent() override { return true; }
+		bool DoneRenderContextCurrent() override { return true; }
+		void DestroyRenderSurface() override {}
+		bool ChangeRenderWindow(const WindowInfo& wi) override { return true; }
+		bool SupportsFullscreen() const override { return false; }
+		bool IsFullscreen() override { return false; }
+		bool SetFullscreen(bool fullscreen, u32 width, u32 height, float refresh_rate) override { return false; }
+		AdapterAndModeList GetAdapterAndModeList() override { return {}; }
+		std::string GetDriverInfo() const override { return "Null"; }
+
+		void ResizeRenderWindow(s32 new_window_width, s32 new_window_height, float new_window_scale) override {}
+
+		std::unique_ptr<HostDisplayTexture> CreateTexture(u32 width, u32 height, const void* data, u32 data_stride, bool dynamic = false) override { return {}; }
+		void UpdateTexture(HostDisplayTexture* texture, u32 x, u32 y, u32 width, u32 height, const void* data, u32 data_stride) override {}
+
+		bool BeginPresent(bool frame_skip) override { return false; }
+		void EndPresent() override {}
+		void SetVSync(VsyncMode mode) override { m_vsync_mode = mode; }
+
+		bool CreateImGuiContext() override { return true; }
+		void DestroyImGuiContext() override {}
+		bool UpdateImGuiFontTexture() override { return true; }
+	};
+
+	struct Options
+	{
+		std::string dump_path;
+		std::string report_path;
+		GSRendererType renderer = GSRendererType::SW;
+		int loops = 1;
+		int threads = -1; // EmuCore/GS extrathreads default
+	};
+} // namespace
+
+static std::unique_ptr<NullHostDisplay> s_host_display;
+static INISettingsInterface s_settings_interface("");
+
+alignas(64) static u8 s_gs_regs[Ps2MemSize::GSregs];
+
+//////////////////////////////////////////////////////////////////////////
+// Host interface
+//////////////////////////////////////////////////////////////////////////
+
+HostDisplay* Host::AcquireHostDisplay(HostDisplay::RenderAPI api)
+{
+	s_host_display = std::make_unique<NullHostDisplay>();
+	return s_host_display.get();
+}
+
+void Host::ReleaseHostDisplay(bool p_isFailed)
+{
+	s_host_display.reset();
+}
+
+HostDisplay* Host::GetHostDisplay()
+{
+	return s_host_display.get();
+}
+
+bool Host::BeginPresentFrame(bool frame_skip)
+{
+	return false;
+}
+
+void Host::EndPresentFrame()
+{
+}
+
+void Host::ResizeHostDisplay(u32 new_window_width, u32 new_window_height, float new_window_scale)
+{
+}
+
+std::optional<std::vector<u8>> Host::ReadResourceFile(const char* filename)
+{
+	return std::nullopt;
+}
+
+std::optional<std::string> Host::ReadResourceFileToString(const char* filename)
+{
+	return std::nullopt;
+}
+
+void Host::GameChanged(const std::string& disc_path, const std::string& game_serial, const std::string& game_name, u32 game_crc)
+{
+}
+
+void Host::PumpMessagesOnCPUThread()
+{
+}
+
+void Host::InvalidateSaveStateCache()
+{
+}
+
+std::optional<u32> InputManager::ConvertHostKeyboardStringToCode(const std::string_view& str)
+{
+	return std::nullopt;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Replay
+//////////////////////////////////////////////////////////////////////////
+
+static bool LoadDumpState(const GSDumpFile& dump)
+{
+	const GSDumpFile::ByteArray& state = dump.GetStateData();
+	freezeData fd = {static_cast<int>(state.size()), const_cast<u8*>(state.data())};
+	if (GSfreeze(FreezeAction::Load, &fd) != 0)
+		return false;
+
+	const GSDumpFile::ByteArray& regs = dump.GetRegsData();
+	std::memcpy(s_gs_regs, regs.data(), std::min<size_t>(regs.size(), sizeof(s_gs_regs)));
+	return true;
+}
+
+// Returns the number of frames replayed.
+static u64 ReplayPackets(const GSDumpFile& dump)
+{
+	using namespace GSDumpTypes;
+
+	std::vector<u8> buffer;
+	u64 frames = 0;
+
+	for (const GSDumpFile::GSData& packet : dump.GetPackets())
+	{
+		u8* data = const_cast<u8*>(packet.data);
+		const u32 size = static_cast<u32>(packet.length);
+
+		switch (packet.id)
+		{
+			case GSType::Transfer:
+				switch (packet.path)
+				{
+					case GSTransferPath::Path1Old:
+					{
+						// path 1 wraps around the end of VU1 memory
+						buffer.resize(16384);
+						const u32 addr = 16384 - size;
+						std::memcpy(buffer.data() + addr, data, size);
+						GSgifTransfer1(buffer.data(), addr);
+						break;
+					}
+
+					case GSTransferPath::Path1New:
+						GSgifTransfer(data, size / 16);
+						break;
+
+					case GSTransferPath::Path2:
+						GSgifTransfer2(data, size / 16);
+						break;
+
+					case GSTransferPath::Path3:
+						GSgifTransfer3(data, size / 16);
+						break;
+
+					default:
+						break;
+				}
+				break;
+
+			case GSType::VSync:
+				GSvsync((*data & 1) ^ 1, false);
+				frames++;
+				break;
+
+			case GSType::ReadFIFO2:
+			{
+				u32 qwc;
+				std::memcpy(&qwc, data, sizeof(qwc));
+				buffer.resize(qwc * 16);
+				GSreadFIFO2(buffer.data(), qwc);
+				break;
+			}
+
+			case GSType::Registers:
+				std::memcpy(s_gs_regs, data, std::min<size_t>(size, sizeof(s_gs_regs)));
+				break;
+		}
+	}
+
+	return frames;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Report
+//////////////////////////////////////////////////////////////////////////
+
+static std::string JSONString(const std::string_view& str)
+{
+	std::string ret("\"");
+
+	for (const char ch : str)
+	{
+		if (ch == '"' || ch == '\\')
+		{
+			ret += '\\';
+			ret += ch;
+		}
+		else if (static_cast<u8>(ch) < 0x20)
+		{
+			ret += StringUtil::StdStringFromFormat("\\u%04x", ch);
+		}
+		else
+		{
+			ret += ch;
+		}
+	}
+
+	ret += '"';
+	return ret;
+}
+
+static void WriteReport(std::FILE* fp, const Options& options, const GSDumpFile& dump, u64 frames, double seconds, u64 elapsed_ticks, const GSRasterizerStats& stats)
+{
+	const double draws = g_perfmon.GetTotal(GSPerfMon::Draw);
+	const double ticks_per_ms = static_cast<double>(elapsed_ticks) / (seconds * 1000.0);
+
+	std::fprintf(fp, "{\n");
+	std::fprintf(fp, "  \"dump\": %s,\n", JSONString(options.dump_path).c_str());
+	std::fprintf(fp, "  \"serial\": %s,\n", JSONString(dump.GetSerial()).c_str());
+	std::fprintf(fp, "  \"crc\": \"%08X\",\n", dump.GetCRC());
+	std::fprintf(fp, "  \"renderer\": \"%s\",\n", (options.renderer == GSRendererType::SW) ? "SW" : "Null");
+	std::fprintf(fp, "  \"loops\": %d,\n", options.loops);
+	std::fprintf(fp, "  \"frames\": %llu,\n", static_cast<unsigned long long>(frames));
+	std::fprintf(fp, "  \"draws\": %.0f,\n", draws);
+	std::fprintf(fp, "  \"seconds\": %.6f,\n", seconds);
+	std::fprintf(fp, "  \"fps\": %.3f,\n", frames / seconds);
+	std::fprintf(fp, "  \"draws_per_frame\": %.3f,\n", frames ? draws / frames : 0.0);
+
+	std::fprintf(fp, "  \"rasterizer_threads\": [");
+	for (size_t i = 0; i < stats.threads.size(); ++i)
+	{
+		const GSRasterizerStats::Thread& t = stats.threads[i];
+		std::fprintf(fp, "%s\n    {\"thread\": %zu, \"draws\": %llu, \"pixels\": %llu, \"busy_ms\": %.3f, \"utilization\": %.4f, \"tiles\": %llu, \"stolen\": %llu}",
+			i ? "," : "", i,
+			static_cast<unsigned long long>(t.draws),
+			static_cast<unsigned long long>(t.pixels),
+			t.ticks / ticks_per_ms,
+			static_cast<double>(t.ticks) / elapsed_ticks,
+			static_cast<unsigned long long>(t.tiles),
+			static_cast<unsigned long long>(t.stolen));
+	}
+	std::fprintf(fp, "%s],\n", stats.threads.empty() ? "" : "\n  ");
+
+	std::vector<GSFunctionStats> kernels(stats.kernels);
+	std::sort(kernels.begin(), kernels.end(), [](const GSFunctionStats& l, const GSFunctionStats& r) { return l.ticks > r.ticks; });
+
+	std::fprintf(fp, "  \"draw_scanline_kernels\": [");
+	for (size_t i = 0; i < kernels.size(); ++i)
+	{
+		const GSFunctionStats& k = kernels[i];
+		std::fprintf(fp, "%s\n    {\"key\": \"%016llx\", \"frames\": %llu, \"prims\": %llu, \"pixels\": %llu, \"overdraw_pixels\": %llu, \"ms\": %.3f, \"ns_per_pixel\": %.3f}",
+			i ? "," : "",
+			static_cast<unsigned long long>(k.key),
+			static_cast<unsigned long long>(k.frames),
+			static_cast<unsigned long long>(k.prims),
+			static_cast<unsigned long long>(k.actual),
+			static_cast<unsigned long long>(k.total - k.actual),
+			k.ticks / ticks_per_ms,
+			k.actual ? (k.ticks / ticks_per_ms) * 1e6 / k.actual : 0.0);
+	}
+	std::fprintf(fp, "%s]\n", kernels.empty() ? "" : "\n  ");
+	std::fprintf(fp, "}\n");
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Main
+//////////////////////////////////////////////////////////////////////////
+
+static void PrintUsage(const char* progname)
+{
+	std::fprintf(stderr, "Usage: %s [options] <dump.gs[.xz|.zst]>\n", progname);
+	std::fprintf(stderr, "  -renderer sw|null  renderer to replay with (default sw)\n");
+	std::fprintf(stderr, "  -loop N            replay the dump N times (default 1)\n");
+	std::fprintf(stderr, "  -threads N         extra rasterizer threads for the sw renderer\n");
+	std::fprintf(stderr, "  -o FILE            write the JSON report to FILE instead of stdout\n");
+}
+
+static bool ParseCommandLine(int argc, char* argv[], Options& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string_view arg(argv[i]);
+		const bool has_value = (i + 1) < argc;
+
+		if (arg == "-renderer" && has_value)
+		{
+			const std::string_view value(argv[++i]);
+			if (value == "sw")
+				options.renderer = GSRendererType::SW;
+			else if (value == "null")
+				options.renderer = GSRendererType::Null;
+			else
+				return false;
+		}
+		else if (arg == "-loop" && has_value)
+		{
+			options.loops = std::max(StringUtil::FromChars<int>(argv[++i]).value_or(0), 0);
+			if (options.loops == 0)
+				return false;
+		}
+		else if (arg == "-threads" && has_value)
+		{
+			const std::optional<int> threads = StringUtil::FromChars<int>(argv[++i]);
+			if (!threads.has_value() || threads.value() < 0)
+				return false;
+			options.threads = threads.value();
+		}
+		else if (arg == "-o" && has_value)
+		{
+			options.report_path = argv[++i];
+		}
+		else if (!arg.empty() && arg[0] != '-' && options.dump_path.empty())
+		{
+			options.dump_path = argv[i];
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	return !options.dump_path.empty();
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!ParseCommandLine(argc, argv, options))
+	{
+		PrintUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	std::unique_ptr<GSDumpFile> dump(GSDumpFile::OpenGSDump(options.dump_path.c_str()));
+	if (!dump || !dump->ReadFile())
+	{
+		std::fprintf(stderr, "Failed to read GS dump '%s'\n", options.dump_path.c_str());
+		return EXIT_FAILURE;
+	}
+
+	if (options.threads >= 0)
+		s_settings_interface.SetIntValue("EmuCore/GS", "extrathreads", options.threads);
+	Host::Internal::SetBaseSettingsLayer(&s_settings_interface);
+
+	GSRasterizer::EnableDrawStats(true);
+
+	if (GSinit() != 0 || !GSopen(EmuConfig2.GS, options.renderer, s_gs_regs))
+	{
+		std::fprintf(stderr, "Failed to open the GS\n");
+		return EXIT_FAILURE;
+	}
+
+	GSsetGameCRC(dump->GetCRC(), 0);
+
+	u64 frames = 0;
+	bool failed = false;
+
+	Common::Timer timer;
+	const u64 start_ticks = _rdtsc();
+
+	for (int loop = 0; loop < options.loops && !failed; ++loop)
+	{
+		if (!LoadDumpState(*dump))
+		{
+			std::fprintf(stderr, "Failed to load the GS state of the dump\n");
+			failed = true;
+			break;
+		}
+
+		frames += ReplayPackets(*dump);
+	}
+
+	GSRasterizerStats stats;
+	if (options.renderer == GSRendererType::SW)
+		GSRendererSW::GetInstance()->GetDrawStats(stats);
+
+	const double seconds = timer.GetTimeSeconds();
+	const u64 elapsed_ticks = _rdtsc() - start_ticks;
+
+	if (!failed)
+	{
+		std::FILE* fp = options.report_path.empty() ? stdout : FileSystem::OpenCFile(options.report_path.c_str(), "wb");
+		if (fp)
+		{
+			WriteReport(fp, options, *dump, frames, seconds, elapsed_ticks, stats);
+			if (fp != stdout)
+				std::fclose(fp);
+		}
+		else
+		{
+			std::fprintf(stderr, "Failed to open '%s' for writing\n", options.report_path.c_str());
+			failed = true;
+		}
+	}
+
+	GSclose();
+	GSshutdown();
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
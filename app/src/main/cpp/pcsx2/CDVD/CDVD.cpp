@@ -21,6 +21,7 @@
 #include <wx/datetime.h>
 
 #include "common/FileSystem.h"
+#include "common/StringUtil.h"
 
 #include "CdRom.h"
 #include "CDVD.h"
@@ -367,7 +368,7 @@ s32 cdvdWriteConfig(const u8* config)
 static MutexRecursive Mutex_NewDiskCB;
 
 // Sets ElfCRC to the CRC of the game bound to the CDVD source.
-static __fi ElfObject* loadElf(const wxString filename)
+static __fi ElfObject* loadElf(const wxString filename, SectorSource& source)
 {
 	if (filename.StartsWith(L"host"))
 		return new ElfObject(filename.After(':'), FileSystem::GetPathFileSize(filename.After(':').ToUTF8()));
@@ -392,11 +393,31 @@ static __fi ElfObject* loadElf(const wxString filename)
 	if (fixedname != filename)
 		Console.WriteLn(Color_Blue, "(LoadELF) Non-conforming version suffix detected and replaced.");
 
-	IsoFSCDVD isofs;
-	IsoFile file(isofs, fixedname);
+	IsoFile file(source, fixedname);
 	return new ElfObject(fixedname, file);
 }
 
+// BOOT2 names are usually the serial, e.g. cdrom0:\SLUS_209.46;1 -> SLUS-20946.
+static wxString SerialFromPS2ElfPath(const wxString& elfpath)
+{
+	wxString fname = elfpath.AfterLast('\\');
+	if (!fname)
+		fname = elfpath.AfterLast('/');
+	if (!fname)
+		fname = elfpath.AfterLast(':');
+	if (fname.Matches(L"????_???.??*"))
+		return fname(0, 4) + L"-" + fname(5, 3) + fname(9, 2);
+
+	return wxEmptyString;
+}
+
+// PS1 discs just get the exe name, stripped of problematic characters.
+static wxString SerialFromPS1ElfPath(const wxString& elfpath)
+{
+	// Also catch elf paths which lack a backslash, and only have a colon.
+	return elfpath.AfterLast('\\').AfterLast(':').BeforeFirst(';');
+}
+
 static __fi void _reloadElfInfo(wxString elfpath)
 {
 	// Now's a good time to reload the ELF info...
@@ -406,15 +427,12 @@ static __fi void _reloadElfInfo(wxString elfpath)
 		return;
 	LastELF = elfpath;
 
-	wxString fname = elfpath.AfterLast('\\');
-	if (!fname)
-		fname = elfpath.AfterLast('/');
-	if (!fname)
-		fname = elfpath.AfterLast(':');
-	if (fname.Matches(L"????_???.??*"))
-		DiscSerial = fname(0, 4) + L"-" + fname(5, 3) + fname(9, 2);
+	const wxString serial(SerialFromPS2ElfPath(elfpath));
+	if (!serial.IsEmpty())
+		DiscSerial = serial;
 
-	std::unique_ptr<ElfObject> elfptr(loadElf(elfpath));
+	IsoFSCDVD isofs;
+	std::unique_ptr<ElfObject> elfptr(loadElf(elfpath, isofs));
 
 	elfptr->loadHeaders();
 	ElfCRC = elfptr->getCRC();
@@ -451,9 +469,7 @@ void cdvdReloadElfInfo(wxString elfoverride)
 			// PCSX2 currently only recognizes *.elf executables in proper PS2 format.
 			// To support different PSX titles in the console title and for savestates, this code bypasses all the detection,
 			// simply using the exe name, stripped of problematic characters.
-			wxString fname = elfpath.AfterLast('\\').AfterLast(':'); // Also catch elf paths which lack a backslash, and only have a colon.
-			wxString fname2 = fname.BeforeFirst(';');
-			DiscSerial = fname2;
+			DiscSerial = SerialFromPS1ElfPath(elfpath);
 			Console.SetTitle(DiscSerial);
 			return;
 		}
@@ -472,6 +488,35 @@ void cdvdReloadElfInfo(wxString elfoverride)
 	}
 }
 
+int cdvdGetDiscElfInfo(SectorSource& source, std::string* serial, u32* crc)
+{
+	serial->clear();
+	*crc = 0;
+
+	wxString elfpath;
+	const int disc_type = GetPS2ElfName(source, elfpath);
+	if (disc_type == 1)
+	{
+		*serial = StringUtil::wxStringToUTF8String(SerialFromPS1ElfPath(elfpath));
+	}
+	else if (disc_type == 2)
+	{
+		*serial = StringUtil::wxStringToUTF8String(SerialFromPS2ElfPath(elfpath));
+
+		try
+		{
+			std::unique_ptr<ElfObject> elfptr(loadElf(elfpath, source));
+			*crc = elfptr->getCRC();
+		}
+		catch (Exception::BaseException& ex)
+		{
+			Console.Error(ex.FormatDiagnosticMessage());
+		}
+	}
+
+	return disc_type;
+}
+
 static __fi s32 StrToS32(const wxString& str, int base = 10)
 {
 	long l;
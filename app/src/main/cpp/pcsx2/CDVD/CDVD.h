@@ -173,6 +173,13 @@ extern u8 cdvdRead(u8 key);
 extern void cdvdWrite(u8 key, u8 rt);
 
 extern void cdvdReloadElfInfo(wxString elfoverride = wxEmptyString);
+
+class SectorSource;
+
+// Like cdvdReloadElfInfo(), but reads through source and returns the serial and CRC instead of
+// setting DiscSerial/ElfCRC, so it can run on any thread.  Returns the GetPS2ElfName() disc type.
+extern int cdvdGetDiscElfInfo(SectorSource& source, std::string* serial, u32* crc);
+
 extern s32 cdvdCtrlTrayOpen();
 extern s32 cdvdCtrlTrayClose();
 
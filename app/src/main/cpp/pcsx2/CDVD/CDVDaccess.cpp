@@ -76,12 +76,11 @@ static void CheckNullCDVD()
 //////////////////////////////////////////////////////////////////////////////////////////
 // Disk Type detection stuff (from cdvdGigaherz)
 //
-static int CheckDiskTypeFS(int baseType)
+int CheckDiskTypeFS(SectorSource& source, int baseType)
 {
-	IsoFSCDVD isofs;
 	try
 	{
-		IsoDirectory rootdir(isofs);
+		IsoDirectory rootdir(source);
 
 		try
 		{
@@ -231,7 +230,8 @@ static int FindDiskType(int mType)
 
 	if (dataTracks > 0)
 	{
-		iCDType = CheckDiskTypeFS(iCDType);
+		IsoFSCDVD isofs;
+		iCDType = CheckDiskTypeFS(isofs, iCDType);
 	}
 
 	if (audioTracks > 0)
@@ -168,3 +168,9 @@ extern s32 DoCDVDreadTrack(u32 lsn, int mode);
 extern s32 DoCDVDgetBuffer(u8* buffer);
 extern s32 DoCDVDdetectDiskType();
 extern void DoCDVDresetDiskTypeCache();
+
+class SectorSource;
+
+// Works out the disc type from the filesystem (SYSTEM.CNF, PSX.EXE, VIDEO_TS).
+// baseType is the CDVD_TYPE_DETCT* media type, used to tell PS2 CDs and DVDs apart.
+extern int CheckDiskTypeFS(SectorSource& source, int baseType);
@@ -140,6 +140,7 @@ bool ChdFileReader::Open2(std::string fileName)
 		m_files.push_back(fp);
 	}
 	ChdFile = child;
+	m_chain.assign(std::make_reverse_iterator(chds + chd_depth + 1), std::make_reverse_iterator(chds));
 
 	const chd_header* chd_header = chd_get_header(ChdFile);
 	file_size = static_cast<u64>(chd_header->unitbytes) * chd_header->unitcount;
@@ -182,6 +183,70 @@ int ChdFileReader::ReadChunk(void* dst, s64 chunkID)
 	return hunk_size;
 }
 
+u32 ChdFileReader::OpenWorkers(u32 count)
+{
+	for (u32 i = 0; i < count; ++i)
+	{
+		WorkerState state = {};
+		chd_file* parent = nullptr;
+		for (const std::string& path : m_chain)
+		{
+			std::FILE* fp;
+			chd_file* child = nullptr;
+			if (chd_open_wrapper(path.c_str(), &fp, CHD_OPEN_READ, parent, &child) != CHDERR_NONE)
+			{
+				if (parent)
+					chd_close(parent);
+				parent = nullptr;
+				break;
+			}
+			state.files.push_back(fp);
+			parent = child;
+		}
+
+		if (!parent)
+		{
+			for (std::FILE* fp : state.files)
+				std::fclose(fp);
+			break;
+		}
+
+		state.chd = parent;
+		m_workerStates.push_back(std::move(state));
+	}
+
+	if (m_workerStates.size() < count)
+		Console.Warning("CDVD: Only %zu of %u CHD readahead workers could be started.", m_workerStates.size(), count);
+
+	return static_cast<u32>(m_workerStates.size());
+}
+
+void ChdFileReader::CloseWorkers()
+{
+	for (WorkerState& state : m_workerStates)
+	{
+		chd_close(state.chd);
+		for (std::FILE* fp : state.files)
+			std::fclose(fp);
+	}
+	m_workerStates.clear();
+}
+
+int ChdFileReader::ReadChunkOnWorker(void* dst, s64 chunkID, u32 worker)
+{
+	if (chunkID < 0)
+		return -1;
+
+	chd_error error = chd_read(m_workerStates[worker].chd, chunkID, dst);
+	if (error != CHDERR_NONE)
+	{
+		Console.Error(L"CDVD: chd_read returned error: %s", chd_error_string(error));
+		return 0;
+	}
+
+	return hunk_size;
+}
+
 void ChdFileReader::Close2()
 {
 	if (ChdFile != NULL)
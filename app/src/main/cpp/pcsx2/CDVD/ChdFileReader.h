@@ -35,9 +35,24 @@ public:
 	uint GetBlockCount(void) const override;
 	ChdFileReader(void);
 
+protected:
+	u32 OpenWorkers(u32 count) override;
+	void CloseWorkers(void) override;
+	int ReadChunkOnWorker(void* dst, s64 chunkID, u32 worker) override;
+
 private:
 	chd_file* ChdFile;
 	u64 file_size;
 	u32 hunk_size;
 	std::vector<std::FILE*> m_files;
+	/// Resolved parent chain, parent-most file first, so workers can reopen it
+	std::vector<std::string> m_chain;
+
+	/// Readahead workers each get their own chd_file, libchdr keeps per-file decompression state
+	struct WorkerState
+	{
+		chd_file* chd;
+		std::vector<std::FILE*> files;
+	};
+	std::vector<WorkerState> m_workerStates;
 };
@@ -15,44 +15,139 @@
 
 #include "PrecompiledHeader.h"
 #include "ChunksCache.h"
+#include "PerformanceMetrics.h"
 
 void ChunksCache::SetLimit(uint megabytes)
 {
-	m_limit = (s64)megabytes * 1024 * 1024;
+	m_maxSlots = std::max<u32>(1, static_cast<u32>((s64)megabytes * 1024 * 1024 / m_chunkSize));
 	MatchLimit();
 }
 
-void ChunksCache::MatchLimit(bool removeAll)
+void ChunksCache::Clear()
 {
-	std::list<CacheEntry*>::reverse_iterator rit;
-	while (!m_entries.empty() && (removeAll || m_size > m_limit))
+	m_blocks.clear();
+	m_entries.clear();
+	m_freeSlots.clear();
+	m_lookup.clear();
+	m_head = INVALID_SLOT;
+	m_tail = INVALID_SLOT;
+}
+
+void ChunksCache::MatchLimit()
+{
+	while (m_lookup.size() > m_maxSlots)
 	{
-		rit = m_entries.rbegin();
-		m_size -= (*rit)->size;
-		delete (*rit);
-		m_entries.pop_back();
+		const u32 slot = m_tail;
+		Evict(slot);
+		m_freeSlots.push_back(slot);
 	}
 }
 
-void ChunksCache::Take(void* pMallocedSrc, s64 offset, int length, int coverage)
+void ChunksCache::Unlink(u32 slot)
 {
-	m_entries.push_front(new CacheEntry(pMallocedSrc, offset, length, coverage));
-	m_size += length;
-	MatchLimit();
+	CacheEntry& e = m_entries[slot];
+	if (e.prev != INVALID_SLOT)
+		m_entries[e.prev].next = e.next;
+	else
+		m_head = e.next;
+	if (e.next != INVALID_SLOT)
+		m_entries[e.next].prev = e.prev;
+	else
+		m_tail = e.prev;
+}
+
+void ChunksCache::PushFront(u32 slot)
+{
+	CacheEntry& e = m_entries[slot];
+	e.prev = INVALID_SLOT;
+	e.next = m_head;
+	if (m_head != INVALID_SLOT)
+		m_entries[m_head].prev = slot;
+	else
+		m_tail = slot;
+	m_head = slot;
+}
+
+void ChunksCache::Evict(u32 slot)
+{
+	CacheEntry& e = m_entries[slot];
+	Unlink(slot);
+	m_lookup.erase(KeyForOffset(e.offset));
+	PerformanceMetrics::AddDiscCacheEviction(e.size);
+}
+
+u32 ChunksCache::AllocateSlot()
+{
+	if (m_lookup.size() >= m_maxSlots)
+	{
+		// Full, recycle the least recently used chunk
+		const u32 slot = m_tail;
+		Evict(slot);
+		return slot;
+	}
+
+	if (m_freeSlots.empty())
+	{
+		const u32 first = static_cast<u32>(m_blocks.size() * SLOTS_PER_BLOCK);
+		m_blocks.push_back(std::make_unique<u8[]>(static_cast<size_t>(m_chunkSize) * SLOTS_PER_BLOCK));
+		m_entries.resize(first + SLOTS_PER_BLOCK);
+		for (u32 i = SLOTS_PER_BLOCK; i > 0; i--)
+			m_freeSlots.push_back(first + i - 1);
+	}
+
+	const u32 slot = m_freeSlots.back();
+	m_freeSlots.pop_back();
+	return slot;
+}
+
+void ChunksCache::Insert(const void* pSrc, s64 offset, int length, int coverage)
+{
+	pxAssert(length >= 0 && length <= coverage && coverage <= static_cast<int>(m_chunkSize));
+
+	const s64 key = KeyForOffset(offset);
+	u32 slot;
+	auto it = m_lookup.find(key);
+	if (it != m_lookup.end())
+	{
+		// Replace the previous extraction of this chunk in place
+		slot = it->second;
+		Unlink(slot);
+	}
+	else
+	{
+		slot = AllocateSlot();
+		m_lookup.emplace(key, slot);
+	}
+
+	CacheEntry& e = m_entries[slot];
+	e.offset = offset;
+	e.size = length;
+	e.coverage = coverage;
+	if (length)
+		memcpy(SlotData(slot), pSrc, length);
+	PushFront(slot);
 }
 
 // By design, succeed only if the entire request is in a single cached chunk
 int ChunksCache::Read(void* pDest, s64 offset, int length)
 {
-	for (auto it = m_entries.begin(); it != m_entries.end(); it++)
+	auto it = m_lookup.find(KeyForOffset(offset));
+	if (it != m_lookup.end())
 	{
-		CacheEntry* e = *it;
-		if (e && offset >= e->offset && (offset + length) <= (e->offset + e->coverage))
+		const u32 slot = it->second;
+		const CacheEntry& e = m_entries[slot];
+		if (offset >= e.offset && (offset + length) <= (e.offset + e.coverage))
 		{
-			if (it != m_entries.begin())
-				m_entries.splice(m_entries.begin(), m_entries, it); // Move to top (MRU)
-			return CopyAvailable(e->data, e->offset, e->size, pDest, offset, length);
+			if (slot != m_head)
+			{
+				// Move to top (MRU)
+				Unlink(slot);
+				PushFront(slot);
+			}
+			PerformanceMetrics::AddDiscCacheLookup(true);
+			return CopyAvailable(SlotData(slot), e.offset, e.size, pDest, offset, length);
 		}
 	}
+	PerformanceMetrics::AddDiscCacheLookup(false);
 	return -1;
 }
@@ -17,20 +17,27 @@
 
 #include "zlib_indexed.h"
 
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 #define CLAMP(val, minval, maxval) (std::min(maxval, std::max(minval, val)))
 
 class ChunksCache
 {
 public:
-	ChunksCache(uint initialLimitMb)
-		: m_entries(0)
-		, m_size(0)
-		, m_limit(initialLimitMb * 1024 * 1024){};
+	ChunksCache(uint initialLimitMb, uint chunkSize)
+		: m_chunkSize(chunkSize)
+	{
+		SetLimit(initialLimitMb);
+	};
 	~ChunksCache() { Clear(); };
 	void SetLimit(uint megabytes);
-	void Clear() { MatchLimit(true); };
+	void Clear();
 
-	void Take(void* pMallocedSrc, s64 offset, int length, int coverage);
+	/// Copies `length` bytes of extracted data at `offset` into the cache
+	/// `coverage` is the part of the source they stand for (bigger than `length` at EOF), at most one chunk
+	void Insert(const void* pSrc, s64 offset, int length, int coverage);
 	int Read(void* pDest, s64 offset, int length);
 
 	static int CopyAvailable(void* pSrc, s64 srcOffset, int srcSize,
@@ -42,31 +49,37 @@ public:
 	};
 
 private:
-	class CacheEntry
-	{
-	public:
-		CacheEntry(void* pMallocedSrc, s64 offset, int length, int coverage)
-			: data(pMallocedSrc)
-			, offset(offset)
-			, coverage(coverage)
-			, size(length){};
-
-		~CacheEntry()
-		{
-			if (data)
-				free(data);
-		};
+	static constexpr u32 INVALID_SLOT = ~0u;
+	/// Slots are allocated in blocks to avoid one allocation per chunk
+	static constexpr u32 SLOTS_PER_BLOCK = 16;
 
-		void* data;
+	/// Metadata of the chunk stored in the slot with the same index, linked in LRU order
+	struct CacheEntry
+	{
 		s64 offset;
-		int coverage;
 		int size;
+		int coverage;
+		u32 prev; ///< Towards the most recently used entry
+		u32 next; ///< Towards the least recently used entry
 	};
 
-	std::list<CacheEntry*> m_entries;
-	void MatchLimit(bool removeAll = false);
-	s64 m_size;
-	s64 m_limit;
+	u8* SlotData(u32 slot) { return m_blocks[slot / SLOTS_PER_BLOCK].get() + (slot % SLOTS_PER_BLOCK) * m_chunkSize; }
+	s64 KeyForOffset(s64 offset) const { return offset - offset % m_chunkSize; }
+	u32 AllocateSlot();
+	void Unlink(u32 slot);
+	void PushFront(u32 slot);
+	void Evict(u32 slot);
+	void MatchLimit();
+
+	std::vector<std::unique_ptr<u8[]>> m_blocks;
+	std::vector<CacheEntry> m_entries;
+	std::vector<u32> m_freeSlots;
+	/// Chunk-aligned offset -> slot
+	std::unordered_map<s64, u32> m_lookup;
+	u32 m_head = INVALID_SLOT; ///< Most recently used
+	u32 m_tail = INVALID_SLOT; ///< Least recently used
+	u32 m_chunkSize;
+	u32 m_maxSlots = 0;
 };
 
 #undef CLAMP
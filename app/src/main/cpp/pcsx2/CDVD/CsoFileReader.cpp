@@ -142,15 +142,7 @@ bool CsoFileReader::InitializeBuffers()
 	// Round up, since part of a frame requires a full frame.
 	u32 numFrames = (u32)((m_totalSize + m_frameSize - 1) / m_frameSize);
 
-	// We might read a bit of alignment too, so be prepared.
-	if (m_frameSize + (1 << m_indexShift) < CSO_READ_BUFFER_SIZE)
-	{
-		m_readBuffer = new u8[CSO_READ_BUFFER_SIZE];
-	}
-	else
-	{
-		m_readBuffer = new u8[m_frameSize + (1 << m_indexShift)];
-	}
+	m_readBuffer = new u8[ReadBufferSize()];
 
 	const u32 indexSize = numFrames + 1;
 	m_index = new u32[indexSize];
@@ -173,6 +165,54 @@ bool CsoFileReader::InitializeBuffers()
 	return true;
 }
 
+u32 CsoFileReader::ReadBufferSize() const
+{
+	// We might read a bit of alignment too, so be prepared.
+	return std::max<u32>(m_frameSize + (1 << m_indexShift), CSO_READ_BUFFER_SIZE);
+}
+
+u32 CsoFileReader::OpenWorkers(u32 count)
+{
+	for (u32 i = 0; i < count; ++i)
+	{
+		WorkerState state = {};
+		state.src = FileSystem::OpenCFile(m_filename.c_str(), "rb");
+		if (!state.src)
+			break;
+
+		state.zstream = new z_stream;
+		state.zstream->zalloc = Z_NULL;
+		state.zstream->zfree = Z_NULL;
+		state.zstream->opaque = Z_NULL;
+		if (inflateInit2(state.zstream, -15) != Z_OK)
+		{
+			delete state.zstream;
+			fclose(state.src);
+			break;
+		}
+
+		state.readBuffer = new u8[ReadBufferSize()];
+		m_workerStates.push_back(state);
+	}
+
+	if (m_workerStates.size() < count)
+		Console.Warning("CSO: Only %zu of %u readahead workers could be started.", m_workerStates.size(), count);
+
+	return static_cast<u32>(m_workerStates.size());
+}
+
+void CsoFileReader::CloseWorkers()
+{
+	for (WorkerState& state : m_workerStates)
+	{
+		fclose(state.src);
+		inflateEnd(state.zstream);
+		delete state.zstream;
+		delete[] state.readBuffer;
+	}
+	m_workerStates.clear();
+}
+
 void CsoFileReader::Close2()
 {
 	m_filename.clear();
@@ -221,8 +261,20 @@ int CsoFileReader::ReadChunk(void *dst, s64 chunkID)
 	if (chunkID < 0)
 		return -1;
 
-	const u32 frame = chunkID;
+	return ReadFrame(dst, static_cast<u32>(chunkID), m_src, m_z_stream, m_readBuffer);
+}
+
+int CsoFileReader::ReadChunkOnWorker(void* dst, s64 chunkID, u32 worker)
+{
+	if (chunkID < 0)
+		return -1;
+
+	WorkerState& state = m_workerStates[worker];
+	return ReadFrame(dst, static_cast<u32>(chunkID), state.src, state.zstream, state.readBuffer);
+}
 
+int CsoFileReader::ReadFrame(void* dst, u32 frame, FILE* src, z_stream* zstream, u8* readBuffer)
+{
 	// Grab the index data for the frame we're about to read.
 	const bool compressed = (m_index[frame + 0] & 0x80000000) == 0;
 	const u32 index0 = m_index[frame + 0] & 0x7FFFFFFF;
@@ -235,35 +287,35 @@ int CsoFileReader::ReadChunk(void *dst, s64 chunkID)
 	if (!compressed)
 	{
 		// Just read directly, easy.
-		if (FileSystem::FSeek64(m_src, frameRawPos, SEEK_SET) != 0)
+		if (FileSystem::FSeek64(src, frameRawPos, SEEK_SET) != 0)
 		{
 			Console.Error("Unable to seek to uncompressed CSO data.");
 			return 0;
 		}
-		return fread(dst, 1, m_frameSize, m_src);
+		return fread(dst, 1, m_frameSize, src);
 	}
 	else
 	{
-		if (FileSystem::FSeek64(m_src, frameRawPos, SEEK_SET) != 0)
+		if (FileSystem::FSeek64(src, frameRawPos, SEEK_SET) != 0)
 		{
 			Console.Error("Unable to seek to compressed CSO data.");
 			return 0;
 		}
 		// This might be less bytes than frameRawSize in case of padding on the last frame.
 		// This is because the index positions must be aligned.
-		const u32 readRawBytes = fread(m_readBuffer, 1, frameRawSize, m_src);
+		const u32 readRawBytes = fread(readBuffer, 1, frameRawSize, src);
 
-		m_z_stream->next_in = m_readBuffer;
-		m_z_stream->avail_in = readRawBytes;
-		m_z_stream->next_out = static_cast<Bytef*>(dst);
-		m_z_stream->avail_out = m_frameSize;
+		zstream->next_in = readBuffer;
+		zstream->avail_in = readRawBytes;
+		zstream->next_out = static_cast<Bytef*>(dst);
+		zstream->avail_out = m_frameSize;
 
-		int status = inflate(m_z_stream, Z_FINISH);
-		bool success = status == Z_STREAM_END && m_z_stream->total_out == m_frameSize;
+		int status = inflate(zstream, Z_FINISH);
+		bool success = status == Z_STREAM_END && zstream->total_out == m_frameSize;
 
 		if (!success)
 			Console.Error("Unable to decompress CSO frame using zlib.");
-		inflateReset(m_z_stream);
+		inflateReset(zstream);
 
 		return success ? m_frameSize : 0;
 	}
@@ -60,6 +60,10 @@ public:
 
 	void Close2(void) override;
 
+	u32 OpenWorkers(u32 count) override;
+	void CloseWorkers(void) override;
+	int ReadChunkOnWorker(void* dst, s64 chunkID, u32 worker) override;
+
 	uint GetBlockCount(void) const override
 	{
 		return (m_totalSize - m_dataoffset) / m_blocksize;
@@ -69,6 +73,8 @@ private:
 	static bool ValidateHeader(const CsoHeader& hdr);
 	bool ReadFileHeader();
 	bool InitializeBuffers();
+	u32 ReadBufferSize() const;
+	int ReadFrame(void* dst, u32 frame, FILE* src, z_stream* zstream, u8* readBuffer);
 	int ReadFromFrame(u8* dest, u64 pos, int maxBytes);
 	bool DecompressFrame(Bytef* dst, u32 frame, u32 readBufferSize);
 	bool DecompressFrame(u32 frame, u32 readBufferSize);
@@ -82,4 +88,13 @@ private:
 	// The actual source cso file handle.
 	FILE* m_src;
 	z_stream* m_z_stream;
+
+	/// Each readahead worker reads through its own handle and inflate state
+	struct WorkerState
+	{
+		FILE* src;
+		z_stream* zstream;
+		u8* readBuffer;
+	};
+	std::vector<WorkerState> m_workerStates;
 };
@@ -18,8 +18,10 @@
 #include <fstream>
 #include "common/FileSystem.h"
 #include "common/StringUtil.h"
+#include "common/Timer.h"
 #include "Config.h"
 #include "ChunksCache.h"
+#include "PerformanceMetrics.h"
 #include "GzippedFileReader.h"
 #include "zlib_indexed.h"
 
@@ -193,7 +195,7 @@ GzippedFileReader::GzippedFileReader(void)
 	, m_pIndex(0)
 	, m_zstates(0)
 	, m_src(0)
-	, m_cache(GZFILE_CACHE_SIZE_MB)
+	, m_cache(GZFILE_CACHE_SIZE_MB, GZFILE_READ_CHUNK_SIZE)
 {
 	m_blocksize = 2048;
 	AsyncPrefetchReset();
@@ -361,6 +363,9 @@ bool GzippedFileReader::Open(std::string fileName)
 		return false;
 	};
 
+	// Must fit at least one extraction chunk
+	m_cache.SetLimit(std::max<u32>(EmuConfig.GzipIsoCacheSize, (GZFILE_READ_CHUNK_SIZE + 1024 * 1024 - 1) / (1024 * 1024)));
+
 	AsyncPrefetchOpen();
 	return true;
 };
@@ -441,6 +446,7 @@ int GzippedFileReader::_ReadSync(void* pBuffer, s64 offset, uint bytesToRead)
 	// Not available from cache. Decompress from optimal starting
 	// point in GZFILE_READ_CHUNK_SIZE chunks and cache each chunk.
 	PTT s = NOW();
+	Common::Timer timer;
 	s64 extractOffset = GetOptimalExtractionStart(offset); // guaranteed in GZFILE_READ_CHUNK_SIZE boundaries
 	int size = offset + maxInChunk - extractOffset;
 	unsigned char* extracted = (unsigned char*)malloc(size);
@@ -473,20 +479,15 @@ int GzippedFileReader::_ReadSync(void* pBuffer, s64 offset, uint bytesToRead)
 		m_zstates[spanix].Kill();
 	}
 
-	if (size <= GZFILE_READ_CHUNK_SIZE)
-		m_cache.Take(extracted, extractOffset, res, size);
-	else
-	{ // split into cacheable chunks
-		for (int i = 0; i < size; i += GZFILE_READ_CHUNK_SIZE)
-		{
-			int available = CLAMP(res - i, 0, GZFILE_READ_CHUNK_SIZE);
-			void* chunk = available ? malloc(available) : 0;
-			if (available)
-				memcpy(chunk, extracted + i, available);
-			m_cache.Take(chunk, extractOffset + i, available, std::min(size - i, GZFILE_READ_CHUNK_SIZE));
-		}
-		free(extracted);
+	// split into cacheable chunks
+	for (int i = 0; i < size; i += GZFILE_READ_CHUNK_SIZE)
+	{
+		int available = CLAMP(res - i, 0, GZFILE_READ_CHUNK_SIZE);
+		m_cache.Insert(extracted + i, extractOffset + i, available, std::min(size - i, GZFILE_READ_CHUNK_SIZE));
 	}
+	free(extracted);
+
+	PerformanceMetrics::AddDiscDecompressTime(static_cast<u64>(timer.GetTimeNanoseconds() / 1000.0));
 
 	int duration = NOW() - s;
 	if (duration > 10)
@@ -509,6 +510,16 @@ void GzippedFileReader::Close()
 	}
 
 	InitZstates(); // results in delete because no index
+
+	const u64 hits = PerformanceMetrics::GetDiscCacheHits();
+	const u64 misses = PerformanceMetrics::GetDiscCacheMisses();
+	if (hits + misses)
+	{
+		DevCon.WriteLn("gunzip: cache hit rate %.1f%% (%llu/%llu), %llu MB evicted, %.0f ms decompressing",
+			100.0 * hits / (hits + misses), (unsigned long long)hits, (unsigned long long)(hits + misses),
+			(unsigned long long)(PerformanceMetrics::GetDiscCacheBytesEvicted() / (1024 * 1024)),
+			PerformanceMetrics::GetDiscDecompressTime());
+	}
 	m_cache.Clear();
 
 	if (m_src)
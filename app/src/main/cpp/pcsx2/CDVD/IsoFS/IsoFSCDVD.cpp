@@ -18,6 +18,7 @@
 
 #include "IsoFSCDVD.h"
 #include "CDVD/CDVDaccess.h"
+#include "CDVD/IsoFileFormats.h"
 
 IsoFSCDVD::IsoFSCDVD()
 {
@@ -35,3 +36,27 @@ int IsoFSCDVD::getNumSectors()
 
 	return td.lsn;
 }
+
+IsoFSInputIso::IsoFSInputIso(InputIsoFile& iso)
+	: m_iso(iso)
+{
+}
+
+bool IsoFSInputIso::readSector(unsigned char* buffer, int lba)
+{
+	// same as ISOreadSector() in CDVD_MODE_2048
+	if (lba < 0 || static_cast<uint>(lba) >= m_iso.GetBlockCount())
+		return false;
+
+	u8 cdbuffer[CD_FRAMESIZE_RAW] = {};
+	if (m_iso.ReadSync(cdbuffer, lba) < 0)
+		return false;
+
+	std::memcpy(buffer, cdbuffer + 24, 2048);
+	return true;
+}
+
+int IsoFSInputIso::getNumSectors()
+{
+	return m_iso.GetBlockCount();
+}
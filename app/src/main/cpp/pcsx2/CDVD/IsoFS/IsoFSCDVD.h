@@ -29,3 +29,21 @@ public:
 
 	virtual int getNumSectors();
 };
+
+class InputIsoFile;
+
+// Reads straight from an image instead of going through the active CDVD source, so
+// several can be used at once from different threads (game list scanning).
+class IsoFSInputIso : public SectorSource
+{
+public:
+	IsoFSInputIso(InputIsoFile& iso);
+	virtual ~IsoFSInputIso() = default;
+
+	virtual bool readSector(unsigned char* buffer, int lba);
+
+	virtual int getNumSectors();
+
+protected:
+	InputIsoFile& m_iso;
+};
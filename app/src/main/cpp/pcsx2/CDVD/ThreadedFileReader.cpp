@@ -15,11 +15,17 @@
 
 #include "PrecompiledHeader.h"
 #include "ThreadedFileReader.h"
+#include "Config.h"
 
 // Make sure buffer size is bigger than the cutoff where PCSX2 emulates a seek
 // If buffers are smaller than that, we can't keep up with linear reads
 static constexpr u32 MINIMUM_SIZE = 128 * 1024;
 
+static constexpr u32 MAX_READAHEAD_WORKERS = 8;
+static constexpr u32 MAX_READAHEAD_DEPTH = 32;
+/// Number of back-to-back requests before we consider the game to be streaming
+static constexpr u32 SEQUENTIAL_READS_THRESHOLD = 2;
+
 ThreadedFileReader::ThreadedFileReader()
 {
 	m_readThread = std::thread([](ThreadedFileReader* r){ r->Loop(); }, this);
@@ -31,6 +37,7 @@ ThreadedFileReader::~ThreadedFileReader()
 	(void)std::lock_guard<std::mutex>{m_mtx};
 	m_condition.notify_one();
 	m_readThread.join();
+	pxAssert(m_workers.empty());
 	for (auto& buffer : m_buffer)
 		if (buffer.ptr)
 			free(buffer.ptr);
@@ -73,21 +80,53 @@ void ThreadedFileReader::Loop()
 		u64 requestOffset = m_requestOffset;
 		u32 requestSize = m_requestSize;
 		void* ptr = m_requestPtr.load(std::memory_order_relaxed);
+		// The worker pool keeps the window ahead of streaming reads, don't fight it for the decompressor
+		const bool windowed = m_readaheadCount && m_sequentialReads >= SEQUENTIAL_READS_THRESHOLD;
 
 		m_running = true;
+
+		void* dst = ptr;
+		u64 offset = requestOffset;
+		u32 size = requestSize;
+
+		if (dst && m_readaheadCount)
+		{
+			// If the window already covers this request, wait for it instead of decompressing the same chunks twice
+			// Spans no worker has picked up yet are claimed and filled here
+			ReadaheadSlot* slot;
+			while ((slot = FindReadaheadSlot(offset)) && slot->state != ReadaheadSlot::State::Ready &&
+				   !m_requestCancelled.load(std::memory_order_relaxed))
+			{
+				if (slot->state == ReadaheadSlot::State::Queued)
+				{
+					slot->state = ReadaheadSlot::State::Busy;
+					lock.unlock();
+					const u32 filled = FillReadaheadSlot(*slot, -1);
+					lock.lock();
+					FinishReadaheadSlot(*slot, filled);
+				}
+				else
+				{
+					m_condition.wait(lock);
+				}
+			}
+
+			CopyFromCache(dst, offset, size);
+		}
+
 		lock.unlock();
 
 		bool ok = true;
 
-		if (ptr)
+		if (dst && size)
 		{
-			ok = Decompress(ptr, requestOffset, requestSize);
+			ok = Decompress(dst, offset, size);
 		}
 
 		m_requestPtr.store(nullptr, std::memory_order_release);
 		m_condition.notify_one();
 
-		if (ok)
+		if (ok && !windowed)
 		{
 			// Readahead
 			Chunk chunk = ChunkForOffset(requestOffset + requestSize);
@@ -210,39 +249,247 @@ bool ThreadedFileReader::Decompress(void* target, u64 begin, u32 size)
 
 bool ThreadedFileReader::TryCachedRead(void*& buffer, u64& offset, u32& size, const std::lock_guard<std::mutex>&)
 {
-	// Run through twice so that if m_buffer[1] contains the first half and m_buffer[0] contains the second half it still works
 	m_amtRead = 0;
+	return CopyFromCache(buffer, offset, size);
+}
+
+bool ThreadedFileReader::CopyFromCache(void*& buffer, u64& offset, u32& size)
+{
+	Buffer* buffers[ArraySize(m_buffer) + MAX_READAHEAD_DEPTH];
+	u32 count = 0;
+	for (Buffer& buf : m_buffer)
+	{
+		if (buf.size.load(std::memory_order_acquire))
+			buffers[count++] = &buf;
+	}
+	for (u32 i = 0; i < m_readaheadCount; ++i)
+	{
+		if (m_readahead[i].state == ReadaheadSlot::State::Ready)
+			buffers[count++] = &m_readahead[i].buf;
+	}
+
+	// Buffers can hold consecutive data in any order, so keep going over them while we make progress
 	u64 end = 0;
-	bool allDone = false;
-	for (int i = 0; i < static_cast<int>(ArraySize(m_buffer) * 2); ++i)
+	bool progress = true;
+	while (size && progress)
+	{
+		progress = false;
+		for (u32 i = 0; i < count && size; ++i)
+		{
+			Buffer& buf = *buffers[i];
+			u32 bufsize = buf.size.load(std::memory_order_relaxed);
+			if (buf.offset <= offset && buf.offset + bufsize > offset)
+			{
+				u32 off = offset - buf.offset;
+				u32 cpysize = std::min(size, bufsize - off);
+				size_t read = CopyBlocks(buffer, static_cast<char*>(buf.ptr) + off, cpysize);
+				m_amtRead += read;
+				size -= cpysize;
+				offset += cpysize;
+				buffer = static_cast<char*>(buffer) + read;
+				if (size == 0)
+					end = buf.offset + bufsize;
+				progress = true;
+			}
+		}
+	}
+
+	// Do buffers contain the current and next block?
+	if (end == 0)
+		return false;
+	for (u32 i = 0; i < count; ++i)
+	{
+		if (buffers[i]->offset == end)
+			return true;
+	}
+	return false;
+}
+
+void ThreadedFileReader::StartWorkers(void)
+{
+	const u32 threads = std::min<u32>(EmuConfig.CdvdReadaheadThreads, MAX_READAHEAD_WORKERS);
+	const u32 depth = std::min<u32>(EmuConfig.CdvdReadaheadDepth, MAX_READAHEAD_DEPTH);
+	if (threads == 0 || depth == 0)
+		return;
+
+	const u32 count = OpenWorkers(threads);
+	if (count == 0)
+		return;
+
+	m_readahead = std::make_unique<ReadaheadSlot[]>(depth);
+	m_readaheadCount = depth;
+	m_workersQuit = false;
+	m_lastReadEnd = 0;
+	m_sequentialReads = 0;
+
+	for (u32 i = 0; i < count; ++i)
+		m_workers.emplace_back([this, i]() { WorkerLoop(i); });
+}
+
+void ThreadedFileReader::StopWorkers(void)
+{
+	if (m_workers.empty())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_workersQuit = true;
+	}
+	m_workerCondition.notify_all();
+	for (std::thread& thread : m_workers)
+		thread.join();
+	m_workers.clear();
+
+	CloseWorkers();
+
+	for (u32 i = 0; i < m_readaheadCount; ++i)
+	{
+		if (m_readahead[i].buf.ptr)
+			free(m_readahead[i].buf.ptr);
+	}
+	m_readahead.reset();
+	m_readaheadCount = 0;
+}
+
+void ThreadedFileReader::WorkerLoop(u32 worker)
+{
+	Threading::SetNameOfCurrentThread("ISO Readahead");
+
+	std::unique_lock<std::mutex> lock(m_mtx);
+
+	while (true)
 	{
-		Buffer& buf = m_buffer[i % ArraySize(m_buffer)];
-		u32 bufsize = buf.size.load(std::memory_order_acquire);
-		if (!bufsize)
+		// Closest span first, it's the one the read head reaches next
+		ReadaheadSlot* slot = nullptr;
+		for (u32 i = 0; i < m_readaheadCount; ++i)
+		{
+			ReadaheadSlot& candidate = m_readahead[i];
+			if (candidate.state == ReadaheadSlot::State::Queued && (!slot || candidate.buf.offset < slot->buf.offset))
+				slot = &candidate;
+		}
+
+		if (m_workersQuit)
+			return;
+
+		if (!slot)
+		{
+			m_workerCondition.wait(lock);
 			continue;
-		if (buf.offset <= offset && buf.offset + bufsize > offset)
+		}
+
+		slot->state = ReadaheadSlot::State::Busy;
+		lock.unlock();
+		const u32 size = FillReadaheadSlot(*slot, static_cast<int>(worker));
+		lock.lock();
+		FinishReadaheadSlot(*slot, size);
+	}
+}
+
+ThreadedFileReader::ReadaheadSlot* ThreadedFileReader::FindReadaheadSlot(u64 offset)
+{
+	for (u32 i = 0; i < m_readaheadCount; ++i)
+	{
+		ReadaheadSlot& slot = m_readahead[i];
+		if (slot.state != ReadaheadSlot::State::Empty && slot.buf.offset <= offset && slot.end > offset)
+			return &slot;
+	}
+	return nullptr;
+}
+
+u32 ThreadedFileReader::FillReadaheadSlot(ReadaheadSlot& slot, int worker)
+{
+	u32 size = 0;
+	Chunk chunk = ChunkForOffset(slot.buf.offset);
+	while (chunk.chunkID >= 0 && chunk.offset < slot.end && size + chunk.length <= slot.buf.cap)
+	{
+		void* dst = static_cast<char*>(slot.buf.ptr) + size;
+		const int amt = (worker < 0) ? ReadChunk(dst, chunk.chunkID) : ReadChunkOnWorker(dst, chunk.chunkID, static_cast<u32>(worker));
+		if (amt <= 0)
+			break;
+		size += amt;
+		// A short chunk (end of file) can't be followed by anything contiguous
+		if (static_cast<u32>(amt) < chunk.length)
+			break;
+		chunk = ChunkForOffset(slot.buf.offset + size);
+	}
+	return size;
+}
+
+void ThreadedFileReader::FinishReadaheadSlot(ReadaheadSlot& slot, u32 size)
+{
+	slot.buf.size.store(size, std::memory_order_release);
+	slot.state = size ? ReadaheadSlot::State::Ready : ReadaheadSlot::State::Empty;
+	// The read thread may be waiting for this span
+	m_condition.notify_all();
+}
+
+void ThreadedFileReader::UpdateReadahead(u64 offset, u32 size)
+{
+	if (offset == m_lastReadEnd)
+		m_sequentialReads++;
+	else
+		m_sequentialReads = 0;
+	m_lastReadEnd = offset + size;
+
+	if (!m_readaheadCount || m_sequentialReads < SEQUENTIAL_READS_THRESHOLD)
+		return;
+
+	bool queued = false;
+	Chunk chunk = ChunkForOffset(m_lastReadEnd);
+	for (u32 i = 0; i < m_readaheadCount && chunk.chunkID >= 0; ++i)
+	{
+		ReadaheadSlot* slot = FindReadaheadSlot(chunk.offset);
+		if (!slot)
 		{
-			u32 off = offset - buf.offset;
-			u32 cpysize = std::min(size, bufsize - off);
-			size_t read = CopyBlocks(buffer, static_cast<char*>(buf.ptr) + off, cpysize);
-			m_amtRead += read;
-			size -= cpysize;
-			offset += cpysize;
-			buffer = static_cast<char*>(buffer) + read;
-			if (size == 0)
-				end = buf.offset + bufsize;
+			// Reuse a free slot, or one the read head has already moved past
+			for (u32 j = 0; j < m_readaheadCount && !slot; ++j)
+			{
+				ReadaheadSlot& candidate = m_readahead[j];
+				if (candidate.state == ReadaheadSlot::State::Empty ||
+					(candidate.state != ReadaheadSlot::State::Busy && candidate.end <= offset))
+				{
+					slot = &candidate;
+				}
+			}
+			if (!slot)
+				break;
+
+			// Group consecutive chunks so that small CSO frames still give the workers a worthwhile amount of work
+			u64 end = chunk.offset;
+			u32 length = 0;
+			for (Chunk next = chunk; next.chunkID >= 0 && length < MINIMUM_SIZE; next = ChunkForOffset(end))
+			{
+				length += next.length;
+				end = next.offset + next.length;
+			}
+
+			if (slot->buf.cap < length)
+			{
+				slot->buf.ptr = realloc(slot->buf.ptr, length);
+				slot->buf.cap = length;
+			}
+			slot->buf.offset = chunk.offset;
+			slot->buf.size.store(0, std::memory_order_relaxed);
+			slot->end = end;
+			slot->state = ReadaheadSlot::State::Queued;
+			queued = true;
 		}
-		// Do buffers contain the current and next block?
-		if (end > 0 && buf.offset == end)
-			allDone = true;
+
+		chunk = ChunkForOffset(slot->end);
 	}
-	return allDone;
+
+	if (queued)
+		m_workerCondition.notify_all();
 }
 
 bool ThreadedFileReader::Open(std::string fileName)
 {
 	CancelAndWaitUntilStopped();
-	return Open2(std::move(fileName));
+	StopWorkers();
+	if (!Open2(std::move(fileName)))
+		return false;
+	StartWorkers();
+	return true;
 }
 
 int ThreadedFileReader::ReadSync(void* pBuffer, uint sector, uint count)
@@ -252,6 +499,7 @@ int ThreadedFileReader::ReadSync(void* pBuffer, uint sector, uint count)
 	u32 size = count * blocksize;
 	{
 		std::lock_guard<std::mutex> l(m_mtx);
+		UpdateReadahead(offset, size);
 		if (TryCachedRead(pBuffer, offset, size, l))
 			return m_amtRead;
 
@@ -301,6 +549,7 @@ void ThreadedFileReader::BeginRead(void* pBuffer, uint sector, uint count)
 	u32 size = count * blocksize;
 	{
 		std::lock_guard<std::mutex> l(m_mtx);
+		UpdateReadahead(offset, size);
 		if (TryCachedRead(pBuffer, offset, size, l))
 			return;
 		if (size == 0)
@@ -344,6 +593,7 @@ void ThreadedFileReader::CancelRead(void)
 void ThreadedFileReader::Close(void)
 {
 	CancelAndWaitUntilStopped();
+	StopWorkers();
 	for (auto& buf : m_buffer)
 		buf.size.store(0, std::memory_order_relaxed);
 	Close2();
@@ -18,8 +18,10 @@
 #include "AsyncFileReader.h"
 #include "common/PersistentThread.h"
 
+#include <memory>
 #include <thread>
 #include <mutex>
+#include <vector>
 #include <atomic>
 #include <condition_variable>
 
@@ -50,6 +52,14 @@ protected:
 	virtual bool Open2(std::string fileName) = 0;
 	/// AsyncFileReader close but ThreadedFileReader needs prep work first
 	virtual void Close2(void) = 0;
+	/// Prepare independent decompression state for `count` readahead workers
+	/// Returns the number of workers that can be used, 0 keeps all decompression on the read thread
+	virtual u32 OpenWorkers(u32 count) { return 0; }
+	/// Release everything allocated by OpenWorkers
+	virtual void CloseWorkers(void) {}
+	/// Like ReadChunk, but using the state of readahead worker `worker`
+	/// Must be safe to call concurrently with ReadChunk and with other workers
+	virtual int ReadChunkOnWorker(void* dst, s64 chunkID, u32 worker) { return -1; }
 
 	ThreadedFileReader();
 	~ThreadedFileReader();
@@ -78,6 +88,31 @@ private:
 	Buffer m_buffer[2];
 	u32 m_nextBuffer = 0;
 
+	/// A span of consecutive chunks decompressed ahead of the read head by the worker pool
+	struct ReadaheadSlot
+	{
+		enum class State : u8
+		{
+			Empty,
+			Queued,
+			Busy, ///< Owned by the thread filling it, nobody else may touch `buf`
+			Ready,
+		};
+		Buffer buf;
+		/// Offset one past the last chunk this slot should hold
+		u64 end = 0;
+		State state = State::Empty;
+	};
+	/// Readahead window, slot states are guarded by `m_mtx`
+	std::unique_ptr<ReadaheadSlot[]> m_readahead;
+	u32 m_readaheadCount = 0;
+	std::vector<std::thread> m_workers;
+	std::condition_variable m_workerCondition;
+	bool m_workersQuit = false;
+	/// Used to detect streaming access: end of the last request and how many requests in a row started there
+	u64 m_lastReadEnd = 0;
+	u32 m_sequentialReads = 0;
+
 	std::thread m_readThread;
 	std::mutex m_mtx;
 	std::condition_variable m_condition;
@@ -96,6 +131,19 @@ private:
 
 	/// Main loop of read thread
 	void Loop();
+	/// Main loop of readahead worker threads
+	void WorkerLoop(u32 worker);
+	void StartWorkers(void);
+	void StopWorkers(void);
+	/// Track sequential access and queue the next spans for the workers if the game is streaming
+	/// Call with `m_mtx` held, before the request is served
+	void UpdateReadahead(u64 offset, u32 size);
+	/// Find the non-empty readahead slot containing `offset`, requires `m_mtx`
+	ReadaheadSlot* FindReadaheadSlot(u64 offset);
+	/// Decompress the chunks of a Busy slot, `worker` < 0 uses the read thread's state
+	u32 FillReadaheadSlot(ReadaheadSlot& slot, int worker);
+	/// Publish a slot filled by FillReadaheadSlot, requires `m_mtx`
+	void FinishReadaheadSlot(ReadaheadSlot& slot, u32 size);
 
 	/// Load the given block into one of the `m_buffer` buffers if necessary and return a pointer to its contents if successful
 	Buffer* GetBlockPtr(const Chunk& block);
@@ -107,6 +155,8 @@ private:
 	/// Adjusts pointer, offset, and size if successful
 	/// Returns true if no additional reads are necessary
 	bool TryCachedRead(void*& buffer, u64& offset, u32& size, const std::lock_guard<std::mutex>&);
+	/// TryCachedRead without resetting `m_amtRead`, requires `m_mtx`
+	bool CopyFromCache(void*& buffer, u64& offset, u32& size);
 
 public:
 	bool Open(std::string fileName) final override;
@@ -375,6 +375,8 @@ struct Pcsx2Config
 			EnableEECache : 1;
 		bool
 			EnableFastmem : 1;
+		bool
+			EnableEEDecodeCache : 1; // interpreter runs pre-decoded blocks instead of fetching every instruction
 		BITFIELD_END
 
 		RecompilerOptions();
@@ -676,7 +678,8 @@ struct Pcsx2Config
 			WaitLoop : 1, // enables constant loop detection and fast-forwarding
 			vuFlagHack : 1, // microVU specific flag hack
 			vuThread : 1, // Enable Threaded VU1
-			vu1Instant : 1; // Enable Instant VU1 (Without MTVU only)
+			vu1Instant : 1, // Enable Instant VU1 (Without MTVU only)
+			ipuThread : 1; // Decode IPU commands on a separate thread
 		BITFIELD_END
 
 		s8 EECycleRate; // EE cycle rate selector (1.0, 1.5, 2.0)
@@ -796,6 +799,8 @@ struct Pcsx2Config
 		// when enabled uses BOOT2 injection, skipping sony bios splashes
 		UseBOOT2Injection : 1,
 		BackupSavestate : 1,
+		// keeps a ring of recent in-memory snapshots to step back to
+		EnableRewind : 1,
 		// enables simulated ejection of memory cards when loading savestates
 		McdEnableEjection : 1,
 		McdFolderAutoManage : 1,
@@ -830,6 +835,14 @@ struct Pcsx2Config
 	McdOptions Mcd[8];
 	std::string GzipIsoIndexTemplate; // for quick-access index with gzipped ISO
 
+	// Worker threads and window size (in ~128KB spans) for compressed ISO readahead, 0 disables the pool
+	u32 CdvdReadaheadThreads;
+	u32 CdvdReadaheadDepth;
+	u32 GzipIsoCacheSize; // in MB, extracted chunks kept around for gzipped ISOs
+
+	u32 RewindFrequency; // frames between rewind snapshots
+	u32 RewindBufferSize; // in MB, compressed snapshots kept for rewinding
+
 	// Set at runtime, not loaded from config.
 	std::string CurrentBlockdump;
 	std::string CurrentIRX;
@@ -989,6 +1002,8 @@ struct Pcsx2Config2
                         UseDebugDevice : 1,
                         UseBlitSwapChain : 1,
                         DisableShaderCache : 1,
+                        PrecompileShaders : 1,
+                        AsyncShaderCompile : 1,
                         DisableDualSourceBlend : 1,
                         DisableFramebufferFetch : 1,
                         ThreadedPresentation : 1,
@@ -1005,6 +1020,7 @@ struct Pcsx2Config2
                 bool
                         HWDisableReadbacks : 1,
                         HWSpinCPUForReadbacks : 1,
+                        HWDeferReadbacks : 1,
                         AccurateDATE : 1,
                         GPUPaletteConversion : 1,
                         ConservativeFramebuffer : 1,
@@ -1604,8 +1620,10 @@ namespace EmuFolders
 
 #define THREAD_VU1 (EmuConfig.Cpu.Recompiler.EnableVU1 && EmuConfig.Speedhacks.vuThread)
 #define INSTANT_VU1 (EmuConfig.Speedhacks.vu1Instant)
+#define THREAD_IPU (EmuConfig.Speedhacks.ipuThread)
 #define CHECK_EEREC (EmuConfig.Cpu.Recompiler.EnableEE)
 #define CHECK_CACHE (EmuConfig.Cpu.Recompiler.EnableEECache)
+#define CHECK_EEDECODECACHE (EmuConfig.Cpu.Recompiler.EnableEEDecodeCache)
 #define CHECK_IOPREC (EmuConfig.Cpu.Recompiler.EnableIOP)
 
 #ifdef _M_ARM64
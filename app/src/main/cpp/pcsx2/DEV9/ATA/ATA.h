@@ -21,9 +21,9 @@
 #include <mutex>
 #include <condition_variable>
 #include <ghc/filesystem.h>
-#include <fstream>
 
 #include "DEV9/SimpleQueue.h"
+#include "HddImage.h"
 
 class ATA
 {
@@ -35,7 +35,7 @@ public:
 private:
 	const bool lba48Supported = false;
 
-	std::fstream hddImage;
+	HddImage hddImage;
 	u64 hddImageSize;
 
 	int pioMode;
@@ -117,6 +117,7 @@ private:
 
 	std::condition_variable ioThreadIdle_cv;
 	bool ioThreadIdle_bool = false;
+	bool ioSyncRead = false; //HDD_ReadSync is reading the image, don't Sync() it
 
 	std::condition_variable ioReady;
 	std::atomic_bool ioClose{false};
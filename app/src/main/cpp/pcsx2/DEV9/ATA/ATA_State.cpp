@@ -44,11 +44,14 @@ int ATA::Open(ghc::filesystem::path hddPath)
 		if (hddCreator.errored)
 			return -1;
 	}
-	hddImage = ghc::filesystem::fstream(hddPath, std::ios::in | std::ios::out | std::ios::binary);
+	if (!hddImage.Open(hddPath))
+	{
+		Console.Error("DEV9: ATA: Failed to open HDD image %s", hddPath.u8string().c_str());
+		return -1;
+	}
 
 	//Store HddImage size for later check
-	hddImage.seekg(0, std::ios::end);
-	hddImageSize = hddImage.tellg();
+	hddImageSize = hddImage.GetSize();
 
 	{
 		std::lock_guard ioSignallock(ioMutex);
@@ -88,9 +91,8 @@ void ATA::Close()
 		abort(); //All data must be written at this point
 	}
 
-	//Close File Handle
-	if (hddImage.is_open())
-		hddImage.close();
+	//Close File Handle, syncs outstanding writes
+	hddImage.Close();
 
 	delete[] readBuffer;
 	readBuffer = nullptr;
@@ -291,7 +293,7 @@ void ATA::Write16(u32 addr, u16 value)
 
 void ATA::Async(uint cycles)
 {
-	if (!hddImage.is_open())
+	if (!hddImage.IsOpen())
 		return;
 
 	if ((regStatus & (ATA_STAT_BUSY | ATA_STAT_DRQ)) == 0 ||
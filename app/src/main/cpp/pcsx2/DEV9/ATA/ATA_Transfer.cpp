@@ -30,7 +30,27 @@ void ATA::IO_Thread()
 		ioThreadIdle_bool = true;
 		ioThreadIdle_cv.notify_all();
 
-		ioReady.wait(ioWaitHandle, [&] { return ioRead | ioWrite; });
+		if (hddImage.IsDirty())
+		{
+			//Sync once writes have been quiet for a while
+			if (!ioReady.wait_for(ioWaitHandle, HddImage::SyncInterval, [&] { return ioRead | ioWrite; }))
+			{
+				//Not while HDD_ReadSync is reading the image, retry after another interval
+				if (ioSyncRead)
+				{
+					ioWaitHandle.unlock();
+					continue;
+				}
+				//Not idle while syncing, so HDD_ReadSync waits for us
+				//The top of the loop flags idle again and notifies
+				ioThreadIdle_bool = false;
+				ioWaitHandle.unlock();
+				hddImage.Sync();
+				continue;
+			}
+		}
+		else
+			ioReady.wait(ioWaitHandle, [&] { return ioRead | ioWrite; });
 		ioThreadIdle_bool = false;
 
 		int ioType = -1;
@@ -75,8 +95,7 @@ void ATA::IO_Read()
 	}
 
 	const u64 pos = lba * 512;
-	hddImage.seekg(pos, std::ios::beg);
-	if (hddImage.fail())
+	if (!hddImage.Read(pos, readBuffer, (u32)nsector * 512))
 	{
 #ifdef PCSX2_DEBUG
 		Console.Error("DEV9: ATA: File read error");
@@ -84,7 +103,6 @@ void ATA::IO_Read()
 		pxAssert(false);
 		abort();
 	}
-	hddImage.read((char*)readBuffer, (u64)nsector * 512);
 	{
 		std::lock_guard ioSignallock(ioMutex);
 		ioRead = false;
@@ -93,17 +111,29 @@ void ATA::IO_Read()
 
 bool ATA::IO_Write()
 {
-	WriteQueueEntry entry;
-	if (!writeQueue.Dequeue(&entry))
+	WriteQueueEntry entries[HddImage::MaxWriteBuffers];
+	if (!writeQueue.Dequeue(&entries[0]))
 	{
 		std::lock_guard ioSignallock(ioMutex);
 		ioWrite = false;
 		return false;
 	}
 
-	hddImage.seekp(entry.sector * 512, std::ios::beg);
-	hddImage.write((char*)entry.data, entry.length);
-	if (hddImage.fail())
+	//Merge queued writes that continue where the previous one ended
+	HddImage::WriteBuffer buffers[HddImage::MaxWriteBuffers];
+	buffers[0] = {entries[0].data, entries[0].length};
+	u64 nextSector = entries[0].sector + entries[0].length / 512;
+	u32 count = 1;
+	while (count < HddImage::MaxWriteBuffers &&
+		   writeQueue.Peek(&entries[count]) && entries[count].sector == nextSector)
+	{
+		writeQueue.Dequeue(&entries[count]);
+		buffers[count] = {entries[count].data, entries[count].length};
+		nextSector += entries[count].length / 512;
+		count++;
+	}
+
+	if (!hddImage.Write(entries[0].sector * 512, buffers, count))
 	{
 #ifdef PCSX2_DEBUG
 		Console.Error("DEV9: ATA: File write error");
@@ -111,8 +141,11 @@ bool ATA::IO_Write()
 		pxAssert(false);
 		abort();
 	}
-	hddImage.flush();
-	delete[] entry.data;
+	//Long write bursts still get synced periodically
+	hddImage.SyncIfDue();
+
+	for (u32 i = 0; i < count; i++)
+		delete[] entries[i].data;
 	return true;
 }
 
@@ -151,19 +184,21 @@ void ATA::HDD_ReadSync(void (ATA::*drqCMD)())
 
 	//wait until thread waiting
 	ioThreadIdle_cv.wait(ioWaitHandle, [&] { return ioThreadIdle_bool; });
+	//Keep the thread from syncing the image while we read it
+	ioSyncRead = true;
 	ioWaitHandle.unlock();
 
 	nsectorLeft = 0;
 
 	if (!HDD_CanAssessOrSetError())
 	{
+		ioWaitHandle.lock();
+		ioSyncRead = false;
 		if (ioWritePaused)
-		{
-			ioWaitHandle.lock();
 			ioWrite = true;
-			ioWaitHandle.unlock();
+		ioWaitHandle.unlock();
+		if (ioWritePaused)
 			ioReady.notify_all();
-		}
 		return;
 	}
 
@@ -177,13 +212,13 @@ void ATA::HDD_ReadSync(void (ATA::*drqCMD)())
 
 	IO_Read();
 
+	ioWaitHandle.lock();
+	ioSyncRead = false;
 	if (ioWritePaused)
-	{
-		ioWaitHandle.lock();
 		ioWrite = true;
-		ioWaitHandle.unlock();
+	ioWaitHandle.unlock();
+	if (ioWritePaused)
 		ioReady.notify_all();
-	}
 
 	(this->*drqCMD)();
 }
@@ -15,8 +15,8 @@
 
 #include "PrecompiledHeader.h"
 
-#include <fstream>
 #include "HddCreate.h"
+#include "HddImage.h"
 
 void HddCreate::Start()
 {
@@ -80,70 +80,22 @@ void HddCreate::Start()
 
 void HddCreate::WriteImage(ghc::filesystem::path hddPath, int reqSizeMiB)
 {
-	constexpr int buffsize = 4 * 1024;
-	u8 buff[buffsize] = {0}; //4kb
-
 	if (ghc::filesystem::exists(hddPath))
 	{
 		SetError();
 		return;
 	}
 
-	std::fstream newImage = ghc::filesystem::fstream(hddPath, std::ios::out | std::ios::binary);
-
-	if (newImage.fail())
-	{
-		SetError();
-		return;
-	}
-
-	//Size file
-	newImage.seekp(((u64)reqSizeMiB) * 1024 * 1024 - 1, std::ios::beg);
-	const char zero = 0;
-	newImage.write(&zero, 1);
-
-	if (newImage.fail())
+	//The image starts out zeroed, which a sparse file gives us without writing anything
+	if (!HddImage::Create(hddPath, ((u64)reqSizeMiB) * 1024 * 1024))
 	{
-		newImage.close();
-		ghc::filesystem::remove(filePath);
+		std::error_code ec;
+		ghc::filesystem::remove(hddPath, ec);
 		SetError();
 		return;
 	}
 
-	lastUpdate = std::chrono::steady_clock::now();
-
-	newImage.seekp(0, std::ios::beg);
-
-	for (int iMiB = 0; iMiB < reqSizeMiB; ++iMiB)
-	{
-		for (int i4kb = 0; i4kb < 256; ++i4kb)
-		{
-			newImage.write((char*)buff, buffsize);
-			if (newImage.fail())
-			{
-				newImage.close();
-				ghc::filesystem::remove(filePath);
-				SetError();
-				return;
-			}
-		}
-
-		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
-		if (std::chrono::duration_cast<std::chrono::milliseconds>(now - lastUpdate).count() >= 100 || (iMiB + 1) == neededSize)
-		{
-			lastUpdate = now;
-			SetFileProgress(iMiB + 1);
-		}
-		if (canceled.load())
-		{
-			newImage.close();
-			ghc::filesystem::remove(filePath);
-			SetError();
-			return;
-		}
-	}
-	newImage.flush();
-	newImage.close();
+	SetFileProgress(reqSizeMiB);
 }
 
 void HddCreate::SetFileProgress(int currentSize)
@@ -48,8 +48,6 @@ private:
 	std::condition_variable completedCV;
 	bool completed = false;
 
-	std::chrono::steady_clock::time_point lastUpdate;
-
 public:
 	void Start();
 
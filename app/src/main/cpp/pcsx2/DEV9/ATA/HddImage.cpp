@@ -0,0 +1,304 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include "common/RedtapeWindows.h"
+#include <winioctl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "common/FileSystem.h"
+#include "HddImage.h"
+
+HddImage::~HddImage()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool HddImage::Create(const ghc::filesystem::path& path, u64 size)
+{
+	const HANDLE handle = CreateFileW(path.wstring().c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	//Mark the file sparse before extending it, otherwise NTFS allocates the whole size
+	//Not all file systems support sparse files, extending still works on those
+	DWORD bytesReturned = 0;
+	DeviceIoControl(handle, FSCTL_SET_SPARSE, nullptr, 0, nullptr, 0, &bytesReturned, nullptr);
+
+	LARGE_INTEGER end;
+	end.QuadPart = static_cast<LONGLONG>(size);
+	const bool ok = SetFilePointerEx(handle, end, nullptr, FILE_BEGIN) && SetEndOfFile(handle);
+	CloseHandle(handle);
+	return ok;
+}
+
+bool HddImage::Open(const ghc::filesystem::path& path)
+{
+	Close();
+
+	file = FileSystem::OpenCFile(path.u8string().c_str(), "r+b");
+	if (file == nullptr)
+		return false;
+
+	size = FileSystem::FSize64(file);
+	return true;
+}
+
+void HddImage::Close()
+{
+	if (file == nullptr)
+		return;
+
+	Sync();
+	std::fclose(file);
+	file = nullptr;
+	size = 0;
+	readaheadLength = 0;
+	lastReadEnd = ~0ULL;
+}
+
+bool HddImage::IsOpen() const
+{
+	return file != nullptr;
+}
+
+bool HddImage::ReadDirect(u64 offset, u8* data, u32 length)
+{
+	return FileSystem::FSeek64(file, offset, SEEK_SET) == 0 &&
+		   std::fread(data, 1, length, file) == length;
+}
+
+bool HddImage::Write(u64 offset, const WriteBuffer* buffers, u32 count)
+{
+	if (FileSystem::FSeek64(file, offset, SEEK_SET) != 0)
+		return false;
+
+	u64 total = 0;
+	for (u32 i = 0; i < count; i++)
+	{
+		if (std::fwrite(buffers[i].data, 1, buffers[i].length, file) != buffers[i].length)
+			return false;
+		total += buffers[i].length;
+	}
+
+	InvalidateReadahead(offset, total);
+	if (!dirty)
+	{
+		dirty = true;
+		dirtySince = std::chrono::steady_clock::now();
+	}
+	return true;
+}
+
+bool HddImage::Sync()
+{
+	if (!dirty)
+		return true;
+
+	dirty = false;
+	return std::fflush(file) == 0 && _commit(_fileno(file)) == 0;
+}
+
+#else
+
+bool HddImage::Create(const ghc::filesystem::path& path, u64 size)
+{
+	const int newFd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+	if (newFd < 0)
+		return false;
+
+	//Extending with ftruncate leaves a hole, blocks get allocated as they are written
+	const bool ok = ftruncate(newFd, static_cast<off_t>(size)) == 0 && fsync(newFd) == 0;
+	close(newFd);
+	return ok;
+}
+
+bool HddImage::Open(const ghc::filesystem::path& path)
+{
+	Close();
+
+	fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		close(fd);
+		fd = -1;
+		return false;
+	}
+	size = static_cast<u64>(st.st_size);
+
+#ifdef POSIX_FADV_SEQUENTIAL
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+	return true;
+}
+
+void HddImage::Close()
+{
+	if (fd < 0)
+		return;
+
+	Sync();
+	close(fd);
+	fd = -1;
+	size = 0;
+	readaheadLength = 0;
+	lastReadEnd = ~0ULL;
+}
+
+bool HddImage::IsOpen() const
+{
+	return fd >= 0;
+}
+
+bool HddImage::ReadDirect(u64 offset, u8* data, u32 length)
+{
+	while (length > 0)
+	{
+		const ssize_t ret = pread(fd, data, length, static_cast<off_t>(offset));
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
+
+		data += ret;
+		offset += ret;
+		length -= static_cast<u32>(ret);
+	}
+	return true;
+}
+
+bool HddImage::Write(u64 offset, const WriteBuffer* buffers, u32 count)
+{
+	pxAssert(count <= MaxWriteBuffers);
+
+	iovec iov[MaxWriteBuffers];
+	u64 total = 0;
+	for (u32 i = 0; i < count; i++)
+	{
+		iov[i].iov_base = const_cast<u8*>(buffers[i].data);
+		iov[i].iov_len = buffers[i].length;
+		total += buffers[i].length;
+	}
+
+	//Mark dirty first, even a partial write needs syncing
+	if (!dirty)
+	{
+		dirty = true;
+		dirtySince = std::chrono::steady_clock::now();
+	}
+	InvalidateReadahead(offset, total);
+
+	iovec* cur = iov;
+	int left = static_cast<int>(count);
+	u64 pos = offset;
+	while (left > 0)
+	{
+		ssize_t ret = pwritev(fd, cur, left, static_cast<off_t>(pos));
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
+
+		//Short write, skip what made it
+		pos += ret;
+		while (left > 0 && static_cast<size_t>(ret) >= cur->iov_len)
+		{
+			ret -= cur->iov_len;
+			cur++;
+			left--;
+		}
+		if (left > 0)
+		{
+			cur->iov_base = static_cast<u8*>(cur->iov_base) + ret;
+			cur->iov_len -= ret;
+		}
+	}
+	return true;
+}
+
+bool HddImage::Sync()
+{
+	if (!dirty)
+		return true;
+
+	dirty = false;
+	return fdatasync(fd) == 0;
+}
+
+#endif
+
+bool HddImage::Read(u64 offset, u8* data, u32 length)
+{
+	//Already buffered
+	if (offset >= readaheadOffset && offset + length <= readaheadOffset + readaheadLength)
+	{
+		std::memcpy(data, &readahead[offset - readaheadOffset], length);
+		lastReadEnd = offset + length;
+		return true;
+	}
+
+	//Only read ahead once the guest streams, random access goes straight to the file
+	const bool sequential = offset == lastReadEnd;
+	lastReadEnd = offset + length;
+	if (!sequential || length >= ReadaheadSize || offset >= size)
+		return ReadDirect(offset, data, length);
+
+	const u32 fill = static_cast<u32>(std::min<u64>(ReadaheadSize, size - offset));
+	if (fill < length)
+		return ReadDirect(offset, data, length);
+
+	readahead.resize(ReadaheadSize);
+	if (!ReadDirect(offset, readahead.data(), fill))
+	{
+		readaheadLength = 0;
+		return false;
+	}
+
+	readaheadOffset = offset;
+	readaheadLength = fill;
+	std::memcpy(data, readahead.data(), length);
+	return true;
+}
+
+void HddImage::InvalidateReadahead(u64 offset, u64 length)
+{
+	if (offset < readaheadOffset + readaheadLength && readaheadOffset < offset + length)
+		readaheadLength = 0;
+}
+
+bool HddImage::SyncIfDue()
+{
+	if (!dirty || std::chrono::steady_clock::now() - dirtySince < SyncInterval)
+		return true;
+
+	return Sync();
+}
@@ -0,0 +1,88 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "ghc/filesystem.h"
+
+//Block level access to the HDD image file
+//Reads and writes are positional, so the file has no shared seek state.
+//Not thread safe, ATA makes sure the EE and IO threads never access it at the same time.
+class HddImage
+{
+public:
+	struct WriteBuffer
+	{
+		const u8* data;
+		u32 length;
+	};
+
+	//Maximum number of buffers passed to one Write() call
+	static constexpr u32 MaxWriteBuffers = 64;
+
+	HddImage() = default;
+	~HddImage();
+
+	HddImage(const HddImage&) = delete;
+	HddImage& operator=(const HddImage&) = delete;
+
+	//Creates a zero filled image without writing it out
+	//The file is sparse where the filesystem allows it
+	static bool Create(const ghc::filesystem::path& path, u64 size);
+
+	bool Open(const ghc::filesystem::path& path);
+	//Syncs any pending writes
+	void Close();
+
+	bool IsOpen() const;
+	u64 GetSize() const { return size; }
+
+	bool Read(u64 offset, u8* data, u32 length);
+	//Writes the buffers back to back starting at offset
+	bool Write(u64 offset, const WriteBuffer* buffers, u32 count);
+
+	//Flushes written data to disk if anything was written since the last sync
+	bool Sync();
+	//Syncs when data has been dirty for longer than SyncInterval
+	bool SyncIfDue();
+
+	bool IsDirty() const { return dirty; }
+
+	static constexpr std::chrono::milliseconds SyncInterval{1000};
+
+private:
+	bool ReadDirect(u64 offset, u8* data, u32 length);
+	void InvalidateReadahead(u64 offset, u64 length);
+
+#ifdef _WIN32
+	std::FILE* file = nullptr;
+#else
+	int fd = -1;
+#endif
+	u64 size = 0;
+
+	bool dirty = false;
+	std::chrono::steady_clock::time_point dirtySince;
+
+	//Sequential reads get served from a larger read
+	static constexpr u32 ReadaheadSize = 256 * 1024;
+	std::vector<u8> readahead;
+	u64 readaheadOffset = 0;
+	u32 readaheadLength = 0;
+	u64 lastReadEnd = ~0ULL;
+};
@@ -17,17 +17,20 @@
 #include "Breakpoints.h"
 #include "SymbolMap.h"
 #include "MIPSAnalyst.h"
+#include <algorithm>
 #include <cstdio>
 #include "R5900.h"
 #include "System.h"
 
 std::vector<BreakPoint> CBreakPoints::breakPoints_;
+CBreakPoints::BreakPointIndex CBreakPoints::breakPointIndex_[2];
 u32 CBreakPoints::breakSkipFirstAtEE_ = 0;
 u64 CBreakPoints::breakSkipFirstTicksEE_ = 0;
 u32 CBreakPoints::breakSkipFirstAtIop_ = 0;
 u64 CBreakPoints::breakSkipFirstTicksIop_ = 0;
 std::vector<MemCheck> CBreakPoints::memChecks_;
 std::vector<MemCheck *> CBreakPoints::cleanupMemChecks_;
+CBreakPoints::MemCheckIndex CBreakPoints::memCheckIndex_[2];
 bool CBreakPoints::breakpointTriggered_ = false;
 
 // called from the dynarec
@@ -61,6 +64,7 @@ MemCheck::MemCheck()
 
 void MemCheck::Log(u32 addr, bool write, int size, u32 pc)
 {
+	Console.WriteLn("Memcheck: %s of %d bytes at 0x%08x (pc 0x%08x)", write ? "write" : "read", size, addr, pc);
 }
 
 void MemCheck::Action(u32 addr, bool write, int size, u32 pc)
@@ -70,7 +74,8 @@ void MemCheck::Action(u32 addr, bool write, int size, u32 pc)
 	{
 		++numHits;
 
-		Log(addr, write, size, pc);
+		if (result & MEMCHECK_LOG)
+			Log(addr, write, size, pc);
 		if (result & MEMCHECK_BREAK)
 		{
 		//	Core_EnableStepping(true);
@@ -122,40 +127,164 @@ void MemCheck::JitCleanup()
 		host->SetDebugMode(true);*/
 }
 
-size_t CBreakPoints::FindBreakpoint(BreakPointCpu cpu, u32 addr, bool matchTemp, bool temp)
+static u32 standardizeAddress(BreakPointCpu cpu, u32 addr)
 {
-	if (cpu == BREAKPOINT_EE)
-		addr = standardizeBreakpointAddress(addr);
+	return cpu == BREAKPOINT_EE ? standardizeBreakpointAddress(addr) : addr;
+}
+
+static bool testPageBit(const std::vector<u64>& pages, u32 addr)
+{
+	const u32 page = addr >> 12;
+	return (pages[page >> 6] >> (page & 63)) & 1;
+}
+
+void CBreakPoints::RebuildBreakPointIndex()
+{
+	for (BreakPointIndex& index : breakPointIndex_)
+		index.entries.clear();
 
 	for (size_t i = 0; i < breakPoints_.size(); ++i)
 	{
-		u32 cmp = cpu == BREAKPOINT_EE ? standardizeBreakpointAddress(breakPoints_[i].addr) : breakPoints_[i].addr;
-		if (cpu == breakPoints_[i].cpu && cmp == addr && (!matchTemp || breakPoints_[i].temporary == temp))
-			return i;
+		const BreakPointCpu cpu = breakPoints_[i].cpu;
+		if (cpu == BREAKPOINT_EE || cpu == BREAKPOINT_IOP)
+			breakPointIndex_[IndexOf(cpu)].entries.push_back({standardizeAddress(cpu, breakPoints_[i].addr), i});
 	}
 
-	return INVALID_BREAKPOINT;
+	// stable, so duplicates keep their order in breakPoints_ like the old linear search
+	for (BreakPointIndex& index : breakPointIndex_)
+	{
+		std::stable_sort(index.entries.begin(), index.entries.end(),
+			[](const BreakPointIndex::Entry& a, const BreakPointIndex::Entry& b) { return a.addr < b.addr; });
+	}
 }
 
-size_t CBreakPoints::FindMemCheck(BreakPointCpu cpu, u32 start, u32 end)
+void CBreakPoints::RebuildMemCheckIndex()
 {
-	if (cpu == BREAKPOINT_EE)
+	for (MemCheckIndex& index : memCheckIndex_)
 	{
-		start = standardizeBreakpointAddress(start);
-		end = standardizeBreakpointAddress(end);
+		index.ranges.clear();
+		index.maxEnd.clear();
+		index.pages.clear();
 	}
 
 	for (size_t i = 0; i < memChecks_.size(); ++i)
 	{
-		u32 cmpStart = cpu == BREAKPOINT_EE ? standardizeBreakpointAddress(memChecks_[i].start) : memChecks_[i].start;
-		u32 cmpEnd = cpu == BREAKPOINT_EE ? standardizeBreakpointAddress(memChecks_[i].end) : memChecks_[i].end;
-		if (memChecks_[i].cpu == cpu && cmpStart == start && cmpEnd == end)
-			return i;
+		const BreakPointCpu cpu = memChecks_[i].cpu;
+		if (cpu == BREAKPOINT_EE || cpu == BREAKPOINT_IOP)
+			memCheckIndex_[IndexOf(cpu)].ranges.push_back({standardizeAddress(cpu, memChecks_[i].start), standardizeAddress(cpu, memChecks_[i].end), i});
+	}
+
+	for (MemCheckIndex& index : memCheckIndex_)
+	{
+		if (index.ranges.empty())
+			continue;
+
+		std::stable_sort(index.ranges.begin(), index.ranges.end(),
+			[](const MemCheckIndex::Range& a, const MemCheckIndex::Range& b) { return a.start < b.start; });
+
+		index.pages.resize((0x100000000ULL >> 12) / 64);
+		u32 maxEnd = 0;
+		for (const MemCheckIndex::Range& range : index.ranges)
+		{
+			maxEnd = std::max(maxEnd, range.end);
+			index.maxEnd.push_back(maxEnd);
+
+			// an end of 0 never matches, see CheckMemAccess()
+			if (range.end == 0)
+				continue;
+
+			const u32 firstPage = std::min(range.start, range.end - 1) >> 12;
+			const u32 lastPage = std::max(range.start, range.end - 1) >> 12;
+			for (u32 page = firstPage; page <= lastPage; ++page)
+				index.pages[page >> 6] |= 1ULL << (page & 63);
+		}
+	}
+}
+
+size_t CBreakPoints::FindBreakpoint(BreakPointCpu cpu, u32 addr, bool matchTemp, bool temp)
+{
+	if (cpu != BREAKPOINT_EE && cpu != BREAKPOINT_IOP)
+		return INVALID_BREAKPOINT;
+
+	addr = standardizeAddress(cpu, addr);
+
+	const std::vector<BreakPointIndex::Entry>& entries = breakPointIndex_[IndexOf(cpu)].entries;
+	auto it = std::lower_bound(entries.begin(), entries.end(), addr,
+		[](const BreakPointIndex::Entry& entry, u32 value) { return entry.addr < value; });
+	for (; it != entries.end() && it->addr == addr; ++it)
+	{
+		if (!matchTemp || breakPoints_[it->bp].temporary == temp)
+			return it->bp;
+	}
+
+	return INVALID_BREAKPOINT;
+}
+
+size_t CBreakPoints::FindMemCheck(BreakPointCpu cpu, u32 start, u32 end)
+{
+	if (cpu != BREAKPOINT_EE && cpu != BREAKPOINT_IOP)
+		return INVALID_MEMCHECK;
+
+	start = standardizeAddress(cpu, start);
+	end = standardizeAddress(cpu, end);
+
+	const std::vector<MemCheckIndex::Range>& ranges = memCheckIndex_[IndexOf(cpu)].ranges;
+	auto it = std::lower_bound(ranges.begin(), ranges.end(), start,
+		[](const MemCheckIndex::Range& range, u32 value) { return range.start < value; });
+	for (; it != ranges.end() && it->start == start; ++it)
+	{
+		if (it->end == end)
+			return it->mc;
 	}
 
 	return INVALID_MEMCHECK;
 }
 
+bool CBreakPoints::IsMemCheckPage(BreakPointCpu cpu, u32 addr)
+{
+	const MemCheckIndex& index = memCheckIndex_[IndexOf(cpu)];
+	return !index.pages.empty() && testPageBit(index.pages, standardizeAddress(cpu, addr));
+}
+
+bool CBreakPoints::CheckMemAccess(BreakPointCpu cpu, u32 addr, u32 size, bool write, u32 pc)
+{
+	const MemCheckIndex& index = memCheckIndex_[IndexOf(cpu)];
+	if (index.ranges.empty())
+		return false;
+
+	const u32 start = standardizeAddress(cpu, addr);
+	const u32 end = start + size;
+	if (!testPageBit(index.pages, start) && !testPageBit(index.pages, end - 1))
+		return false;
+
+	// Resuming from a break at this access, its actions already ran when it broke
+	if (CheckSkipFirst(cpu, pc) != 0)
+		return false;
+
+	// Every range starting before end is a candidate. Walk them backwards until no earlier
+	// range can reach start anymore.
+	const auto first_after = std::lower_bound(index.ranges.begin(), index.ranges.end(), end,
+		[](const MemCheckIndex::Range& range, u32 value) { return range.start < value; });
+
+	const int mask = write ? MEMCHECK_WRITE : MEMCHECK_READ;
+	bool triggered = false;
+	for (size_t i = first_after - index.ranges.begin(); i-- > 0 && index.maxEnd[i] > start;)
+	{
+		if (index.ranges[i].end <= start)
+			continue;
+
+		MemCheck& check = memChecks_[index.ranges[i].mc];
+		if (check.result == 0 || (check.cond & mask) == 0)
+			continue;
+
+		check.Action(addr, write, size, pc);
+		if (check.result & MEMCHECK_BREAK)
+			triggered = true;
+	}
+
+	return triggered;
+}
+
 bool CBreakPoints::IsAddressBreakPoint(BreakPointCpu cpu, u32 addr)
 {
 	size_t bp = FindBreakpoint(cpu, addr);
@@ -192,6 +321,7 @@ void CBreakPoints::AddBreakPoint(BreakPointCpu cpu, u32 addr, bool temp)
 		pt.cpu = cpu;
 
 		breakPoints_.push_back(pt);
+		RebuildBreakPointIndex();
 		Update(cpu, addr);
 	}
 	else if (!breakPoints_[bp].enabled)
@@ -208,11 +338,15 @@ void CBreakPoints::RemoveBreakPoint(BreakPointCpu cpu, u32 addr)
 	if (bp != INVALID_BREAKPOINT)
 	{
 		breakPoints_.erase(breakPoints_.begin() + bp);
+		RebuildBreakPointIndex();
 
 		// Check again, there might've been an overlapping temp breakpoint.
 		bp = FindBreakpoint(cpu, addr);
 		if (bp != INVALID_BREAKPOINT)
+		{
 			breakPoints_.erase(breakPoints_.begin() + bp);
+			RebuildBreakPointIndex();
+		}
 
 		Update(cpu, addr);
 	}
@@ -233,6 +367,7 @@ void CBreakPoints::ClearAllBreakPoints()
 	if (!breakPoints_.empty())
 	{
 		breakPoints_.clear();
+		RebuildBreakPointIndex();
 		Update();
 	}
 }
@@ -250,6 +385,7 @@ void CBreakPoints::ClearTemporaryBreakPoints()
 			breakPoints_.erase(breakPoints_.begin() + i);
 		}
 	}
+	RebuildBreakPointIndex();
 }
 
 void CBreakPoints::ChangeBreakPointAddCond(BreakPointCpu cpu, u32 addr, const BreakPointCond &cond)
@@ -302,6 +438,7 @@ void CBreakPoints::AddMemCheck(BreakPointCpu cpu, u32 start, u32 end, MemCheckCo
 		check.cpu = cpu;
 
 		memChecks_.push_back(check);
+		RebuildMemCheckIndex();
 		Update(cpu);
 	}
 	else
@@ -321,6 +458,7 @@ void CBreakPoints::RemoveMemCheck(BreakPointCpu cpu, u32 start, u32 end)
 	if (mc != INVALID_MEMCHECK)
 	{
 		memChecks_.erase(memChecks_.begin() + mc);
+		RebuildMemCheckIndex();
 		Update(cpu);
 	}
 }
@@ -344,6 +482,7 @@ void CBreakPoints::ClearAllMemChecks()
 	if (!memChecks_.empty())
 	{
 		memChecks_.clear();
+		RebuildMemCheckIndex();
 		Update();
 	}
 }
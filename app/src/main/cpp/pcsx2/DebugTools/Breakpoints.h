@@ -109,7 +109,7 @@ struct MemCheck
 
 // BreakPoints cannot overlap, only one is allowed per address.
 // MemChecks can overlap, as long as their ends are different.
-// WARNING: MemChecks are not used in the interpreter or HLE currently.
+// WARNING: MemChecks are only used by the EE interpreter currently.
 class CBreakPoints
 {
 public:
@@ -145,6 +145,15 @@ public:
 	static const std::vector<BreakPoint> GetBreakpoints();
 	static size_t GetNumMemchecks() { return memChecks_.size(); }
 
+	// Cheap tests for the cpu cores, false means no memcheck can match.
+	static bool HasMemChecks(BreakPointCpu cpu) { return !memCheckIndex_[IndexOf(cpu)].ranges.empty(); }
+	static bool IsMemCheckPage(BreakPointCpu cpu, u32 addr);
+
+	// Runs Action() on every memcheck overlapping [addr, addr+size).
+	// Returns true if one of them asks for a break. Does nothing for the access at pc which
+	// SetSkipFirst() resumes from, so its actions don't run twice.
+	static bool CheckMemAccess(BreakPointCpu cpu, u32 addr, u32 size, bool write, u32 pc);
+
 	static void Update(BreakPointCpu cpu = BREAKPOINT_IOP_AND_EE, u32 addr = 0);
 
 	static void SetBreakpointTriggered(bool b) { breakpointTriggered_ = b; };
@@ -155,7 +164,37 @@ private:
 	// Finds exactly, not using a range check.
 	static size_t FindMemCheck(BreakPointCpu cpu, u32 start, u32 end);
 
+	// Lookup tables over breakPoints_ and memChecks_ (addresses already standardized),
+	// rebuilt whenever an entry is added or removed.
+	struct BreakPointIndex
+	{
+		struct Entry
+		{
+			u32 addr;
+			size_t bp;
+		};
+		std::vector<Entry> entries; // sorted by addr, then by position in breakPoints_
+	};
+
+	struct MemCheckIndex
+	{
+		struct Range
+		{
+			u32 start;
+			u32 end;
+			size_t mc;
+		};
+		std::vector<Range> ranges; // sorted by start
+		std::vector<u32> maxEnd;   // highest end of ranges[0..i], bounds the backwards scan
+		std::vector<u64> pages;    // one bit per 4KB page touched by any range
+	};
+
+	static int IndexOf(BreakPointCpu cpu) { return cpu == BREAKPOINT_IOP ? 1 : 0; }
+	static void RebuildBreakPointIndex();
+	static void RebuildMemCheckIndex();
+
 	static std::vector<BreakPoint> breakPoints_;
+	static BreakPointIndex breakPointIndex_[2];
 	static u32 breakSkipFirstAtEE_;
 	static u64 breakSkipFirstTicksEE_;
 	static u32 breakSkipFirstAtIop_;
@@ -165,6 +204,7 @@ private:
 
 	static std::vector<MemCheck> memChecks_;
 	static std::vector<MemCheck *> cleanupMemChecks_;
+	static MemCheckIndex memCheckIndex_[2];
 };
 
 
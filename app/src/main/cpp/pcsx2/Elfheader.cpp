@@ -310,12 +310,18 @@ void ElfObject::loadHeaders()
 //   1 - PS1 CD
 //   2 - PS2 CD
 int GetPS2ElfName( wxString& name )
+{
+	IsoFSCDVD isofs;
+	return GetPS2ElfName( isofs, name );
+}
+
+// Reads SYSTEM.CNF through source rather than the active CDVD source.
+int GetPS2ElfName( SectorSource& source, wxString& name )
 {
 	int retype = 0;
 
 	try {
-		IsoFSCDVD isofs;
-		IsoFile file( isofs, L"SYSTEM.CNF;1");
+		IsoFile file( source, L"SYSTEM.CNF;1");
 
 		int size = file.getLength();
 		if( size == 0 ) return 0;
@@ -162,6 +162,7 @@ class ElfObject
 //-------------------
 extern void loadElfFile(const wxString& filename);
 extern int  GetPS2ElfName( wxString& dest );
+extern int  GetPS2ElfName( SectorSource& source, wxString& dest );
 
 
 extern u32 ElfCRC;
@@ -21,18 +21,24 @@
 #include "common/Console.h"
 #include "common/FileSystem.h"
 #include "common/Path.h"
+#include "common/PersistentThread.h"
 #include "common/ProgressCallback.h"
 #include "common/StringUtil.h"
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cctype>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
 #include <ctime>
 #include <fstream>
 #include <string_view>
+#include <thread>
 #include <utility>
 
 #include "CDVD/CDVD.h"
+#include "CDVD/IsoFileFormats.h"
 #include "Elfheader.h"
 #include "VMManager.h"
 
@@ -55,12 +61,16 @@ namespace GameList
 	static void ScanDirectory(const char* path, bool recursive, const std::vector<std::string>& excluded_paths,
 		ProgressCallback* progress);
 	static bool AddFileFromCache(const std::string& path, std::time_t timestamp);
-	static bool ScanFile(std::string path, std::time_t timestamp);
+	static void ScanFiles(const std::vector<FILESYSTEM_FIND_DATA*>& files, ProgressCallback* progress);
+	static bool ScanFile(const std::string& path, std::time_t timestamp, Entry* entry);
+	static void AddScannedEntries(std::vector<Entry>& entries);
+	static u32 GetScanThreadCount(size_t file_count);
 
 	static void LoadCache();
 	static bool LoadEntriesFromCache(std::FILE* stream);
 	static bool OpenCacheForWriting();
 	static bool WriteEntryToCache(const GameList::Entry* entry);
+	static bool FlushCacheFileStream();
 	static void CloseCacheFileStream();
 	static void DeleteCacheFile();
 
@@ -182,47 +192,45 @@ bool GameList::GetIsoListEntry(const std::string& path, GameList::Entry* entry)
 	if (!FileSystem::StatFile(path.c_str(), &sd))
 		return false;
 
-	// This isn't great, we really want to make it all thread-local...
-	CDVD = &CDVDapi_Iso;
-	if (CDVD->open(path.c_str()) != 0)
-		return false;
-
-	const s32 type = DoCDVDdetectDiskType();
-	switch (type)
+	// Read the image directly rather than through the CDVD plugin and its globals,
+	// so this can run on the scan threads.
+	InputIsoFile iso;
+	try
 	{
-		case CDVD_TYPE_PSCD:
-		case CDVD_TYPE_PSCDDA:
-			entry->type = EntryType::PS1Disc;
-			break;
+		iso.Open(path);
 
-		case CDVD_TYPE_PS2CD:
-		case CDVD_TYPE_PS2CDDA:
-		case CDVD_TYPE_PS2DVD:
-			entry->type = EntryType::PS2Disc;
-			break;
+		IsoFSInputIso isofs(iso);
+		const s32 type = CheckDiskTypeFS(isofs, (iso.GetType() == ISOTYPE_DVD) ? CDVD_TYPE_DETCTDVDS : CDVD_TYPE_DETCTCD);
+		switch (type)
+		{
+			case CDVD_TYPE_PSCD:
+			case CDVD_TYPE_PSCDDA:
+				entry->type = EntryType::PS1Disc;
+				break;
 
-		case CDVD_TYPE_ILLEGAL:
-		default:
-			DoCDVDclose();
-			return false;
-	}
+			case CDVD_TYPE_PS2CD:
+			case CDVD_TYPE_PS2CDDA:
+			case CDVD_TYPE_PS2DVD:
+				entry->type = EntryType::PS2Disc;
+				break;
 
-	cdvdReloadElfInfo();
+			case CDVD_TYPE_ILLEGAL:
+			default:
+				return false;
+		}
+
+		cdvdGetDiscElfInfo(isofs, &entry->serial, &entry->crc);
+	}
+	catch (Exception::BaseException& ex)
+	{
+		Console.Error(ex.FormatDiagnosticMessage());
+		return false;
+	}
 
 	entry->path = path;
-	entry->serial = DiscSerial;
-	entry->crc = ElfCRC;
 	entry->total_size = sd.Size;
 	entry->compatibility_rating = CompatibilityRating::Unknown;
 
-	DoCDVDclose();
-
-	// TODO(Stenzek): These globals are **awful**. Clean it up.
-	DiscSerial.clear();
-	ElfCRC = 0;
-	ElfEntry = -1;
-	LastELF.clear();
-
 	if (const GameDatabaseSchema::GameEntry* db_entry = GameDatabase::FindGame(entry->serial))
 	{
 		entry->title = std::move(db_entry->name);
@@ -494,14 +502,14 @@ bool GameList::WriteEntryToCache(const Entry* entry)
 	result &= WriteU64(m_cache_write_stream, static_cast<u64>(entry->last_modified_time));
 	result &= WriteU32(m_cache_write_stream, entry->crc);
 	result &= WriteU8(m_cache_write_stream, static_cast<u8>(entry->compatibility_rating));
-
-	// flush after each entry, that way we don't end up with a corrupted file if we crash scanning.
-	if (result)
-		result = (std::fflush(m_cache_write_stream) == 0);
-
 	return result;
 }
 
+bool GameList::FlushCacheFileStream()
+{
+	return (std::fflush(m_cache_write_stream) == 0);
+}
+
 void GameList::CloseCacheFileStream()
 {
 	if (!m_cache_write_stream)
@@ -547,6 +555,8 @@ void GameList::ScanDirectory(const char* path, bool recursive, const std::vector
 	progress->SetProgressRange(static_cast<u32>(files.size()));
 	progress->SetProgressValue(0);
 
+	// cache hits are cheap, only the files which have to be opened go to the scan threads
+	std::vector<FILESYSTEM_FIND_DATA*> files_to_scan;
 	for (FILESYSTEM_FIND_DATA& ffd : files)
 	{
 		if (progress->IsCancelled() || !GameList::IsScannableFilename(ffd.FileName) ||
@@ -564,16 +574,128 @@ void GameList::ScanDirectory(const char* path, bool recursive, const std::vector
 			}
 		}
 
-		// ownership of fp is transferred
-		progress->SetFormattedStatusText("Scanning '%s'...", FileSystem::GetDisplayNameFromPath(ffd.FileName).c_str());
-		ScanFile(std::move(ffd.FileName), ffd.ModificationTime);
-		progress->IncrementProgressValue();
+		files_to_scan.push_back(&ffd);
+	}
+
+	if (!files_to_scan.empty() && !progress->IsCancelled())
+	{
+		progress->SetFormattedStatusText("Scanning %zu files in '%s'...", files_to_scan.size(), path);
+		ScanFiles(files_to_scan, progress);
 	}
 
 	progress->SetProgressValue(static_cast<u32>(files.size()));
 	progress->PopState();
 }
 
+u32 GameList::GetScanThreadCount(size_t file_count)
+{
+	// Scanning is mostly waiting on storage, so it's worth going a little wider than the core count on
+	// network shares, but every thread has an image open with its own readahead, so keep it bounded.
+	u32 thread_count = static_cast<u32>(std::max(Host::GetIntSettingValue("GameList", "ScanThreads", 0), 0));
+	if (thread_count == 0)
+		thread_count = std::clamp(std::thread::hardware_concurrency(), 1u, 8u);
+
+	return std::min(thread_count, static_cast<u32>(file_count));
+}
+
+void GameList::ScanFiles(const std::vector<FILESYSTEM_FIND_DATA*>& files, ProgressCallback* progress)
+{
+	// Workers pull files off a shared index and hand back entries; this thread owns the progress callback,
+	// the cache stream and m_entries, and picks the results up in batches.
+	std::atomic<size_t> next_file{0};
+	std::atomic_bool cancelled{false};
+
+	std::mutex results_mutex;
+	std::condition_variable results_cv;
+	std::vector<Entry> results;
+	size_t files_done = 0;
+
+	auto worker = [&]() {
+		Threading::SetNameOfCurrentThread("GameList Scan");
+
+		while (!cancelled.load(std::memory_order_relaxed))
+		{
+			const size_t index = next_file.fetch_add(1, std::memory_order_relaxed);
+			if (index >= files.size())
+				break;
+
+			const FILESYSTEM_FIND_DATA& ffd = *files[index];
+			Entry entry;
+			const bool valid = ScanFile(ffd.FileName, ffd.ModificationTime, &entry);
+
+			std::unique_lock lock(results_mutex);
+			if (valid)
+				results.push_back(std::move(entry));
+			files_done++;
+			results_cv.notify_one();
+		}
+	};
+
+	const u32 thread_count = GetScanThreadCount(files.size());
+	DevCon.WriteLn("Scanning %zu files with %u threads", files.size(), thread_count);
+
+	std::vector<std::thread> threads;
+	threads.reserve(thread_count);
+	for (u32 i = 0; i < thread_count; i++)
+		threads.emplace_back(worker);
+
+	std::vector<Entry> batch;
+	size_t files_reported = 0;
+	while (files_reported < files.size())
+	{
+		size_t done;
+		{
+			// wake up now and again even if nothing finished, so cancelling doesn't wait on a slow file
+			std::unique_lock lock(results_mutex);
+			results_cv.wait_for(lock, std::chrono::milliseconds(100),
+				[&files_done, files_reported]() { return files_done != files_reported; });
+			batch.swap(results);
+			done = files_done;
+		}
+
+		AddScannedEntries(batch);
+		for (; files_reported < done; files_reported++)
+			progress->IncrementProgressValue();
+
+		if (progress->IsCancelled())
+		{
+			cancelled.store(true, std::memory_order_relaxed);
+			break;
+		}
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	// anything which finished after we were cancelled is still good
+	AddScannedEntries(results);
+}
+
+void GameList::AddScannedEntries(std::vector<Entry>& entries)
+{
+	if (entries.empty())
+		return;
+
+	std::unique_lock lock(s_mutex);
+
+	if (m_cache_write_stream || OpenCacheForWriting())
+	{
+		for (const Entry& entry : entries)
+		{
+			if (!WriteEntryToCache(&entry))
+				Console.Warning("Failed to write entry '%s' to cache", entry.path.c_str());
+		}
+
+		// flush after each batch, that way we don't end up with a corrupted file if we crash scanning.
+		if (!FlushCacheFileStream())
+			Console.Warning("Failed to flush game list cache");
+	}
+
+	for (Entry& entry : entries)
+		m_entries.push_back(std::move(entry));
+	entries.clear();
+}
+
 bool GameList::AddFileFromCache(const std::string& path, std::time_t timestamp)
 {
 	if (std::any_of(m_entries.begin(), m_entries.end(), [&path](const Entry& other) { return other.path == path; }))
@@ -590,25 +712,15 @@ bool GameList::AddFileFromCache(const std::string& path, std::time_t timestamp)
 	return true;
 }
 
-bool GameList::ScanFile(std::string path, std::time_t timestamp)
+bool GameList::ScanFile(const std::string& path, std::time_t timestamp, Entry* entry)
 {
 	DevCon.WriteLn("Scanning '%s'...", path.c_str());
 
-	Entry entry;
-	if (!PopulateEntryFromPath(path, &entry))
+	if (!PopulateEntryFromPath(path, entry))
 		return false;
 
-	entry.path = std::move(path);
-	entry.last_modified_time = timestamp;
-
-	if (m_cache_write_stream || OpenCacheForWriting())
-	{
-		if (!WriteEntryToCache(&entry))
-			Console.Warning("Failed to write entry '%s' to cache", entry.path.c_str());
-	}
-
-	std::unique_lock lock(s_mutex);
-	m_entries.push_back(std::move(entry));
+	entry->path = path;
+	entry->last_modified_time = timestamp;
 	return true;
 }
 
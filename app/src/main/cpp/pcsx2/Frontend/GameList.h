@@ -103,7 +103,7 @@ namespace GameList
 	void FillBootParametersForEntry(VMBootParameters* params, const Entry* entry);
 
 	/// Populates a game list entry struct with information from the iso/elf.
-	/// Do *not* call while the system is running, it will mess with CDVD state.
+	/// Doesn't touch the CDVD state, so it's safe to call from any thread.
 	bool PopulateEntryFromPath(const std::string& path, GameList::Entry* entry);
 
 	// Game list access. It's the caller's responsibility to hold the lock while manipulating the entry in any way.
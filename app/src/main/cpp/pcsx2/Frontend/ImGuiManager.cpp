@@ -700,6 +700,11 @@ void ImGuiManager::DrawPerformanceOverlay()
 			FormatProcessorStat(text, PerformanceMetrics::GetGSThreadUsage(), PerformanceMetrics::GetGSThreadAverageTime());
 			DRAW_LINE(s_fixed_font, text.c_str(), IM_COL32(255, 255, 255, 255));
 
+			text.clear();
+			fmt::format_to(std::back_inserter(text), "EE stall: {:.2f}ms | GS idle: {:.2f}ms", PerformanceMetrics::GetEEStallTime(),
+				PerformanceMetrics::GetGSIdleTime());
+			DRAW_LINE(s_fixed_font, text.c_str(), IM_COL32(255, 255, 255, 255));
+
 //			const u32 gs_sw_threads = PerformanceMetrics::GetGSSWThreadCount();
 //			for (u32 i = 0; i < gs_sw_threads; ++i)
 //			{
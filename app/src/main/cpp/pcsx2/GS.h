@@ -358,6 +358,24 @@ public:
     std::mutex m_lock_Stack;
 #endif
 
+    // Spin-then-park policy for the MTGS idle wait and EE ring stalls.
+    // Keeps a running average of how long recent waits lasted and only spins when that's short
+    // enough for spinning to beat a kernel wakeup, with separate enter/leave thresholds so a
+    // single outlier doesn't flip it back and forth.
+    struct AdaptiveSpin
+    {
+        u32 average_ns = 0;
+        bool spinning = true;
+
+        void Reset();
+        /// How long to spin before parking the thread, in nanoseconds
+        u32 Budget() const;
+        /// Feed back how long the last wait actually took
+        void Update(u64 waited_ns);
+    };
+    AdaptiveSpin m_idle_spin;  // MTGS thread waiting for work
+    AdaptiveSpin m_stall_spin; // EE thread waiting for ring buffer space
+
     std::thread m_thread;
     Threading::ThreadHandle m_thread_handle;
     std::atomic_bool m_open_flag{false};
@@ -406,6 +424,8 @@ public:
 	void SetSoftwareRendering(bool software);
 	void ToggleSoftwareRendering();
 	bool SaveMemorySnapshot(u32 width, u32 height, std::vector<u32>* pixels);
+	bool BeginCapture();
+	void EndCapture();
 
 protected:
 	bool OpenGS();
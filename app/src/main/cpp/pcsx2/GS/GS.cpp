@@ -220,6 +220,10 @@ static bool DoGSOpen(GSRendererType renderer, u8* basemem)
 
 	switch (display->GetRenderAPI())
 	{
+		case HostDisplay::RenderAPI::None:
+			g_gs_device = std::make_unique<GSDeviceNull>();
+			break;
+
 #ifdef _WIN32
 		case HostDisplay::RenderAPI::D3D11:
 			g_gs_device = std::make_unique<GSDevice11>();
@@ -622,6 +626,8 @@ int GStest()
 	return 0;
 }
 
+#endif
+
 static void pt(const char* str)
 {
 	struct tm* current;
@@ -640,7 +646,8 @@ bool GSsetupRecording(std::string& filename)
 		printf("GS: no s_gs for recording\n");
 		return false;
 	}
-#if defined(__unix__) || defined(__APPLE__)
+	// Core frontends only get here when the user asks for a capture, there's no hotkey to guard.
+#if !defined(PCSX2_CORE) && (defined(__unix__) || defined(__APPLE__))
 	if (!theApp.GetConfigB("capture_enabled"))
 	{
 		printf("GS: Recording is disabled\n");
@@ -662,11 +669,13 @@ bool GSsetupRecording(std::string& filename)
 
 void GSendRecording()
 {
+	if (g_gs_renderer == NULL)
+		return;
+
 	printf("GS: Recording end command\n");
 	g_gs_renderer->EndCapture();
 	pt(" - Capture ended\n");
 }
-#endif
 
 void GSsetGameCRC(u32 crc, int options)
 {
@@ -793,7 +802,7 @@ void GSgetStats(std::string& info)
 	{
 		if (GSConfig.TexturePreloading == TexturePreloadingLevel::Full)
 		{
-			info = StringUtil::StdStringFromFormat("%s HW | HC: %d MB | %d P | %d D | %d DC | %d B | %d RB | %d TC | %d TU",
+			info = StringUtil::StdStringFromFormat("%s HW | HC: %d MB | %d P | %d D | %d DC | %d B | %d RB | %d/%d RS | %d TC | %d TU",
 				api_name,
 				(int)std::ceil(GSRendererHW::GetInstance()->GetTextureCache()->GetHashCacheMemoryUsage() / 1048576.0f),
 				(int)pm.Get(GSPerfMon::Prim),
@@ -801,18 +810,22 @@ void GSgetStats(std::string& info)
 				(int)std::ceil(pm.Get(GSPerfMon::DrawCalls)),
 				(int)std::ceil(pm.Get(GSPerfMon::Barriers)),
 				(int)std::ceil(pm.Get(GSPerfMon::Readbacks)),
+				(int)std::ceil(pm.Get(GSPerfMon::ReadbacksForced)),
+				(int)std::ceil(pm.Get(GSPerfMon::ReadbacksDeferred)),
 				(int)std::ceil(pm.Get(GSPerfMon::TextureCopies)),
 				(int)std::ceil(pm.Get(GSPerfMon::TextureUploads)));
 		}
 		else
 		{
-			info = StringUtil::StdStringFromFormat("%s HW | %d P | %d D | %d DC | %d B | %d RB | %d TC | %d TU",
+			info = StringUtil::StdStringFromFormat("%s HW | %d P | %d D | %d DC | %d B | %d RB | %d/%d RS | %d TC | %d TU",
 				api_name,
 				(int)pm.Get(GSPerfMon::Prim),
 				(int)pm.Get(GSPerfMon::Draw),
 				(int)std::ceil(pm.Get(GSPerfMon::DrawCalls)),
 				(int)std::ceil(pm.Get(GSPerfMon::Barriers)),
 				(int)std::ceil(pm.Get(GSPerfMon::Readbacks)),
+				(int)std::ceil(pm.Get(GSPerfMon::ReadbacksForced)),
+				(int)std::ceil(pm.Get(GSPerfMon::ReadbacksDeferred)),
 				(int)std::ceil(pm.Get(GSPerfMon::TextureCopies)),
 				(int)std::ceil(pm.Get(GSPerfMon::TextureUploads)));
 		}
@@ -1410,7 +1423,14 @@ void GSApp::Init()
 	m_default_configuration["AspectRatio"]                                = "1";
 	m_default_configuration["autoflush_sw"]                               = "1";
 	m_default_configuration["capture_enabled"]                            = "0";
+#ifdef PCSX2_CORE
+	// Empty puts captures in the snapshots folder, png per frame is too slow to be the default here.
+	m_default_configuration["capture_format"]                             = "y4m";
+	m_default_configuration["capture_out_dir"]                            = "";
+#else
+	m_default_configuration["capture_format"]                             = "png";
 	m_default_configuration["capture_out_dir"]                            = "/tmp/GS_Capture";
+#endif
 	m_default_configuration["capture_threads"]                            = "4";
 	m_default_configuration["CaptureHeight"]                              = "480";
 	m_default_configuration["CaptureWidth"]                               = "640";
@@ -1418,6 +1438,8 @@ void GSApp::Init()
 	m_default_configuration["CrcHacksExclusions"]                         = "";
 	m_default_configuration["disable_hw_gl_draw"]                         = "0";
 	m_default_configuration["disable_shader_cache"]                       = "0";
+	m_default_configuration["PrecompileShaders"]                          = "1";
+	m_default_configuration["AsyncShaderCompile"]                         = "0";
 	m_default_configuration["DisableDualSourceBlend"]                     = "0";
 	m_default_configuration["DisableFramebufferFetch"]                    = "0";
 	m_default_configuration["dithering_ps2"]                              = "2";
@@ -1429,12 +1451,14 @@ void GSApp::Init()
 	m_default_configuration["DumpPaletteTextures"]                        = "1";
 	m_default_configuration["extrathreads"]                               = "2";
 	m_default_configuration["extrathreads_height"]                        = "4";
+	m_default_configuration["extrathreads_tiled"]                         = "0";
 	m_default_configuration["filter"]                                     = std::to_string(static_cast<s8>(BiFiltering::PS2));
 	m_default_configuration["FMVSoftwareRendererSwitch"]                  = "0";
 	m_default_configuration["FullscreenMode"]                             = "";
 	m_default_configuration["fxaa"]                                       = "0";
 	m_default_configuration["GSDumpCompression"]                          = "0";
 	m_default_configuration["HWDisableReadbacks"]                         = "0";
+	m_default_configuration["HWDeferReadbacks"]                           = "0";
 	m_default_configuration["pcrtc_antiblur"]                             = "1";
 	m_default_configuration["disable_interlace_offset"]                   = "0";
 	m_default_configuration["pcrtc_offsets"]                              = "0";
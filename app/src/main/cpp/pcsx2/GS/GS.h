@@ -79,9 +79,9 @@ void GSPresentCurrentFrame();
 void GSkeyEvent(const HostKeyEvent& e);
 void GSconfigure();
 int GStest();
+#endif
 bool GSsetupRecording(std::string& filename);
 void GSendRecording();
-#endif
 void GSsetGameCRC(u32 crc, int options);
 void GSsetFrameSkip(int frameskip);
 
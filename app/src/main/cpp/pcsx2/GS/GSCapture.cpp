@@ -18,7 +18,10 @@
 #include "GSPng.h"
 #include "GSUtil.h"
 #include "GSExtra.h"
+#include "common/FileSystem.h"
+#include "common/Path.h"
 #include "common/StringUtil.h"
+#include <ctime>
 
 #ifdef _WIN32
 
@@ -417,6 +420,10 @@ bool GSCapture::BeginCapture(float fps, GSVector2i recommendedResolution, float
 	// reload settings because they may have changed
 	m_out_dir = theApp.GetConfigS("capture_out_dir");
 	m_threads = theApp.GetConfigI("capture_threads");
+#ifdef PCSX2_CORE
+	if (m_out_dir.empty())
+		m_out_dir = Path::CombineStdString(EmuFolders::Snapshots, "GS_Capture");
+#endif
 #if defined(__unix__)
 	m_compression_level = theApp.GetConfigI("png_compression_level");
 #endif
@@ -537,9 +544,33 @@ bool GSCapture::BeginCapture(float fps, GSVector2i recommendedResolution, float
 	m_size.x = theApp.GetConfigI("CaptureWidth");
 	m_size.y = theApp.GetConfigI("CaptureHeight");
 
-	for (int i = 0; i < m_threads; ++i)
+	const std::string format(theApp.GetConfigS("capture_format"));
+	if (const std::optional<GSCaptureStream::Format> stream_format = GSCaptureStream::ParseFormat(format))
+	{
+		// One file written sequentially, no encoding on the GS thread.
+		// Named after the start time, so a new capture doesn't overwrite the last one.
+		const char* extension = GSCaptureStream::GetExtension(*stream_format);
+		const std::time_t now = std::time(nullptr);
+		char timestamp[32];
+		std::strftime(timestamp, sizeof(timestamp), "%Y%m%d-%H%M%S", std::localtime(&now));
+		std::string out_file(StringUtil::StdStringFromFormat("%s/capture_%s.%s", m_out_dir.c_str(), timestamp, extension));
+		for (int i = 2; FileSystem::FileExists(out_file.c_str()); i++)
+			out_file = StringUtil::StdStringFromFormat("%s/capture_%s_%d.%s", m_out_dir.c_str(), timestamp, i, extension);
+
+		m_stream = std::make_unique<GSCaptureStream>();
+		if (!m_stream->Open(out_file, *stream_format, m_size.x, m_size.y, fps))
+		{
+			Console.Error("GS: Failed to open capture file %s", out_file.c_str());
+			m_stream.reset();
+			return false;
+		}
+	}
+	else
 	{
-		m_workers.push_back(std::unique_ptr<GSPng::Worker>(new GSPng::Worker({}, &GSPng::Process, {})));
+		for (int i = 0; i < m_threads; ++i)
+		{
+			m_workers.push_back(std::unique_ptr<GSPng::Worker>(new GSPng::Worker({}, &GSPng::Process, {})));
+		}
 	}
 
 	m_capturing = true;
@@ -570,6 +601,12 @@ bool GSCapture::DeliverFrame(const void* bits, int pitch, bool rgba)
 
 #elif defined(__unix__)
 
+	if (m_stream)
+	{
+		m_frame++;
+		return m_stream->PushFrame(bits, pitch, rgba);
+	}
+
 	std::string out_file = m_out_dir + StringUtil::StdStringFromFormat("/frame.%010d.png", m_frame);
 	//GSPng::Save(GSPng::RGB_PNG, out_file, (u8*)bits, m_size.x, m_size.y, pitch, m_compression_level);
 	m_workers[m_frame % m_threads]->Push(std::make_shared<GSPng::Transaction>(GSPng::RGB_PNG, out_file, static_cast<const u8*>(bits), m_size.x, m_size.y, pitch, m_compression_level));
@@ -604,6 +641,11 @@ bool GSCapture::EndCapture()
 
 #elif defined(__unix__)
 	m_workers.clear();
+	if (m_stream)
+	{
+		m_stream->Close();
+		m_stream.reset();
+	}
 
 	m_frame = 0;
 
@@ -17,6 +17,7 @@
 
 #include "GSVector.h"
 #include "GSPng.h"
+#include "GSCaptureStream.h"
 
 #ifdef _WIN32
 #include "Window/GSCaptureDlg.h"
@@ -41,6 +42,7 @@ class GSCapture
 
 	std::vector<std::unique_ptr<GSPng::Worker>> m_workers;
 	int m_compression_level;
+	std::unique_ptr<GSCaptureStream> m_stream; // null when capturing to png
 
 #endif
 
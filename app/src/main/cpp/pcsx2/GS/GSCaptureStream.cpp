@@ -0,0 +1,363 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "GSCaptureStream.h"
+#include "common/FileSystem.h"
+#include "common/PersistentThread.h"
+#include "common/StringUtil.h"
+#include "common/Timer.h"
+
+#include "3rdparty/zstd/zstd/lib/zstd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Raw container layout:
+//   header   RawHeader
+//   frames   u32 size, then the RGBA pixels or a zstd frame of them
+//   index    u64 file offset of every frame, followed by RawTrailer
+// A file without trailer (e.g. after a crash) can still be read front to back.
+static constexpr char RAW_MAGIC[8] = {'P', '2', 'C', 'A', 'P', 'R', 'A', 'W'};
+static constexpr char RAW_INDEX_MAGIC[8] = {'P', '2', 'C', 'A', 'P', 'I', 'D', 'X'};
+static constexpr u32 RAW_VERSION = 1;
+static constexpr u32 RAW_FLAG_ZSTD = 1;
+static constexpr int RAW_ZSTD_LEVEL = 1;
+
+namespace
+{
+	struct RawHeader
+	{
+		char magic[8];
+		u32 version;
+		u32 width;
+		u32 height;
+		u32 fps_num;
+		u32 fps_den;
+		u32 flags;
+	};
+	static_assert(sizeof(RawHeader) == 32);
+
+	struct RawTrailer
+	{
+		u64 index_offset;
+		u32 frame_count;
+		u32 reserved;
+		char magic[8];
+	};
+	static_assert(sizeof(RawTrailer) == 24);
+} // namespace
+
+GSCaptureStream::GSCaptureStream() = default;
+
+GSCaptureStream::~GSCaptureStream()
+{
+	Close();
+}
+
+std::optional<GSCaptureStream::Format> GSCaptureStream::ParseFormat(const std::string& name)
+{
+	if (StringUtil::Strcasecmp(name.c_str(), "y4m") == 0)
+		return Format::Y4M;
+	if (StringUtil::Strcasecmp(name.c_str(), "raw") == 0)
+		return Format::Raw;
+	if (StringUtil::Strcasecmp(name.c_str(), "raw_zstd") == 0)
+		return Format::RawZstd;
+
+	return std::nullopt;
+}
+
+const char* GSCaptureStream::GetExtension(Format format)
+{
+	return (format == Format::Y4M) ? "y4m" : "p2raw";
+}
+
+bool GSCaptureStream::Open(const std::string& filename, Format format, int width, int height, float fps)
+{
+	Close();
+
+	// 4:2:0 needs even dimensions
+	if (format == Format::Y4M)
+	{
+		width &= ~1;
+		height &= ~1;
+	}
+
+	if (width <= 0 || height <= 0)
+		return false;
+
+	m_fp = FileSystem::OpenCFile(filename.c_str(), "wb");
+	if (!m_fp)
+		return false;
+
+	m_format = format;
+	m_width = width;
+	m_height = height;
+	m_file_pos = 0;
+	m_write_failed = false;
+	m_index.clear();
+
+	const u32 fps_den = 1000;
+	const u32 fps_num = static_cast<u32>(std::lround(fps * fps_den));
+
+	if (format == Format::Y4M)
+	{
+		// ConvertToI420() produces limited range, say so rather than leave players to assume full range jpeg
+		const std::string header(StringUtil::StdStringFromFormat("YUV4MPEG2 W%d H%d F%u:%u Ip A1:1 C420 XCOLORRANGE=LIMITED\n", width, height, fps_num, fps_den));
+		Write(header.data(), header.size());
+		m_convert_buffer.resize(static_cast<size_t>(width) * height * 3 / 2);
+	}
+	else
+	{
+		RawHeader header;
+		std::memcpy(header.magic, RAW_MAGIC, sizeof(header.magic));
+		header.version = RAW_VERSION;
+		header.width = width;
+		header.height = height;
+		header.fps_num = fps_num;
+		header.fps_den = fps_den;
+		header.flags = (format == Format::RawZstd) ? RAW_FLAG_ZSTD : 0;
+		Write(&header, sizeof(header));
+
+		if (format == Format::RawZstd)
+		{
+			m_cctx = ZSTD_createCCtx();
+			m_convert_buffer.resize(ZSTD_compressBound(static_cast<size_t>(width) * height * 4));
+		}
+	}
+
+	m_frames_captured.store(0, std::memory_order_relaxed);
+	m_frames_written.store(0, std::memory_order_relaxed);
+	m_frames_dropped.store(0, std::memory_order_relaxed);
+	m_bytes_written.store(0, std::memory_order_relaxed);
+	m_write_time.store(0, std::memory_order_relaxed);
+	m_queue_depth.store(0, std::memory_order_relaxed);
+	m_max_queued.store(0, std::memory_order_relaxed);
+
+	m_frames.resize(QUEUE_SIZE);
+	for (Frame& frame : m_frames)
+	{
+		frame.pixels.resize(static_cast<size_t>(width) * height * 4);
+		m_free.push(&frame);
+	}
+
+	m_exit.store(false, std::memory_order_relaxed);
+	m_sema.Reset();
+	m_thread = std::thread(&GSCaptureStream::WriterThread, this);
+	return true;
+}
+
+void GSCaptureStream::Close()
+{
+	if (!m_fp)
+		return;
+
+	m_exit.store(true, std::memory_order_release);
+	m_sema.NotifyOfWork();
+	m_thread.join();
+
+	if (m_format != Format::Y4M)
+	{
+		RawTrailer trailer;
+		trailer.index_offset = m_file_pos;
+		trailer.frame_count = static_cast<u32>(m_index.size());
+		trailer.reserved = 0;
+		std::memcpy(trailer.magic, RAW_INDEX_MAGIC, sizeof(trailer.magic));
+		Write(m_index.data(), m_index.size() * sizeof(u64));
+		Write(&trailer, sizeof(trailer));
+	}
+
+	if (std::fclose(m_fp) != 0)
+		m_write_failed = true;
+	m_fp = nullptr;
+
+	if (m_write_failed)
+		Console.Error("GS: Failed to write capture file, it is probably incomplete.");
+
+	const Stats stats(GetStats());
+	Console.WriteLn("GS: Capture finished, %llu frames written, %llu dropped (queue peaked at %u/%u, %.2f ms per frame, %llu MB)",
+		stats.frames_written, stats.frames_dropped, stats.max_queued, QUEUE_SIZE, stats.write_ms, stats.bytes_written >> 20);
+
+	Frame* frame;
+	while (m_free.pop(frame))
+		;
+	while (m_queued.pop(frame))
+		;
+	m_frames.clear();
+	m_convert_buffer = {};
+	m_index = {};
+
+	if (m_cctx)
+	{
+		ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(m_cctx));
+		m_cctx = nullptr;
+	}
+}
+
+bool GSCaptureStream::PushFrame(const void* bits, int pitch, bool rgba)
+{
+	m_frames_captured.fetch_add(1, std::memory_order_relaxed);
+
+	Frame* frame;
+	if (!m_fp || !m_free.pop(frame))
+	{
+		m_frames_dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	StringUtil::StrideMemCpy(frame->pixels.data(), m_width * 4, bits, pitch, m_width * 4, m_height);
+	frame->rgba = rgba;
+
+	m_queued.push(frame);
+	const u32 depth = m_queue_depth.fetch_add(1, std::memory_order_relaxed) + 1;
+	if (depth > m_max_queued.load(std::memory_order_relaxed))
+		m_max_queued.store(depth, std::memory_order_relaxed);
+
+	m_sema.NotifyOfWork();
+	return true;
+}
+
+GSCaptureStream::Stats GSCaptureStream::GetStats() const
+{
+	Stats stats;
+	stats.frames_captured = m_frames_captured.load(std::memory_order_relaxed);
+	stats.frames_written = m_frames_written.load(std::memory_order_relaxed);
+	stats.frames_dropped = m_frames_dropped.load(std::memory_order_relaxed);
+	stats.bytes_written = m_bytes_written.load(std::memory_order_relaxed);
+	stats.max_queued = m_max_queued.load(std::memory_order_relaxed);
+	stats.write_ms = stats.frames_written ?
+		(Common::Timer::ConvertValueToMilliseconds(m_write_time.load(std::memory_order_relaxed)) / stats.frames_written) : 0.0;
+	return stats;
+}
+
+void GSCaptureStream::WriterThread()
+{
+	Threading::SetNameOfCurrentThread("GS Capture Writer");
+
+	while (true)
+	{
+		m_sema.WaitForWork();
+
+		Frame* frame;
+		while (m_queued.pop(frame))
+		{
+			m_queue_depth.fetch_sub(1, std::memory_order_relaxed);
+
+			const Common::Timer::Value start = Common::Timer::GetCurrentValue();
+			if (!m_write_failed && WriteFrame(frame))
+				m_frames_written.fetch_add(1, std::memory_order_relaxed);
+			m_write_time.fetch_add(Common::Timer::GetCurrentValue() - start, std::memory_order_relaxed);
+
+			m_free.push(frame);
+		}
+
+		// Everything queued before Close() has been written at this point.
+		if (m_exit.load(std::memory_order_acquire) && m_queued.empty())
+			break;
+	}
+}
+
+bool GSCaptureStream::Write(const void* data, size_t size)
+{
+	if (m_write_failed || size == 0)
+		return !m_write_failed;
+
+	if (std::fwrite(data, size, 1, m_fp) != 1)
+	{
+		m_write_failed = true;
+		return false;
+	}
+
+	m_file_pos += size;
+	m_bytes_written.fetch_add(size, std::memory_order_relaxed);
+	return true;
+}
+
+bool GSCaptureStream::WriteFrame(Frame* frame)
+{
+	if (m_format == Format::Y4M)
+	{
+		ConvertToI420(frame);
+		static constexpr char frame_header[] = "FRAME\n";
+		return Write(frame_header, sizeof(frame_header) - 1) && Write(m_convert_buffer.data(), m_convert_buffer.size());
+	}
+
+	// Raw frames are always stored as RGBA.
+	if (!frame->rgba)
+	{
+		u8* row = frame->pixels.data();
+		for (size_t i = 0; i < frame->pixels.size(); i += 4)
+			std::swap(row[i + 0], row[i + 2]);
+	}
+
+	const void* data = frame->pixels.data();
+	u32 size = static_cast<u32>(frame->pixels.size());
+	if (m_format == Format::RawZstd)
+	{
+		const size_t res = ZSTD_compressCCtx(static_cast<ZSTD_CCtx*>(m_cctx), m_convert_buffer.data(), m_convert_buffer.size(),
+			frame->pixels.data(), frame->pixels.size(), RAW_ZSTD_LEVEL);
+		if (ZSTD_isError(res))
+			return false;
+
+		data = m_convert_buffer.data();
+		size = static_cast<u32>(res);
+	}
+
+	m_index.push_back(m_file_pos);
+	return Write(&size, sizeof(size)) && Write(data, size);
+}
+
+void GSCaptureStream::ConvertToI420(const Frame* frame)
+{
+	// BT.601 limited range, same coefficients as the DirectShow YUY2 path.
+	const int r_idx = frame->rgba ? 0 : 2;
+	const int b_idx = frame->rgba ? 2 : 0;
+	const size_t y_size = static_cast<size_t>(m_width) * m_height;
+	const int cw = m_width / 2;
+
+	u8* y_plane = m_convert_buffer.data();
+	u8* u_plane = y_plane + y_size;
+	u8* v_plane = u_plane + y_size / 4;
+
+	for (int y = 0; y < m_height; y += 2)
+	{
+		const u8* row0 = &frame->pixels[static_cast<size_t>(y) * m_width * 4];
+		const u8* row1 = row0 + m_width * 4;
+		u8* y0 = y_plane + static_cast<size_t>(y) * m_width;
+		u8* y1 = y0 + m_width;
+		u8* u = u_plane + static_cast<size_t>(y / 2) * cw;
+		u8* v = v_plane + static_cast<size_t>(y / 2) * cw;
+
+		for (int x = 0; x < m_width; x += 2)
+		{
+			int rs = 0, gs = 0, bs = 0;
+			const u8* px[4] = {row0 + x * 4, row0 + x * 4 + 4, row1 + x * 4, row1 + x * 4 + 4};
+			u8* yp[4] = {y0 + x, y0 + x + 1, y1 + x, y1 + x + 1};
+			for (int i = 0; i < 4; i++)
+			{
+				const int r = px[i][r_idx], g = px[i][1], b = px[i][b_idx];
+				*yp[i] = static_cast<u8>((66 * r + 129 * g + 25 * b + 128 + (16 << 8)) >> 8);
+				rs += r;
+				gs += g;
+				bs += b;
+			}
+
+			// chroma of the averaged 2x2 block, the sums carry two extra bits
+			u[x / 2] = static_cast<u8>((-38 * rs - 74 * gs + 112 * bs + 512 + (128 << 10)) >> 10);
+			v[x / 2] = static_cast<u8>((112 * rs - 94 * gs - 18 * bs + 512 + (128 << 10)) >> 10);
+		}
+	}
+}
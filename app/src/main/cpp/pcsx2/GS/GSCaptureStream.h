@@ -0,0 +1,113 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/boost_spsc_queue.hpp"
+#include "common/Threading.h"
+#include <atomic>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes captured frames into a single file from a writer thread.
+// The GS thread only copies the frame into a free buffer, when the writer falls behind
+// frames are dropped and counted rather than stalling emulation.
+//
+// Formats:
+//  - Y4M: YUV4MPEG2, 4:2:0 BT.601 limited range, readable by most tools.
+//  - Raw: RGBA frames, each prefixed by its size, with an offset index at the end of the file.
+//  - RawZstd: same as Raw, but each frame is a zstd frame.
+class GSCaptureStream
+{
+public:
+	enum class Format
+	{
+		Y4M,
+		Raw,
+		RawZstd,
+	};
+
+	struct Stats
+	{
+		u64 frames_captured;
+		u64 frames_written;
+		u64 frames_dropped;
+		u64 bytes_written;
+		u32 max_queued; // most frames waiting for the writer at once
+		double write_ms; // average time the writer spent on a frame
+	};
+
+	// Frames which can wait for the writer before new ones get dropped.
+	static constexpr u32 QUEUE_SIZE = 8;
+
+	GSCaptureStream();
+	~GSCaptureStream();
+
+	static std::optional<Format> ParseFormat(const std::string& name);
+	static const char* GetExtension(Format format);
+
+	bool Open(const std::string& filename, Format format, int width, int height, float fps);
+	// Flushes queued frames, writes the index and closes the file.
+	void Close();
+	bool IsOpen() const { return m_fp != nullptr; }
+
+	// Never blocks, returns false when the frame was dropped.
+	bool PushFrame(const void* bits, int pitch, bool rgba);
+
+	Stats GetStats() const;
+
+private:
+	struct Frame
+	{
+		std::vector<u8> pixels; // tightly packed, m_width * 4 bytes per row
+		bool rgba;
+	};
+
+	void WriterThread();
+	bool WriteFrame(Frame* frame);
+	bool Write(const void* data, size_t size);
+	void ConvertToI420(const Frame* frame);
+
+	std::FILE* m_fp = nullptr;
+	Format m_format = Format::Raw;
+	int m_width = 0;
+	int m_height = 0;
+
+	std::vector<Frame> m_frames;
+	ringbuffer_base<Frame*, QUEUE_SIZE + 1> m_queued;
+	ringbuffer_base<Frame*, QUEUE_SIZE + 1> m_free;
+
+	std::thread m_thread;
+	Threading::WorkSema m_sema;
+	std::atomic_bool m_exit{false};
+
+	// writer thread only
+	std::vector<u8> m_convert_buffer;
+	std::vector<u64> m_index;
+	void* m_cctx = nullptr;
+	u64 m_file_pos = 0;
+	bool m_write_failed = false;
+
+	std::atomic<u64> m_frames_captured{0};
+	std::atomic<u64> m_frames_written{0};
+	std::atomic<u64> m_frames_dropped{0};
+	std::atomic<u64> m_bytes_written{0};
+	std::atomic<u64> m_write_time{0};
+	std::atomic<u32> m_queue_depth{0};
+	std::atomic<u32> m_max_queued{0};
+};
@@ -26,6 +26,7 @@ GSPerfMon::GSPerfMon()
 {
     memset(m_counters, 0, sizeof(m_counters));
     memset(m_stats, 0, sizeof(m_stats));
+    memset(m_totals, 0, sizeof(m_totals));
     memset(m_timer_stats, 0, sizeof(m_timer_stats));
     memset(m_total, 0, sizeof(m_total));
     memset(m_begin, 0, sizeof(m_begin));
@@ -73,6 +74,9 @@ void GSPerfMon::Update()
         }
 	}
 
+	for (size_t i = 0; i < std::size(m_counters); ++i)
+		m_totals[i] += m_counters[i];
+
 	memset(m_counters, 0, sizeof(m_counters));
 #endif
 }
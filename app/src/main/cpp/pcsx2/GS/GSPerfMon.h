@@ -38,6 +38,8 @@ public:
 		Quad,
 		SyncPoint,
 		Barriers,
+		ReadbacksForced, // deferred readbacks the GS thread had to wait on the GPU for
+		ReadbacksDeferred, // deferred readbacks which were already done when they got resolved
 		CounterLast,
 
 		// Reused counters for HW.
@@ -48,6 +50,7 @@ public:
 protected:
 	double m_counters[CounterLast];
 	double m_stats[CounterLast];
+	double m_totals[CounterLast];
     float m_timer_stats[TimerLast];
     u64 m_begin[TimerLast], m_total[TimerLast], m_start[TimerLast];
 	u64 m_frame;
@@ -66,6 +69,7 @@ public:
 
 	void Put(counter_t c, double val) { m_counters[c] += val; }
 	double Get(counter_t c) { return m_stats[c]; }
+	double GetTotal(counter_t c) { return m_totals[c] + m_counters[c]; }
     float GetTimer(timer_t t) { return m_timer_stats[t]; }
 	void Update();
 
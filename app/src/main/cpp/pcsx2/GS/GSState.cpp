@@ -2526,6 +2526,7 @@ int GSState::Freeze(freezeData* fd, bool sizeonly)
 		return -1;
 
 	Flush();
+	ResolvePendingReadbacks();
 
 	u8* data = fd->data;
 
@@ -2616,6 +2617,9 @@ int GSState::Defrost(const freezeData* fd)
 
 	Flush();
 
+	// nothing queued may land on top of the memory we're about to load
+	ResolvePendingReadbacks();
+
 	Reset(false);
 
 	ReadState(&m_env.PRIM, data);
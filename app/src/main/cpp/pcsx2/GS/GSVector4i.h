@@ -877,6 +877,19 @@ public:
 		return GSVector4i(_mm_mulhrs_epi16(m, v.m));
 	}
 
+	__forceinline GSVector4i mul32l(const GSVector4i& v) const
+	{
+		return GSVector4i(_mm_mullo_epi32(m, v.m));
+	}
+
+	// High 32 bits of the signed 64-bit products
+	__forceinline GSVector4i mul32hs(const GSVector4i& v) const
+	{
+		const __m128i even = _mm_srli_epi64(_mm_mul_epi32(m, v.m), 32);
+		const __m128i odd = _mm_mul_epi32(_mm_srli_epi64(m, 32), _mm_srli_epi64(v.m, 32));
+		return GSVector4i(_mm_blend_epi16(even, odd, 0xcc));
+	}
+
 	GSVector4i madd(const GSVector4i& v) const
 	{
 		return GSVector4i(_mm_madd_epi16(m, v.m));
@@ -17,6 +17,10 @@
 #include "GSDevice.h"
 #include "GS/GSGL.h"
 #include "GS/GS.h"
+#include "common/FileSystem.h"
+#include "common/Path.h"
+#include "common/StringUtil.h"
+#include "Config.h"
 
 const char* shaderName(ShaderConvert value)
 {
@@ -314,6 +318,84 @@ bool GSDevice::DownloadTextureConvert(GSTexture* src, const GSVector4& sRect, co
 	return ret;
 }
 
+static constexpr u32 SELECTOR_LOG_SIGNATURE = 0x4C505347; // GSPL
+
+static std::string GetSelectorLogFilename(const char* name, u32 crc)
+{
+	return Path::CombineStdString(EmuFolders::Cache, StringUtil::StdStringFromFormat("gs_%s_%08X.bin", name, crc));
+}
+
+bool GSDevice::ReadSelectorLog(const char* name, u32 version, u32 selector_size, std::vector<u8>& data) const
+{
+	if (m_game_crc == 0)
+		return false;
+
+	auto fp = FileSystem::OpenManagedCFile(GetSelectorLogFilename(name, m_game_crc).c_str(), "rb");
+	if (!fp)
+		return false;
+
+	u32 signature, file_version, file_selector_size, count;
+	if (std::fread(&signature, sizeof(signature), 1, fp.get()) != 1 || signature != SELECTOR_LOG_SIGNATURE ||
+		std::fread(&file_version, sizeof(file_version), 1, fp.get()) != 1 || file_version != version ||
+		std::fread(&file_selector_size, sizeof(file_selector_size), 1, fp.get()) != 1 || file_selector_size != selector_size ||
+		std::fread(&count, sizeof(count), 1, fp.get()) != 1 || count > 65536)
+	{
+		Console.Warning("(GSDevice) Ignoring stale or corrupted %s list for %08X", name, m_game_crc);
+		return false;
+	}
+
+	data.resize(static_cast<size_t>(count) * selector_size);
+	if (count > 0 && std::fread(data.data(), selector_size, count, fp.get()) != count)
+	{
+		Console.Warning("(GSDevice) Ignoring truncated %s list for %08X", name, m_game_crc);
+		data.clear();
+		return false;
+	}
+
+	return true;
+}
+
+void GSDevice::WriteSelectorLog(const char* name, u32 version, u32 selector_size, const void* selectors, size_t count) const
+{
+	if (m_game_crc == 0 || count == 0)
+		return;
+
+	const std::string filename(GetSelectorLogFilename(name, m_game_crc));
+	auto fp = FileSystem::OpenManagedCFile(filename.c_str(), "wb");
+	if (!fp)
+		return;
+
+	const u32 count32 = static_cast<u32>(std::min<size_t>(count, 65536));
+	if (std::fwrite(&SELECTOR_LOG_SIGNATURE, sizeof(SELECTOR_LOG_SIGNATURE), 1, fp.get()) != 1 ||
+		std::fwrite(&version, sizeof(version), 1, fp.get()) != 1 ||
+		std::fwrite(&selector_size, sizeof(selector_size), 1, fp.get()) != 1 ||
+		std::fwrite(&count32, sizeof(count32), 1, fp.get()) != 1 ||
+		std::fwrite(selectors, selector_size, count32, fp.get()) != count32)
+	{
+		Console.Error("(GSDevice) Failed to write %s list '%s'", name, filename.c_str());
+		fp.reset();
+		FileSystem::DeleteFilePath(filename.c_str());
+	}
+}
+
+int GSDevice::QueueDownloadTextureConvert(GSTexture* src, const GSVector4& sRect, const GSVector2i& dSize, GSTexture::Format format, ShaderConvert ps_shader, const bool linear)
+{
+	ASSERT(src);
+	ASSERT(format == GSTexture::Format::Color || format == GSTexture::Format::UInt16 || format == GSTexture::Format::UInt32);
+
+	GSTexture* dst = CreateRenderTarget(dSize.x, dSize.y, format);
+	if (!dst)
+		return -1;
+
+	GSVector4i dRect(0, 0, dSize.x, dSize.y);
+	StretchRect(src, sRect, dst, GSVector4(dRect), ps_shader, linear);
+
+	// The copy is recorded after the stretch, so the target can go back to the pool straight away.
+	const int slot = QueueDownloadTexture(dst, dRect);
+	Recycle(dst);
+	return slot;
+}
+
 void GSDevice::StretchRect(GSTexture* sTex, GSTexture* dTex, const GSVector4& dRect, ShaderConvert shader, bool linear)
 {
 	StretchRect(sTex, GSVector4(0, 0, 1, 1), dTex, dRect, shader, linear);
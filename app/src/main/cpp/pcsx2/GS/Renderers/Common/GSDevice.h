@@ -684,6 +684,7 @@ protected:
 	unsigned int m_frame = 0; // for ageing the pool
 	bool m_rbswapped = false;
 	FeatureSupport m_features;
+	u32 m_game_crc = 0;
 
 	virtual GSTexture* CreateSurface(GSTexture::Type type, int width, int height, int levels, GSTexture::Format format) = 0;
 	GSTexture* FetchSurface(GSTexture::Type type, int width, int height, int levels, GSTexture::Format format, bool clear, bool prefer_reuse);
@@ -694,6 +695,30 @@ protected:
 	virtual void DoShadeBoost(GSTexture* sTex, GSTexture* dTex, const float params[4]) {}
 	virtual void DoExternalFX(GSTexture* sTex, GSTexture* dTex) {}
 
+	/// Per game list of the pipeline selectors a renderer used, kept in the cache folder so the pipelines can be compiled
+	/// ahead of time on the next boot. Selectors are stored raw, bump `version` whenever their layout or meaning changes.
+	bool ReadSelectorLog(const char* name, u32 version, u32 selector_size, std::vector<u8>& data) const;
+	void WriteSelectorLog(const char* name, u32 version, u32 selector_size, const void* selectors, size_t count) const;
+
+	template <typename T>
+	std::vector<T> ReadSelectorLog(const char* name, u32 version) const
+	{
+		std::vector<u8> data;
+		std::vector<T> selectors;
+		if (ReadSelectorLog(name, version, sizeof(T), data))
+		{
+			selectors.resize(data.size() / sizeof(T));
+			std::memcpy(static_cast<void*>(selectors.data()), data.data(), selectors.size() * sizeof(T));
+		}
+		return selectors;
+	}
+
+	template <typename T>
+	void WriteSelectorLog(const char* name, u32 version, const std::vector<T>& selectors) const
+	{
+		WriteSelectorLog(name, version, sizeof(T), selectors.data(), selectors.size());
+	}
+
 public:
 	GSDevice();
 	virtual ~GSDevice();
@@ -722,6 +747,13 @@ public:
 	virtual bool Create(HostDisplay* display);
 	virtual void Destroy();
 
+	/// Called with the CRC of the running game. Devices which compile pipelines ahead of time save the selectors the
+	/// previous game used and start compiling the ones the new game used last time.
+	virtual void SetGameCRC(u32 crc) { m_game_crc = crc; }
+
+	/// Called once per presented frame, so devices can spread background shader work over several frames.
+	virtual void EndFrame() {}
+
 	virtual void ResetAPIState();
 	virtual void RestoreAPIState();
 
@@ -760,6 +792,25 @@ public:
 	/// Must be called to free resources after calling `DownloadTexture` or `DownloadTextureConvert`
 	virtual void DownloadTextureComplete() {}
 
+	/// Number of staging slots for queued downloads, 0 if the device only supports `DownloadTexture`
+	virtual u32 GetDownloadQueueSize() const { return 0; }
+
+	/// Records a download of the region `rect` of `src` into a free staging slot, without waiting for the GPU.
+	/// Returns the slot, or -1 on failure. Callers must not hold more than `GetDownloadQueueSize` slots.
+	virtual int QueueDownloadTexture(GSTexture* src, const GSVector4i& rect) { return -1; }
+
+	/// Same as `DownloadTextureConvert`, but queued like `QueueDownloadTexture`
+	int QueueDownloadTextureConvert(GSTexture* src, const GSVector4& sRect, const GSVector2i& dSize, GSTexture::Format format, ShaderConvert ps_shader, bool linear);
+
+	/// Returns true if the GPU is done with the queued download, i.e. mapping it won't stall
+	virtual bool IsQueuedDownloadReady(int slot) { return true; }
+
+	/// Waits for a queued download if needed, `out_map` is valid until `ReleaseQueuedDownload`
+	virtual bool MapQueuedDownload(int slot, GSTexture::GSMap& out_map) { return false; }
+
+	/// Returns the staging slot to the ring, with or without having mapped it
+	virtual void ReleaseQueuedDownload(int slot) {}
+
 	virtual void CopyRect(GSTexture* sTex, GSTexture* dTex, const GSVector4i& r, u32 destX, u32 destY) {}
 	virtual void StretchRect(GSTexture* sTex, const GSVector4& sRect, GSTexture* dTex, const GSVector4& dRect, ShaderConvert shader = ShaderConvert::COPY, bool linear = true) {}
 	virtual void StretchRect(GSTexture* sTex, const GSVector4& sRect, GSTexture* dTex, const GSVector4& dRect, bool red, bool green, bool blue, bool alpha) {}
@@ -36,6 +36,14 @@
 
 #endif
 
+// Accumulated stats of one generated function, see GSFunctionMap::UpdateStats().
+struct GSFunctionStats
+{
+	u64 key;
+	u64 frames, prims;
+	u64 ticks, actual, total;
+};
+
 template <class KEY, class VALUE>
 class GSFunctionMap
 {
@@ -45,6 +53,7 @@ protected:
 		uint64 frame, frames, prims;
 		uint64 ticks, actual, total;
 		VALUE f;
+		bool used; // looked up since the last TakeUsedKeys(), prewarming doesn't count
 	};
 
 	std::unordered_map<KEY, ActivePtr*> m_map_active;
@@ -53,6 +62,21 @@ protected:
 
 	virtual VALUE GetDefaultFunction(KEY key) = 0;
 
+	ActivePtr* Create(KEY key)
+	{
+		ActivePtr* p = new ActivePtr();
+
+		memset(p, 0, sizeof(*p));
+
+		p->frame = (uint64)-1;
+
+		p->f = GetDefaultFunction(key);
+
+		m_map_active[key] = p;
+
+		return p;
+	}
+
 public:
 	GSFunctionMap()
 		: m_active(NULL)
@@ -77,20 +101,32 @@ public:
 		}
 		else
 		{
-			ActivePtr* p = new ActivePtr();
-
-			memset(p, 0, sizeof(*p));
+			m_active = Create(key);
+		}
 
-			p->frame = (uint64)-1;
+		m_active->used = true;
 
-			p->f = GetDefaultFunction(key);
+		return m_active->f;
+	}
 
-			m_map_active[key] = p;
+	// Generates the function for key ahead of its first draw, without touching the stats.
+	void Prewarm(KEY key)
+	{
+		if (m_map_active.find(key) == m_map_active.end())
+			Create(key);
+	}
 
-			m_active = p;
+	// Appends the keys looked up since the last call and clears their used flag.
+	void TakeUsedKeys(std::vector<KEY>& keys)
+	{
+		for (auto& i : m_map_active)
+		{
+			if (i.second->used)
+			{
+				keys.push_back(i.first);
+				i.second->used = false;
+			}
 		}
-
-		return m_active->f;
 	}
 
 	void UpdateStats(uint64 frame, uint64 ticks, int actual, int total, int prims)
@@ -112,6 +148,19 @@ public:
 		}
 	}
 
+	void GetStats(std::vector<GSFunctionStats>& stats) const
+	{
+		stats.reserve(stats.size() + m_map_active.size());
+
+		for (const auto& i : m_map_active)
+		{
+			const ActivePtr* p = i.second;
+
+			if (p->frames)
+				stats.push_back({(u64)i.first, p->frames, p->prims, p->ticks, p->actual, p->total});
+		}
+	}
+
 	virtual void PrintStats()
 	{
 		uint64 totalTicks = 0;
@@ -0,0 +1,129 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "GS/GSRegs.h"
+#include "GS/Renderers/Common/GSFastList.h"
+#include <algorithm>
+#include <array>
+
+/// Where a surface sits in a GSPageIndex. The surface keeps it so it can be moved or removed
+/// without searching the buckets.
+struct GSPageIndexEntry
+{
+	u16 start_it = 0;
+	u16 first_page = 0; // pages covered by the surface, inclusive
+	u16 last_page = 0;
+	bool covering = false; // the surface doesn't cover anything until its end block reaches its base block
+	std::array<u16, MAX_PAGES> cover_it;
+};
+
+/// Buckets surfaces by the GS local memory pages they live in, so a lookup at a block only visits the
+/// few surfaces which can touch it instead of the whole cache.
+///
+/// Start buckets hold each surface under the page of its base block. A bucket keeps the relative order
+/// of the owner's list, as long as the owner mirrors its push_front/MoveFront calls here.
+/// Cover buckets hold each surface under every page from its base block to its end block, unordered.
+/// Surfaces wrapping around the end of memory are cut at the last page.
+///
+/// T needs a GSPageIndexEntry m_page_entry member.
+template <class T>
+class GSPageIndex
+{
+public:
+	static constexpr u32 MAX_BP = MAX_BLOCKS - 1;
+
+	void Insert(T* t, u32 bp, u32 end_block)
+	{
+		t->m_page_entry.start_it = m_start[bp >> 5].InsertFront(t);
+		t->m_page_entry.covering = false;
+		Cover(t, bp, end_block);
+	}
+
+	void MoveFront(T* t, u32 bp)
+	{
+		m_start[bp >> 5].MoveFront(t->m_page_entry.start_it);
+	}
+
+	/// Updates the cover buckets after the end block of the surface changed.
+	void Cover(T* t, u32 bp, u32 end_block)
+	{
+		GSPageIndexEntry& e = t->m_page_entry;
+
+		if (end_block < bp)
+		{
+			Uncover(e);
+			return;
+		}
+
+		const u32 first = bp >> 5;
+		const u32 last = std::min(end_block, MAX_BP) >> 5;
+
+		if (e.covering && e.first_page == first)
+		{
+			// Usually the surface just grew (or shrank) by a few pages at the end.
+			for (u32 page = e.last_page + 1; page <= last; page++)
+				e.cover_it[page] = m_cover[page].InsertFront(t);
+			for (u32 page = last + 1; page <= e.last_page; page++)
+				m_cover[page].EraseIndex(e.cover_it[page]);
+		}
+		else
+		{
+			Uncover(e);
+			for (u32 page = first; page <= last; page++)
+				e.cover_it[page] = m_cover[page].InsertFront(t);
+		}
+
+		e.first_page = static_cast<u16>(first);
+		e.last_page = static_cast<u16>(last);
+		e.covering = true;
+	}
+
+	void Remove(T* t, u32 bp)
+	{
+		m_start[bp >> 5].EraseIndex(t->m_page_entry.start_it);
+		Uncover(t->m_page_entry);
+	}
+
+	void Clear()
+	{
+		for (auto& list : m_start)
+			list.clear();
+		for (auto& list : m_cover)
+			list.clear();
+	}
+
+	/// Surfaces whose base block is in the page, most recently used first.
+	const FastList<T*>& Starting(u32 page) const { return m_start[page]; }
+
+	/// Surfaces which cover the page, in no particular order.
+	const FastList<T*>& Covering(u32 page) const { return m_cover[page]; }
+
+private:
+	void Uncover(GSPageIndexEntry& e)
+	{
+		if (!e.covering)
+			return;
+
+		for (u32 page = e.first_page; page <= e.last_page; page++)
+			m_cover[page].EraseIndex(e.cover_it[page]);
+
+		e.covering = false;
+	}
+
+	std::array<FastList<T*>, MAX_PAGES> m_start;
+	std::array<FastList<T*>, MAX_PAGES> m_cover;
+};
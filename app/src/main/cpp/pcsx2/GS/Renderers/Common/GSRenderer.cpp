@@ -566,6 +566,7 @@ void GSRenderer::VSync(u32 field, bool registers_written)
     }
 
     g_gs_device->AgePool();
+    g_gs_device->EndFrame();
 
     g_perfmon.EndFrame();
     if ((g_perfmon.GetFrame() & 0x1f) == 0)
@@ -593,6 +594,24 @@ void GSRenderer::VSync(u32 field, bool registers_written)
         if (GSConfig.OsdShowGPU)
             PerformanceMetrics::OnGPUPresent(Host::GetHostDisplay()->GetAndResetAccumulatedGPUTime());
     }
+
+    if (m_capture.IsCapturing())
+    {
+        // The capture sink only copies the frame, encoding and writing happen on its own threads.
+        GSTexture* current = g_gs_device->GetCurrent();
+        if (current && !blank_frame)
+        {
+            GSTexture::GSMap map;
+            const GSVector2i size(m_capture.GetSize());
+            if (g_gs_device->DownloadTextureConvert(current, GSVector4(0.0f, 0.0f, 1.0f, 1.0f), size,
+                    GSTexture::Format::Color, ShaderConvert::COPY, map, true))
+            {
+                m_capture.DeliverFrame(map.bits, map.pitch, !g_gs_device->IsRBSwapped());
+                g_gs_device->DownloadTextureComplete();
+            }
+        }
+    }
+
     g_gs_device->RestoreAPIState();
     PerformanceMetrics::Update(registers_written, fb_sprite_frame);
 }
@@ -627,8 +646,6 @@ void GSRenderer::PresentCurrentFrame()
 	g_gs_device->RestoreAPIState();
 }
 
-#ifndef PCSX2_CORE
-
 bool GSRenderer::BeginCapture(std::string& filename)
 {
 	return m_capture.BeginCapture(GetTvRefreshRate(), GetInternalResolution(), GetCurrentAspectRatioFloat(GetVideoMode() == GSVideoMode::SDTV_480P || (GSConfig.PCRTCOverscan && GSConfig.PCRTCOffsets)), filename);
@@ -639,6 +656,8 @@ void GSRenderer::EndCapture()
 	m_capture.EndCapture();
 }
 
+#ifndef PCSX2_CORE
+
 void GSRenderer::KeyEvent(const HostKeyEvent& e)
 {
 #ifdef _WIN32
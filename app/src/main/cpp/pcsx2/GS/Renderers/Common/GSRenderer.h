@@ -32,8 +32,8 @@ private:
 
 	u64 m_shader_time_start = 0;
 
-#ifndef PCSX2_CORE
 	GSCapture m_capture;
+#ifndef PCSX2_CORE
 	std::mutex m_snapshot_mutex;
 	bool m_shift_key = false;
 	bool m_control_key = false;
@@ -72,9 +72,10 @@ public:
 	void StopGSDump();
 	void PresentCurrentFrame();
 
-#ifndef PCSX2_CORE
 	bool BeginCapture(std::string& filename);
 	void EndCapture();
+
+#ifndef PCSX2_CORE
 	void KeyEvent(const HostKeyEvent& e);
 #endif
 };
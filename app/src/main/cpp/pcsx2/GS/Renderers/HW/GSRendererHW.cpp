@@ -186,6 +186,7 @@ void GSRendererHW::SetGameCRC(u32 crc, int options)
 	m_hacks.SetGameCRC(m_game);
 
 	GSTextureReplacements::GameChanged();
+	g_gs_device->SetGameCRC(crc);
 }
 
 bool GSRendererHW::CanUpscale()
@@ -811,11 +812,20 @@ void GSRendererHW::InvalidateLocalMem(const GIFRegBITBLTBUF& BITBLTBUF, const GS
 	// printf("[%d] InvalidateLocalMem %d,%d - %d,%d %05x (%d)\n", (int)m_perfmon.GetFrame(), r.left, r.top, r.right, r.bottom, (int)BITBLTBUF.SBP, (int)BITBLTBUF.SPSM);
 
 	if (clut)
-		return; // FIXME
+	{
+		// FIXME: no readback, but the CLUT still has to see the ones already queued
+		m_tc->ResolvePendingReadbacks(m_mem.GetOffset(BITBLTBUF.SBP, BITBLTBUF.SBW, BITBLTBUF.SPSM), r);
+		return;
+	}
 
 	m_tc->InvalidateLocalMem(m_mem.GetOffset(BITBLTBUF.SBP, BITBLTBUF.SBW, BITBLTBUF.SPSM), r);
 }
 
+void GSRendererHW::ResolvePendingReadbacks()
+{
+	m_tc->ResolvePendingReadbacks();
+}
+
 void GSRendererHW::Move()
 {
 	const int sx = m_env.TRXPOS.SSAX;
@@ -949,6 +959,8 @@ void GSRendererHW::SwSpriteRender()
 	constexpr bool invalidate_local_mem_before_fb_read = false;
 	if (invalidate_local_mem_before_fb_read && (alpha_blending_enabled || fb_mask_enabled))
 		m_tc->InvalidateLocalMem(dpo, m_r);
+	// A queued readback of an older target may still cover these pages, land it before drawing over them.
+	m_tc->ResolvePendingReadbacks(dpo, m_r);
 
 	for (int y = 0; y < h; y++, ++sy, ++dy)
 	{
@@ -3973,6 +3985,8 @@ void GSRendererHW::OI_GsMemClear()
 #endif
 		const int format = GSLocalMemory::m_psm[m_context->FRAME.PSM].fmt;
 
+		m_tc->ResolvePendingReadbacks(off, r);
+
 		// FIXME: loop can likely be optimized with AVX/SSE. Pixels aren't
 		// linear but the value will be done for all pixels of a block.
 		// FIXME: maybe we could limit the write to the top and bottom row page.
@@ -4390,6 +4404,8 @@ bool GSRendererHW::OI_PointListPalette(GSTexture* rt, GSTexture* ds, GSTextureCa
 #ifdef PCSX2_DEBUG
 		GL_INS("PointListPalette - m_r = <%d, %d => %d, %d>, n_vertices = %zu, FBP = 0x%x, FBW = %u", m_r.x, m_r.y, m_r.z, m_r.w, n_vertices, FBP, FBW);
 #endif
+		m_tc->ResolvePendingReadbacks(m_context->offset.fb, m_r + GSVector4i(0, 0, 1, 1));
+
 		const GSVertex* RESTRICT v = m_vertex.buff;
 		const int ox(m_context->XYOFFSET.OFX);
 		const int oy(m_context->XYOFFSET.OFY);
@@ -191,6 +191,7 @@ public:
 	GSTexture* GetFeedbackOutput() override;
 	void InvalidateVideoMem(const GIFRegBITBLTBUF& BITBLTBUF, const GSVector4i& r) override;
 	void InvalidateLocalMem(const GIFRegBITBLTBUF& BITBLTBUF, const GSVector4i& r, bool clut = false) override;
+	void ResolvePendingReadbacks() override;
 	void Move() override;
 	void Draw() override;
 
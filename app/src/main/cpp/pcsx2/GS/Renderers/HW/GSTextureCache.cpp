@@ -22,6 +22,7 @@
 #include "GS/GSUtil.h"
 #include "common/Align.h"
 #include "common/HashCombine.h"
+#include "common/ScopedGuard.h"
 
 #define XXH_STATIC_LINKING_ONLY 1
 #define XXH_INLINE_ALL 1
@@ -60,11 +61,14 @@ void GSTextureCache::RemovePartial()
 			delete t;
 
 		m_dst[type].clear();
+		m_dst_pages[type].Clear();
 	}
 }
 
 void GSTextureCache::RemoveAll()
 {
+	ResolvePendingReadbacks();
+
 	m_src.RemoveAll();
 
 	for (int type = 0; type < 2; ++type)
@@ -73,6 +77,7 @@ void GSTextureCache::RemoveAll()
 			delete t;
 
 		m_dst[type].clear();
+		m_dst_pages[type].Clear();
 	}
 
 	for (auto it : m_hash_cache)
@@ -204,6 +209,15 @@ GSTextureCache::Source* GSTextureCache::LookupSource(const GIFRegTEX0& TEX0, con
 	const GSLocalMemory::psm_t& psm_s = GSLocalMemory::m_psm[TEX0.PSM];
 	//const GSLocalMemory::psm_t& cpsm = psm.pal > 0 ? GSLocalMemory::m_psm[TEX0.CPSM] : psm;
 
+	// Sources are hashed and uploaded from local memory, mipmaps live elsewhere so don't bother narrowing those down.
+	if (!m_pending_readbacks.empty())
+	{
+		if (lod)
+			ResolvePendingReadbacks();
+		else
+			ResolvePendingReadbacks(g_gs_renderer->m_mem.GetOffset(TEX0.TBP0, TEX0.TBW, TEX0.PSM), GSVector4i(0, 0, 1 << TEX0.TW, 1 << TEX0.TH));
+	}
+
 	// Until DX is fixed
 	if (psm_s.pal > 0)
 		g_gs_renderer->m_mem.m_clut.Read32(TEX0, TEXA);
@@ -292,7 +306,11 @@ GSTextureCache::Source* GSTextureCache::LookupSource(const GIFRegTEX0& TEX0, con
 						// There is no dedicated shader to handle 4-bit conversion (Stuntman has been confirmed to use 4-bit).
 						// Direct3D10/11 and OpenGL support 8-bit fb conversion but don't render some corner cases properly (Harry Potter games).
 						// The hack can fix glitches in some games.
+					{
+						// The source below is hashed and uploaded from local memory, so the readback can't stay queued.
 						Read(t, t->m_valid);
+						ResolvePendingReadbacks(g_gs_renderer->m_mem.GetOffset(t->m_TEX0.TBP0, t->m_TEX0.TBW, t->m_TEX0.PSM), t->m_valid);
+					}
 					else
 						dst = t;
 					found_t = true;
@@ -452,13 +470,12 @@ GSTextureCache::Target* GSTextureCache::LookupTarget(const GIFRegTEX0& TEX0, con
 	auto& list = m_dst[type];
 	if (!is_frame)
 	{
-		for (auto i = list.begin(); i != list.end(); ++i)
+		for (auto t : m_dst_pages[type].Starting(bp >> 5))
 		{
-			Target* t = *i;
-
 			if (bp == t->m_TEX0.TBP0)
 			{
-				list.MoveFront(i.Index());
+				list.MoveFront(t->m_dst_it);
+				m_dst_pages[type].MoveFront(t, bp);
 
 				dst = t;
 
@@ -473,7 +490,7 @@ GSTextureCache::Target* GSTextureCache::LookupTarget(const GIFRegTEX0& TEX0, con
 	{
 		assert(type == RenderTarget);
 		// Let's try to find a perfect frame that contains valid data
-		for (auto t : list)
+		for (auto t : m_dst_pages[type].Starting(bp >> 5))
 		{
 			if (bp == t->m_TEX0.TBP0 && t->m_end_block >= bp)
 			{
@@ -507,7 +524,7 @@ GSTextureCache::Target* GSTextureCache::LookupTarget(const GIFRegTEX0& TEX0, con
 		// 3rd try ! Try to find a frame that doesn't contain valid data (honestly I'm not sure we need to do it)
 		if (!dst)
 		{
-			for (auto t : list)
+			for (auto t : m_dst_pages[type].Starting(bp >> 5))
 			{
 				if (bp == t->m_TEX0.TBP0)
 				{
@@ -554,7 +571,7 @@ GSTextureCache::Target* GSTextureCache::LookupTarget(const GIFRegTEX0& TEX0, con
 		// Depth stencil/RT can be an older RT/DS but only check recent RT/DS to avoid to pick
 		// some bad data.
 		Target* dst_match = nullptr;
-		for (auto t : m_dst[rev_type])
+		for (auto t : m_dst_pages[rev_type].Starting(bp >> 5))
 		{
 			if (bp == t->m_TEX0.TBP0)
 			{
@@ -710,11 +727,8 @@ void GSTextureCache::InvalidateVideoMemType(int type, u32 bp)
 	if (GSConfig.UserHacks_DisableDepthSupport)
 		return;
 
-	auto& list = m_dst[type];
-	for (auto i = list.begin(); i != list.end(); ++i)
+	for (auto t : m_dst_pages[type].Starting(bp >> 5))
 	{
-		Target* t = *i;
-
 		if (bp == t->m_TEX0.TBP0)
 		{
 #ifdef PCSX2_DEBUG
@@ -722,8 +736,7 @@ void GSTextureCache::InvalidateVideoMemType(int type, u32 bp)
 				t->m_texture ? t->m_texture->GetID() : 0,
 				t->m_TEX0.TBP0);
 #endif
-			list.erase(i);
-			delete t;
+			RemoveTarget(t);
 
 			break;
 		}
@@ -738,6 +751,10 @@ void GSTextureCache::InvalidateVideoMem(const GSOffset& off, const GSVector4i& r
 	u32 bw = off.bw();
 	u32 psm = off.psm();
 
+	// A transfer is about to overwrite local memory, older readbacks of these pages must land first.
+	if (target)
+		ResolvePendingReadbacks(off, rect);
+
 	if (!target)
 	{
 		// Remove Source that have same BP as the render target (color&dss)
@@ -875,14 +892,33 @@ void GSTextureCache::InvalidateVideoMem(const GSOffset& off, const GSVector4i& r
 	if (!target)
 		return;
 
+	// Only two kinds of targets can be touched below: the ones starting at bp or a whole number of rows
+	// after it while still inside the rect ("Dirty After"), and the ones containing bp ("Dirty in the middle").
+	const u32 first_page = bp >> 5;
+	u32 last_page = first_page;
+	if (bw > 0 && r.bottom > 0)
+	{
+		const u32 rows = (r.bottom + GSLocalMemory::m_psm[psm].pgs.y - 1) / GSLocalMemory::m_psm[psm].pgs.y;
+		last_page = std::min(bp + bw * 32 * rows, MAX_BP) >> 5;
+	}
+
 	for (int type = 0; type < 2; ++type)
 	{
-		auto& list = m_dst[type];
-		for (auto i = list.begin(); i != list.end();)
+		auto& pages = m_dst_pages[type];
+		m_invalidate_targets.clear();
+		for (u32 page = first_page; page <= last_page; page++)
 		{
-			auto j = i++;
-			Target* t = *j;
+			for (auto t : pages.Starting(page))
+				m_invalidate_targets.push_back(t);
+		}
+		for (auto t : pages.Covering(first_page))
+		{
+			if ((t->m_TEX0.TBP0 >> 5) < first_page)
+				m_invalidate_targets.push_back(t);
+		}
 
+		for (Target* t : m_invalidate_targets)
+		{
 			// GH: (I think) this code is completely broken. Typical issue:
 			// EE write an alpha channel into 32 bits texture
 			// Results: the target is deleted (because HasCompatibleBits is false)
@@ -934,13 +970,12 @@ void GSTextureCache::InvalidateVideoMem(const GSOffset& off, const GSVector4i& r
 					}
 					else
 					{
-						list.erase(j);
 #ifdef PCSX2_DEBUG
 						GL_CACHE("TC: Remove Target(%s) %d (0x%x)", to_string(type),
 							t->m_texture ? t->m_texture->GetID() : 0,
 							t->m_TEX0.TBP0);
 #endif
-						delete t;
+						RemoveTarget(t);
 					}
 					continue;
 				}
@@ -1031,6 +1066,9 @@ void GSTextureCache::InvalidateLocalMem(const GSOffset& off, const GSVector4i& r
 		r.z,
 		r.w);
 #endif
+	// Whatever is read back below, or was queued before, has to be in local memory when we return.
+	ScopedGuard resolve_readbacks([this, &off, &r]() { ResolvePendingReadbacks(off, r); });
+
 	if (GSConfig.HWDisableReadbacks)
 	{
 #ifdef PCSX2_DEBUG
@@ -1275,8 +1313,8 @@ void GSTextureCache::InvalidateVideoMemSubTarget(GSTextureCache::Target* rt)
 			GL_INS("InvalidateVideoMemSubTarget: rt 0x%x -> 0x%x, sub rt 0x%x -> 0x%x",
 				rt->m_TEX0.TBP0, rt->m_end_block, t->m_TEX0.TBP0, t->m_end_block);
 #endif
-			i = list.erase(i);
-			delete t;
+			++i;
+			RemoveTarget(t);
 		}
 		else
 		{
@@ -1357,13 +1395,13 @@ void GSTextureCache::IncAge()
 
 			if (++t->m_age > max_rt_age)
 			{
-				i = list.erase(i);
+				++i;
 #ifdef PCSX2_DEBUG
 				GL_CACHE("TC: Remove Target(%s): %d (0x%x) due to age", to_string(type),
 					t->m_texture ? t->m_texture->GetID() : 0,
 					t->m_TEX0.TBP0);
 #endif
-				delete t;
+				RemoveTarget(t);
 			}
 			else
 			{
@@ -1831,6 +1869,13 @@ GSTextureCache::HashCacheEntry* GSTextureCache::LookupHashCache(const GIFRegTEX0
 	return &m_hash_cache.emplace(key, entry).first->second;
 }
 
+void GSTextureCache::RemoveTarget(Target* t)
+{
+	m_dst[t->m_type].EraseIndex(t->m_dst_it);
+	m_dst_pages[t->m_type].Remove(t, t->m_TEX0.TBP0);
+	delete t;
+}
+
 GSTextureCache::Target* GSTextureCache::CreateTarget(const GIFRegTEX0& TEX0, int w, int h, int type, const bool clear)
 {
 	ASSERT(type == RenderTarget || type == DepthStencil);
@@ -1852,7 +1897,8 @@ GSTextureCache::Target* GSTextureCache::CreateTarget(const GIFRegTEX0& TEX0, int
 
 	t->m_texture->SetScale(g_gs_renderer->GetTextureScaleFactor());
 
-	m_dst[type].push_front(t);
+	t->m_dst_it = m_dst[type].InsertFront(t);
+	m_dst_pages[type].Insert(t, t->m_TEX0.TBP0, t->m_end_block);
 
 	return t;
 }
@@ -1904,52 +1950,129 @@ void GSTextureCache::Read(Target* t, const GSVector4i& r)
 #endif
 
 	const GSVector4 src = GSVector4(r) * GSVector4(t->m_texture->GetScale()).xyxy() / GSVector4(t->m_texture->GetSize()).xyxy();
+	const bool direct = (t->m_texture->GetScale() == GSVector2(1, 1) && ps_shader == ShaderConvert::COPY);
+
+	// Queue the copy and leave local memory alone until something reads or writes those pages, so
+	// the GPU isn't drained once per target and parts nobody looks at never get swizzled.
+	const u32 queue_size = g_gs_device->GetDownloadQueueSize();
+	if (GSConfig.HWDeferReadbacks && queue_size > 0)
+	{
+		if (m_pending_readbacks.size() >= queue_size)
+			ResolveOldestReadbacks(m_pending_readbacks.size() - queue_size + 1);
+
+		const int slot = direct ?
+			g_gs_device->QueueDownloadTexture(t->m_texture, r) :
+			g_gs_device->QueueDownloadTextureConvert(t->m_texture, src, GSVector2i(r.width(), r.height()), fmt, ps_shader, false);
+		if (slot >= 0)
+		{
+			PendingReadback& rb = m_pending_readbacks.emplace_back();
+			rb.TEX0 = TEX0;
+			rb.rect = r;
+			rb.slot = slot;
+			memset(rb.pages, 0, sizeof(rb.pages));
+			g_gs_renderer->m_mem.GetOffset(TEX0.TBP0, TEX0.TBW, TEX0.PSM).loopPages(r, [&rb](u32 page) {
+				rb.pages[page >> 5] |= 1u << (page & 31);
+			});
+			return;
+		}
+	}
+
+	// Queued readbacks over the same pages are older than this one and must not land on top of it.
+	ResolvePendingReadbacks(g_gs_renderer->m_mem.GetOffset(TEX0.TBP0, TEX0.TBW, TEX0.PSM), r);
 
 	bool res;
 	GSTexture::GSMap m;
 
-	if (t->m_texture->GetScale() == GSVector2(1, 1) && ps_shader == ShaderConvert::COPY)
+	if (direct)
 		res = g_gs_device->DownloadTexture(t->m_texture, r, m);
 	else
 		res = g_gs_device->DownloadTextureConvert(t->m_texture, src, GSVector2i(r.width(), r.height()), fmt, ps_shader, m, false);
 
 	if (res)
 	{
-		const GSOffset off = g_gs_renderer->m_mem.GetOffset(TEX0.TBP0, TEX0.TBW, TEX0.PSM);
+		g_perfmon.Put(GSPerfMon::ReadbacksForced, 1);
+		WriteReadback(TEX0, r, m);
+		g_gs_device->DownloadTextureComplete();
+	}
+}
+
+void GSTextureCache::ResolvePendingReadbacks(const GSOffset& off, const GSVector4i& r)
+{
+	if (m_pending_readbacks.empty() || r.rempty())
+		return;
 
-		switch (TEX0.PSM)
+	// Readbacks can overlap each other, so the last one touching these pages has to land after
+	// everything that was queued before it.
+	size_t count = 0;
+	off.loopPages(r, [this, &count](u32 page) {
+		for (size_t i = m_pending_readbacks.size(); i > count; i--)
 		{
-			case PSM_PSMCT32:
-			case PSM_PSMZ32:
-				g_gs_renderer->m_mem.WritePixel32(m.bits, m.pitch, off, r);
-				break;
-			case PSM_PSMCT24:
-			case PSM_PSMZ24:
-				g_gs_renderer->m_mem.WritePixel24(m.bits, m.pitch, off, r);
-				break;
-			case PSM_PSMCT16:
-			case PSM_PSMCT16S:
-			case PSM_PSMZ16:
-			case PSM_PSMZ16S:
-				g_gs_renderer->m_mem.WritePixel16(m.bits, m.pitch, off, r);
+			if (m_pending_readbacks[i - 1].pages[page >> 5] & (1u << (page & 31)))
+			{
+				count = i;
 				break;
-
-			default:
-				ASSERT(0);
+			}
 		}
+	});
 
-		g_gs_device->DownloadTextureComplete();
+	if (count > 0)
+		ResolveOldestReadbacks(count);
+}
+
+void GSTextureCache::ResolveOldestReadbacks(size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const PendingReadback& rb = m_pending_readbacks[i];
+
+		g_perfmon.Put(g_gs_device->IsQueuedDownloadReady(rb.slot) ? GSPerfMon::ReadbacksDeferred : GSPerfMon::ReadbacksForced, 1);
+
+		GSTexture::GSMap m;
+		if (g_gs_device->MapQueuedDownload(rb.slot, m))
+			WriteReadback(rb.TEX0, rb.rect, m);
+
+		g_gs_device->ReleaseQueuedDownload(rb.slot);
+	}
+
+	m_pending_readbacks.erase(m_pending_readbacks.begin(), m_pending_readbacks.begin() + count);
+}
+
+void GSTextureCache::WriteReadback(const GIFRegTEX0& TEX0, const GSVector4i& r, const GSTexture::GSMap& m)
+{
+	const GSOffset off = g_gs_renderer->m_mem.GetOffset(TEX0.TBP0, TEX0.TBW, TEX0.PSM);
+
+	switch (TEX0.PSM)
+	{
+		case PSM_PSMCT32:
+		case PSM_PSMZ32:
+			g_gs_renderer->m_mem.WritePixel32(m.bits, m.pitch, off, r);
+			break;
+		case PSM_PSMCT24:
+		case PSM_PSMZ24:
+			g_gs_renderer->m_mem.WritePixel24(m.bits, m.pitch, off, r);
+			break;
+		case PSM_PSMCT16:
+		case PSM_PSMCT16S:
+		case PSM_PSMZ16:
+		case PSM_PSMZ16S:
+			g_gs_renderer->m_mem.WritePixel16(m.bits, m.pitch, off, r);
+			break;
+
+		default:
+			ASSERT(0);
 	}
 }
 
 void GSTextureCache::Read(Source* t, const GSVector4i& r)
 {
 	const GIFRegTEX0& TEX0 = t->m_TEX0;
+	const GSOffset off = g_gs_renderer->m_mem.GetOffset(TEX0.TBP0, TEX0.TBW, TEX0.PSM);
+
+	ResolvePendingReadbacks(off, r);
 
 	GSTexture::GSMap m;
 	if (g_gs_device->DownloadTexture(t->m_texture, r, m))
 	{
-		GSOffset off = g_gs_renderer->m_mem.GetOffset(TEX0.TBP0, TEX0.TBW, TEX0.PSM);
 		g_gs_renderer->m_mem.WritePixel32(m.bits, m.pitch, off, r);
 		g_gs_device->DownloadTextureComplete();
 	}
@@ -2345,6 +2468,9 @@ void GSTextureCache::Target::Update()
 	if (r.rempty())
 		return;
 
+	// the dirty area is uploaded from local memory
+	GSRendererHW::GetInstance()->GetTextureCache()->ResolvePendingReadbacks(g_gs_renderer->m_mem.GetOffset(m_TEX0.TBP0, m_TEX0.TBW, m_TEX0.PSM), r);
+
 	// No handling please
 	if ((m_type == DepthStencil) && !m_depth_supported)
 	{
@@ -2449,7 +2575,12 @@ void GSTextureCache::Target::UpdateValidity(const GSVector4i& rect)
 	m_valid = m_valid.runion(rect);
 
 	// Block of the bottom right texel of the validity rectangle, last valid block of the texture
-	m_end_block = GSLocalMemory::m_psm[m_TEX0.PSM].info.bn(m_valid.z - 1, m_valid.w - 1, m_TEX0.TBP0, m_TEX0.TBW); // Valid only for color formats
+	const u32 end_block = GSLocalMemory::m_psm[m_TEX0.PSM].info.bn(m_valid.z - 1, m_valid.w - 1, m_TEX0.TBP0, m_TEX0.TBW); // Valid only for color formats
+	if (end_block != m_end_block)
+	{
+		m_end_block = end_block;
+		GSRendererHW::GetInstance()->GetTextureCache()->m_dst_pages[m_type].Cover(this, m_TEX0.TBP0, m_end_block);
+	}
 
 	// GL_CACHE("UpdateValidity (0x%x->0x%x) from R:%d,%d Valid: %d,%d", m_TEX0.TBP0, m_end_block, rect.z, rect.w, m_valid.z, m_valid.w);
 }
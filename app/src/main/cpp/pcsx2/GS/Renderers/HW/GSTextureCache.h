@@ -19,6 +19,7 @@
 
 #include "GS/Renderers/Common/GSRenderer.h"
 #include "GS/Renderers/Common/GSFastList.h"
+#include "GS/Renderers/Common/GSPageIndex.h"
 #include "GS/Renderers/Common/GSDirtyRect.h"
 #include <unordered_set>
 
@@ -193,6 +194,9 @@ public:
 		GSVector4i m_valid;
 		const bool m_depth_supported;
 		bool m_dirty_alpha;
+		// Keep a GSTextureCache::m_dst index and the GSTextureCache::m_dst_pages position to allow fast moves and erase
+		u16 m_dst_it;
+		GSPageIndexEntry m_page_entry;
 
 	public:
 		Target(const GIFRegTEX0& TEX0, const bool depth_supported, const int type);
@@ -243,6 +247,15 @@ public:
 		void RemoveAt(Source* s);
 	};
 
+	/// A target readback which was queued on the device but hasn't been written to local memory yet.
+	struct PendingReadback
+	{
+		GIFRegTEX0 TEX0;
+		GSVector4i rect;
+		u32 pages[MAX_PAGES / 32]; // bitmap of the pages the readback writes
+		int slot;
+	};
+
 	struct SurfaceOffsetKeyElem
 	{
 		u32 psm;
@@ -278,10 +291,20 @@ protected:
 	std::unordered_map<HashCacheKey, HashCacheEntry, HashCacheKeyHash> m_hash_cache;
 	u64 m_hash_cache_memory_usage = 0;
 	FastList<Target*> m_dst[2];
+	GSPageIndex<Target> m_dst_pages[2]; // m_dst by page, kept in sync with it
+	std::vector<Target*> m_invalidate_targets; // scratch list for InvalidateVideoMem
 	static u8* m_temp;
 	constexpr static size_t S_SURFACE_OFFSET_CACHE_MAX_SIZE = std::numeric_limits<u16>::max();
 	std::unordered_map<SurfaceOffsetKey, SurfaceOffset, SurfaceOffsetKeyHash, SurfaceOffsetKeyEqual> m_surface_offset_cache;
 	Source* m_temporary_source = nullptr; // invalidated after the draw
+	std::vector<PendingReadback> m_pending_readbacks; // in the order they were queued
+
+	/// Writes the first `count` queued readbacks to local memory, in order.
+	void ResolveOldestReadbacks(size_t count);
+	static void WriteReadback(const GIFRegTEX0& TEX0, const GSVector4i& r, const GSTexture::GSMap& m);
+
+	/// Unlinks the target from m_dst and the page index, then deletes it.
+	void RemoveTarget(Target* t);
 
 	Source* CreateSource(const GIFRegTEX0& TEX0, const GIFRegTEXA& TEXA, Target* t = NULL, bool half_right = false, int x_offset = 0, int y_offset = 0, const GSVector2i* lod = nullptr, const GSVector4i* src_range = nullptr);
 	Target* CreateTarget(const GIFRegTEX0& TEX0, int w, int h, int type, const bool clear);
@@ -306,6 +329,11 @@ public:
 	void Read(Target* t, const GSVector4i& r);
 	void Read(Source* t, const GSVector4i& r);
 	void RemoveAll();
+
+	/// Writes queued readbacks which touch the pages of `r` to local memory, along with everything queued before them.
+	void ResolvePendingReadbacks(const GSOffset& off, const GSVector4i& r);
+	/// Writes every queued readback to local memory.
+	void ResolvePendingReadbacks() { ResolveOldestReadbacks(m_pending_readbacks.size()); }
 	void RemovePartial();
 
 	Source* LookupSource(const GIFRegTEX0& TEX0, const GIFRegTEXA& TEXA, const GSVector4i& r, const GSVector2i* lod);
@@ -18,6 +18,7 @@
 #include "common/AlignedMalloc.h"
 #include "common/HashCombine.h"
 #include "common/FileSystem.h"
+#include "common/MPMCQueue.h"
 #include "common/Path.h"
 #include "common/StringUtil.h"
 #include "common/ScopedGuard.h"
@@ -32,13 +33,14 @@
 #include "VMManager.h"
 #endif
 
+#include <algorithm>
+#include <atomic>
 #include <cinttypes>
 #include <cstring>
-#include <functional>
+#include <deque>
 #include <mutex>
 #include <unordered_map>
 #include <unordered_set>
-#include <queue>
 #include <tuple>
 #include <thread>
 
@@ -115,16 +117,60 @@ namespace GSTextureReplacements
 	static std::string GetDumpFilename(const TextureName& name, u32 level);
 	static std::string GetGameSerial();
 	static std::optional<ReplacementTexture> LoadReplacementTexture(const TextureName& name, const std::string& filename, bool only_base_image);
-	static void QueueAsyncReplacementTextureLoad(const TextureName& name, const std::string& filename, bool mipmap);
 	static void PrecacheReplacementTextures();
 	static void ClearReplacementTextures();
 
+	/// Work for the loader/dumper pool. Plain data rather than a closure, so queueing doesn't allocate.
+	struct WorkerItem
+	{
+		enum class Type : u8
+		{
+			Load,
+			Dump,
+		};
+
+		Type type = Type::Load;
+		bool mipmap = false; // load: create the texture with mipmaps
+		u32 generation = 0; // load: dropped if the pending loads were cancelled since
+		u32 width = 0; // dump
+		u32 height = 0; // dump
+		u32 pitch = 0; // dump
+		TextureName name = {}; // load
+		std::string filename;
+		AlignedBuffer<u8, 32> buffer; // dump, must be 32 byte aligned for ReadTexture()
+	};
+
+	/// Which worker queue an item goes to. Demand loads are for textures the TC is waiting on this frame,
+	/// everything else (dumps, precaching) only runs when there's no demand load to pick up.
+	enum class WorkerLane : u8
+	{
+		Demand,
+		Background,
+	};
+
+	/// Replacement loaded by a worker, waiting for the GS thread to upload it.
+	struct AsyncLoadedTexture
+	{
+		TextureName name;
+		bool mipmap;
+		bool valid; // false if loading failed
+		u32 generation;
+		ReplacementTexture texture;
+		AsyncLoadedTexture* next;
+	};
+
+	static void QueueAsyncReplacementTextureLoad(const TextureName& name, const std::string& filename, bool mipmap, WorkerLane lane);
+
 	static void StartWorkerThread();
 	static void StopWorkerThread();
-	static void QueueWorkerThreadItem(std::function<void()> fn);
+	static void QueueWorkerThreadItem(WorkerLane lane, WorkerItem item);
+	static bool TryPopWorkerThreadItem(WorkerItem& item);
 	static void WorkerThreadEntryPoint();
+	static void ExecuteWorkerItem(WorkerItem& item);
 	static void SyncWorkerThread();
 	static void CancelPendingLoadsAndDumps();
+	static AsyncLoadedTexture* TakeAsyncLoadedTextures();
+	static void DiscardAsyncLoadedTextures();
 
 	static std::string s_current_serial;
 
@@ -141,22 +187,32 @@ namespace GSTextureReplacements
 	static std::unordered_set<TextureName> s_replacement_textures_without_clut_hash;
 
 	/// Lookup map of texture names to replacement data which has been cached.
+	/// Only touched by the GS thread, the workers hand their results over through s_async_loaded_textures.
 	static std::unordered_map<TextureName, ReplacementTexture> s_replacement_texture_cache;
-	static std::mutex s_replacement_texture_cache_mutex;
 
-	/// List of textures that are pending asynchronous load.
-	static std::unordered_set<TextureName> s_pending_async_load_textures;
-
-	/// List of textures that we have asynchronously loaded and can now be injected back into the TC.
-	/// Second element is whether the texture should be created with mipmaps.
-	static std::vector<std::pair<TextureName, bool>> s_async_loaded_textures;
-
-	/// Loader/dumper thread.
-	static std::thread s_worker_thread;
-	static std::mutex s_worker_thread_mutex;
-	static std::condition_variable s_worker_thread_cv;
-	static std::queue<std::function<void()>> s_worker_thread_queue;
-	static bool s_worker_thread_running = false;
+	/// Textures that are pending asynchronous load, and whether they've been queued on the demand lane.
+	static std::unordered_map<TextureName, bool> s_pending_async_load_textures;
+
+	/// Textures that we have asynchronously loaded and can now be injected back into the TC.
+	/// Lock-free stack, workers push and the GS thread takes the whole list at once.
+	static std::atomic<AsyncLoadedTexture*> s_async_loaded_textures{nullptr};
+
+	/// Bumped whenever pending loads are cancelled, results from older generations are thrown away.
+	static std::atomic<u32> s_async_load_generation{0};
+
+	/// Loader/dumper pool.
+	static constexpr u32 MAX_WORKER_THREADS = 4;
+	static std::vector<std::thread> s_worker_threads;
+	static MPMCQueue<WorkerItem, 256> s_worker_demand_queue;
+	static MPMCQueue<WorkerItem, 1024> s_worker_background_queue;
+	/// Overflow for when a queue is full, so the GS thread never waits on the workers.
+	static std::mutex s_worker_spill_mutex;
+	static std::deque<WorkerItem> s_worker_demand_spill;
+	static std::deque<WorkerItem> s_worker_background_spill;
+	static std::atomic<u32> s_worker_spill_count{0};
+	static Threading::UserspaceSemaphore s_worker_sema;
+	static std::atomic<u32> s_worker_outstanding{0};
+	static std::atomic<bool> s_worker_thread_running{false};
 }; // namespace GSTextureReplacements
 
 TextureName GSTextureReplacements::CreateTextureName(const GSTextureCache::HashCacheKey& hash, u32 miplevel)
@@ -296,10 +352,9 @@ void GSTextureReplacements::ReloadReplacementMap()
 		s_replacement_texture_filenames.clear();
 		s_replacement_textures_without_clut_hash.clear();
 
-		std::unique_lock<std::mutex> lock(s_replacement_texture_cache_mutex);
 		s_replacement_texture_cache.clear();
 		s_pending_async_load_textures.clear();
-		s_async_loaded_textures.clear();
+		DiscardAsyncLoadedTextures();
 	}
 
 	// can't replace bios textures.
@@ -412,22 +467,18 @@ GSTexture* GSTextureReplacements::LookupReplacementTexture(const GSTextureCache:
 		return nullptr;
 
 	// try the full cache first, to avoid reloading from disk
+	auto it = s_replacement_texture_cache.find(name);
+	if (it != s_replacement_texture_cache.end())
 	{
-		std::unique_lock<std::mutex> lock(s_replacement_texture_cache_mutex);
-		auto it = s_replacement_texture_cache.find(name);
-		if (it != s_replacement_texture_cache.end())
-		{
-			// replacement is cached, can immediately upload to host GPU
-			return CreateReplacementTexture(it->second, name.ReplacementScale(it->second), mipmap);
-		}
+		// replacement is cached, can immediately upload to host GPU
+		return CreateReplacementTexture(it->second, name.ReplacementScale(it->second), mipmap);
 	}
 
 	// load asynchronously?
 	if (GSConfig.LoadTextureReplacementsAsync)
 	{
 		// replacement will be injected into the TC later on
-		std::unique_lock<std::mutex> lock(s_replacement_texture_cache_mutex);
-		QueueAsyncReplacementTextureLoad(name, fnit->second, mipmap);
+		QueueAsyncReplacementTextureLoad(name, fnit->second, mipmap, WorkerLane::Demand);
 
 		*pending = true;
 		return nullptr;
@@ -440,7 +491,6 @@ GSTexture* GSTextureReplacements::LookupReplacementTexture(const GSTextureCache:
 			return nullptr;
 
 		// insert into cache
-		std::unique_lock<std::mutex> lock(s_replacement_texture_cache_mutex);
 		const ReplacementTexture& rtex = s_replacement_texture_cache.emplace(name, std::move(replacement.value())).first->second;
 
 		// and upload to gpu
@@ -461,40 +511,36 @@ std::optional<GSTextureReplacements::ReplacementTexture> GSTextureReplacements::
 	return rtex;
 }
 
-void GSTextureReplacements::QueueAsyncReplacementTextureLoad(const TextureName& name, const std::string& filename, bool mipmap)
+void GSTextureReplacements::QueueAsyncReplacementTextureLoad(const TextureName& name, const std::string& filename, bool mipmap, WorkerLane lane)
 {
-	// check the pending list, so we don't queue it up multiple times
-	if (s_pending_async_load_textures.find(name) != s_pending_async_load_textures.end())
-		return;
-
-	s_pending_async_load_textures.insert(name);
-	QueueWorkerThreadItem([name, filename, mipmap]() {
-		// actually load the file, this is what will take the time
-		std::optional<ReplacementTexture> replacement(LoadReplacementTexture(name, filename, !mipmap));
+	const bool demand = (lane == WorkerLane::Demand);
 
-		// check the pending set, there's a race here if we disable replacements while loading otherwise
-		std::unique_lock<std::mutex> lock(s_replacement_texture_cache_mutex);
-		if (s_pending_async_load_textures.find(name) == s_pending_async_load_textures.end())
+	// check the pending list, so we don't queue it up multiple times.
+	// a precache load which the TC is now waiting on gets queued again on the demand lane, whichever finishes first wins.
+	auto it = s_pending_async_load_textures.find(name);
+	if (it != s_pending_async_load_textures.end())
+	{
+		if (!demand || it->second)
 			return;
 
-		// insert into the cache and queue for later injection
-		if (replacement.has_value())
-		{
-			s_replacement_texture_cache.emplace(name, std::move(replacement.value()));
-			s_async_loaded_textures.emplace_back(name, mipmap);
-		}
-		else
-		{
-			// loading failed, so clear it from the pending list
-			s_pending_async_load_textures.erase(name);
-		}
-	});
+		it->second = true;
+	}
+	else
+	{
+		s_pending_async_load_textures.emplace(name, demand);
+	}
+
+	WorkerItem item;
+	item.type = WorkerItem::Type::Load;
+	item.mipmap = mipmap;
+	item.generation = s_async_load_generation.load(std::memory_order_relaxed);
+	item.name = name;
+	item.filename = filename;
+	QueueWorkerThreadItem(lane, std::move(item));
 }
 
 void GSTextureReplacements::PrecacheReplacementTextures()
 {
-	std::unique_lock<std::mutex> lock(s_replacement_texture_cache_mutex);
-
 	// predict whether the requests will come with mipmaps
 	// TODO: This will be wrong for hw mipmap games like Jak.
 	const bool mipmap = GSConfig.HWMipmap >= HWMipmapLevel::Basic ||
@@ -507,7 +553,7 @@ void GSTextureReplacements::PrecacheReplacementTextures()
 			continue;
 
 		// precaching always goes async.. for now
-		QueueAsyncReplacementTextureLoad(it.first, it.second, mipmap);
+		QueueAsyncReplacementTextureLoad(it.first, it.second, mipmap, WorkerLane::Background);
 	}
 }
 
@@ -516,10 +562,9 @@ void GSTextureReplacements::ClearReplacementTextures()
 	s_replacement_texture_filenames.clear();
 	s_replacement_textures_without_clut_hash.clear();
 
-	std::unique_lock<std::mutex> lock(s_replacement_texture_cache_mutex);
 	s_replacement_texture_cache.clear();
 	s_pending_async_load_textures.clear();
-	s_async_loaded_textures.clear();
+	DiscardAsyncLoadedTextures();
 }
 
 GSTexture* GSTextureReplacements::CreateReplacementTexture(const ReplacementTexture& rtex, const GSVector2& scale, bool mipmap)
@@ -565,24 +610,58 @@ GSTexture* GSTextureReplacements::CreateReplacementTexture(const ReplacementText
 
 void GSTextureReplacements::ProcessAsyncLoadedTextures()
 {
-	// this holds the lock while doing the upload, but it should be reasonably quick
-	std::unique_lock<std::mutex> lock(s_replacement_texture_cache_mutex);
-	for (const auto& [name, mipmap] : s_async_loaded_textures)
+	AsyncLoadedTexture* list = TakeAsyncLoadedTextures();
+	if (!list)
+		return;
+
+	const u32 generation = s_async_load_generation.load(std::memory_order_relaxed);
+	while (list)
 	{
-		// no longer pending!
-		s_pending_async_load_textures.erase(name);
+		std::unique_ptr<AsyncLoadedTexture> loaded(list);
+		list = list->next;
 
-		// we should be in the cache now, lock and loaded
-		auto it = s_replacement_texture_cache.find(name);
-		if (it == s_replacement_texture_cache.end())
+		// no longer pending! if it isn't pending, the load was cancelled or a second copy of it already got here.
+		// failed loads still come through here so they get cleared from the pending list.
+		const TextureName& name = loaded->name;
+		if (loaded->generation != generation || s_pending_async_load_textures.erase(name) == 0 || !loaded->valid)
 			continue;
 
 		// upload and inject into TC
-		GSTexture* tex = CreateReplacementTexture(it->second, name.ReplacementScale(it->second), mipmap);
+		const ReplacementTexture& rtex = s_replacement_texture_cache.emplace(name, std::move(loaded->texture)).first->second;
+		GSTexture* tex = CreateReplacementTexture(rtex, name.ReplacementScale(rtex), loaded->mipmap);
 		if (tex)
 			s_tc->InjectHashCacheTexture(HashCacheKeyFromTextureName(name), tex);
 	}
-	s_async_loaded_textures.clear();
+}
+
+GSTextureReplacements::AsyncLoadedTexture* GSTextureReplacements::TakeAsyncLoadedTextures()
+{
+	AsyncLoadedTexture* list = s_async_loaded_textures.exchange(nullptr, std::memory_order_acquire);
+
+	// the stack hands them back newest first, put them back in completion order
+	AsyncLoadedTexture* ordered = nullptr;
+	while (list)
+	{
+		AsyncLoadedTexture* next = list->next;
+		list->next = ordered;
+		ordered = list;
+		list = next;
+	}
+	return ordered;
+}
+
+void GSTextureReplacements::DiscardAsyncLoadedTextures()
+{
+	// anything still in flight will see the new generation and be dropped too
+	s_async_load_generation.fetch_add(1, std::memory_order_relaxed);
+
+	AsyncLoadedTexture* list = TakeAsyncLoadedTextures();
+	while (list)
+	{
+		AsyncLoadedTexture* next = list->next;
+		delete list;
+		list = next;
+	}
 }
 
 void GSTextureReplacements::DumpTexture(const GSTextureCache::HashCacheKey& hash, const GIFRegTEX0& TEX0, const GIFRegTEXA& TEXA, GSLocalMemory& mem, u32 level)
@@ -595,7 +674,10 @@ void GSTextureReplacements::DumpTexture(const GSTextureCache::HashCacheKey& hash
 	s_dumped_textures.insert(name);
 
 	// already exists on disk?
-	std::string filename(GetDumpFilename(name, level));
+	WorkerItem item;
+	item.type = WorkerItem::Type::Dump;
+	item.filename = GetDumpFilename(name, level);
+	const std::string& filename = item.filename;
 	if (filename.empty() || FileSystem::FileExists(filename.c_str()))
 		return;
 
@@ -614,18 +696,14 @@ void GSTextureReplacements::DumpTexture(const GSTextureCache::HashCacheKey& hash
 	const u32 pitch = static_cast<u32>(read_width) * sizeof(u32);
 
 	// use per-texture buffer so we can compress the texture asynchronously and not block the GS thread
-	// must be 32 byte aligned for ReadTexture().
-	AlignedBuffer<u8, 32> buffer(pitch * static_cast<u32>(read_height));
-	(mem.*psm.rtx)(mem.GetOffset(TEX0.TBP0, TEX0.TBW, TEX0.PSM), block_rect, buffer.GetPtr(), pitch, TEXA);
+	item.width = static_cast<u32>(tw);
+	item.height = static_cast<u32>(th);
+	item.pitch = pitch;
+	item.buffer.Alloc(pitch * static_cast<u32>(read_height));
+	(mem.*psm.rtx)(mem.GetOffset(TEX0.TBP0, TEX0.TBW, TEX0.PSM), block_rect, item.buffer.GetPtr(), pitch, TEXA);
 
 	// okay, now we can actually dump it
-	QueueWorkerThreadItem([filename = std::move(filename), tw, th, pitch, buffer = std::move(buffer)]() {
-		if (!SavePNGImage(filename.c_str(), tw, th, buffer.GetPtr(), pitch)) {
-#ifdef PCSX2_DEBUG
-            Console.Error("Failed to dump texture to '%s'.", filename.c_str());
-#endif
-        }
-	});
+	QueueWorkerThreadItem(WorkerLane::Background, std::move(item));
 }
 
 void GSTextureReplacements::ClearDumpedTextureList()
@@ -639,83 +717,162 @@ void GSTextureReplacements::ClearDumpedTextureList()
 
 void GSTextureReplacements::StartWorkerThread()
 {
-	std::unique_lock<std::mutex> lock(s_worker_thread_mutex);
-
-	if (s_worker_thread.joinable())
+	if (!s_worker_threads.empty())
 		return;
 
-	s_worker_thread_running = true;
-	s_worker_thread = std::thread(WorkerThreadEntryPoint);
+	// png decode/encode is the bulk of the work, leave the other cores to the emulator
+	const u32 count = std::clamp(std::thread::hardware_concurrency() / 2, 1u, MAX_WORKER_THREADS);
+
+	s_worker_thread_running.store(true, std::memory_order_release);
+	s_worker_threads.reserve(count);
+	for (u32 i = 0; i < count; i++)
+		s_worker_threads.emplace_back(WorkerThreadEntryPoint);
 }
 
 void GSTextureReplacements::StopWorkerThread()
 {
-	{
-		std::unique_lock<std::mutex> lock(s_worker_thread_mutex);
-		if (!s_worker_thread.joinable())
-			return;
-
-		s_worker_thread_running = false;
-		s_worker_thread_cv.notify_one();
-	}
+	if (s_worker_threads.empty())
+		return;
 
-	s_worker_thread.join();
+	s_worker_thread_running.store(false, std::memory_order_release);
+	for (size_t i = 0; i < s_worker_threads.size(); i++)
+		s_worker_sema.Post();
+	for (std::thread& thread : s_worker_threads)
+		thread.join();
+	s_worker_threads.clear();
 
 	// clear out workery-things too
 	CancelPendingLoadsAndDumps();
 }
 
-void GSTextureReplacements::QueueWorkerThreadItem(std::function<void()> fn)
+void GSTextureReplacements::QueueWorkerThreadItem(WorkerLane lane, WorkerItem item)
 {
-	pxAssert(s_worker_thread.joinable());
+	pxAssert(!s_worker_threads.empty());
+
+	s_worker_outstanding.fetch_add(1, std::memory_order_relaxed);
+
+	// the queues are bounded, anything past that (e.g. a big precache) goes to the spill list
+	const bool pushed = (lane == WorkerLane::Demand) ?
+		s_worker_demand_queue.try_push(std::move(item)) :
+		s_worker_background_queue.try_push(std::move(item));
+	if (!pushed)
+	{
+		std::unique_lock lock(s_worker_spill_mutex);
+		((lane == WorkerLane::Demand) ? s_worker_demand_spill : s_worker_background_spill).push_back(std::move(item));
+		s_worker_spill_count.fetch_add(1, std::memory_order_release);
+	}
 
-	std::unique_lock<std::mutex> lock(s_worker_thread_mutex);
-	s_worker_thread_queue.push(std::move(fn));
-	s_worker_thread_cv.notify_one();
+	s_worker_sema.Post();
 }
 
-void GSTextureReplacements::WorkerThreadEntryPoint()
+bool GSTextureReplacements::TryPopWorkerThreadItem(WorkerItem& item)
 {
-	std::unique_lock<std::mutex> lock(s_worker_thread_mutex);
-	while (s_worker_thread_running)
+	if (s_worker_demand_queue.try_pop(item))
+		return true;
+
+	if (s_worker_spill_count.load(std::memory_order_acquire) != 0)
+	{
+		std::unique_lock lock(s_worker_spill_mutex);
+		if (!s_worker_demand_spill.empty())
+		{
+			item = std::move(s_worker_demand_spill.front());
+			s_worker_demand_spill.pop_front();
+			s_worker_spill_count.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	if (s_worker_background_queue.try_pop(item))
+		return true;
+
+	if (s_worker_spill_count.load(std::memory_order_acquire) != 0)
 	{
-		if (s_worker_thread_queue.empty())
+		std::unique_lock lock(s_worker_spill_mutex);
+		if (!s_worker_background_spill.empty())
 		{
-			s_worker_thread_cv.wait(lock);
+			item = std::move(s_worker_background_spill.front());
+			s_worker_background_spill.pop_front();
+			s_worker_spill_count.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void GSTextureReplacements::WorkerThreadEntryPoint()
+{
+	WorkerItem item;
+	for (;;)
+	{
+		// one post per queued item, so there's always something to pop unless it was cancelled
+		s_worker_sema.Wait();
+		if (!s_worker_thread_running.load(std::memory_order_acquire))
+			break;
+
+		if (!TryPopWorkerThreadItem(item))
 			continue;
+
+		ExecuteWorkerItem(item);
+		item = WorkerItem();
+		s_worker_outstanding.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+void GSTextureReplacements::ExecuteWorkerItem(WorkerItem& item)
+{
+	switch (item.type)
+	{
+		case WorkerItem::Type::Load:
+		{
+			// don't bother loading if it was cancelled while queued
+			if (item.generation != s_async_load_generation.load(std::memory_order_relaxed))
+				return;
+
+			// actually load the file, this is what will take the time
+			std::optional<ReplacementTexture> replacement(LoadReplacementTexture(item.name, item.filename, !item.mipmap));
+
+			// failed loads are handed back too, so they get cleared from the pending list
+			AsyncLoadedTexture* loaded = new AsyncLoadedTexture{item.name, item.mipmap, replacement.has_value(), item.generation, {}, nullptr};
+			if (replacement.has_value())
+				loaded->texture = std::move(replacement.value());
+
+			loaded->next = s_async_loaded_textures.load(std::memory_order_relaxed);
+			while (!s_async_loaded_textures.compare_exchange_weak(loaded->next, loaded, std::memory_order_release, std::memory_order_relaxed))
+				;
 		}
+		break;
 
-		std::function<void()> fn = std::move(s_worker_thread_queue.front());
-		s_worker_thread_queue.pop();
-		lock.unlock();
-		fn();
-		lock.lock();
+		case WorkerItem::Type::Dump:
+		{
+			if (!SavePNGImage(item.filename.c_str(), item.width, item.height, item.buffer.GetPtr(), item.pitch))
+			{
+#ifdef PCSX2_DEBUG
+				Console.Error("Failed to dump texture to '%s'.", item.filename.c_str());
+#endif
+			}
+		}
+		break;
 	}
 }
 
 void GSTextureReplacements::SyncWorkerThread()
 {
-	std::unique_lock<std::mutex> lock(s_worker_thread_mutex);
-	if (!s_worker_thread.joinable())
+	if (s_worker_threads.empty())
 		return;
 
 	// not the most efficient by far, but it only gets called on config changes, so whatever
-	for (;;)
-	{
-		if (s_worker_thread_queue.empty())
-			break;
-
-		lock.unlock();
+	while (s_worker_outstanding.load(std::memory_order_acquire) != 0)
 		std::this_thread::sleep_for(std::chrono::milliseconds(1));
-		lock.lock();
-	}
 }
 
 void GSTextureReplacements::CancelPendingLoadsAndDumps()
 {
-	std::unique_lock<std::mutex> lock(s_worker_thread_mutex);
-	while (!s_worker_thread_queue.empty())
-		s_worker_thread_queue.pop();
-	s_async_loaded_textures.clear();
+	// the workers may be popping at the same time, whoever gets an item accounts for it
+	WorkerItem item;
+	while (TryPopWorkerThreadItem(item))
+		s_worker_outstanding.fetch_sub(1, std::memory_order_release);
+
+	DiscardAsyncLoadedTextures();
 	s_pending_async_load_textures.clear();
 }
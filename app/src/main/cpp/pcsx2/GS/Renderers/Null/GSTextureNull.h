@@ -19,24 +19,12 @@
 
 class GSTextureNull final : public GSTexture
 {
-	struct
-	{
-		Type type;
-		Format format;
-		int w, h;
-	} m_desc;
-
 public:
-	GSTextureNull();
-	GSTextureNull(Type type, int w, int h, Format format);
-
-	Type GetType() const { return m_desc.type; }
-	Format GetFormat() const { return m_desc.format; }
+	GSTextureNull(Type type, int width, int height, int levels, Format format);
 
 	bool Update(const GSVector4i& r, const void* data, int pitch, int layer = 0) override { return true; }
 	bool Map(GSMap& m, const GSVector4i* r = NULL, int layer = 0) override { return false; }
 	void Unmap() override {}
 	bool Save(const std::string& fn) override { return false; }
-	void Swap(GSTexture* tex) override;
 	void* GetNativeHandle() const override;
 };
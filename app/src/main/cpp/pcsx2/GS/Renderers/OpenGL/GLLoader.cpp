@@ -162,6 +162,7 @@ namespace GLLoader
 	bool found_framebuffer_fetch = false;
 	bool found_geometry_shader = true; // we require GL3.3 so geometry must be supported by default
 	bool found_GL_ARB_clear_texture = false;
+	bool found_parallel_shader_compile = false;
 	// DX11 GPU
 	bool found_GL_ARB_gpu_shader5 = false;             // Require IvyBridge
 	bool found_GL_ARB_shader_image_load_store = false; // Intel IB. Nvidia/AMD miss Mesa implementation.
@@ -312,6 +313,9 @@ namespace GLLoader
 			found_GL_ARB_get_texture_sub_image = optional("GL_ARB_get_texture_sub_image");
 #endif
 
+			// Lets the driver compile and link on its own threads
+			found_parallel_shader_compile = optional("GL_KHR_parallel_shader_compile") || optional("GL_ARB_parallel_shader_compile");
+
 			found_framebuffer_fetch = GLAD_GL_EXT_shader_framebuffer_fetch || GLAD_GL_ARM_shader_framebuffer_fetch;
 			if (theApp.GetConfigB("disable_framebuffer_fetch"))
 				found_framebuffer_fetch = false;
@@ -14,6 +14,7 @@
  */
 
 #include "PrecompiledHeader.h"
+#include "common/PersistentThread.h"
 #include "common/StringUtil.h"
 #include "GS/GSState.h"
 #include "GSDeviceOGL.h"
@@ -43,6 +44,9 @@ static constexpr u32 INDEX_BUFFER_SIZE = 16 * 1024 * 1024;
 static constexpr u32 VERTEX_UNIFORM_BUFFER_SIZE = 8 * 1024 * 1024;
 static constexpr u32 FRAGMENT_UNIFORM_BUFFER_SIZE = 8 * 1024 * 1024;
 
+// Bump when ProgramSelector changes, older program logs are then ignored.
+static constexpr u32 PROGRAM_LOG_VERSION = 1;
+
 int   GSDeviceOGL::m_shader_inst = 0;
 int   GSDeviceOGL::m_shader_reg  = 0;
 FILE* GSDeviceOGL::m_debug_gl_file = NULL;
@@ -63,6 +67,9 @@ GSDeviceOGL::GSDeviceOGL()
 
 GSDeviceOGL::~GSDeviceOGL()
 {
+	SaveGamePrograms();
+	StopProgramCompileWorkers();
+
 #ifdef ENABLE_OGL_DEBUG
 	if (m_debug_gl_file)
 	{
@@ -94,6 +101,8 @@ GSDeviceOGL::~GSDeviceOGL()
 	m_fragment_uniform_stream_buffer.reset();
 	glDeleteSamplers(1, &m_palette_ss);
 
+	m_pending_programs.clear();
+	m_linking_programs.clear();
 	m_programs.clear();
 
 	glDeleteSamplers(std::size(m_ps_ss), m_ps_ss);
@@ -102,6 +111,13 @@ GSDeviceOGL::~GSDeviceOGL()
 		delete ds;
 
 	PboPool::Destroy();
+
+	for (u32 i = 0; i < DOWNLOAD_QUEUE_SIZE; i++)
+	{
+		ReleaseQueuedDownload(i);
+		if (m_queued_downloads[i].buffer != 0)
+			glDeleteBuffers(1, &m_queued_downloads[i].buffer);
+	}
 }
 
 void GSDeviceOGL::GenerateProfilerData()
@@ -213,6 +229,16 @@ bool GSDeviceOGL::Create(HostDisplay* display)
         Console.Warning("Shader cache failed to open.");
     }
 
+	m_gl_context = static_cast<GL::Context*>(display->GetRenderContext());
+	if (GLLoader::found_parallel_shader_compile)
+	{
+		// Let the driver use as many threads as it wants.
+		if (GLAD_GL_KHR_parallel_shader_compile)
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+		else
+			glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+	}
+
 	// optional features based on context
 	m_features.broken_point_sampler = GLLoader::vendor_id_amd;
 	m_features.geometry_shader = GLLoader::found_geometry_shader;
@@ -1272,6 +1298,84 @@ bool GSDeviceOGL::DownloadTexture(GSTexture* src, const GSVector4i& rect, GSText
 	return true;
 }
 
+int GSDeviceOGL::QueueDownloadTexture(GSTexture* src, const GSVector4i& rect)
+{
+	ASSERT(src);
+
+	auto it = std::find_if(m_queued_downloads.begin(), m_queued_downloads.end(), [](const QueuedDownload& slot) { return !slot.in_use; });
+	if (it == m_queued_downloads.end())
+		return -1;
+
+	g_perfmon.Put(GSPerfMon::Readbacks, 1);
+
+	GSTextureOGL* srcgl = static_cast<GSTextureOGL*>(src);
+	it->pitch = srcgl->GetReadPitch(rect);
+	it->size = it->pitch * rect.height();
+
+	if (it->buffer == 0)
+		glGenBuffers(1, &it->buffer);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, it->buffer);
+	if (it->buffer_size < it->size)
+	{
+		glBufferData(GL_PIXEL_PACK_BUFFER, it->size, nullptr, GL_STREAM_READ);
+		it->buffer_size = it->size;
+	}
+
+	srcgl->ReadToPixelPackBuffer(rect);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	it->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	it->in_use = true;
+	return static_cast<int>(it - m_queued_downloads.begin());
+}
+
+bool GSDeviceOGL::IsQueuedDownloadReady(int slot)
+{
+	const QueuedDownload& qd = m_queued_downloads[slot];
+	const GLenum status = glClientWaitSync(qd.fence, 0, 0);
+	return (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED);
+}
+
+bool GSDeviceOGL::MapQueuedDownload(int slot, GSTexture::GSMap& out_map)
+{
+	QueuedDownload& qd = m_queued_downloads[slot];
+	ASSERT(qd.in_use && !qd.mapped);
+
+	glClientWaitSync(qd.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, qd.buffer);
+	void* map = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, qd.size, GL_MAP_READ_BIT);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	if (!map)
+		return false;
+
+	qd.mapped = true;
+	out_map.bits = static_cast<u8*>(map);
+	out_map.pitch = qd.pitch;
+	return true;
+}
+
+void GSDeviceOGL::ReleaseQueuedDownload(int slot)
+{
+	QueuedDownload& qd = m_queued_downloads[slot];
+	if (qd.mapped)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, qd.buffer);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		qd.mapped = false;
+	}
+
+	if (qd.fence)
+	{
+		glDeleteSync(qd.fence);
+		qd.fence = nullptr;
+	}
+
+	qd.in_use = false;
+}
+
 // Copy a sub part of texture (same as below but force a conversion)
 void GSDeviceOGL::BlitRect(GSTexture* sTex, const GSVector4i& r, const GSVector2i& dsize, bool at_origin, bool linear)
 {
@@ -1953,23 +2057,322 @@ __fi static void WriteToStreamBuffer(GL::StreamBuffer* sb, u32 index, u32 align,
 	glBindBufferRange(GL_UNIFORM_BUFFER, index, sb->GetGLBufferId(), res.buffer_offset, size);
 }
 
-void GSDeviceOGL::SetupPipeline(const ProgramSelector& psel)
+void GSDeviceOGL::SetGameCRC(u32 crc)
 {
-	auto it = m_programs.find(psel);
-	if (it != m_programs.end())
-	{
-		it->second.Bind();
+	if (crc == m_game_crc)
 		return;
+
+	SaveGamePrograms();
+	GSDevice::SetGameCRC(crc);
+
+	// Programs already in the map get recorded again when the new game uses them.
+	m_game_programs.clear();
+	m_program_generation++;
+
+	if (GSConfig.PrecompileShaders)
+		PrecompileGamePrograms();
+}
+
+const GL::Program* GSDeviceOGL::GetProgram(const ProgramSelector& psel, bool wait)
+{
+	const auto [it, inserted] = m_programs.try_emplace(psel);
+	TFXProgram& prog = it->second;
+	if (prog.generation != m_program_generation)
+	{
+		prog.generation = m_program_generation;
+		m_game_programs.push_back(psel);
 	}
 
+	if (inserted)
+	{
+		if (wait)
+		{
+			CompileProgram(psel, prog.program);
+			return &prog.program;
+		}
+
+		StartProgramAsync(psel, prog);
+	}
+
+	u8 state = prog.state.load(std::memory_order_acquire);
+	switch (state)
+	{
+		case TFXProgram::Ready:
+			return &prog.program;
+
+		case TFXProgram::Linking:
+			if (!wait && !prog.program.IsLinkComplete())
+				return nullptr;
+
+			FinishProgram(psel, prog);
+			return &prog.program;
+
+		case TFXProgram::Pending:
+			if (wait)
+			{
+				CompileProgram(psel, prog.program);
+				prog.state.store(TFXProgram::Ready, std::memory_order_relaxed);
+				return &prog.program;
+			}
+
+			// Needed now, don't leave it for EndFrame().
+			StartProgramAsync(psel, prog);
+			return (prog.state.load(std::memory_order_acquire) == TFXProgram::Ready) ? &prog.program : nullptr;
+
+		case TFXProgram::Queued:
+			if (!wait)
+				return nullptr;
+
+			// Don't wait for the compile threads to get to it.
+			if (prog.state.compare_exchange_strong(state, TFXProgram::Compiling, std::memory_order_acq_rel))
+			{
+				CompileProgram(psel, prog.program);
+				prog.state.store(TFXProgram::Ready, std::memory_order_release);
+				return &prog.program;
+			}
+			[[fallthrough]];
+
+		default:
+			if (!wait)
+				return nullptr;
+
+			while (prog.state.load(std::memory_order_acquire) != TFXProgram::Ready)
+				std::this_thread::yield();
+			return &prog.program;
+	}
+}
+
+void GSDeviceOGL::CompileProgram(const ProgramSelector& psel, GL::Program& program)
+{
 	const std::string vs(GetVSSource(psel.vs));
 	const std::string ps(GetPSSource(psel.ps));
 	const std::string gs((psel.gs.key != 0) ? GetGSSource(psel.gs) : std::string());
 
-	GL::Program prog;
-	m_shader_cache.GetProgram(&prog, vs, gs, ps);
-	it = m_programs.emplace(psel, std::move(prog)).first;
-	it->second.Bind();
+	m_shader_cache.GetProgram(&program, vs, gs, ps);
+}
+
+void GSDeviceOGL::StartProgram(const ProgramSelector& psel, TFXProgram& prog)
+{
+	const std::string vs(GetVSSource(psel.vs));
+	const std::string ps(GetPSSource(psel.ps));
+	const std::string gs((psel.gs.key != 0) ? GetGSSource(psel.gs) : std::string());
+
+	bool pending;
+	std::optional<GL::Program> program(m_shader_cache.StartProgram(vs, gs, ps, &pending));
+	if (program)
+		prog.program = std::move(*program);
+
+	prog.state.store(pending ? TFXProgram::Linking : TFXProgram::Ready, std::memory_order_relaxed);
+	if (pending)
+		m_linking_programs.push_back({psel, &prog});
+}
+
+void GSDeviceOGL::FinishProgram(const ProgramSelector& psel, TFXProgram& prog)
+{
+	// The sources are only needed again for the cache key.
+	const std::string vs(GetVSSource(psel.vs));
+	const std::string ps(GetPSSource(psel.ps));
+	const std::string gs((psel.gs.key != 0) ? GetGSSource(psel.gs) : std::string());
+
+	m_shader_cache.FinishProgram(prog.program, vs, gs, ps);
+	prog.state.store(TFXProgram::Ready, std::memory_order_relaxed);
+}
+
+void GSDeviceOGL::StartProgramAsync(const ProgramSelector& psel, TFXProgram& prog)
+{
+	// The driver's own threads are the cheapest, then ours on shared contexts, and as a last resort the GS thread.
+	if (GLLoader::found_parallel_shader_compile)
+		StartProgram(psel, prog);
+	else if (!QueueProgram(psel, prog))
+	{
+		CompileProgram(psel, prog.program);
+		prog.state.store(TFXProgram::Ready, std::memory_order_relaxed);
+	}
+}
+
+bool GSDeviceOGL::StartProgramCompileWorkers()
+{
+	if (m_program_compile_workers_failed || !m_gl_context)
+		return false;
+
+	// Leave some cores for the EE and the GS thread.
+	const u32 count = std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+
+	m_cancel_program_compiles.store(false, std::memory_order_relaxed);
+	for (u32 i = 0; i < count; i++)
+	{
+		std::unique_ptr<GL::Context> context(m_gl_context->CreateSharedContext(WindowInfo()));
+		if (!context)
+			break;
+
+		m_program_compile_workers.emplace_back(&GSDeviceOGL::ProgramCompileWorkerThread, this, context.get());
+		m_program_compile_contexts.push_back(std::move(context));
+	}
+
+	if (m_program_compile_workers.empty())
+	{
+		Console.Warning("(GSDeviceOGL) Failed to create a shared context, programs will be compiled on the GS thread");
+		m_program_compile_workers_failed = true;
+		return false;
+	}
+
+	return true;
+}
+
+void GSDeviceOGL::StopProgramCompileWorkers()
+{
+	if (m_program_compile_workers.empty())
+		return;
+
+	// Jobs left in the list are dropped, their entries are destroyed along with the map.
+	{
+		std::unique_lock lock(m_program_compile_mutex);
+		m_cancel_program_compiles.store(true, std::memory_order_relaxed);
+		m_program_compile_jobs.clear();
+	}
+	m_program_compile_cv.notify_all();
+
+	for (std::thread& thread : m_program_compile_workers)
+		thread.join();
+	m_program_compile_workers.clear();
+	m_program_compile_contexts.clear();
+}
+
+bool GSDeviceOGL::QueueProgram(const ProgramSelector& psel, TFXProgram& prog)
+{
+	if (m_program_compile_workers.empty() && !StartProgramCompileWorkers())
+		return false;
+
+	prog.state.store(TFXProgram::Queued, std::memory_order_relaxed);
+	{
+		std::unique_lock lock(m_program_compile_mutex);
+		m_program_compile_jobs.push_back({psel, &prog});
+	}
+	m_program_compile_cv.notify_one();
+	return true;
+}
+
+void GSDeviceOGL::ProgramCompileWorkerThread(GL::Context* context)
+{
+	Threading::SetNameOfCurrentThread("GL Program Compiler");
+	context->MakeCurrent();
+
+	std::unique_lock lock(m_program_compile_mutex);
+	for (;;)
+	{
+		m_program_compile_cv.wait(lock, [this]() {
+			return m_cancel_program_compiles.load(std::memory_order_relaxed) || !m_program_compile_jobs.empty();
+		});
+		if (m_cancel_program_compiles.load(std::memory_order_relaxed))
+			break;
+
+		ProgramCompileJob job = m_program_compile_jobs.front();
+		m_program_compile_jobs.pop_front();
+
+		lock.unlock();
+		CompileQueuedProgram(job);
+		lock.lock();
+	}
+
+	lock.unlock();
+	context->DoneCurrent();
+}
+
+void GSDeviceOGL::CompileQueuedProgram(ProgramCompileJob& job)
+{
+	// The GS thread may have taken it over already.
+	u8 expected = TFXProgram::Queued;
+	if (m_cancel_program_compiles.load(std::memory_order_relaxed) ||
+		!job.program->state.compare_exchange_strong(expected, TFXProgram::Compiling, std::memory_order_acq_rel))
+	{
+		return;
+	}
+
+	CompileProgram(job.p, job.program->program);
+
+	// The program has to be complete before the GS thread's context can use it.
+	glFinish();
+	job.program->state.store(TFXProgram::Ready, std::memory_order_release);
+}
+
+void GSDeviceOGL::PrecompileGamePrograms()
+{
+	const std::vector<ProgramSelector> selectors(ReadSelectorLog<ProgramSelector>("gl_programs", PROGRAM_LOG_VERSION));
+	if (selectors.empty())
+		return;
+
+	u32 started = 0;
+	for (const ProgramSelector& p : selectors)
+	{
+		const auto [it, inserted] = m_programs.try_emplace(p);
+		if (it->second.generation == m_program_generation)
+			continue;
+
+		it->second.generation = m_program_generation;
+		m_game_programs.push_back(p);
+		if (inserted)
+		{
+			// Starts on the GS thread's context are left to EndFrame(), a few at a time.
+			if (GLLoader::found_parallel_shader_compile || !QueueProgram(p, it->second))
+			{
+				it->second.state.store(TFXProgram::Pending, std::memory_order_relaxed);
+				m_pending_programs.push_back({p, &it->second});
+			}
+			started++;
+		}
+	}
+
+	Console.WriteLn("(GSDeviceOGL) Precompiling %u of %zu programs for %08X", started, selectors.size(), m_game_crc);
+}
+
+void GSDeviceOGL::EndFrame()
+{
+	// Entries which were drawn with in the meantime have already been started by GetProgram().
+	const u32 budget = GLLoader::found_parallel_shader_compile ? PENDING_STARTS_PER_FRAME : PENDING_COMPILES_PER_FRAME;
+	for (u32 count = 0; count < budget && !m_pending_programs.empty();)
+	{
+		const ProgramCompileJob job = m_pending_programs.front();
+		m_pending_programs.pop_front();
+		if (job.program->state.load(std::memory_order_relaxed) != TFXProgram::Pending)
+			continue;
+
+		if (GLLoader::found_parallel_shader_compile)
+		{
+			StartProgram(job.p, *job.program);
+		}
+		else
+		{
+			CompileProgram(job.p, job.program->program);
+			job.program->state.store(TFXProgram::Ready, std::memory_order_relaxed);
+		}
+		count++;
+	}
+
+	// Links nothing has drawn with yet would otherwise never reach FinishProgram(), and never get cached.
+	const size_t polls = std::min<size_t>(m_linking_programs.size(), LINK_POLLS_PER_FRAME);
+	for (size_t i = 0; i < polls; i++)
+	{
+		const ProgramCompileJob job = m_linking_programs.front();
+		m_linking_programs.pop_front();
+		if (job.program->state.load(std::memory_order_relaxed) != TFXProgram::Linking)
+			continue;
+
+		if (job.program->program.IsLinkComplete())
+			FinishProgram(job.p, *job.program);
+		else
+			m_linking_programs.push_back(job);
+	}
+}
+
+void GSDeviceOGL::SaveGamePrograms()
+{
+	if (GSConfig.PrecompileShaders)
+		WriteSelectorLog("gl_programs", PROGRAM_LOG_VERSION, m_game_programs);
+}
+
+void GSDeviceOGL::SetupPipeline(const ProgramSelector& psel)
+{
+	GetProgram(psel, true)->Bind();
 }
 
 void GSDeviceOGL::SetupSampler(PSSamplerSelector ssel)
@@ -2010,6 +2413,28 @@ static constexpr std::array<GLenum, 3> s_gl_blend_ops = { {
 
 void GSDeviceOGL::RenderHW(GSHWDrawConfig& config)
 {
+	ProgramSelector psel;
+	psel.vs = convertSel(config.vs);
+	psel.ps.key_hi = config.ps.key_hi;
+	psel.ps.key_lo = config.ps.key_lo;
+	psel.gs.key = 0;
+	psel.pad = 0;
+	if (config.gs.expand)
+	{
+		psel.gs.iip = config.gs.iip;
+		switch (config.gs.topology)
+		{
+			case GSHWDrawConfig::GSTopology::Point:    psel.gs.point  = 1; break;
+			case GSHWDrawConfig::GSTopology::Line:     psel.gs.line   = 1; break;
+			case GSHWDrawConfig::GSTopology::Sprite:   psel.gs.sprite = 1; break;
+			case GSHWDrawConfig::GSTopology::Triangle: ASSERT(0);          break;
+		}
+	}
+
+	// Skip the draw instead of stalling the GS thread, the program will be there in a few frames.
+	if (GSConfig.AsyncShaderCompile && !GetProgram(psel, false))
+		return;
+
 	if (!GLState::scissor.eq(config.scissor))
 	{
 		glScissor(config.scissor.x, config.scissor.y, config.scissor.width(), config.scissor.height());
@@ -2096,24 +2521,6 @@ void GSDeviceOGL::RenderHW(GSHWDrawConfig& config)
 			m_uniform_buffer_alignment, &config.cb_ps, sizeof(config.cb_ps));
 	}
 
-	ProgramSelector psel;
-	psel.vs = convertSel(config.vs);
-	psel.ps.key_hi = config.ps.key_hi;
-	psel.ps.key_lo = config.ps.key_lo;
-	psel.gs.key = 0;
-	psel.pad = 0;
-	if (config.gs.expand)
-	{
-		psel.gs.iip = config.gs.iip;
-		switch (config.gs.topology)
-		{
-			case GSHWDrawConfig::GSTopology::Point:    psel.gs.point  = 1; break;
-			case GSHWDrawConfig::GSTopology::Line:     psel.gs.line   = 1; break;
-			case GSHWDrawConfig::GSTopology::Sprite:   psel.gs.sprite = 1; break;
-			case GSHWDrawConfig::GSTopology::Triangle: ASSERT(0);          break;
-		}
-	}
-
     if(m_tfx_vgs.use) {
         setGameIcoTfxVgs();
     }
@@ -26,6 +26,11 @@
 #include "GLState.h"
 #include "GLLoader.h"
 #include "GS/GS.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 #ifdef ENABLE_OGL_DEBUG_MEM_BW
 extern u64 g_real_texture_upload_byte;
@@ -211,6 +216,33 @@ public:
 	static int m_shader_reg;
 
 private:
+	struct TFXProgram
+	{
+		enum State : u8
+		{
+			Ready,
+			Queued, // waiting for a compile thread
+			Compiling, // on a compile thread
+			Linking, // link running in the driver, see KHR_parallel_shader_compile
+			Pending, // precompiled, waiting for EndFrame() to start it
+		};
+
+		GL::Program program;
+		u32 generation = 0; // last m_program_generation which used it
+		std::atomic<u8> state{Ready};
+	};
+
+	struct ProgramCompileJob
+	{
+		ProgramSelector p;
+		TFXProgram* program;
+	};
+
+	// Spread over frames, so a long program log doesn't stall the game starting up.
+	static constexpr u32 PENDING_STARTS_PER_FRAME = 16;
+	static constexpr u32 PENDING_COMPILES_PER_FRAME = 2;
+	static constexpr u32 LINK_POLLS_PER_FRAME = 8;
+
 	// Increment this constant whenever shaders change, to invalidate user's program binary cache.
 	static constexpr u32 SHADER_VERSION = 3;
 
@@ -298,9 +330,27 @@ private:
 
 	GLuint m_ps_ss[1 << 8];
 	GSDepthStencilOGL* m_om_dss[1 << 5] = {};
-	std::unordered_map<ProgramSelector, GL::Program, ProgramSelectorHash> m_programs;
+	std::unordered_map<ProgramSelector, TFXProgram, ProgramSelectorHash> m_programs;
 	GL::ShaderCache m_shader_cache;
 
+	// Selectors used by the current game, saved to its program log and precompiled the next time it boots.
+	std::vector<ProgramSelector> m_game_programs;
+	u32 m_program_generation = 1;
+
+	// Compile threads, each with a context sharing objects with the GS thread's one.
+	GL::Context* m_gl_context = nullptr;
+	std::vector<std::unique_ptr<GL::Context>> m_program_compile_contexts;
+	std::vector<std::thread> m_program_compile_workers;
+	std::deque<ProgramCompileJob> m_program_compile_jobs;
+	std::mutex m_program_compile_mutex;
+	std::condition_variable m_program_compile_cv;
+	bool m_program_compile_workers_failed = false;
+	std::atomic<bool> m_cancel_program_compiles{false};
+
+	// Precompiled programs waiting to be started, and driver links which haven't been drawn with yet.
+	std::deque<ProgramCompileJob> m_pending_programs;
+	std::deque<ProgramCompileJob> m_linking_programs;
+
 	GLuint m_palette_ss;
 
 	GSHWDrawConfig::VSConstantBuffer m_vs_cb_cache;
@@ -308,6 +358,20 @@ private:
 
 	AlignedBuffer<u8, 32> m_download_buffer;
 
+	// PBO ring for readbacks the texture cache resolves later
+	struct QueuedDownload
+	{
+		GLuint buffer = 0;
+		GLsync fence = nullptr;
+		u32 buffer_size = 0;
+		u32 size = 0;
+		u32 pitch = 0;
+		bool in_use = false;
+		bool mapped = false;
+	};
+	static constexpr u32 DOWNLOAD_QUEUE_SIZE = 4;
+	std::array<QueuedDownload, DOWNLOAD_QUEUE_SIZE> m_queued_downloads;
+
 	GSTexture* CreateSurface(GSTexture::Type type, int width, int height, int levels, GSTexture::Format format) final;
 
 	void DoMerge(GSTexture* sTex[3], GSVector4* sRect, GSTexture* dTex, GSVector4* dRect, const GSRegPMODE& PMODE, const GSRegEXTBUF& EXTBUF, const GSVector4& c) final;
@@ -333,6 +397,9 @@ public:
 
 	bool Create(HostDisplay* display) override;
 
+	void SetGameCRC(u32 crc) override;
+	void EndFrame() override;
+
     void setGameIcoTfxVgs();
     void SetGameIco(bool p_value) override;
 
@@ -354,6 +421,12 @@ public:
 
 	bool DownloadTexture(GSTexture* src, const GSVector4i& rect, GSTexture::GSMap& out_map) final;
 
+	u32 GetDownloadQueueSize() const final { return DOWNLOAD_QUEUE_SIZE; }
+	int QueueDownloadTexture(GSTexture* src, const GSVector4i& rect) final;
+	bool IsQueuedDownloadReady(int slot) final;
+	bool MapQueuedDownload(int slot, GSTexture::GSMap& out_map) final;
+	void ReleaseQueuedDownload(int slot) final;
+
 	void CopyRect(GSTexture* sTex, GSTexture* dTex, const GSVector4i& r, u32 destX, u32 destY) final;
 
 	void PushDebugGroup(const char* fmt, ...) final;
@@ -400,6 +473,20 @@ public:
 	GLuint CreateSampler(PSSamplerSelector sel);
 	GSDepthStencilOGL* CreateDepthStencil(OMDepthStencilSelector dssel);
 
+	/// Returns null when the program isn't built yet and wait is false.
+	const GL::Program* GetProgram(const ProgramSelector& psel, bool wait);
+	void CompileProgram(const ProgramSelector& psel, GL::Program& program);
+	void StartProgram(const ProgramSelector& psel, TFXProgram& prog);
+	void FinishProgram(const ProgramSelector& psel, TFXProgram& prog);
+	void StartProgramAsync(const ProgramSelector& psel, TFXProgram& prog);
+	bool StartProgramCompileWorkers();
+	void StopProgramCompileWorkers();
+	bool QueueProgram(const ProgramSelector& psel, TFXProgram& prog);
+	void ProgramCompileWorkerThread(GL::Context* context);
+	void CompileQueuedProgram(ProgramCompileJob& job);
+	void PrecompileGamePrograms();
+	void SaveGamePrograms();
+
 	void SetupPipeline(const ProgramSelector& psel);
 	void SetupSampler(PSSamplerSelector ssel);
 	void SetupOM(OMDepthStencilSelector dssel);
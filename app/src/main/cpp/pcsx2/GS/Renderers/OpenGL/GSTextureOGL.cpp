@@ -633,12 +633,12 @@ void GSTextureOGL::CommitPages(const GSVector2i& region, bool commit)
 GSTexture::GSMap GSTextureOGL::Read(const GSVector4i& r, AlignedBuffer<u8, 32>& buffer)
 {
 	GSMap m;
-	m.pitch = r.width() << m_int_shift;
+	m.pitch = GetReadPitch(r);
 	buffer.MakeRoomFor(m.pitch * r.height());
 	m.bits = buffer.GetPtr();
 
-	// The fastest way will be to use a PBO to read the data asynchronously. Unfortunately GS
-	// architecture is waiting the data right now.
+	// The fastest way is to read into a PBO (see ReadToPixelPackBuffer), this one is for
+	// callers that need the data right now.
 
 	// Bind the texture to the read framebuffer to avoid any disturbance
 	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo_read);
@@ -654,6 +654,20 @@ GSTexture::GSMap GSTextureOGL::Read(const GSVector4i& r, AlignedBuffer<u8, 32>&
 	return m;
 }
 
+// Same as Read, but into the currently bound GL_PIXEL_PACK_BUFFER at offset 0. The call returns
+// as soon as the copy is queued, the buffer holds the data once the GPU gets there.
+void GSTextureOGL::ReadToPixelPackBuffer(const GSVector4i& r)
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo_read);
+	glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture_id, 0);
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1u << m_int_shift);
+
+	glReadPixels(r.x, r.y, r.width(), r.height(), m_int_format, m_int_type, nullptr);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
 bool GSTextureOGL::Save(const std::string& fn)
 {
 	// Collect the texture data
@@ -71,6 +71,8 @@ public:
 	void Swap(GSTexture* tex) final;
 
 	GSMap Read(const GSVector4i& r, AlignedBuffer<u8, 32>& buffer);
+	void ReadToPixelPackBuffer(const GSVector4i& r);
+	u32 GetReadPitch(const GSVector4i& r) const { return r.width() << m_int_shift; }
 	bool IsDepth() { return (m_type == Type::DepthStencil || m_type == Type::SparseDepthStencil); }
 	bool IsIntegerFormat() const
 	{
@@ -109,6 +109,26 @@ void GSDrawScanline::EndDraw(u64 frame, u64 ticks, int actual, int total, int pr
 	m_ds_map.UpdateStats(frame, ticks, actual, total, prims);
 }
 
+void GSDrawScanline::PrewarmKernels(const GSScanlineKernelList& list)
+{
+	for (u64 key : list.sp)
+		m_sp_map.Prewarm(key);
+
+	for (u64 key : list.ds)
+		m_ds_map.Prewarm(key);
+}
+
+void GSDrawScanline::TakeUsedKernelKeys(GSScanlineKernelList& list)
+{
+	m_sp_map.TakeUsedKeys(list.sp);
+	m_ds_map.TakeUsedKeys(list.ds);
+}
+
+void GSDrawScanline::GetStats(std::vector<GSFunctionStats>& stats) const
+{
+	m_ds_map.GetStats(stats);
+}
+
 #if _M_SSE >= 0x501
 typedef GSVector8i VectorI;
 typedef GSVector8  VectorF;
@@ -84,4 +84,8 @@ public:
 	{
 		m_ds_map.PrintStats();
 	}
+
+	void PrewarmKernels(const GSScanlineKernelList& list);
+	void TakeUsedKernelKeys(GSScanlineKernelList& list);
+	void GetStats(std::vector<GSFunctionStats>& stats) const;
 };
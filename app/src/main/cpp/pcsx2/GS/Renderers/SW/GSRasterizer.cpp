@@ -25,10 +25,31 @@
 #include "VMManager.h"
 #endif
 
-#define ENABLE_DRAW_STATS 0
-
 int GSRasterizerData::s_counter = 0;
 
+bool GSRasterizer::s_draw_stats = false;
+
+void GSRasterizerStats::MergeKernels(const std::vector<GSFunctionStats>& stats)
+{
+	for (const GSFunctionStats& s : stats)
+	{
+		auto it = std::find_if(kernels.begin(), kernels.end(), [&s](const GSFunctionStats& k) { return k.key == s.key; });
+
+		if (it == kernels.end())
+		{
+			kernels.push_back(s);
+			continue;
+		}
+
+		// every thread sees the same frames
+		it->frames = std::max(it->frames, s.frames);
+		it->prims += s.prims;
+		it->ticks += s.ticks;
+		it->actual += s.actual;
+		it->total += s.total;
+	}
+}
+
 static int compute_best_thread_height(int threads)
 {
 	// - for more threads screen segments should be smaller to better distribute the pixels
@@ -142,31 +163,45 @@ int GSRasterizer::GetPixels(bool reset)
 
 void GSRasterizer::Draw(GSRasterizerData* data)
 {
-	if (data->vertex != NULL && data->vertex_count == 0 || data->index != NULL && data->index_count == 0)
+	Draw(data, data->scissor);
+}
+
+void GSRasterizer::Draw(GSRasterizerData* data, const GSVector4i& scissor)
+{
+	Draw(data, scissor, data->index, data->index_count);
+}
+
+void GSRasterizer::Draw(GSRasterizerData* data, const GSVector4i& scissor, const u32* index, int index_count)
+{
+	if (data->kernels)
+	{
+		m_ds->PrewarmKernels(*data->kernels);
+		return;
+	}
+
+	if (data->vertex != NULL && data->vertex_count == 0 || index != NULL && index_count == 0)
 		return;
 
 	m_pixels.actual = 0;
 	m_pixels.total = 0;
 	m_primcount = 0;
 
-	if constexpr (ENABLE_DRAW_STATS)
-		data->start = _rdtsc();
+	const u64 start = s_draw_stats ? _rdtsc() : 0;
 
 	m_ds->BeginDraw(data);
 
 	const GSVertexSW* vertex = data->vertex;
 	const GSVertexSW* vertex_end = data->vertex + data->vertex_count;
 
-	const u32* index = data->index;
-	const u32* index_end = data->index + data->index_count;
+	const u32* index_end = index + index_count;
 
 	u32 tmp_index[] = {0, 1, 2};
 
-	bool scissor_test = !data->bbox.eq(data->bbox.rintersect(data->scissor));
+	bool scissor_test = !data->bbox.eq(data->bbox.rintersect(scissor));
 
-	m_scissor = data->scissor;
-	m_fscissor_x = GSVector4(data->scissor).xzxz();
-	m_fscissor_y = GSVector4(data->scissor).ywyw();
+	m_scissor = scissor;
+	m_fscissor_x = GSVector4(scissor).xzxz();
+	m_fscissor_y = GSVector4(scissor).ywyw();
 	m_scanmsk_value = data->scanmsk_value;
 
 	switch (data->primclass)
@@ -175,11 +210,11 @@ void GSRasterizer::Draw(GSRasterizerData* data)
 
 			if (scissor_test)
 			{
-				DrawPoint<true>(vertex, data->vertex_count, index, data->index_count);
+				DrawPoint<true>(vertex, data->vertex_count, index, index_count);
 			}
 			else
 			{
-				DrawPoint<false>(vertex, data->vertex_count, index, data->index_count);
+				DrawPoint<false>(vertex, data->vertex_count, index, index_count);
 			}
 
 			break;
@@ -259,8 +294,25 @@ void GSRasterizer::Draw(GSRasterizerData* data)
 
 	m_pixels.sum += m_pixels.actual;
 
-	if constexpr (ENABLE_DRAW_STATS)
-		m_ds->EndDraw(data->frame, _rdtsc() - data->start, m_pixels.actual, m_pixels.total, m_primcount);
+	if (s_draw_stats)
+	{
+		const u64 ticks = _rdtsc() - start;
+
+		m_ds->EndDraw(data->frame, ticks, m_pixels.actual, m_pixels.total, m_primcount);
+
+		m_stats.draws++;
+		m_stats.ticks += ticks;
+		m_stats.pixels += m_pixels.actual;
+	}
+}
+
+void GSRasterizer::GetStats(GSRasterizerStats& stats) const
+{
+	stats.threads.push_back(m_stats);
+
+	std::vector<GSFunctionStats> kernels;
+	m_ds->GetStats(kernels);
+	stats.MergeKernels(kernels);
 }
 
 template <bool scissor_test>
@@ -1246,6 +1298,31 @@ bool GSRasterizerList::IsSynced() const
 	return true;
 }
 
+void GSRasterizerList::PrewarmKernels(const GSRingHeap::SharedPtr<GSRasterizerData>& data)
+{
+	// every worker owns its own code generators, so each of them has to see the list
+	for (size_t i = 0; i < m_workers.size(); ++i)
+	{
+		m_workers[i]->Push(data);
+	}
+}
+
+void GSRasterizerList::TakeUsedKernelKeys(GSScanlineKernelList& list)
+{
+	for (size_t i = 0; i < m_r.size(); ++i)
+	{
+		m_r[i]->TakeUsedKernelKeys(list);
+	}
+}
+
+void GSRasterizerList::GetStats(GSRasterizerStats& stats) const
+{
+	for (size_t i = 0; i < m_r.size(); ++i)
+	{
+		m_r[i]->GetStats(stats);
+	}
+}
+
 int GSRasterizerList::GetPixels(bool reset)
 {
 	int pixels = 0;
@@ -1257,3 +1334,424 @@ int GSRasterizerList::GetPixels(bool reset)
 
 	return pixels;
 }
+
+bool GSRasterizerList::UseTiledDispatch()
+{
+	return theApp.GetConfigB("extrathreads_tiled");
+}
+
+// GSTiledRasterizerList
+
+GSTiledRasterizerList::GSTiledRasterizerList()
+	: m_tiles(new Tile[TILES_X * TILES_Y])
+	, m_exit(false)
+{
+}
+
+GSTiledRasterizerList::~GSTiledRasterizerList()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_exit = true;
+	}
+
+	m_work_cv.notify_all();
+
+	for (auto& worker : m_workers)
+	{
+		worker->thread.join();
+	}
+}
+
+void GSTiledRasterizerList::Start()
+{
+	for (size_t i = 0; i < m_r.size(); ++i)
+	{
+		m_workers.push_back(std::make_unique<Worker>());
+	}
+
+	// only start the threads once every worker exists, they steal from each other
+	for (size_t i = 0; i < m_workers.size(); ++i)
+	{
+		m_workers[i]->thread = std::thread(&GSTiledRasterizerList::ThreadProc, this, static_cast<int>(i));
+	}
+}
+
+void GSTiledRasterizerList::ThreadProc(int i)
+{
+	GSRasterizerList::OnWorkerStartup(i);
+
+	Worker& worker = *m_workers[i];
+
+	while (true)
+	{
+		GSRingHeap::SharedPtr<GSRasterizerData> job;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			m_work_cv.wait(lock, [this, &worker]() { return m_exit || !worker.jobs.empty() || m_ready.load(std::memory_order_acquire) > 0; });
+
+			if (m_exit)
+				break;
+
+			if (!worker.jobs.empty())
+			{
+				job = std::move(worker.jobs.front());
+				worker.jobs.pop_front();
+			}
+		}
+
+		if (job.get())
+		{
+			m_r[i]->Draw(job.get());
+			job = nullptr;
+			Complete();
+			continue;
+		}
+
+		int index;
+
+		while ((index = PopTile(i)) >= 0)
+		{
+			DrawTile(i, index);
+		}
+	}
+
+	GSRasterizerList::OnWorkerShutdown(i);
+}
+
+int GSTiledRasterizerList::PopTile(int i)
+{
+	const int count = static_cast<int>(m_workers.size());
+
+	for (int j = 0; j < count; ++j)
+	{
+		Worker& victim = *m_workers[(i + j) % count];
+
+		std::lock_guard<std::mutex> lock(victim.lock);
+
+		if (victim.ready.empty())
+			continue;
+
+		int index;
+
+		// own tiles are taken in queue order, stolen ones from the other end
+		if (j == 0)
+		{
+			index = victim.ready.front();
+			victim.ready.pop_front();
+		}
+		else
+		{
+			index = victim.ready.back();
+			victim.ready.pop_back();
+			m_workers[i]->stolen.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		m_ready.fetch_sub(1, std::memory_order_relaxed);
+
+		return index;
+	}
+
+	return -1;
+}
+
+void GSTiledRasterizerList::DrawTile(int i, int index)
+{
+	Tile& tile = m_tiles[index];
+
+	const int x = index % TILES_X;
+	const int y = index / TILES_X;
+	const GSVector4i rect(x << TILE_WIDTH_SHIFT, y << TILE_HEIGHT_SHIFT, (x + 1) << TILE_WIDTH_SHIFT, (y + 1) << TILE_HEIGHT_SHIFT);
+
+	m_workers[i]->tiles.fetch_add(1, std::memory_order_relaxed);
+
+	while (true)
+	{
+		TileDraw draw;
+
+		{
+			std::lock_guard<std::mutex> lock(tile.lock);
+
+			if (tile.draws.empty())
+			{
+				tile.scheduled = false;
+				break;
+			}
+
+			draw = std::move(tile.draws.front());
+			tile.draws.pop_front();
+		}
+
+		GSRasterizerData* data = draw.data.get();
+
+		if (draw.bins)
+			m_r[i]->Draw(data, data->scissor.rintersect(rect), draw.bins->data() + draw.offset, draw.count);
+		else
+			m_r[i]->Draw(data, data->scissor.rintersect(rect));
+
+		// drop our reference first, Sync() must not return before the draw releases its pages
+		draw = {};
+
+		Complete();
+	}
+}
+
+void GSTiledRasterizerList::Complete()
+{
+	if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_idle_cv.notify_all();
+	}
+}
+
+void GSTiledRasterizerList::Queue(const GSRingHeap::SharedPtr<GSRasterizerData>& data)
+{
+	GSVector4i r = data->bbox.rintersect(data->scissor);
+
+	ASSERT(r.top >= 0 && r.top < 2048 && r.bottom >= 0 && r.bottom < 2048);
+
+	const int left = std::max(r.left, 0) >> TILE_WIDTH_SHIFT;
+	const int top = r.top >> TILE_HEIGHT_SHIFT;
+	const int right = std::min((r.right + (1 << TILE_WIDTH_SHIFT) - 1) >> TILE_WIDTH_SHIFT, TILES_X);
+	const int bottom = std::min((r.bottom + (1 << TILE_HEIGHT_SHIFT) - 1) >> TILE_HEIGHT_SHIFT, TILES_Y);
+
+	if (left >= right || top >= bottom)
+		return;
+
+	const GSVector4i tiles(left, top, right, bottom);
+	const std::shared_ptr<const std::vector<u32>> bins = BinPrimitives(*data, tiles);
+
+	bool scheduled = false;
+
+	for (int y = top; y < bottom; ++y)
+	{
+		for (int x = left; x < right; ++x)
+		{
+			const int index = y * TILES_X + x;
+			Tile& tile = m_tiles[index];
+
+			TileDraw draw = {data, bins, 0, 0};
+
+			if (bins)
+			{
+				const int bin = (y - top) * tiles.width() + (x - left);
+
+				// none of the primitives touch this tile
+				if (m_bin_counts[bin] == 0)
+					continue;
+
+				draw.offset = m_bin_offsets[bin];
+				draw.count = m_bin_counts[bin];
+			}
+
+			m_pending.fetch_add(1, std::memory_order_relaxed);
+
+			{
+				std::lock_guard<std::mutex> lock(tile.lock);
+
+				tile.draws.push_back(std::move(draw));
+
+				if (tile.scheduled)
+					continue;
+
+				tile.scheduled = true;
+			}
+
+			// the home worker keeps neighbouring draws of the same tile cache-local, others steal when idle
+			Worker& worker = *m_workers[index % m_workers.size()];
+
+			{
+				std::lock_guard<std::mutex> lock(worker.lock);
+				worker.ready.push_back(index);
+			}
+
+			m_ready.fetch_add(1, std::memory_order_release);
+
+			scheduled = true;
+		}
+	}
+
+	if (scheduled)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_work_cv.notify_all();
+	}
+}
+
+std::shared_ptr<const std::vector<u32>> GSTiledRasterizerList::BinPrimitives(const GSRasterizerData& data, const GSVector4i& tiles)
+{
+	// a draw within one tile, or one primitive, covers the same tiles as its bbox
+	const int bin_count = tiles.width() * tiles.height();
+
+	if (bin_count <= 1 || data.index == NULL || data.kernels)
+		return nullptr;
+
+	int n;
+
+	switch (data.primclass)
+	{
+		case GS_POINT_CLASS: n = 1; break;
+		case GS_LINE_CLASS: n = 2; break;
+		case GS_TRIANGLE_CLASS: n = 3; break;
+		case GS_SPRITE_CLASS: n = 2; break;
+		default: return nullptr;
+	}
+
+	const int prims = data.index_count / n;
+
+	if (prims <= 1)
+		return nullptr;
+
+	m_bin_rects.resize(prims);
+	m_bin_counts.assign(bin_count, 0);
+
+	const u32* index = data.index;
+
+	for (int i = 0; i < prims; ++i, index += n)
+	{
+		GSVector4 pmin = data.vertex[index[0]].p;
+		GSVector4 pmax = pmin;
+
+		for (int j = 1; j < n; ++j)
+		{
+			pmin = pmin.min(data.vertex[index[j]].p);
+			pmax = pmax.max(data.vertex[index[j]].p);
+		}
+
+		// a pixel of slack either side covers the rasterizer's rounding
+		const GSVector4i p = GSVector4i(pmin.xyxy(pmax).floor()) + GSVector4i(-1, -1, 1, 1);
+		const GSVector4i rect = GSVector4i(
+			p.x >> TILE_WIDTH_SHIFT, p.y >> TILE_HEIGHT_SHIFT,
+			(p.z >> TILE_WIDTH_SHIFT) + 1, (p.w >> TILE_HEIGHT_SHIFT) + 1).rintersect(tiles) - tiles.xyxy();
+
+		m_bin_rects[i] = rect;
+
+		for (int y = rect.top; y < rect.bottom; ++y)
+			for (int x = rect.left; x < rect.right; ++x)
+				m_bin_counts[y * tiles.width() + x] += n;
+	}
+
+	m_bin_offsets.resize(bin_count);
+
+	int total = 0;
+
+	for (int i = 0; i < bin_count; ++i)
+	{
+		m_bin_offsets[i] = total;
+		total += m_bin_counts[i];
+	}
+
+	// fill in primitive order, so every tile still draws its primitives in the order they were sent
+	std::vector<u32> bins(total);
+	std::vector<int> cursor(m_bin_offsets);
+
+	index = data.index;
+
+	for (int i = 0; i < prims; ++i, index += n)
+	{
+		const GSVector4i& rect = m_bin_rects[i];
+
+		for (int y = rect.top; y < rect.bottom; ++y)
+		{
+			for (int x = rect.left; x < rect.right; ++x)
+			{
+				int& pos = cursor[y * tiles.width() + x];
+				std::copy(index, index + n, &bins[pos]);
+				pos += n;
+			}
+		}
+	}
+
+	return std::make_shared<const std::vector<u32>>(std::move(bins));
+}
+
+void GSTiledRasterizerList::Sync()
+{
+	if (!IsSynced())
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		m_idle_cv.wait(lock, [this]() { return m_pending.load(std::memory_order_acquire) == 0; });
+
+		g_perfmon.Put(GSPerfMon::SyncPoint, 1);
+	}
+}
+
+bool GSTiledRasterizerList::IsSynced() const
+{
+	return m_pending.load(std::memory_order_acquire) == 0;
+}
+
+int GSTiledRasterizerList::GetPixels(bool reset)
+{
+	int pixels = 0;
+
+	for (size_t i = 0; i < m_r.size(); ++i)
+	{
+		pixels += m_r[i]->GetPixels(reset);
+	}
+
+	return pixels;
+}
+
+int GSTiledRasterizerList::GetPixels(int thread, bool reset)
+{
+	return m_r[thread]->GetPixels(reset);
+}
+
+void GSTiledRasterizerList::PrintStats()
+{
+	Console.WriteLn("GS tiled rasterizer");
+
+	for (size_t i = 0; i < m_workers.size(); ++i)
+	{
+		const Worker& worker = *m_workers[i];
+
+		Console.WriteLn("  thread %zu: %8llu tiles, %8llu stolen", i,
+			static_cast<unsigned long long>(worker.tiles.load(std::memory_order_relaxed)),
+			static_cast<unsigned long long>(worker.stolen.load(std::memory_order_relaxed)));
+	}
+}
+
+void GSTiledRasterizerList::PrewarmKernels(const GSRingHeap::SharedPtr<GSRasterizerData>& data)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		for (auto& worker : m_workers)
+		{
+			m_pending.fetch_add(1, std::memory_order_relaxed);
+			worker->jobs.push_back(data);
+		}
+	}
+
+	m_work_cv.notify_all();
+}
+
+void GSTiledRasterizerList::TakeUsedKernelKeys(GSScanlineKernelList& list)
+{
+	for (size_t i = 0; i < m_r.size(); ++i)
+	{
+		m_r[i]->TakeUsedKernelKeys(list);
+	}
+}
+
+void GSTiledRasterizerList::GetStats(GSRasterizerStats& stats) const
+{
+	const size_t first = stats.threads.size();
+
+	for (size_t i = 0; i < m_r.size(); ++i)
+	{
+		m_r[i]->GetStats(stats);
+	}
+
+	for (size_t i = 0; i < m_workers.size(); ++i)
+	{
+		GSRasterizerStats::Thread& thread = stats.threads[first + i];
+		thread.tiles = m_workers[i]->tiles.load(std::memory_order_relaxed);
+		thread.stolen = m_workers[i]->stolen.load(std::memory_order_relaxed);
+	}
+}
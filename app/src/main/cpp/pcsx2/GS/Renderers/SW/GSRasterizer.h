@@ -22,6 +22,45 @@
 #include "GS/GSThread_CXX11.h"
 #include "GS/GSRingHeap.h"
 
+// Selector keys of the setup-prim and draw-scanline kernels a game used, persisted
+// per game so that the JIT can generate them before the first draw.
+struct GSScanlineKernelList
+{
+	std::vector<u64> sp;
+	std::vector<u64> ds;
+
+	bool IsEmpty() const { return sp.empty() && ds.empty(); }
+
+	// Sorts and removes duplicate keys, call after merging lists from several rasterizers.
+	void Compact()
+	{
+		for (std::vector<u64>* keys : {&sp, &ds})
+		{
+			std::sort(keys->begin(), keys->end());
+			keys->erase(std::unique(keys->begin(), keys->end()), keys->end());
+		}
+	}
+};
+
+// Draw stats of the rasterizer threads, only collected while GSRasterizer::EnableDrawStats() is on.
+struct GSRasterizerStats
+{
+	struct Thread
+	{
+		u64 draws = 0; // with tiled dispatch, a draw counts once for every tile it covers
+		u64 ticks = 0;
+		u64 pixels = 0;
+		u64 tiles = 0;
+		u64 stolen = 0;
+	};
+
+	std::vector<Thread> threads;
+	std::vector<GSFunctionStats> kernels;
+
+	// Adds the draw-scanline kernel stats of one thread, summed by key.
+	void MergeKernels(const std::vector<GSFunctionStats>& stats);
+};
+
 class alignas(32) GSRasterizerData : public GSAlignedClass<32>
 {
 	static int s_counter;
@@ -40,6 +79,7 @@ public:
 	int pixels;
 	int counter;
 	u8 scanmsk_value;
+	std::shared_ptr<const GSScanlineKernelList> kernels; // when set, only prewarm these kernels
 
 	GSRasterizerData()
 		: scissor(GSVector4i::zero())
@@ -109,6 +149,10 @@ public:
 
 	virtual void PrintStats() = 0;
 
+	virtual void PrewarmKernels(const GSScanlineKernelList& list) {}
+	virtual void TakeUsedKernelKeys(GSScanlineKernelList& list) {}
+	virtual void GetStats(std::vector<GSFunctionStats>& stats) const {}
+
 	__forceinline bool HasEdge() const { return m_de != NULL; }
 	__forceinline bool IsSolidRect() const { return m_dr != NULL; }
 };
@@ -123,6 +167,13 @@ public:
 	virtual bool IsSynced() const = 0;
 	virtual int GetPixels(bool reset = true) = 0;
 	virtual void PrintStats() = 0;
+
+	// Generates the kernels of data->kernels on the thread(s) which will later use them.
+	virtual void PrewarmKernels(const GSRingHeap::SharedPtr<GSRasterizerData>& data) = 0;
+	// Collects the kernels used by draws since the last call. Must only be called while synced.
+	virtual void TakeUsedKernelKeys(GSScanlineKernelList& list) = 0;
+	// Must only be called while synced.
+	virtual void GetStats(GSRasterizerStats& stats) const = 0;
 };
 
 class alignas(32) GSRasterizer : public IRasterizer
@@ -140,6 +191,9 @@ protected:
 	struct { GSVertexSW* buff; int count; } m_edge;
 	struct { int sum, actual, total; } m_pixels;
 	int m_primcount;
+	GSRasterizerStats::Thread m_stats;
+
+	static bool s_draw_stats;
 
 	typedef void (GSRasterizer::*DrawPrimPtr)(const GSVertexSW* v, int count);
 
@@ -172,6 +226,8 @@ public:
 	__forceinline int FindMyNextScanline(int top) const;
 
 	void Draw(GSRasterizerData* data);
+	void Draw(GSRasterizerData* data, const GSVector4i& scissor);
+	void Draw(GSRasterizerData* data, const GSVector4i& scissor, const u32* index, int index_count);
 
 	// IRasterizer
 
@@ -180,6 +236,107 @@ public:
 	bool IsSynced() const { return true; }
 	int GetPixels(bool reset);
 	void PrintStats() { m_ds->PrintStats(); }
+	void PrewarmKernels(const GSRingHeap::SharedPtr<GSRasterizerData>& data) { Draw(data.get()); }
+	void TakeUsedKernelKeys(GSScanlineKernelList& list) { m_ds->TakeUsedKernelKeys(list); }
+	void GetStats(GSRasterizerStats& stats) const;
+
+	// Times every draw and keeps per-kernel stats, set before the rasterizers start drawing.
+	static void EnableDrawStats(bool enabled) { s_draw_stats = enabled; }
+	static bool IsDrawStatsEnabled() { return s_draw_stats; }
+};
+
+// Splits the screen into tiles, each with its own ordered queue of draws. A worker owns a
+// tile while it drains its queue, which keeps draws in order per pixel, and idle workers
+// steal ready tiles from the others instead of waiting on their fixed scanlines.
+class GSTiledRasterizerList : public IRasterizer
+{
+protected:
+	static constexpr int TILE_WIDTH_SHIFT = 8;
+	static constexpr int TILE_HEIGHT_SHIFT = 6;
+	static constexpr int TILES_X = 2048 >> TILE_WIDTH_SHIFT;
+	static constexpr int TILES_Y = 2048 >> TILE_HEIGHT_SHIFT;
+
+	// A draw queued on a tile, with the indices of the primitives overlapping it when it was binned.
+	struct TileDraw
+	{
+		GSRingHeap::SharedPtr<GSRasterizerData> data;
+		std::shared_ptr<const std::vector<u32>> bins;
+		int offset;
+		int count;
+	};
+
+	struct Tile
+	{
+		std::mutex lock;
+		std::deque<TileDraw> draws;
+		bool scheduled = false; // sitting in a ready queue or being drained by a worker
+	};
+
+	struct Worker
+	{
+		std::mutex lock;
+		std::deque<int> ready;
+		std::deque<GSRingHeap::SharedPtr<GSRasterizerData>> jobs; // thread-specific work, guarded by m_mutex
+		std::thread thread;
+		std::atomic<u64> tiles{0};
+		std::atomic<u64> stolen{0};
+	};
+
+	std::vector<std::unique_ptr<GSRasterizer>> m_r;
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::unique_ptr<Tile[]> m_tiles;
+
+	std::mutex m_mutex;
+	std::condition_variable m_work_cv;
+	std::condition_variable m_idle_cv;
+	std::atomic<int> m_ready{0}; // tiles waiting in any ready queue
+	std::atomic<int> m_pending{0}; // queued (tile, draw) pairs and jobs not finished yet
+	bool m_exit;
+
+	// Scratch for BinPrimitives(), only touched by the thread queueing draws.
+	std::vector<GSVector4i> m_bin_rects;
+	std::vector<int> m_bin_offsets;
+	std::vector<int> m_bin_counts;
+
+	GSTiledRasterizerList();
+
+	void Start();
+	void ThreadProc(int i);
+	int PopTile(int i);
+	void DrawTile(int i, int index);
+	void Complete();
+	std::shared_ptr<const std::vector<u32>> BinPrimitives(const GSRasterizerData& data, const GSVector4i& tiles);
+
+public:
+	virtual ~GSTiledRasterizerList();
+
+	template <class DS>
+	static std::unique_ptr<IRasterizer> Create(int threads)
+	{
+		std::unique_ptr<GSTiledRasterizerList> rl(new GSTiledRasterizerList());
+
+		for (int i = 0; i < threads; ++i)
+		{
+			// every worker may draw any tile, so none of them filters scanlines
+			rl->m_r.push_back(std::unique_ptr<GSRasterizer>(new GSRasterizer(new DS(), 0, 1)));
+		}
+
+		rl->Start();
+
+		return rl;
+	}
+
+	// IRasterizer
+
+	void Queue(const GSRingHeap::SharedPtr<GSRasterizerData>& data);
+	void Sync();
+	bool IsSynced() const;
+	int GetPixels(bool reset);
+	int GetPixels(int thread, bool reset);
+	void PrintStats();
+	void PrewarmKernels(const GSRingHeap::SharedPtr<GSRasterizerData>& data);
+	void TakeUsedKernelKeys(GSScanlineKernelList& list);
+	void GetStats(GSRasterizerStats& stats) const;
 };
 
 class GSRasterizerList : public IRasterizer
@@ -195,10 +352,12 @@ protected:
 
 	GSRasterizerList(int threads);
 
+	static bool UseTiledDispatch();
+
+public:
 	static void OnWorkerStartup(int i);
 	static void OnWorkerShutdown(int i);
 
-public:
 	virtual ~GSRasterizerList();
 
 	template <class DS>
@@ -211,6 +370,11 @@ public:
 			return std::make_unique<GSRasterizer>(new DS(), 0, 1);
 		}
 
+		if (UseTiledDispatch())
+		{
+			return GSTiledRasterizerList::Create<DS>(threads);
+		}
+
 		std::unique_ptr<GSRasterizerList> rl(new GSRasterizerList(threads));
 
 		for (int i = 0; i < threads; ++i)
@@ -233,4 +397,7 @@ public:
 	bool IsSynced() const;
 	int GetPixels(bool reset);
 	void PrintStats() {}
+	void PrewarmKernels(const GSRingHeap::SharedPtr<GSRasterizerData>& data);
+	void TakeUsedKernelKeys(GSScanlineKernelList& list);
+	void GetStats(GSRasterizerStats& stats) const;
 };
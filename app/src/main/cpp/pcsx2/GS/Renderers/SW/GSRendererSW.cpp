@@ -16,7 +16,13 @@
 #include "PrecompiledHeader.h"
 #include "GSRendererSW.h"
 #include "GS/GSGL.h"
+#include "common/FileSystem.h"
 #include "common/StringUtil.h"
+#include "Config.h"
+
+#if defined(_M_ARM64)
+#include <cpuinfo.h>
+#endif
 
 #define LOG 0
 
@@ -77,6 +83,9 @@ void GSRendererSW::Reset(bool hardware_reset)
 
 void GSRendererSW::Destroy()
 {
+	if (m_rl)
+		SaveKernelCache();
+
 	// Need to destroy worker queue first to stop any pending thread work
 	m_rl.reset();
 	m_tc.reset();
@@ -91,6 +100,206 @@ void GSRendererSW::Destroy()
 	m_output = nullptr;
 }
 
+void GSRendererSW::SetGameCRC(u32 crc, int options)
+{
+	const bool changed = (crc != m_crc);
+
+	if (changed)
+		SaveKernelCache();
+
+	GSRenderer::SetGameCRC(crc, options);
+
+	if (changed)
+		LoadKernelCache();
+}
+
+// The generated kernels embed the address of their GSScanlineLocalData, so they can't be
+// stored as machine code. Instead we remember which selectors a game used and let every
+// worker JIT them again before the first draw reaches it.
+
+static constexpr u32 KERNEL_CACHE_SIGNATURE = 0x4B575347; // GSWK
+static constexpr u32 KERNEL_CACHE_VERSION = 2;
+
+// A kernel which no draw used for this many sessions is dropped from the cache file.
+static constexpr u8 KERNEL_CACHE_MAX_AGE = 8;
+// Per list, only the most recently used kernels are kept past this.
+static constexpr u32 KERNEL_CACHE_MAX_KEYS = 4096;
+
+// Hash of the code generator sources, set by CMake. Builds without it can't tell
+// whether a cached selector still means the same kernel, so they don't use the cache.
+#ifdef GS_SW_CODEGEN_HASH
+static constexpr u32 KERNEL_CACHE_CODEGEN_VERSION = GS_SW_CODEGEN_HASH;
+#else
+static constexpr u32 KERNEL_CACHE_CODEGEN_VERSION = 0;
+#endif
+
+static u64 GetKernelCacheCPUHash()
+{
+#if defined(_M_ARM64)
+	if (!cpuinfo_initialize())
+		return 0;
+
+	const bool features[] = {
+		cpuinfo_has_arm_neon(), cpuinfo_has_arm_neon_fp16(), cpuinfo_has_arm_neon_fma(),
+		cpuinfo_has_arm_neon_v8(), cpuinfo_has_arm_atomics(), cpuinfo_has_arm_neon_rdm(),
+		cpuinfo_has_arm_neon_fp16_arith(), cpuinfo_has_arm_fp16_arith(), cpuinfo_has_arm_neon_dot(),
+		cpuinfo_has_arm_jscvt(), cpuinfo_has_arm_fcma(), cpuinfo_has_arm_aes(),
+		cpuinfo_has_arm_sha1(), cpuinfo_has_arm_sha2(), cpuinfo_has_arm_pmull(),
+		cpuinfo_has_arm_crc32(), cpuinfo_has_arm_sve(), cpuinfo_has_arm_sve2(),
+	};
+
+	u64 hash = 1ULL << 60;
+	for (size_t i = 0; i < std::size(features); i++)
+		hash |= static_cast<u64>(features[i]) << i;
+
+	return hash;
+#else
+	return x86caps.AllCapabilities ^ (2ULL << 60);
+#endif
+}
+
+static std::string GetKernelCacheFilename(u32 crc)
+{
+	return Path::CombineStdString(EmuFolders::Cache, StringUtil::StdStringFromFormat("gs_sw_kernels_%08X.bin", crc));
+}
+
+static bool ReadKernelKeys(std::FILE* fp, std::unordered_map<u64, u8>& ages)
+{
+	u32 count;
+	if (std::fread(&count, sizeof(count), 1, fp) != 1 || count > KERNEL_CACHE_MAX_KEYS)
+		return false;
+
+	std::vector<u64> keys(count);
+	std::vector<u8> key_ages(count);
+	if (count != 0 &&
+		(std::fread(keys.data(), sizeof(u64), count, fp) != count ||
+		 std::fread(key_ages.data(), sizeof(u8), count, fp) != count))
+	{
+		return false;
+	}
+
+	for (u32 i = 0; i < count; i++)
+		ages.emplace(keys[i], key_ages[i]);
+
+	return true;
+}
+
+// Kernels used this session get age 0, cached ones which weren't get a session older until they
+// reach KERNEL_CACHE_MAX_AGE. used must be sorted.
+static bool WriteKernelKeys(std::FILE* fp, const std::vector<u64>& used, const std::unordered_map<u64, u8>& cached)
+{
+	std::vector<std::pair<u8, u64>> entries;
+	entries.reserve(used.size() + cached.size());
+
+	for (u64 key : used)
+		entries.emplace_back(0, key);
+
+	for (const auto& [key, age] : cached)
+	{
+		if (age + 1 < KERNEL_CACHE_MAX_AGE && !std::binary_search(used.begin(), used.end(), key))
+			entries.emplace_back(age + 1, key);
+	}
+
+	// youngest first, so the cap drops the ones which went unused the longest
+	std::sort(entries.begin(), entries.end());
+	if (entries.size() > KERNEL_CACHE_MAX_KEYS)
+		entries.resize(KERNEL_CACHE_MAX_KEYS);
+
+	const u32 count = static_cast<u32>(entries.size());
+	std::vector<u64> keys(count);
+	std::vector<u8> ages(count);
+	for (u32 i = 0; i < count; i++)
+	{
+		ages[i] = entries[i].first;
+		keys[i] = entries[i].second;
+	}
+
+	return std::fwrite(&count, sizeof(count), 1, fp) == 1 &&
+		   (count == 0 ||
+			   (std::fwrite(keys.data(), sizeof(u64), count, fp) == count &&
+				   std::fwrite(ages.data(), sizeof(u8), count, fp) == count));
+}
+
+void GSRendererSW::LoadKernelCache()
+{
+	m_cached_sp_ages.clear();
+	m_cached_ds_ages.clear();
+
+	if (m_crc == 0 || KERNEL_CACHE_CODEGEN_VERSION == 0)
+		return;
+
+	auto fp = FileSystem::OpenManagedCFile(GetKernelCacheFilename(m_crc).c_str(), "rb");
+	if (!fp)
+		return;
+
+	u32 signature, version, codegen_version;
+	u64 cpu_hash;
+	if (std::fread(&signature, sizeof(signature), 1, fp.get()) != 1 || signature != KERNEL_CACHE_SIGNATURE ||
+		std::fread(&version, sizeof(version), 1, fp.get()) != 1 || version != KERNEL_CACHE_VERSION ||
+		std::fread(&codegen_version, sizeof(codegen_version), 1, fp.get()) != 1 || codegen_version != KERNEL_CACHE_CODEGEN_VERSION ||
+		std::fread(&cpu_hash, sizeof(cpu_hash), 1, fp.get()) != 1 || cpu_hash != GetKernelCacheCPUHash() ||
+		!ReadKernelKeys(fp.get(), m_cached_sp_ages) || !ReadKernelKeys(fp.get(), m_cached_ds_ages))
+	{
+		Console.Warning("(GSRendererSW) Ignoring stale or corrupted kernel cache for %08X", m_crc);
+		m_cached_sp_ages.clear();
+		m_cached_ds_ages.clear();
+		return;
+	}
+
+	auto list = std::make_shared<GSScanlineKernelList>();
+	for (const auto& it : m_cached_sp_ages)
+		list->sp.push_back(it.first);
+	for (const auto& it : m_cached_ds_ages)
+		list->ds.push_back(it.first);
+
+	if (list->IsEmpty())
+		return;
+
+	Console.WriteLn("(GSRendererSW) Prewarming %zu setup and %zu scanline kernels for %08X", list->sp.size(), list->ds.size(), m_crc);
+
+	// Queued like a draw, so the workers generate the kernels in the background and in order with the first draws.
+	auto data = m_vertex_heap.make_shared<GSRasterizerData>();
+	data->kernels = std::move(list);
+	m_rl->PrewarmKernels(data);
+}
+
+void GSRendererSW::SaveKernelCache()
+{
+	Sync(8);
+
+	// Always taken, so kernels used by this game don't count as used by the next one.
+	GSScanlineKernelList list;
+	m_rl->TakeUsedKernelKeys(list);
+	list.Compact();
+
+	if (m_crc == 0 || KERNEL_CACHE_CODEGEN_VERSION == 0 || list.IsEmpty())
+		return;
+
+	const std::string filename(GetKernelCacheFilename(m_crc));
+	auto fp = FileSystem::OpenManagedCFile(filename.c_str(), "wb");
+	if (!fp)
+		return;
+
+	const u64 cpu_hash = GetKernelCacheCPUHash();
+	if (std::fwrite(&KERNEL_CACHE_SIGNATURE, sizeof(KERNEL_CACHE_SIGNATURE), 1, fp.get()) != 1 ||
+		std::fwrite(&KERNEL_CACHE_VERSION, sizeof(KERNEL_CACHE_VERSION), 1, fp.get()) != 1 ||
+		std::fwrite(&KERNEL_CACHE_CODEGEN_VERSION, sizeof(KERNEL_CACHE_CODEGEN_VERSION), 1, fp.get()) != 1 ||
+		std::fwrite(&cpu_hash, sizeof(cpu_hash), 1, fp.get()) != 1 ||
+		!WriteKernelKeys(fp.get(), list.sp, m_cached_sp_ages) || !WriteKernelKeys(fp.get(), list.ds, m_cached_ds_ages))
+	{
+		Console.Error("(GSRendererSW) Failed to write kernel cache '%s'", filename.c_str());
+		fp.reset();
+		FileSystem::DeleteFilePath(filename.c_str());
+	}
+}
+
+void GSRendererSW::GetDrawStats(GSRasterizerStats& stats)
+{
+	Sync(9);
+
+	m_rl->GetStats(stats);
+}
+
 void GSRendererSW::VSync(u32 field, bool registers_written)
 {
 	Sync(0); // IncAge might delete a cached texture in use
@@ -77,6 +77,9 @@ protected:
 	u32 m_fzb_cur_pages[16];
 	std::atomic<u32> m_fzb_pages[512]; // u16 frame/zbuf pages interleaved
 	std::atomic<u16> m_tex_pages[512];
+	// Sessions since the kernels in the game's cache file were last used, see SaveKernelCache().
+	std::unordered_map<u64, u8> m_cached_sp_ages;
+	std::unordered_map<u64, u8> m_cached_ds_ages;
 
 	void Reset(bool hardware_reset) override;
 	void VSync(u32 field, bool registers_written) override;
@@ -97,6 +100,9 @@ protected:
 
 	bool GetScanlineGlobalData(SharedData* data);
 
+	void LoadKernelCache();
+	void SaveKernelCache();
+
 public:
 	GSRendererSW(int threads);
 	~GSRendererSW() override;
@@ -104,4 +110,8 @@ public:
 	__fi static GSRendererSW* GetInstance() { return static_cast<GSRendererSW*>(g_gs_renderer.get()); }
 
 	void Destroy() override;
+	void SetGameCRC(u32 crc, int options) override;
+
+	/// Waits for the rasterizers and returns their draw stats, see GSRasterizer::EnableDrawStats().
+	void GetDrawStats(GSRasterizerStats& stats);
 };
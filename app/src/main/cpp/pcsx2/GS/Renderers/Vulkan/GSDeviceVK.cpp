@@ -35,6 +35,9 @@
 static u32 s_debug_scope_depth = 0;
 #endif
 
+// Bump when PipelineSelector changes, older pipeline logs are then ignored.
+static constexpr u32 PIPELINE_LOG_VERSION = 1;
+
 static bool IsDepthConvertShader(ShaderConvert i)
 {
 	return (i == ShaderConvert::DEPTH_COPY || i == ShaderConvert::RGBA8_TO_FLOAT32 ||
@@ -140,10 +143,27 @@ void GSDeviceVK::Destroy()
 
 	EndRenderPass();
 	ExecuteCommandBuffer(true);
+	SaveGamePipelines();
 	DestroyResources();
 	GSDevice::Destroy();
 }
 
+void GSDeviceVK::SetGameCRC(u32 crc)
+{
+	if (crc == m_game_crc)
+		return;
+
+	SaveGamePipelines();
+	GSDevice::SetGameCRC(crc);
+
+	// Pipelines already in the map get recorded again when the new game uses them.
+	m_game_pipelines.clear();
+	m_tfx_pipeline_generation++;
+
+	if (GSConfig.PrecompileShaders)
+		PrecompileGamePipelines();
+}
+
 void GSDeviceVK::ResetAPIState()
 {
 	EndRenderPass();
@@ -429,7 +449,6 @@ bool GSDeviceVK::DownloadTexture(GSTexture* src, const GSVector4i& rect, GSTextu
 	const u32 height = rect.height();
 	const u32 pitch = width * Vulkan::Util::GetTexelSize(static_cast<GSTextureVK*>(src)->GetNativeFormat());
 	const u32 size = pitch * height;
-	const u32 level = 0;
 	if (!CheckStagingBufferSize(size))
 	{
 #ifdef PCSX2_DEBUG
@@ -439,49 +458,7 @@ bool GSDeviceVK::DownloadTexture(GSTexture* src, const GSVector4i& rect, GSTextu
 	}
 
 	g_perfmon.Put(GSPerfMon::Readbacks, 1);
-	EndRenderPass();
-	{
-		const VkCommandBuffer cmdbuf = g_vulkan_context->GetCurrentCommandBuffer();
-#ifdef PCSX2_DEBUG
-		GL_INS("ReadbackTexture: {%d,%d} %ux%u", rect.left, rect.top, width, height);
-#endif
-		GSTextureVK* vkSrc = static_cast<GSTextureVK*>(src);
-		VkImageLayout old_layout = vkSrc->GetTexture().GetLayout();
-		if (old_layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
-			vkSrc->GetTexture().TransitionSubresourcesToLayout(
-				cmdbuf, level, 1, 0, 1, old_layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-
-		VkBufferImageCopy image_copy = {};
-		const VkImageAspectFlags aspect = Vulkan::Util::IsDepthFormat(static_cast<VkFormat>(vkSrc->GetFormat())) ?
-                                              VK_IMAGE_ASPECT_DEPTH_BIT :
-                                              VK_IMAGE_ASPECT_COLOR_BIT;
-		image_copy.bufferOffset = 0;
-		image_copy.bufferRowLength = width;
-		image_copy.bufferImageHeight = 0;
-		image_copy.imageSubresource = {aspect, level, 0u, 1u};
-		image_copy.imageOffset = {rect.left, rect.top, 0};
-		image_copy.imageExtent = {width, height, 1u};
-
-		// invalidate gpu cache
-		// TODO: Needed?
-		Vulkan::Util::BufferMemoryBarrier(cmdbuf, m_readback_staging_buffer, 0, VK_ACCESS_TRANSFER_WRITE_BIT, 0, size,
-			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
-
-		// do the copy
-		vkCmdCopyImageToBuffer(cmdbuf, vkSrc->GetTexture().GetImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-			m_readback_staging_buffer, 1, &image_copy);
-
-		// flush gpu cache
-		Vulkan::Util::BufferMemoryBarrier(cmdbuf, m_readback_staging_buffer, VK_ACCESS_TRANSFER_WRITE_BIT,
-			VK_ACCESS_HOST_READ_BIT, 0, size, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT);
-
-		if (old_layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
-		{
-			vkSrc->GetTexture().TransitionSubresourcesToLayout(
-				cmdbuf, level, 1, 0, 1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, old_layout);
-		}
-	}
-
+	RecordDownload(static_cast<GSTextureVK*>(src), rect, m_readback_staging_buffer, size);
 	ExecuteCommandBuffer(true);
 
 	// invalidate cpu cache before reading
@@ -495,8 +472,115 @@ bool GSDeviceVK::DownloadTexture(GSTexture* src, const GSVector4i& rect, GSTextu
 	return true;
 }
 
+void GSDeviceVK::RecordDownload(GSTextureVK* vkSrc, const GSVector4i& rect, VkBuffer buffer, u32 size)
+{
+	const u32 width = rect.width();
+	const u32 height = rect.height();
+	const u32 level = 0;
+
+	EndRenderPass();
+
+	const VkCommandBuffer cmdbuf = g_vulkan_context->GetCurrentCommandBuffer();
+#ifdef PCSX2_DEBUG
+	GL_INS("ReadbackTexture: {%d,%d} %ux%u", rect.left, rect.top, width, height);
+#endif
+	VkImageLayout old_layout = vkSrc->GetTexture().GetLayout();
+	if (old_layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+		vkSrc->GetTexture().TransitionSubresourcesToLayout(
+			cmdbuf, level, 1, 0, 1, old_layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+	VkBufferImageCopy image_copy = {};
+	const VkImageAspectFlags aspect = Vulkan::Util::IsDepthFormat(static_cast<VkFormat>(vkSrc->GetFormat())) ?
+                                          VK_IMAGE_ASPECT_DEPTH_BIT :
+                                          VK_IMAGE_ASPECT_COLOR_BIT;
+	image_copy.bufferOffset = 0;
+	image_copy.bufferRowLength = width;
+	image_copy.bufferImageHeight = 0;
+	image_copy.imageSubresource = {aspect, level, 0u, 1u};
+	image_copy.imageOffset = {rect.left, rect.top, 0};
+	image_copy.imageExtent = {width, height, 1u};
+
+	// invalidate gpu cache
+	// TODO: Needed?
+	Vulkan::Util::BufferMemoryBarrier(cmdbuf, buffer, 0, VK_ACCESS_TRANSFER_WRITE_BIT, 0, size,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	// do the copy
+	vkCmdCopyImageToBuffer(cmdbuf, vkSrc->GetTexture().GetImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		buffer, 1, &image_copy);
+
+	// flush gpu cache
+	Vulkan::Util::BufferMemoryBarrier(cmdbuf, buffer, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_ACCESS_HOST_READ_BIT, 0, size, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT);
+
+	if (old_layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+	{
+		vkSrc->GetTexture().TransitionSubresourcesToLayout(
+			cmdbuf, level, 1, 0, 1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, old_layout);
+	}
+}
+
 void GSDeviceVK::DownloadTextureComplete() {}
 
+int GSDeviceVK::QueueDownloadTexture(GSTexture* src, const GSVector4i& rect)
+{
+	auto it = std::find_if(m_queued_downloads.begin(), m_queued_downloads.end(), [](const QueuedDownload& slot) { return !slot.in_use; });
+	if (it == m_queued_downloads.end())
+		return -1;
+
+	GSTextureVK* vkSrc = static_cast<GSTextureVK*>(src);
+	const u32 pitch = rect.width() * Vulkan::Util::GetTexelSize(vkSrc->GetNativeFormat());
+	const u32 size = pitch * rect.height();
+	if (!CheckQueuedDownloadSize(*it, size))
+	{
+#ifdef PCSX2_DEBUG
+		Console.Error("Can't queue read back of %ux%u", rect.width(), rect.height());
+#endif
+		return -1;
+	}
+
+	g_perfmon.Put(GSPerfMon::Readbacks, 1);
+	RecordDownload(vkSrc, rect, it->buffer, size);
+
+	it->size = size;
+	it->pitch = pitch;
+	it->fence_counter = g_vulkan_context->GetCurrentFenceCounter();
+	it->in_use = true;
+	return static_cast<int>(it - m_queued_downloads.begin());
+}
+
+bool GSDeviceVK::IsQueuedDownloadReady(int slot)
+{
+	const QueuedDownload& qd = m_queued_downloads[slot];
+	return (qd.fence_counter != g_vulkan_context->GetCurrentFenceCounter() &&
+			g_vulkan_context->GetCompletedFenceCounter() >= qd.fence_counter);
+}
+
+bool GSDeviceVK::MapQueuedDownload(int slot, GSTexture::GSMap& out_map)
+{
+	QueuedDownload& qd = m_queued_downloads[slot];
+	ASSERT(qd.in_use);
+
+	// the copy is still in the command buffer we're recording, nothing else to do but submit it
+	if (qd.fence_counter == g_vulkan_context->GetCurrentFenceCounter())
+		ExecuteCommandBuffer(true);
+	else if (g_vulkan_context->GetCompletedFenceCounter() < qd.fence_counter)
+		g_vulkan_context->WaitForFenceCounter(qd.fence_counter);
+
+	VkResult res = vmaInvalidateAllocation(g_vulkan_context->GetAllocator(), qd.allocation, 0, qd.size);
+	if (res != VK_SUCCESS)
+		LOG_VULKAN_ERROR(res, "vmaInvalidateAllocation() failed, readback may be incorrect: ");
+
+	out_map.bits = reinterpret_cast<u8*>(qd.map);
+	out_map.pitch = qd.pitch;
+	return true;
+}
+
+void GSDeviceVK::ReleaseQueuedDownload(int slot)
+{
+	m_queued_downloads[slot].in_use = false;
+}
+
 void GSDeviceVK::CopyRect(GSTexture* sTex, GSTexture* dTex, const GSVector4i& r, u32 destX, u32 destY)
 {
 	g_perfmon.Put(GSPerfMon::TextureCopies, 1);
@@ -1817,6 +1901,7 @@ bool GSDeviceVK::CheckStagingBufferSize(u32 required_size)
 	}
 
 	m_readback_staging_buffer_map = ai.pMappedData;
+	m_readback_staging_buffer_size = required_size;
 	return true;
 }
 
@@ -1835,14 +1920,58 @@ void GSDeviceVK::DestroyStagingBuffer()
 	}
 }
 
+bool GSDeviceVK::CheckQueuedDownloadSize(QueuedDownload& slot, u32 required_size)
+{
+	if (slot.buffer_size >= required_size)
+		return true;
+
+	// a slot that was released without being mapped can still have a copy in flight
+	if (slot.buffer != VK_NULL_HANDLE)
+		g_vulkan_context->DeferBufferDestruction(slot.buffer, slot.allocation);
+	slot = {};
+
+	const VkBufferCreateInfo bci = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, nullptr, 0u, required_size,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE, 0u, nullptr};
+
+	VmaAllocationCreateInfo aci = {};
+	aci.usage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+	aci.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+	aci.preferredFlags = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+	VmaAllocationInfo ai = {};
+	VkResult res = vmaCreateBuffer(g_vulkan_context->GetAllocator(), &bci, &aci, &slot.buffer, &slot.allocation, &ai);
+	if (res != VK_SUCCESS)
+	{
+		LOG_VULKAN_ERROR(res, "vmaCreateBuffer() failed: ");
+		slot = {};
+		return false;
+	}
+
+	slot.map = ai.pMappedData;
+	slot.buffer_size = required_size;
+	return true;
+}
+
+void GSDeviceVK::DestroyQueuedDownloads()
+{
+	for (QueuedDownload& slot : m_queued_downloads)
+	{
+		// unmapped as part of the buffer destroy
+		if (slot.buffer != VK_NULL_HANDLE)
+			vmaDestroyBuffer(g_vulkan_context->GetAllocator(), slot.buffer, slot.allocation);
+		slot = {};
+	}
+}
+
 void GSDeviceVK::DestroyResources()
 {
     g_vulkan_context->ExecuteCommandBuffer(Vulkan::Context::WaitType::Sleep);
+	StopPipelineCompileWorkers();
 	if (m_tfx_descriptor_sets[0] != VK_NULL_HANDLE)
 		g_vulkan_context->FreeGlobalDescriptorSet(m_tfx_descriptor_sets[0]);
 
 	for (auto& it : m_tfx_pipelines)
-		Vulkan::Util::SafeDestroyPipeline(it.second);
+		Vulkan::Util::SafeDestroyPipeline(it.second.pipeline);
 	for (auto& it : m_tfx_fragment_shaders)
 		Vulkan::Util::SafeDestroyShaderModule(it.second);
 	for (auto& it : m_tfx_geometry_shaders)
@@ -1893,6 +2022,7 @@ void GSDeviceVK::DestroyResources()
 	m_swap_chain_render_pass = VK_NULL_HANDLE;
 
 	DestroyStagingBuffer();
+	DestroyQueuedDownloads();
 
 	m_fragment_uniform_stream_buffer.Destroy(false);
 	m_vertex_uniform_stream_buffer.Destroy(false);
@@ -2039,9 +2169,17 @@ VkPipeline GSDeviceVK::CreateTFXPipeline(const PipelineSelector& p)
 		pps.no_color1 = true;
 	}
 
-	VkShaderModule vs = GetTFXVertexShader(p.vs);
-	VkShaderModule gs = p.gs.expand ? GetTFXGeometryShader(p.gs) : VK_NULL_HANDLE;
-	VkShaderModule fs = GetTFXFragmentShader(pps);
+	// Can be called from the compile workers. The shader modules are cheap next to the pipeline, so only
+	// their lookup is serialized, vkCreateGraphicsPipelines runs in parallel.
+	VkShaderModule vs, gs, fs;
+	VkPipelineCache pipeline_cache;
+	{
+		std::unique_lock lock(m_tfx_shader_mutex);
+		vs = GetTFXVertexShader(p.vs);
+		gs = p.gs.expand ? GetTFXGeometryShader(p.gs) : VK_NULL_HANDLE;
+		fs = GetTFXFragmentShader(pps);
+		pipeline_cache = g_vulkan_shader_cache->GetPipelineCache(true);
+	}
 	if (vs == VK_NULL_HANDLE || (p.gs.expand && gs == VK_NULL_HANDLE) || fs == VK_NULL_HANDLE)
 		return VK_NULL_HANDLE;
 
@@ -2135,7 +2273,7 @@ VkPipeline GSDeviceVK::CreateTFXPipeline(const PipelineSelector& p)
 	if (m_features.framebuffer_fetch && p.feedback_loop)
 		gpb.AddBlendFlags(VK_PIPELINE_COLOR_BLEND_STATE_CREATE_RASTERIZATION_ORDER_ATTACHMENT_ACCESS_BIT_ARM);
 
-	VkPipeline pipeline = gpb.Create(g_vulkan_context->GetDevice(), g_vulkan_shader_cache->GetPipelineCache(true));
+	VkPipeline pipeline = gpb.Create(g_vulkan_context->GetDevice(), pipeline_cache);
 	if (pipeline)
 	{
 		Vulkan::Util::SetObjectName(
@@ -2147,13 +2285,156 @@ VkPipeline GSDeviceVK::CreateTFXPipeline(const PipelineSelector& p)
 
 VkPipeline GSDeviceVK::GetTFXPipeline(const PipelineSelector& p)
 {
-	const auto it = m_tfx_pipelines.find(p);
-	if (it != m_tfx_pipelines.end())
-		return it->second;
+	const auto [it, inserted] = m_tfx_pipelines.try_emplace(p);
+	TFXPipeline& pipeline = it->second;
+	if (pipeline.generation != m_tfx_pipeline_generation)
+	{
+		pipeline.generation = m_tfx_pipeline_generation;
+		m_game_pipelines.push_back(p);
+	}
 
-	VkPipeline pipeline = CreateTFXPipeline(p);
-	m_tfx_pipelines.emplace(p, pipeline);
-	return pipeline;
+	if (inserted)
+	{
+		// Skip the draw instead of stalling the GS thread, the pipeline will be there in a few frames.
+		if (GSConfig.AsyncShaderCompile)
+		{
+			QueueTFXPipeline(p, pipeline);
+			return VK_NULL_HANDLE;
+		}
+
+		pipeline.pipeline = CreateTFXPipeline(p);
+		return pipeline.pipeline;
+	}
+
+	u8 state = pipeline.state.load(std::memory_order_acquire);
+	if (state != TFXPipeline::Ready)
+	{
+		if (GSConfig.AsyncShaderCompile)
+			return VK_NULL_HANDLE;
+
+		// Still queued for precompilation, don't wait for the workers to get to it.
+		if (state == TFXPipeline::Queued &&
+			pipeline.state.compare_exchange_strong(state, TFXPipeline::Compiling, std::memory_order_acq_rel))
+		{
+			pipeline.pipeline = CreateTFXPipeline(p);
+			pipeline.state.store(TFXPipeline::Ready, std::memory_order_release);
+		}
+		else
+		{
+			while (pipeline.state.load(std::memory_order_acquire) != TFXPipeline::Ready)
+				std::this_thread::yield();
+		}
+	}
+
+	return pipeline.pipeline;
+}
+
+void GSDeviceVK::StartPipelineCompileWorkers()
+{
+	// Leave some cores for the EE and the GS thread.
+	const u32 count = std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+
+	m_cancel_pipeline_compiles.store(false, std::memory_order_relaxed);
+	for (u32 i = 0; i < count; i++)
+		m_pipeline_compile_workers.emplace_back(&GSDeviceVK::PipelineCompileWorkerThread, this);
+}
+
+void GSDeviceVK::StopPipelineCompileWorkers()
+{
+	if (m_pipeline_compile_workers.empty())
+		return;
+
+	// Jobs left in the list are dropped, their entries are destroyed along with the map.
+	{
+		std::unique_lock lock(m_pipeline_compile_mutex);
+		m_cancel_pipeline_compiles.store(true, std::memory_order_relaxed);
+		m_pipeline_compile_jobs.clear();
+	}
+	m_pipeline_compile_cv.notify_all();
+
+	for (std::thread& thread : m_pipeline_compile_workers)
+		thread.join();
+	m_pipeline_compile_workers.clear();
+}
+
+void GSDeviceVK::QueueTFXPipeline(const PipelineSelector& p, TFXPipeline& pipeline)
+{
+	if (m_pipeline_compile_workers.empty())
+		StartPipelineCompileWorkers();
+
+	pipeline.state.store(TFXPipeline::Queued, std::memory_order_relaxed);
+	{
+		std::unique_lock lock(m_pipeline_compile_mutex);
+		m_pipeline_compile_jobs.push_back({p, &pipeline});
+	}
+	m_pipeline_compile_cv.notify_one();
+}
+
+void GSDeviceVK::PipelineCompileWorkerThread()
+{
+	Threading::SetNameOfCurrentThread("VK Pipeline Compiler");
+
+	std::unique_lock lock(m_pipeline_compile_mutex);
+	for (;;)
+	{
+		m_pipeline_compile_cv.wait(lock, [this]() {
+			return m_cancel_pipeline_compiles.load(std::memory_order_relaxed) || !m_pipeline_compile_jobs.empty();
+		});
+		if (m_cancel_pipeline_compiles.load(std::memory_order_relaxed))
+			break;
+
+		PipelineCompileJob job = m_pipeline_compile_jobs.front();
+		m_pipeline_compile_jobs.pop_front();
+
+		lock.unlock();
+		CompileQueuedTFXPipeline(job);
+		lock.lock();
+	}
+}
+
+void GSDeviceVK::CompileQueuedTFXPipeline(PipelineCompileJob& job)
+{
+	// The GS thread may have taken it over already.
+	u8 expected = TFXPipeline::Queued;
+	if (m_cancel_pipeline_compiles.load(std::memory_order_relaxed) ||
+		!job.pipeline->state.compare_exchange_strong(expected, TFXPipeline::Compiling, std::memory_order_acq_rel))
+	{
+		return;
+	}
+
+	job.pipeline->pipeline = CreateTFXPipeline(job.p);
+	job.pipeline->state.store(TFXPipeline::Ready, std::memory_order_release);
+}
+
+void GSDeviceVK::PrecompileGamePipelines()
+{
+	const std::vector<PipelineSelector> selectors(ReadSelectorLog<PipelineSelector>("vk_pipelines", PIPELINE_LOG_VERSION));
+	if (selectors.empty())
+		return;
+
+	u32 queued = 0;
+	for (const PipelineSelector& p : selectors)
+	{
+		const auto [it, inserted] = m_tfx_pipelines.try_emplace(p);
+		if (it->second.generation == m_tfx_pipeline_generation)
+			continue;
+
+		it->second.generation = m_tfx_pipeline_generation;
+		m_game_pipelines.push_back(p);
+		if (inserted)
+		{
+			QueueTFXPipeline(p, it->second);
+			queued++;
+		}
+	}
+
+	Console.WriteLn("(GSDeviceVK) Precompiling %u of %zu pipelines for %08X", queued, selectors.size(), m_game_crc);
+}
+
+void GSDeviceVK::SaveGamePipelines()
+{
+	if (GSConfig.PrecompileShaders)
+		WriteSelectorLog("vk_pipelines", PIPELINE_LOG_VERSION, m_game_pipelines);
 }
 
 bool GSDeviceVK::BindDrawPipeline(const PipelineSelector& p)
@@ -2868,8 +3149,33 @@ GSTextureVK* GSDeviceVK::SetupPrimitiveTrackingDATE(GSHWDrawConfig& config)
 	IASetVertexBuffer(config.verts, sizeof(GSVertex), config.nverts);
 	IASetIndexBuffer(config.indices, config.nindices);
 
-	// cut down the configuration for the prepass, we don't need blending or any feedback loop
 	PipelineSelector& pipe = m_pipeline_selector;
+	UpdatePrimitiveTrackingDATEPrepassSelector(config, pipe);
+	if (!BindDrawPipeline(pipe))
+	{
+		// the DATE=3 draw would read an image the prepass never wrote
+		EndRenderPass();
+		Recycle(image);
+		return nullptr;
+	}
+	DrawIndexedPrimitive();
+
+	// image is initialized/prepass is done, so finish up and get ready to do the "real" draw
+	EndRenderPass();
+
+	// .. by setting it to DATE=3
+	config.ps.date = 3;
+	config.alpha_second_pass.ps.date = 3;
+
+	// and bind the image to the primitive sampler
+	image->TransitionToLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	PSSetShaderResource(3, image, false);
+	return image;
+}
+
+void GSDeviceVK::UpdatePrimitiveTrackingDATEPrepassSelector(GSHWDrawConfig& config, PipelineSelector& pipe)
+{
+	// cut down the configuration for the prepass, we don't need blending or any feedback loop
 	UpdateHWPipelineSelector(config, pipe);
 	pipe.dss.zwe = false;
 	pipe.cms.wrgba = 0;
@@ -2880,20 +3186,21 @@ GSTextureVK* GSDeviceVK::SetupPrimitiveTrackingDATE(GSHWDrawConfig& config)
 	pipe.ps.date += 10;
 	pipe.ps.no_color = false;
 	pipe.ps.no_color1 = true;
-	if (BindDrawPipeline(pipe))
-		DrawIndexedPrimitive();
+}
 
-	// image is initialized/prepass is done, so finish up and get ready to do the "real" draw
-	EndRenderPass();
+bool GSDeviceVK::HasPrimitiveTrackingDATEPipelines(GSHWDrawConfig& config)
+{
+	// Look up both before checking either, so a missing pair gets compiled together.
+	PipelineSelector pipe = m_pipeline_selector;
+	UpdatePrimitiveTrackingDATEPrepassSelector(config, pipe);
+	const bool has_prepass = (GetTFXPipeline(pipe) != VK_NULL_HANDLE);
 
-	// .. by setting it to DATE=3
-	config.ps.date = 3;
-	config.alpha_second_pass.ps.date = 3;
+	pipe = m_pipeline_selector;
+	UpdateHWPipelineSelector(config, pipe);
+	pipe.ps.date = 3;
+	const bool has_draw = (GetTFXPipeline(pipe) != VK_NULL_HANDLE);
 
-	// and bind the image to the primitive sampler
-	image->TransitionToLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-	PSSetShaderResource(3, image, false);
-	return image;
+	return has_prepass && has_draw;
 }
 
 void GSDeviceVK::RenderHW(GSHWDrawConfig& config)
@@ -2945,6 +3252,10 @@ void GSDeviceVK::RenderHW(GSHWDrawConfig& config)
 	GSTextureVK* date_image = nullptr;
 	if (config.destination_alpha == GSHWDrawConfig::DestinationAlphaMode::PrimIDTracking)
 	{
+		// With async compiles either pass can be missing, skip the whole sequence until both are ready.
+		if (GSConfig.AsyncShaderCompile && !HasPrimitiveTrackingDATEPipelines(config))
+			return;
+
 		date_image = SetupPrimitiveTrackingDATE(config);
 		if (!date_image)
 		{
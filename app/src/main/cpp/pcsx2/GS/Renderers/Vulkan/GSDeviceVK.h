@@ -22,6 +22,11 @@
 #include "common/HashCombine.h"
 #include "vk_mem_alloc.h"
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 
 class GSDeviceVK final : public GSDevice
@@ -68,6 +73,26 @@ public:
 		}
 	};
 
+	struct TFXPipeline
+	{
+		enum State : u8
+		{
+			Ready,
+			Queued, // waiting for a compile worker
+			Compiling,
+		};
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		u32 generation = 0; // last m_tfx_pipeline_generation which used it
+		std::atomic<u8> state{Ready};
+	};
+
+	struct PipelineCompileJob
+	{
+		PipelineSelector p;
+		TFXPipeline* pipeline;
+	};
+
 	enum : u32
 	{
 		NUM_TFX_DESCRIPTOR_SETS = 3,
@@ -110,6 +135,22 @@ private:
 	void* m_readback_staging_buffer_map = nullptr;
 	u32 m_readback_staging_buffer_size = 0;
 
+	// Staging slots for readbacks the texture cache resolves later, each one remembers the
+	// command buffer its copy went into so mapping only waits when the GPU isn't done yet.
+	struct QueuedDownload
+	{
+		VmaAllocation allocation = VK_NULL_HANDLE;
+		VkBuffer buffer = VK_NULL_HANDLE;
+		void* map = nullptr;
+		u32 buffer_size = 0;
+		u32 size = 0;
+		u32 pitch = 0;
+		u64 fence_counter = 0;
+		bool in_use = false;
+	};
+	static constexpr u32 DOWNLOAD_QUEUE_SIZE = 4;
+	std::array<QueuedDownload, DOWNLOAD_QUEUE_SIZE> m_queued_downloads;
+
 	VkSampler m_point_sampler = VK_NULL_HANDLE;
 	VkSampler m_linear_sampler = VK_NULL_HANDLE;
 
@@ -130,7 +171,19 @@ private:
 	std::unordered_map<u32, VkShaderModule> m_tfx_vertex_shaders;
 	std::unordered_map<u32, VkShaderModule> m_tfx_geometry_shaders;
 	std::unordered_map<GSHWDrawConfig::PSSelector, VkShaderModule, GSHWDrawConfig::PSSelectorHash> m_tfx_fragment_shaders;
-	std::unordered_map<PipelineSelector, VkPipeline, PipelineSelectorHash> m_tfx_pipelines;
+	std::unordered_map<PipelineSelector, TFXPipeline, PipelineSelectorHash> m_tfx_pipelines;
+
+	// Selectors used by the current game, saved to its pipeline log and precompiled the next time it boots.
+	std::vector<PipelineSelector> m_game_pipelines;
+	u32 m_tfx_pipeline_generation = 1;
+
+	// Unbounded, so queueing a whole pipeline log never waits on the workers.
+	std::vector<std::thread> m_pipeline_compile_workers;
+	std::deque<PipelineCompileJob> m_pipeline_compile_jobs;
+	std::mutex m_pipeline_compile_mutex;
+	std::condition_variable m_pipeline_compile_cv;
+	std::atomic<bool> m_cancel_pipeline_compiles{false};
+	std::mutex m_tfx_shader_mutex; // shader maps and g_vulkan_shader_cache are shared with the compile workers
 
 	VkRenderPass m_utility_color_render_pass_load = VK_NULL_HANDLE;
 	VkRenderPass m_utility_color_render_pass_clear = VK_NULL_HANDLE;
@@ -167,6 +220,14 @@ private:
 	VkPipeline CreateTFXPipeline(const PipelineSelector& p);
 	VkPipeline GetTFXPipeline(const PipelineSelector& p);
 
+	void StartPipelineCompileWorkers();
+	void StopPipelineCompileWorkers();
+	void QueueTFXPipeline(const PipelineSelector& p, TFXPipeline& pipeline);
+	void PipelineCompileWorkerThread();
+	void CompileQueuedTFXPipeline(PipelineCompileJob& job);
+	void PrecompileGamePipelines();
+	void SaveGamePipelines();
+
 	VkShaderModule GetUtilityVertexShader(const std::string& source, const char* replace_main);
 	VkShaderModule GetUtilityFragmentShader(const std::string& source, const char* replace_main);
 
@@ -184,6 +245,10 @@ private:
 
 	bool CheckStagingBufferSize(u32 required_size);
 	void DestroyStagingBuffer();
+	bool CheckQueuedDownloadSize(QueuedDownload& slot, u32 required_size);
+	void DestroyQueuedDownloads();
+
+	void RecordDownload(GSTextureVK* src, const GSVector4i& rect, VkBuffer buffer, u32 size);
 
 	void DestroyResources();
 
@@ -204,6 +269,8 @@ public:
 	bool Create(HostDisplay* display) override;
 	void Destroy() override;
 
+	void SetGameCRC(u32 crc) override;
+
 	void ResetAPIState() override;
 	void RestoreAPIState() override;
 
@@ -224,6 +291,12 @@ public:
 	bool DownloadTexture(GSTexture* src, const GSVector4i& rect, GSTexture::GSMap& out_map) override;
 	void DownloadTextureComplete() override;
 
+	u32 GetDownloadQueueSize() const override { return DOWNLOAD_QUEUE_SIZE; }
+	int QueueDownloadTexture(GSTexture* src, const GSVector4i& rect) override;
+	bool IsQueuedDownloadReady(int slot) override;
+	bool MapQueuedDownload(int slot, GSTexture::GSMap& out_map) override;
+	void ReleaseQueuedDownload(int slot) override;
+
 	void CopyRect(GSTexture* sTex, GSTexture* dTex, const GSVector4i& r, u32 destX, u32 destY) override;
 
 	void StretchRect(GSTexture* sTex, const GSVector4& sRect, GSTexture* dTex, const GSVector4& dRect,
@@ -243,6 +316,8 @@ public:
 
 	void SetupDATE(GSTexture* rt, GSTexture* ds, bool datm, const GSVector4i& bbox);
 	GSTextureVK* SetupPrimitiveTrackingDATE(GSHWDrawConfig& config);
+	void UpdatePrimitiveTrackingDATEPrepassSelector(GSHWDrawConfig& config, PipelineSelector& pipe);
+	bool HasPrimitiveTrackingDATEPipelines(GSHWDrawConfig& config);
 
 	void IASetVertexBuffer(const void* vertex, size_t stride, size_t count);
 	bool IAMapVertexBuffer(void** vertex, size_t stride, size_t count);
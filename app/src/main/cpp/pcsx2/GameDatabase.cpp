@@ -29,13 +29,25 @@
 #include "yaml-cpp/yaml.h"
 #include <fstream>
 #include <algorithm>
+#include <cstring>
 #include <mutex>
+#include <string_view>
 #include <thread>
 
+#ifdef _WIN32
+#include "common/RedtapeWindows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 static constexpr char GAMEDB_YAML_FILE_NAME[] = "GameIndex.yaml";
 static constexpr char GAMEDB_CACHE_FILE_NAME[] = "gamedb.cache";
-static constexpr u64 CACHE_FILE_MAGIC = UINT64_C(0x47414D4544423031); // GAMEDB01
+static constexpr u64 CACHE_FILE_MAGIC = UINT64_C(0x47414D4544423032); // GAMEDB02
 
+// Only used while building the cache from the YAML file.
 static std::unordered_map<std::string, GameDatabaseSchema::GameEntry> s_game_db;
 static std::once_flag s_load_once_flag;
 
@@ -265,257 +277,433 @@ static bool LoadYamlFile()
 	return true;
 }
 
-static bool ReadString(std::FILE* stream, std::string* dest)
+static s64 GetExpectedMTime()
 {
-	u32 size;
-	if (std::fread(&size, sizeof(size), 1, stream) != 1)
-		return false;
+	const std::string yaml_filename(Path::CombineStdString(EmuFolders::Resources, GAMEDB_YAML_FILE_NAME));
 
-	dest->resize(size);
-	if (size > 0 && std::fread(dest->data(), size, 1, stream) != 1)
-		return false;
+	FILESYSTEM_STAT_DATA yaml_sd;
+	if (!FileSystem::StatFile(yaml_filename.c_str(), &yaml_sd))
+		return -1;
 
-	return true;
+	return yaml_sd.ModificationTime;
 }
 
-static bool ReadS8(std::FILE* stream, s8* dest)
+// gamedb.cache is a flat image which is queried in place, either mapped or read in one go.  Nothing
+// is deserialized up front, FindGame() binary searches the entry table and only builds a GameEntry
+// for the serial it was asked about.  Offsets are from the start of the file, strings are not
+// null terminated, and patches are stored as one blob of '\n' terminated lines.
+//
+//   CacheHeader
+//   CacheEntry[entry_count], sorted by serial
+//   CacheString[string_ref_count]         (game fixes and memcard filters)
+//   CacheSpeedHack[speed_hack_count]
+//   CachePatch[patch_count]
+//   string data
+struct CacheString
 {
-	return std::fread(dest, sizeof(s8), 1, stream) > 0;
-}
+	u32 offset; // into the string data
+	u32 length;
+};
 
-static bool ReadU8(std::FILE* stream, u8* dest)
+struct CacheHeader
 {
-	return std::fread(dest, sizeof(u8), 1, stream) > 0;
-}
-
-static bool ReadS32(std::FILE* stream, s32* dest)
+	u64 magic;
+	s64 yaml_mtime;
+	u32 file_size;
+	u32 entry_count;
+	u32 entries_offset;
+	u32 string_ref_count;
+	u32 string_refs_offset;
+	u32 speed_hack_count;
+	u32 speed_hacks_offset;
+	u32 patch_count;
+	u32 patches_offset;
+	u32 string_data_offset;
+	u32 string_data_size;
+	u32 pad;
+};
+
+struct CacheEntry
 {
-	return std::fread(dest, sizeof(s32), 1, stream) > 0;
-}
-
-static bool ReadU32(std::FILE* stream, u32* dest)
+	CacheString serial;
+	CacheString name;
+	CacheString region;
+	u8 compat;
+	s8 ee_round_mode;
+	s8 ee_clamp_mode;
+	s8 vu_round_mode;
+	s8 vu_clamp_mode;
+	u8 pad[3];
+	u32 first_game_fix, game_fix_count;
+	u32 first_speed_hack, speed_hack_count;
+	u32 first_memcard_filter, memcard_filter_count;
+	u32 first_patch, patch_count;
+};
+
+struct CacheSpeedHack
 {
-	return std::fread(dest, sizeof(u32), 1, stream) > 0;
-}
+	CacheString name;
+	s32 value;
+};
 
-static bool ReadS64(std::FILE* stream, s64* dest)
+struct CachePatch
 {
-	return std::fread(dest, sizeof(s64), 1, stream) > 0;
-}
+	CacheString crc;
+	CacheString lines;
+};
 
-static bool ReadU64(std::FILE* stream, u64* dest)
-{
-	return std::fread(dest, sizeof(u64), 1, stream) > 0;
-}
+static_assert(sizeof(CacheHeader) % 8 == 0 && sizeof(CacheEntry) % 4 == 0, "Cache tables must stay aligned");
 
-static bool WriteString(std::FILE* stream, const std::string& str)
-{
-	const u32 size = static_cast<u32>(str.size());
-	return (std::fwrite(&size, sizeof(size), 1, stream) > 0 &&
-			(size == 0 || std::fwrite(str.data(), size, 1, stream) > 0));
-}
+// Either a mapping of the cache file, or s_cache_data when it had to be read or was just built.
+static const u8* s_cache_base = nullptr;
+static const CacheHeader* s_cache_header = nullptr;
+static std::vector<u8> s_cache_data;
 
-static bool WriteS8(std::FILE* stream, s8 dest)
+// Entries handed out by FindGame(), which have to stay valid for the lifetime of the process.
+static std::unordered_map<std::string, GameDatabaseSchema::GameEntry> s_found_games;
+static std::mutex s_found_games_mutex;
+
+static bool GetCacheString(const CacheString& str, std::string_view* dest)
 {
-	return std::fwrite(&dest, sizeof(s8), 1, stream) > 0;
+	if (static_cast<u64>(str.offset) + str.length > s_cache_header->string_data_size)
+		return false;
+
+	*dest = std::string_view(reinterpret_cast<const char*>(s_cache_base + s_cache_header->string_data_offset + str.offset), str.length);
+	return true;
 }
 
-static bool WriteU8(std::FILE* stream, u8 dest)
+static bool GetCacheString(const CacheString& str, std::string* dest)
 {
-	return std::fwrite(&dest, sizeof(u8), 1, stream) > 0;
+	std::string_view sv;
+	if (!GetCacheString(str, &sv))
+		return false;
+
+	dest->assign(sv);
+	return true;
 }
 
-static bool WriteS32(std::FILE* stream, s32 dest)
+template <typename T>
+static const T* GetCacheTable(u32 offset)
 {
-	return std::fwrite(&dest, sizeof(s32), 1, stream) > 0;
+	return reinterpret_cast<const T*>(s_cache_base + offset);
 }
 
-static bool WriteU32(std::FILE* stream, u32 dest)
+static bool IsCacheRangeValid(u32 first, u32 count, u32 table_count)
 {
-	return std::fwrite(&dest, sizeof(u32), 1, stream) > 0;
+	return (static_cast<u64>(first) + count <= table_count);
 }
 
-static bool WriteS64(std::FILE* stream, s64 dest)
+static bool IsCacheTableValid(u32 offset, u32 count, size_t element_size, u32 file_size)
 {
-	return std::fwrite(&dest, sizeof(s64), 1, stream) > 0;
+	return ((offset % 4) == 0 && static_cast<u64>(offset) + static_cast<u64>(count) * element_size <= file_size);
 }
 
-static bool WriteU64(std::FILE* stream, u64 dest)
+static bool SetCacheData(const u8* data, size_t size, s64 expected_mtime)
 {
-	return std::fwrite(&dest, sizeof(u64), 1, stream) > 0;
+	if (size < sizeof(CacheHeader))
+		return false;
+
+	const CacheHeader* header = reinterpret_cast<const CacheHeader*>(data);
+	if (header->magic != CACHE_FILE_MAGIC || header->yaml_mtime != expected_mtime || header->file_size != size ||
+		!IsCacheTableValid(header->entries_offset, header->entry_count, sizeof(CacheEntry), header->file_size) ||
+		!IsCacheTableValid(header->string_refs_offset, header->string_ref_count, sizeof(CacheString), header->file_size) ||
+		!IsCacheTableValid(header->speed_hacks_offset, header->speed_hack_count, sizeof(CacheSpeedHack), header->file_size) ||
+		!IsCacheTableValid(header->patches_offset, header->patch_count, sizeof(CachePatch), header->file_size) ||
+		static_cast<u64>(header->string_data_offset) + header->string_data_size > header->file_size)
+	{
+		return false;
+	}
+
+	s_cache_base = data;
+	s_cache_header = header;
+	return true;
 }
 
-static s64 GetExpectedMTime()
+static bool MapCacheFile(const char* filename, s64 expected_mtime)
 {
-	const std::string yaml_filename(Path::CombineStdString(EmuFolders::Resources, GAMEDB_YAML_FILE_NAME));
+#ifdef _WIN32
+	const HANDLE file = CreateFileW(StringUtil::UTF8StringToWideString(filename).c_str(), GENERIC_READ, FILE_SHARE_READ,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
 
-	FILESYSTEM_STAT_DATA yaml_sd;
-	if (!FileSystem::StatFile(yaml_filename.c_str(), &yaml_sd))
-		return -1;
+	LARGE_INTEGER size;
+	const HANDLE mapping = (GetFileSizeEx(file, &size) && size.QuadPart > 0) ?
+							   CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr) :
+                               nullptr;
+	void* ptr = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+	// the view keeps the mapping alive
+	if (mapping)
+		CloseHandle(mapping);
+	CloseHandle(file);
+	if (!ptr)
+		return false;
 
-	return yaml_sd.ModificationTime;
+	if (!SetCacheData(static_cast<const u8*>(ptr), static_cast<size_t>(size.QuadPart), expected_mtime))
+	{
+		UnmapViewOfFile(ptr);
+		return false;
+	}
+#else
+	const int fd = FileSystem::OpenFDFile(filename, O_RDONLY, 0);
+	if (fd < 0)
+		return false;
+
+	struct stat sd;
+	void* ptr = (fstat(fd, &sd) == 0 && sd.st_size > 0) ?
+					mmap(nullptr, static_cast<size_t>(sd.st_size), PROT_READ, MAP_PRIVATE, fd, 0) :
+                    MAP_FAILED;
+	close(fd);
+	if (ptr == MAP_FAILED)
+		return false;
+
+	if (!SetCacheData(static_cast<const u8*>(ptr), static_cast<size_t>(sd.st_size), expected_mtime))
+	{
+		munmap(ptr, static_cast<size_t>(sd.st_size));
+		return false;
+	}
+#endif
+
+	return true;
 }
 
 static bool CheckAndLoad(const char* cached_filename, s64 expected_mtime)
 {
-	auto fp = FileSystem::OpenManagedCFile(cached_filename, "rb");
-	if (!fp)
+	if (MapCacheFile(cached_filename, expected_mtime))
+		return true;
+
+	// can't map it (or it's stale), fall back to reading the whole thing
+	std::optional<std::vector<u8>> data(FileSystem::ReadBinaryFile(cached_filename));
+	if (!data.has_value())
 		return false;
 
-	u64 file_signature;
-	s64 file_mtime, start_pos, file_size;
-	if (!ReadU64(fp.get(), &file_signature) || file_signature != CACHE_FILE_MAGIC ||
-		!ReadS64(fp.get(), &file_mtime) || file_mtime != expected_mtime ||
-		(start_pos = FileSystem::FTell64(fp.get())) < 0 || FileSystem::FSeek64(fp.get(), 0, SEEK_END) != 0 ||
-		(file_size = FileSystem::FTell64(fp.get())) < 0 || FileSystem::FSeek64(fp.get(), start_pos, SEEK_SET) != 0)
+	s_cache_data = std::move(data.value());
+	if (!SetCacheData(s_cache_data.data(), s_cache_data.size(), expected_mtime))
 	{
+		s_cache_data = std::vector<u8>();
 		return false;
 	}
 
-	while (FileSystem::FTell64(fp.get()) != file_size)
+	return true;
+}
+
+namespace
+{
+	class CacheBuilder
 	{
-		std::string serial;
-		GameDatabaseSchema::GameEntry entry;
-		u8 compat;
-		s8 ee_round, ee_clamp, vu_round, vu_clamp;
-		u32 game_fix_count, speed_hack_count, memcard_filter_count, patch_count;
-
-		if (!ReadString(fp.get(), &serial) ||
-			!ReadString(fp.get(), &entry.name) ||
-			!ReadString(fp.get(), &entry.region) ||
-			!ReadU8(fp.get(), &compat) || compat > static_cast<u8>(GameDatabaseSchema::Compatibility::Perfect) ||
-			!ReadS8(fp.get(), &ee_round) || ee_round < static_cast<s8>(GameDatabaseSchema::RoundMode::Undefined) || ee_round > static_cast<s8>(GameDatabaseSchema::RoundMode::ChopZero) ||
-			!ReadS8(fp.get(), &ee_clamp) || ee_clamp < static_cast<s8>(GameDatabaseSchema::ClampMode::Undefined) || ee_clamp > static_cast<s8>(GameDatabaseSchema::ClampMode::Full) ||
-			!ReadS8(fp.get(), &vu_round) || vu_round < static_cast<s8>(GameDatabaseSchema::RoundMode::Undefined) || vu_round > static_cast<s8>(GameDatabaseSchema::RoundMode::ChopZero) ||
-			!ReadS8(fp.get(), &vu_clamp) || vu_clamp < static_cast<s8>(GameDatabaseSchema::ClampMode::Undefined) || vu_clamp > static_cast<s8>(GameDatabaseSchema::ClampMode::Full) ||
-			!ReadU32(fp.get(), &game_fix_count) ||
-			!ReadU32(fp.get(), &speed_hack_count) ||
-			!ReadU32(fp.get(), &memcard_filter_count) ||
-			!ReadU32(fp.get(), &patch_count))
+	public:
+		CacheString AddString(const std::string& str)
 		{
-			Console.Error("GameDB: Read error while loading entry");
-			return false;
+			// game fixes and speedhack names repeat a lot, only store them once
+			const auto it = m_string_lookup.find(str);
+			if (it != m_string_lookup.end())
+				return it->second;
+
+			const CacheString ret = {static_cast<u32>(m_string_data.size()), static_cast<u32>(str.size())};
+			m_string_data.append(str);
+			m_string_lookup.emplace(str, ret);
+			return ret;
 		}
 
-		entry.compat = static_cast<GameDatabaseSchema::Compatibility>(compat);
-		entry.eeRoundMode = static_cast<GameDatabaseSchema::RoundMode>(ee_round);
-		entry.eeClampMode = static_cast<GameDatabaseSchema::ClampMode>(ee_clamp);
-		entry.vuRoundMode = static_cast<GameDatabaseSchema::RoundMode>(vu_round);
-		entry.vuClampMode = static_cast<GameDatabaseSchema::ClampMode>(vu_clamp);
-
-		entry.gameFixes.resize(game_fix_count);
-		for (u32 i = 0; i < game_fix_count; ++i)
+		void AddStringRefs(const std::vector<std::string>& strings, u32* first, u32* count)
 		{
-			if (!ReadString(fp.get(), &entry.gameFixes[i]))
-				return false;
+			*first = static_cast<u32>(m_string_refs.size());
+			*count = static_cast<u32>(strings.size());
+			for (const std::string& str : strings)
+				m_string_refs.push_back(AddString(str));
 		}
 
-		for (u32 i = 0; i < speed_hack_count; ++i)
+		void AddEntry(const std::string& serial, const GameDatabaseSchema::GameEntry& entry)
 		{
-			std::string speed_hack_name;
-			s32 speed_hack_value;
-			if (!ReadString(fp.get(), &speed_hack_name) || !ReadS32(fp.get(), &speed_hack_value))
-				return false;
-			entry.speedHacks.emplace(std::move(speed_hack_name), speed_hack_value);
+			CacheEntry ce = {};
+			ce.serial = AddString(serial);
+			ce.name = AddString(entry.name);
+			ce.region = AddString(entry.region);
+			ce.compat = static_cast<u8>(entry.compat);
+			ce.ee_round_mode = static_cast<s8>(entry.eeRoundMode);
+			ce.ee_clamp_mode = static_cast<s8>(entry.eeClampMode);
+			ce.vu_round_mode = static_cast<s8>(entry.vuRoundMode);
+			ce.vu_clamp_mode = static_cast<s8>(entry.vuClampMode);
+
+			AddStringRefs(entry.gameFixes, &ce.first_game_fix, &ce.game_fix_count);
+			AddStringRefs(entry.memcardFilters, &ce.first_memcard_filter, &ce.memcard_filter_count);
+
+			ce.first_speed_hack = static_cast<u32>(m_speed_hacks.size());
+			ce.speed_hack_count = static_cast<u32>(entry.speedHacks.size());
+			for (const auto& it : entry.speedHacks)
+				m_speed_hacks.push_back({AddString(it.first), it.second});
+
+			ce.first_patch = static_cast<u32>(m_patches.size());
+			ce.patch_count = static_cast<u32>(entry.patches.size());
+			for (const auto& it : entry.patches)
+			{
+				std::string lines;
+				for (const std::string& line : it.second)
+				{
+					lines.append(line);
+					lines.push_back('\n');
+				}
+
+				// patch contents are unique, don't bother putting them in the lookup
+				const CacheString lines_str = {static_cast<u32>(m_string_data.size()), static_cast<u32>(lines.size())};
+				m_string_data.append(lines);
+				m_patches.push_back({AddString(it.first), lines_str});
+			}
+
+			m_entries.push_back(ce);
 		}
 
-		entry.memcardFilters.resize(memcard_filter_count);
-		for (u32 i = 0; i < memcard_filter_count; ++i)
+		std::vector<u8> Build(s64 mtime)
 		{
-			if (!ReadString(fp.get(), &entry.memcardFilters[i]))
-				return false;
+			CacheHeader header = {};
+			header.magic = CACHE_FILE_MAGIC;
+			header.yaml_mtime = mtime;
+
+			u32 offset = sizeof(CacheHeader);
+			header.entry_count = static_cast<u32>(m_entries.size());
+			header.entries_offset = offset;
+			offset += static_cast<u32>(m_entries.size() * sizeof(CacheEntry));
+			header.string_ref_count = static_cast<u32>(m_string_refs.size());
+			header.string_refs_offset = offset;
+			offset += static_cast<u32>(m_string_refs.size() * sizeof(CacheString));
+			header.speed_hack_count = static_cast<u32>(m_speed_hacks.size());
+			header.speed_hacks_offset = offset;
+			offset += static_cast<u32>(m_speed_hacks.size() * sizeof(CacheSpeedHack));
+			header.patch_count = static_cast<u32>(m_patches.size());
+			header.patches_offset = offset;
+			offset += static_cast<u32>(m_patches.size() * sizeof(CachePatch));
+			header.string_data_offset = offset;
+			header.string_data_size = static_cast<u32>(m_string_data.size());
+			offset += static_cast<u32>(m_string_data.size());
+			header.file_size = offset;
+
+			std::vector<u8> data(offset);
+			std::memcpy(data.data(), &header, sizeof(header));
+			std::memcpy(data.data() + header.entries_offset, m_entries.data(), m_entries.size() * sizeof(CacheEntry));
+			std::memcpy(data.data() + header.string_refs_offset, m_string_refs.data(), m_string_refs.size() * sizeof(CacheString));
+			std::memcpy(data.data() + header.speed_hacks_offset, m_speed_hacks.data(), m_speed_hacks.size() * sizeof(CacheSpeedHack));
+			std::memcpy(data.data() + header.patches_offset, m_patches.data(), m_patches.size() * sizeof(CachePatch));
+			std::memcpy(data.data() + header.string_data_offset, m_string_data.data(), m_string_data.size());
+			return data;
 		}
 
-		for (u32 i = 0; i < patch_count; ++i)
-		{
-			std::string patch_crc;
-			u32 patch_line_count;
-			if (!ReadString(fp.get(), &patch_crc) || !ReadU32(fp.get(), &patch_line_count))
-				return false;
-
-			GameDatabaseSchema::Patch patch_lines;
-			patch_lines.resize(patch_line_count);
-			for (u32 j = 0; j < patch_line_count; ++j)
-			{
-				if (!ReadString(fp.get(), &patch_lines[j]))
-					return false;
-			}
+	private:
+		std::vector<CacheEntry> m_entries;
+		std::vector<CacheString> m_string_refs;
+		std::vector<CacheSpeedHack> m_speed_hacks;
+		std::vector<CachePatch> m_patches;
+		std::string m_string_data;
+		std::unordered_map<std::string, CacheString> m_string_lookup;
+	};
+} // namespace
+
+// Flattens s_game_db into the cache format, which then replaces it.
+static void BuildCache(s64 mtime)
+{
+	std::vector<const std::pair<const std::string, GameDatabaseSchema::GameEntry>*> sorted;
+	sorted.reserve(s_game_db.size());
+	for (const auto& it : s_game_db)
+		sorted.push_back(&it);
+	std::sort(sorted.begin(), sorted.end(), [](const auto* lhs, const auto* rhs) {
+		return std::string_view(lhs->first) < std::string_view(rhs->first);
+	});
 
-			entry.patches.emplace(std::move(patch_crc), std::move(patch_lines));
-		}
+	CacheBuilder builder;
+	for (const auto* it : sorted)
+		builder.AddEntry(it->first, it->second);
+
+	s_cache_data = builder.Build(mtime);
+	s_game_db.clear();
+	SetCacheData(s_cache_data.data(), s_cache_data.size(), mtime);
+}
+
+static bool SaveCache(const char* cached_filename)
+{
+	return FileSystem::WriteBinaryFile(cached_filename, s_cache_data.data(), s_cache_data.size());
+}
+
+static const CacheEntry* FindCacheEntry(const std::string_view& serial)
+{
+	const CacheEntry* begin = GetCacheTable<CacheEntry>(s_cache_header->entries_offset);
+	const CacheEntry* end = begin + s_cache_header->entry_count;
+	const CacheEntry* it = std::lower_bound(begin, end, serial, [](const CacheEntry& ce, const std::string_view& serial) {
+		std::string_view ce_serial;
+		return GetCacheString(ce.serial, &ce_serial) && ce_serial < serial;
+	});
+
+	std::string_view it_serial;
+	return (it != end && GetCacheString(it->serial, &it_serial) && it_serial == serial) ? it : nullptr;
+}
+
+static bool ReadStringRefs(u32 first, u32 count, std::vector<std::string>* dest)
+{
+	if (!IsCacheRangeValid(first, count, s_cache_header->string_ref_count))
+		return false;
 
-		s_game_db.emplace(std::move(serial), std::move(entry));
+	const CacheString* refs = GetCacheTable<CacheString>(s_cache_header->string_refs_offset) + first;
+	dest->resize(count);
+	for (u32 i = 0; i < count; i++)
+	{
+		if (!GetCacheString(refs[i], &(*dest)[i]))
+			return false;
 	}
 
 	return true;
 }
 
-static bool SaveCache(const char* cached_filename, s64 mtime)
+static bool ReadCacheEntry(const CacheEntry& ce, GameDatabaseSchema::GameEntry* entry)
 {
-	auto fp = FileSystem::OpenManagedCFile(cached_filename, "wb");
-	if (!fp)
+	if (!GetCacheString(ce.name, &entry->name) ||
+		!GetCacheString(ce.region, &entry->region) ||
+		ce.compat > static_cast<u8>(GameDatabaseSchema::Compatibility::Perfect) ||
+		ce.ee_round_mode < static_cast<s8>(GameDatabaseSchema::RoundMode::Undefined) || ce.ee_round_mode > static_cast<s8>(GameDatabaseSchema::RoundMode::ChopZero) ||
+		ce.ee_clamp_mode < static_cast<s8>(GameDatabaseSchema::ClampMode::Undefined) || ce.ee_clamp_mode > static_cast<s8>(GameDatabaseSchema::ClampMode::Full) ||
+		ce.vu_round_mode < static_cast<s8>(GameDatabaseSchema::RoundMode::Undefined) || ce.vu_round_mode > static_cast<s8>(GameDatabaseSchema::RoundMode::ChopZero) ||
+		ce.vu_clamp_mode < static_cast<s8>(GameDatabaseSchema::ClampMode::Undefined) || ce.vu_clamp_mode > static_cast<s8>(GameDatabaseSchema::ClampMode::Full) ||
+		!ReadStringRefs(ce.first_game_fix, ce.game_fix_count, &entry->gameFixes) ||
+		!ReadStringRefs(ce.first_memcard_filter, ce.memcard_filter_count, &entry->memcardFilters) ||
+		!IsCacheRangeValid(ce.first_speed_hack, ce.speed_hack_count, s_cache_header->speed_hack_count) ||
+		!IsCacheRangeValid(ce.first_patch, ce.patch_count, s_cache_header->patch_count))
+	{
 		return false;
+	}
 
-	if (!WriteU64(fp.get(), CACHE_FILE_MAGIC) || !WriteS64(fp.get(), mtime))
-		return false;
+	entry->compat = static_cast<GameDatabaseSchema::Compatibility>(ce.compat);
+	entry->eeRoundMode = static_cast<GameDatabaseSchema::RoundMode>(ce.ee_round_mode);
+	entry->eeClampMode = static_cast<GameDatabaseSchema::ClampMode>(ce.ee_clamp_mode);
+	entry->vuRoundMode = static_cast<GameDatabaseSchema::RoundMode>(ce.vu_round_mode);
+	entry->vuClampMode = static_cast<GameDatabaseSchema::ClampMode>(ce.vu_clamp_mode);
 
-	for (const auto& it : s_game_db)
+	const CacheSpeedHack* speed_hacks = GetCacheTable<CacheSpeedHack>(s_cache_header->speed_hacks_offset) + ce.first_speed_hack;
+	for (u32 i = 0; i < ce.speed_hack_count; i++)
 	{
-		const GameDatabaseSchema::GameEntry& entry = it.second;
-		const u8 compat = static_cast<u8>(entry.compat);
-		const s8 ee_round = static_cast<s8>(entry.eeRoundMode);
-		const s8 ee_clamp = static_cast<s8>(entry.eeClampMode);
-		const s8 vu_round = static_cast<s8>(entry.vuRoundMode);
-		const s8 vu_clamp = static_cast<s8>(entry.vuClampMode);
-
-		if (!WriteString(fp.get(), it.first) ||
-			!WriteString(fp.get(), entry.name) ||
-			!WriteString(fp.get(), entry.region) ||
-			!WriteU8(fp.get(), compat) ||
-			!WriteS8(fp.get(), ee_round) ||
-			!WriteS8(fp.get(), ee_clamp) ||
-			!WriteS8(fp.get(), vu_round) ||
-			!WriteS8(fp.get(), vu_clamp) ||
-			!WriteU32(fp.get(), static_cast<u32>(entry.gameFixes.size())) ||
-			!WriteU32(fp.get(), static_cast<u32>(entry.speedHacks.size())) ||
-			!WriteU32(fp.get(), static_cast<u32>(entry.memcardFilters.size())) ||
-			!WriteU32(fp.get(), static_cast<u32>(entry.patches.size())))
-		{
+		std::string name;
+		if (!GetCacheString(speed_hacks[i].name, &name))
 			return false;
-		}
-
-		for (const std::string& it : entry.gameFixes)
-		{
-			if (!WriteString(fp.get(), it))
-				return false;
-		}
+		entry->speedHacks.emplace(std::move(name), speed_hacks[i].value);
+	}
 
-		for (const auto& it : entry.speedHacks)
-		{
-			if (!WriteString(fp.get(), it.first) || !WriteS32(fp.get(), it.second))
-				return false;
-		}
+	const CachePatch* patches = GetCacheTable<CachePatch>(s_cache_header->patches_offset) + ce.first_patch;
+	for (u32 i = 0; i < ce.patch_count; i++)
+	{
+		std::string crc;
+		std::string_view lines;
+		if (!GetCacheString(patches[i].crc, &crc) || !GetCacheString(patches[i].lines, &lines))
+			return false;
 
-		for (const std::string& it : entry.memcardFilters)
+		GameDatabaseSchema::Patch patch;
+		while (!lines.empty())
 		{
-			if (!WriteString(fp.get(), it))
-				return false;
+			const std::string_view::size_type pos = lines.find('\n');
+			patch.emplace_back(lines.substr(0, pos));
+			lines.remove_prefix((pos != std::string_view::npos) ? (pos + 1) : lines.size());
 		}
 
-		for (const auto& it : entry.patches)
-		{
-			if (!WriteString(fp.get(), it.first) || !WriteU32(fp.get(), static_cast<u32>(it.second.size())))
-				return false;
-
-			for (const std::string& jt : it.second)
-			{
-				if (!WriteString(fp.get(), jt))
-					return false;
-			}
-		}
+		entry->patches.emplace(std::move(crc), std::move(patch));
 	}
 
-	return std::fflush(fp.get()) == 0;
+	return true;
 }
 
 static void Load()
@@ -536,11 +724,12 @@ static void Load()
 			return;
 		}
 
-		if (!SaveCache(cache_filename.c_str(), expected_mtime))
+		BuildCache(expected_mtime);
+		if (!SaveCache(cache_filename.c_str()))
 			Console.Error("GameDB: Failed to save new cache");
 	}
 
-	Console.WriteLn("[GameDB] %zu games on record (loaded in %.2fms)", s_game_db.size(), timer.GetTimeMilliseconds());
+	Console.WriteLn("[GameDB] %u games on record (loaded in %.2fms)", s_cache_header->entry_count, timer.GetTimeMilliseconds());
 }
 
 void GameDatabase::EnsureLoaded()
@@ -557,13 +746,28 @@ const GameDatabaseSchema::GameEntry* GameDatabase::FindGame(const std::string& s
 	const std::string serialLower(strToLower(serial));
 	Console.WriteLn("[GameDB] Searching for '%s' in GameDB", serialLower.c_str());
 
-	auto iter = s_game_db.find(serialLower);
-	if (iter == s_game_db.end())
+	std::unique_lock lock(s_found_games_mutex);
+	auto iter = s_found_games.find(serialLower);
+	if (iter != s_found_games.end())
+	{
+		Console.WriteLn("[GameDB] Found '%s' in GameDB", serialLower.c_str());
+		return &iter->second;
+	}
+
+	const CacheEntry* ce = s_cache_header ? FindCacheEntry(serialLower) : nullptr;
+	if (!ce)
 	{
 		Console.Error("[GameDB] Could not find '%s' in GameDB", serialLower.c_str());
 		return nullptr;
 	}
 
+	GameDatabaseSchema::GameEntry entry;
+	if (!ReadCacheEntry(*ce, &entry))
+	{
+		Console.Error("[GameDB] Cache entry for '%s' is corrupted", serialLower.c_str());
+		return nullptr;
+	}
+
 	Console.WriteLn("[GameDB] Found '%s' in GameDB", serialLower.c_str());
-	return &iter->second;
+	return &s_found_games.emplace(serialLower, std::move(entry)).first->second;
 }
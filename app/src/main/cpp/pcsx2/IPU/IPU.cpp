@@ -18,13 +18,16 @@
 
 #include "IPU.h"
 #include "IPUdma.h"
+#include "IPU_Kernels.h"
 
 #include <limits.h>
 #include "Config.h"
 
 #include "common/MemsetFast.inl"
+#include "common/PersistentThread.h"
 #include "mpeg2_vlc.h"
 #include <array>
+#include <thread>
 
 #ifdef _M_ARM64
 #ifdef _MSC_VER
@@ -54,24 +57,6 @@ struct macroblock_16
 	s16 Cr[8][8]; //2
 };
 
-struct macroblock_rgb32
-{
-	struct
-	{
-		u8 r, g, b, a;
-	} c[16][16];
-};
-
-struct rgb16_t
-{
-	u16 r : 5, g : 5, b : 5, a : 1;
-};
-
-struct macroblock_rgb16
-{
-	rgb16_t c[16][16];
-};
-
 struct decoder_t
 {
 	/* first, state that carries information from one macroblock to the */
@@ -348,9 +333,6 @@ static __fi int bitstream_init()
 }
 
 
-static void mpeg2_idct_copy(s16* block, u8* dest, int stride);
-static void mpeg2_idct_add(int last, s16* block, s16* dest, int stride);
-
 static bool mpeg2sliceIDEC();
 static bool mpeg2_slice();
 static int get_macroblock_address_increment();
@@ -360,8 +342,6 @@ static int get_motion_delta(const int f_code);
 static int get_dmv();
 
 static void ipu_csc(macroblock_8& mb8, macroblock_rgb32& rgb32, int sgn);
-static void ipu_dither(const macroblock_rgb32& rgb32, macroblock_rgb16& rgb16, int dte);
-static void ipu_vq(macroblock_rgb16& rgb16, u8* indx4);
 
 static void yuv2rgb_reference();
 
@@ -438,7 +418,7 @@ void tIPU_cmd::clear()
 	current = 0xffffffff;
 }
 
-__fi void IPUProcessInterrupt()
+static void IPUProcessInterruptInline()
 {
 	if (ipuRegs.ctrl.BUSY) // && (g_BP.FP || g_BP.IFC || (ipu1ch.chcr.STR && ipu1ch.qwc > 0)))
 		IPUWorker();
@@ -451,11 +431,211 @@ __fi void IPUProcessInterrupt()
 	}
 }
 
+/////////////////////////////////////////////////////////
+// Threaded IPU
+//
+// Works like MTVU: the EE hands the current command to the IPU thread and keeps running until it
+// next touches IPU state, at which point it waits for the thread to catch up.  The decoder only
+// ever sees the EE state captured at kick time, and anything it would have done to the EE
+// (INTC, DMA events) is recorded and replayed relative to the kick cycle.  The sync point is either
+// the next EE access or IPU_PROCESS, a fixed number of EE cycles after the kick, so the emulated
+// timeline never depends on how fast the host thread happens to be.
+
+// How long the EE may run ahead of a kicked IPU command before it waits for the result.
+static constexpr s32 IPU_THREAD_CYCLES = 2048;
+
+namespace
+{
+	struct IPUEEState
+	{
+		u32 cycle;
+		bool to_ipu_waiting;
+		bool to_ipu_active;
+		bool from_ipu_active;
+	};
+
+	struct IPUDeferredEffects
+	{
+		bool intc;
+		s32 to_ipu; // -1 when not scheduled
+		s32 from_ipu;
+	};
+
+	class IPUThread
+	{
+	public:
+		~IPUThread() { Shutdown(); }
+
+		bool IsPending() const { return m_pending; }
+
+		void Kick()
+		{
+			if (!m_thread.joinable())
+				m_thread = std::thread(&IPUThread::ThreadProc, this);
+
+			m_ee.cycle = cpuRegs.cycle;
+			m_ee.to_ipu_waiting = (cpuRegs.eCycle[DMAC_TO_IPU] == 0x9999);
+			m_ee.to_ipu_active = ipu1ch.chcr.STR;
+			m_ee.from_ipu_active = ipu0ch.chcr.STR;
+			m_effects = {false, -1, -1};
+			m_pending = true;
+			m_sem.NotifyOfWork();
+		}
+
+		void Wait()
+		{
+			if (!m_sem.WaitForEmptyWithSpin())
+				pxFailRel("IPU Thread Died");
+			m_pending = false;
+		}
+
+		void Shutdown()
+		{
+			if (!m_thread.joinable())
+				return;
+			m_quit = true;
+			m_sem.NotifyOfWork();
+			m_thread.join();
+			m_quit = false;
+			m_sem.Reset();
+		}
+
+		static bool IsCurrentThread() { return s_on_ipu_thread; }
+
+		// Only valid while running on the IPU thread, or on the EE once Wait() returned
+		IPUEEState m_ee;
+		IPUDeferredEffects m_effects;
+
+	private:
+		void ThreadProc()
+		{
+			Threading::SetNameOfCurrentThread("IPU");
+			s_on_ipu_thread = true;
+
+			while (true)
+			{
+				m_sem.WaitForWorkWithSpin();
+				if (m_quit)
+					break;
+				IPUProcessInterruptInline();
+			}
+		}
+
+		static thread_local bool s_on_ipu_thread;
+
+		std::thread m_thread;
+		Threading::WorkSema m_sem;
+		std::atomic<bool> m_quit{false};
+		bool m_pending = false; // EE only
+	};
+
+	thread_local bool IPUThread::s_on_ipu_thread = false;
+} // namespace
+
+static IPUThread s_ipu_thread;
+
+void ipuThreadSync()
+{
+	if (!s_ipu_thread.IsPending())
+		return;
+
+	s_ipu_thread.Wait();
+	cpuClearInt(IPU_PROCESS);
+
+	const IPUEEState& ee = s_ipu_thread.m_ee;
+	const IPUDeferredEffects& effects = s_ipu_thread.m_effects;
+	if (effects.to_ipu >= 0)
+	{
+		CPU_INT(DMAC_TO_IPU, effects.to_ipu);
+		cpuRegs.sCycle[DMAC_TO_IPU] = ee.cycle;
+		cpuSetNextEvent(ee.cycle, cpuRegs.eCycle[DMAC_TO_IPU]);
+	}
+	if (effects.from_ipu >= 0)
+	{
+		CPU_INT(DMAC_FROM_IPU, effects.from_ipu);
+		cpuRegs.sCycle[DMAC_FROM_IPU] = ee.cycle;
+		cpuSetNextEvent(ee.cycle, cpuRegs.eCycle[DMAC_FROM_IPU]);
+	}
+	if (effects.intc)
+		hwIntcIrq(INTC_IPU);
+}
+
+void ipuThreadShutdown()
+{
+	ipuThreadSync();
+	s_ipu_thread.Shutdown();
+}
+
+__fi void IPUProcessInterrupt()
+{
+	ipuThreadSync();
+
+	if (!THREAD_IPU || !ipuRegs.ctrl.BUSY)
+	{
+		IPUProcessInterruptInline();
+		return;
+	}
+
+	s_ipu_thread.Kick();
+	CPU_INT(IPU_PROCESS, IPU_THREAD_CYCLES);
+}
+
+bool ipuToIpuDmaWaiting()
+{
+	return IPUThread::IsCurrentThread() ? s_ipu_thread.m_ee.to_ipu_waiting : (cpuRegs.eCycle[DMAC_TO_IPU] == 0x9999);
+}
+
+bool ipuToIpuDmaActive()
+{
+	return IPUThread::IsCurrentThread() ? s_ipu_thread.m_ee.to_ipu_active : ipu1ch.chcr.STR;
+}
+
+bool ipuFromIpuDmaActive()
+{
+	return IPUThread::IsCurrentThread() ? s_ipu_thread.m_ee.from_ipu_active : ipu0ch.chcr.STR;
+}
+
+u32 ipuEECycle()
+{
+	return IPUThread::IsCurrentThread() ? s_ipu_thread.m_ee.cycle : cpuRegs.cycle;
+}
+
+void ipuRaiseInterrupt()
+{
+	if (IPUThread::IsCurrentThread())
+		s_ipu_thread.m_effects.intc = true;
+	else
+		hwIntcIrq(INTC_IPU);
+}
+
+void ipuScheduleToIpu(s32 cycles)
+{
+	if (IPUThread::IsCurrentThread())
+	{
+		s_ipu_thread.m_effects.to_ipu = cycles;
+		// Same as CPU_INT leaving eCycle != 0x9999 behind
+		s_ipu_thread.m_ee.to_ipu_waiting = false;
+	}
+	else
+	{
+		CPU_INT(DMAC_TO_IPU, cycles);
+	}
+}
+
+void ipuScheduleFromIpu(s32 cycles)
+{
+	if (IPUThread::IsCurrentThread())
+		s_ipu_thread.m_effects.from_ipu = cycles;
+	else
+		IPU_INT_FROM(cycles);
+}
+
 /////////////////////////////////////////////////////////
 // Register accesses (run on EE thread)
 
 void ipuReset()
 {
+	ipuThreadSync();
 	memzero(ipuRegs);
 	memzero(g_BP);
 	memzero(decoder);
@@ -481,6 +661,9 @@ void ReportIPU()
 
 void SaveStateBase::ipuFreeze()
 {
+	// The thread never holds state of its own, once it's synced the layout is the same as without it
+	ipuThreadSync();
+
 	// Get a report of the status of the ipu variables when saving and loading savestates.
 	//ReportIPU();
 	FreezeTag("IPU");
@@ -585,7 +768,9 @@ __fi u32 ipuRead32(u32 mem)
 	pxAssert((mem & ~0xff) == 0x10002000);
 	mem &= 0xff;	// ipu repeats every 0x100
 
-	IPUProcessInterrupt();
+	// The value is needed right away, so run the IPU here instead of kicking the thread
+	ipuThreadSync();
+	IPUProcessInterruptInline();
 
 	switch (mem)
 	{
@@ -642,7 +827,8 @@ __fi RETURNS_R64 ipuRead64(u32 mem)
 	pxAssert((mem & ~0xff) == 0x10002000);
 	mem &= 0xff;	// ipu repeats every 0x100
 
-	IPUProcessInterrupt();
+	ipuThreadSync();
+	IPUProcessInterruptInline();
 
 	switch (mem)
 	{
@@ -713,6 +899,8 @@ __fi bool ipuWrite32(u32 mem, u32 value)
 	pxAssert((mem & ~0xfff) == 0x10002000);
 	mem &= 0xfff;
 
+	ipuThreadSync();
+
 	switch (mem)
 	{
 		ipucase(IPU_CMD): // IPU_CMD
@@ -752,6 +940,8 @@ __fi bool ipuWrite64(u32 mem, u64 value)
 	pxAssert((mem & ~0xfff) == 0x10002000);
 	mem &= 0xfff;
 
+	ipuThreadSync();
+
 	switch (mem)
 	{
 		ipucase(IPU_CMD):
@@ -852,7 +1042,7 @@ static __fi bool ipuVDEC(u32 val)
 			}
 			count = 0;
 		}
-		eecount_on_last_vdec = cpuRegs.cycle;
+		eecount_on_last_vdec = ipuEECycle();
 	}
 	switch (ipu_cmd.pos[0])
 	{
@@ -1050,7 +1240,7 @@ static __ri bool ipuPACK(tIPU_CMD_CSC csc)
 
 		ipu_dither(decoder.rgb32, decoder.rgb16, csc.DTE);
 
-		if (!csc.OFM) ipu_vq(decoder.rgb16, indx4);
+		if (!csc.OFM) ipu_vq(decoder.rgb16, vqclut, indx4);
 
 		if (csc.OFM)
 		{
@@ -1116,35 +1306,6 @@ __fi void ipu_csc(macroblock_8& mb8, macroblock_rgb32& rgb32, int sgn)
 	}
 }
 
-__fi void ipu_vq(macroblock_rgb16& rgb16, u8* indx4)
-{
-	const auto closest_index = [&](int i, int j) {
-		u8 index = 0;
-		int min_distance = std::numeric_limits<int>::max();
-		for (u8 k = 0; k < 16; ++k)
-		{
-			const int dr = rgb16.c[i][j].r - vqclut[k].r;
-			const int dg = rgb16.c[i][j].g - vqclut[k].g;
-			const int db = rgb16.c[i][j].b - vqclut[k].b;
-			const int distance = dr * dr + dg * dg + db * db;
-
-			// XXX: If two distances are the same which index is used?
-			if (min_distance > distance)
-			{
-				index = k;
-				min_distance = distance;
-			}
-		}
-
-		return index;
-	};
-
-	for (int i = 0; i < 16; ++i)
-		for (int j = 0; j < 8; ++j)
-			indx4[i * 8 + j] = closest_index(i, 2 * j + 1) << 4 | closest_index(i, 2 * j);
-}
-
-
 // --------------------------------------------------------------------------------------
 //  IPU Worker / Dispatcher
 // --------------------------------------------------------------------------------------
@@ -1298,12 +1459,12 @@ __noinline void IPUWorker()
 	// success
 	ipuRegs.ctrl.BUSY = 0;
 	//ipu_cmd.current = 0xffffffff;
-	hwIntcIrq(INTC_IPU);
+	ipuRaiseInterrupt();
 
 	// Fill the FIFO ready for the next command
-	if (ipu1ch.chcr.STR && cpuRegs.eCycle[4] == 0x9999)
+	if (ipuToIpuDmaActive() && ipuToIpuDmaWaiting())
 	{
-		CPU_INT(DMAC_TO_IPU, 32);
+		ipuScheduleToIpu(32);
 	}
 }
 
@@ -2487,338 +2648,6 @@ __fi bool mpeg2_slice()
 }
 
 
-#define W1 2841 /* 2048*sqrt (2)*cos (1*pi/16) */
-#define W2 2676 /* 2048*sqrt (2)*cos (2*pi/16) */
-#define W3 2408 /* 2048*sqrt (2)*cos (3*pi/16) */
-#define W5 1609 /* 2048*sqrt (2)*cos (5*pi/16) */
-#define W6 1108 /* 2048*sqrt (2)*cos (6*pi/16) */
-#define W7 565 /* 2048*sqrt (2)*cos (7*pi/16) */
-
-/*
- * In legal streams, the IDCT output should be between -384 and +384.
- * In corrupted streams, it is possible to force the IDCT output to go
- * to +-3826 - this is the worst case for a column IDCT where the
- * column inputs are 16-bit values.
- */
-static constexpr std::array<u8, 1024> ComputeClipLUT()
-{
-	std::array<u8, 1024> ret = {};
-	for (int i = -384; i < 640; ++i)
-		ret[i + 384] = (i < 0) ? 0 : ((i > 255) ? 255 : i);
-	return ret;
-}
-static constexpr __aligned16 std::array<u8, 1024> clip_lut = ComputeClipLUT();
-
-static __fi void BUTTERFLY(int& t0, int& t1, int w0, int w1, int d0, int d1)
-{
-#if 0
-    t0 = w0*d0 + w1*d1;
-    t1 = w0*d1 - w1*d0;
-#else
-	int tmp = w0 * (d0 + d1);
-	t0 = tmp + (w1 - w0) * d1;
-	t1 = tmp - (w1 + w0) * d0;
-#endif
-}
-
-__ri void mpeg2_idct(s16* block)
-{
-	// TODO-some-time: SIMD-ify this
-	for (int i = 0; i < 8; ++i)
-	{
-		s16* const rblock = block + 8 * i;
-		if (!(rblock[1] | ((s32*)rblock)[1] | ((s32*)rblock)[2] |
-				((s32*)rblock)[3]))
-		{
-			u32 tmp = (u16)(rblock[0] << 3);
-			tmp |= tmp << 16;
-			((s32*)rblock)[0] = tmp;
-			((s32*)rblock)[1] = tmp;
-			((s32*)rblock)[2] = tmp;
-			((s32*)rblock)[3] = tmp;
-			continue;
-		}
-
-		int a0, a1, a2, a3;
-		{
-			const int d0 = (rblock[0] << 11) + 128;
-			const int d1 = rblock[1];
-			const int d2 = rblock[2] << 11;
-			const int d3 = rblock[3];
-			int t0 = d0 + d2;
-			int t1 = d0 - d2;
-			int t2, t3;
-			BUTTERFLY(t2, t3, W6, W2, d3, d1);
-			a0 = t0 + t2;
-			a1 = t1 + t3;
-			a2 = t1 - t3;
-			a3 = t0 - t2;
-		}
-
-		int b0, b1, b2, b3;
-		{
-			const int d0 = rblock[4];
-			const int d1 = rblock[5];
-			const int d2 = rblock[6];
-			const int d3 = rblock[7];
-			int t0, t1, t2, t3;
-			BUTTERFLY(t0, t1, W7, W1, d3, d0);
-			BUTTERFLY(t2, t3, W3, W5, d1, d2);
-			b0 = t0 + t2;
-			b3 = t1 + t3;
-			t0 -= t2;
-			t1 -= t3;
-			b1 = ((t0 + t1) * 181) >> 8;
-			b2 = ((t0 - t1) * 181) >> 8;
-		}
-
-		rblock[0] = (a0 + b0) >> 8;
-		rblock[1] = (a1 + b1) >> 8;
-		rblock[2] = (a2 + b2) >> 8;
-		rblock[3] = (a3 + b3) >> 8;
-		rblock[4] = (a3 - b3) >> 8;
-		rblock[5] = (a2 - b2) >> 8;
-		rblock[6] = (a1 - b1) >> 8;
-		rblock[7] = (a0 - b0) >> 8;
-	}
-
-	for (int i = 0; i < 8; ++i)
-	{
-		s16* const cblock = block + i;
-
-		int a0, a1, a2, a3;
-		{
-			const int d0 = (cblock[8 * 0] << 11) + 65536;
-			const int d1 = cblock[8 * 1];
-			const int d2 = cblock[8 * 2] << 11;
-			const int d3 = cblock[8 * 3];
-			const int t0 = d0 + d2;
-			const int t1 = d0 - d2;
-			int t2;
-			int t3;
-			BUTTERFLY(t2, t3, W6, W2, d3, d1);
-			a0 = t0 + t2;
-			a1 = t1 + t3;
-			a2 = t1 - t3;
-			a3 = t0 - t2;
-		}
-
-		int b0, b1, b2, b3;
-		{
-			const int d0 = cblock[8 * 4];
-			const int d1 = cblock[8 * 5];
-			const int d2 = cblock[8 * 6];
-			const int d3 = cblock[8 * 7];
-			int t0, t1, t2, t3;
-			BUTTERFLY(t0, t1, W7, W1, d3, d0);
-			BUTTERFLY(t2, t3, W3, W5, d1, d2);
-			b0 = t0 + t2;
-			b3 = t1 + t3;
-			t0 = (t0 - t2) >> 8;
-			t1 = (t1 - t3) >> 8;
-			b1 = (t0 + t1) * 181;
-			b2 = (t0 - t1) * 181;
-		}
-
-		cblock[8 * 0] = (a0 + b0) >> 17;
-		cblock[8 * 1] = (a1 + b1) >> 17;
-		cblock[8 * 2] = (a2 + b2) >> 17;
-		cblock[8 * 3] = (a3 + b3) >> 17;
-		cblock[8 * 4] = (a3 - b3) >> 17;
-		cblock[8 * 5] = (a2 - b2) >> 17;
-		cblock[8 * 6] = (a1 - b1) >> 17;
-		cblock[8 * 7] = (a0 - b0) >> 17;
-	}
-}
-
-__ri void mpeg2_idct_copy(s16* block, u8* dest, const int stride)
-{
-	mpeg2_idct(block);
-
-	for (int i = 0; i < 8; ++i)
-	{
-		dest[0] = (clip_lut.data() + 384)[block[0]];
-		dest[1] = (clip_lut.data() + 384)[block[1]];
-		dest[2] = (clip_lut.data() + 384)[block[2]];
-		dest[3] = (clip_lut.data() + 384)[block[3]];
-		dest[4] = (clip_lut.data() + 384)[block[4]];
-		dest[5] = (clip_lut.data() + 384)[block[5]];
-		dest[6] = (clip_lut.data() + 384)[block[6]];
-		dest[7] = (clip_lut.data() + 384)[block[7]];
-
-		std::memset(block, 0, 16);
-
-		dest += stride;
-		block += 8;
-	}
-}
-
-
-// stride = increment for dest in 16-bit units (typically either 8 [128 bits] or 16 [256 bits]).
-__ri void mpeg2_idct_add(const int last, s16* block, s16* dest, const int stride)
-{
-	// on the IPU, stride is always assured to be multiples of QWC (bottom 3 bits are 0).
-
-	if (last != 129 || (block[0] & 7) == 4)
-	{
-		mpeg2_idct(block);
-
-#if defined(_M_X86_32) || defined(_M_X86_64)
-		__m128 zero = _mm_setzero_ps();
-#elif defined(_M_ARM64)
-		int16x8_t zero = vdupq_n_s16(0);
-#endif
-		for (int i = 0; i < 8; ++i)
-		{
-#if defined(_M_X86_32) || defined(_M_X86_64)
-			_mm_store_ps((float*)dest, _mm_load_ps((float*)block));
-			_mm_store_ps((float*)block, zero);
-#elif defined(_M_ARM64)
-			vst1q_s16(dest, vld1q_s16(block));
-			vst1q_s16(block, zero);
-#else
-			std::memcpy(dest, block, 16);
-			std::memset(block, 0, 16);
-#endif
-
-			dest += stride;
-			block += 8;
-		}
-	}
-	else
-	{
-		s16 DC = ((int)block[0] + 4) >> 3;
-		s16 dcf[2] = {DC, DC};
-		block[0] = block[63] = 0;
-
-#if defined(_M_X86_32) || defined(_M_X86_64)
-		__m128 dc128 = _mm_set_ps1(*(float*)dcf);
-
-		for (int i = 0; i < 8; ++i)
-			_mm_store_ps((float*)(dest + (stride * i)), dc128);
-#elif defined(_M_ARM64)
-		float32x4_t dc128 = vld1q_dup_f32((float*)dcf);
-
-		for (int i = 0; i < 8; ++i)
-			vst1q_f32((float*)(dest + (stride * i)), dc128);
-#endif
-	}
-}
-
-
-void ipu_dither_reference(const macroblock_rgb32& rgb32, macroblock_rgb16& rgb16, int dte);
-
-#if defined(_M_X86_32) || defined(_M_X86_64)
-void ipu_dither_sse2(const macroblock_rgb32& rgb32, macroblock_rgb16& rgb16, int dte);
-#endif
-
-__ri void ipu_dither(const macroblock_rgb32& rgb32, macroblock_rgb16& rgb16, int dte)
-{
-#if defined(_M_X86_32) || defined(_M_X86_64)
-	ipu_dither_sse2(rgb32, rgb16, dte);
-#else
-	ipu_dither_reference(rgb32, rgb16, dte);
-#endif
-}
-
-__ri void ipu_dither_reference(const macroblock_rgb32& rgb32, macroblock_rgb16& rgb16, int dte)
-{
-	if (dte) {
-		// I'm guessing values are rounded down when clamping.
-		const int dither_coefficient[4][4] = {
-				{-4, 0, -3, 1},
-				{2, -2, 3, -1},
-				{-3, 1, -4, 0},
-				{3, -1, 2, -2},
-		};
-		for (int i = 0; i < 16; ++i) {
-			for (int j = 0; j < 16; ++j) {
-				const int dither = dither_coefficient[i & 3][j & 3];
-				const int r = std::max(0, std::min(rgb32.c[i][j].r + dither, 255));
-				const int g = std::max(0, std::min(rgb32.c[i][j].g + dither, 255));
-				const int b = std::max(0, std::min(rgb32.c[i][j].b + dither, 255));
-
-				rgb16.c[i][j].r = r >> 3;
-				rgb16.c[i][j].g = g >> 3;
-				rgb16.c[i][j].b = b >> 3;
-				rgb16.c[i][j].a = rgb32.c[i][j].a == 0x40;
-			}
-		}
-	}
-	else {
-		for (int i = 0; i < 16; ++i) {
-			for (int j = 0; j < 16; ++j) {
-				rgb16.c[i][j].r = rgb32.c[i][j].r >> 3;
-				rgb16.c[i][j].g = rgb32.c[i][j].g >> 3;
-				rgb16.c[i][j].b = rgb32.c[i][j].b >> 3;
-				rgb16.c[i][j].a = rgb32.c[i][j].a == 0x40;
-			}
-		}
-	}
-}
-
-#if defined(_M_X86_32) || defined(_M_X86_64)
-
-__ri void ipu_dither_sse2(const macroblock_rgb32& rgb32, macroblock_rgb16& rgb16, int dte)
-{
-	const __m128i alpha_test = _mm_set1_epi16(0x40);
-	const __m128i dither_add_matrix[] = {
-			_mm_setr_epi32(0x00000000, 0x00000000, 0x00000000, 0x00010101),
-			_mm_setr_epi32(0x00020202, 0x00000000, 0x00030303, 0x00000000),
-			_mm_setr_epi32(0x00000000, 0x00010101, 0x00000000, 0x00000000),
-			_mm_setr_epi32(0x00030303, 0x00000000, 0x00020202, 0x00000000),
-	};
-	const __m128i dither_sub_matrix[] = {
-			_mm_setr_epi32(0x00040404, 0x00000000, 0x00030303, 0x00000000),
-			_mm_setr_epi32(0x00000000, 0x00020202, 0x00000000, 0x00010101),
-			_mm_setr_epi32(0x00030303, 0x00000000, 0x00040404, 0x00000000),
-			_mm_setr_epi32(0x00000000, 0x00010101, 0x00000000, 0x00020202),
-	};
-	for (int i = 0; i < 16; ++i) {
-		const __m128i dither_add = dither_add_matrix[i & 3];
-		const __m128i dither_sub = dither_sub_matrix[i & 3];
-		for (int n = 0; n < 2; ++n) {
-			__m128i rgba_8_0123 = _mm_load_si128(reinterpret_cast<const __m128i*>(&rgb32.c[i][n * 8]));
-			__m128i rgba_8_4567 = _mm_load_si128(reinterpret_cast<const __m128i*>(&rgb32.c[i][n * 8 + 4]));
-
-			// Dither and clamp
-			if (dte) {
-				rgba_8_0123 = _mm_adds_epu8(rgba_8_0123, dither_add);
-				rgba_8_0123 = _mm_subs_epu8(rgba_8_0123, dither_sub);
-				rgba_8_4567 = _mm_adds_epu8(rgba_8_4567, dither_add);
-				rgba_8_4567 = _mm_subs_epu8(rgba_8_4567, dither_sub);
-			}
-
-			// Split into channel components and extend to 16 bits
-			const __m128i rgba_16_0415 = _mm_unpacklo_epi8(rgba_8_0123, rgba_8_4567);
-			const __m128i rgba_16_2637 = _mm_unpackhi_epi8(rgba_8_0123, rgba_8_4567);
-			const __m128i rgba_32_0246 = _mm_unpacklo_epi8(rgba_16_0415, rgba_16_2637);
-			const __m128i rgba_32_1357 = _mm_unpackhi_epi8(rgba_16_0415, rgba_16_2637);
-			const __m128i rg_64_01234567 = _mm_unpacklo_epi8(rgba_32_0246, rgba_32_1357);
-			const __m128i ba_64_01234567 = _mm_unpackhi_epi8(rgba_32_0246, rgba_32_1357);
-
-			const __m128i zero = _mm_setzero_si128();
-			__m128i r = _mm_unpacklo_epi8(rg_64_01234567, zero);
-			__m128i g = _mm_unpackhi_epi8(rg_64_01234567, zero);
-			__m128i b = _mm_unpacklo_epi8(ba_64_01234567, zero);
-			__m128i a = _mm_unpackhi_epi8(ba_64_01234567, zero);
-
-			// Create RGBA
-			r = _mm_srli_epi16(r, 3);
-			g = _mm_slli_epi16(_mm_srli_epi16(g, 3), 5);
-			b = _mm_slli_epi16(_mm_srli_epi16(b, 3), 10);
-			a = _mm_slli_epi16(_mm_cmpeq_epi16(a, alpha_test), 15);
-
-			const __m128i rgba16 = _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
-
-			_mm_store_si128(reinterpret_cast<__m128i*>(&rgb16.c[i][n * 8]), rgba16);
-		}
-	}
-}
-
-#endif
-
-
 // The IPU's colour space conversion conforms to ITU-R Recommendation BT.601 if anyone wants to make a
 // faster or "more accurate" implementation, but this is the precise documented integer method used by
 // the hardware and is fast enough with SSE2.
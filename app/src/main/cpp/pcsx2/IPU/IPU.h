@@ -295,3 +295,21 @@ extern bool ipuWrite64(u32 mem,u64 value);
 extern void IPUCMD_WRITE(u32 val);
 extern void ipuSoftReset();
 extern void IPUProcessInterrupt();
+
+// Threaded IPU: the decoder runs on its own thread between two EE accesses to IPU state.
+// Any EE code that touches IPU registers, FIFOs or decoder state has to call ipuThreadSync()
+// first, which waits for the thread and applies the EE side effects it deferred.
+extern void ipuThreadSync();
+// Syncs and joins the thread, the next kick with the speedhack enabled starts it again.
+// Called on VM shutdown and when the speedhack is turned off.
+extern void ipuThreadShutdown();
+
+// EE state used by the decoder, these redirect to a snapshot taken when the thread was kicked
+// and queue the side effects up when called from the IPU thread.
+extern bool ipuToIpuDmaWaiting();   // DMAC_TO_IPU is waiting for the input FIFO to drain
+extern bool ipuToIpuDmaActive();    // ipu1ch.chcr.STR
+extern bool ipuFromIpuDmaActive();  // ipu0ch.chcr.STR
+extern u32 ipuEECycle();            // cpuRegs.cycle
+extern void ipuRaiseInterrupt();    // hwIntcIrq(INTC_IPU)
+extern void ipuScheduleToIpu(s32 cycles);   // CPU_INT(DMAC_TO_IPU)
+extern void ipuScheduleFromIpu(s32 cycles); // IPU_INT_FROM
@@ -0,0 +1,558 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "IPU_Kernels.h"
+#include "GS/GSVector.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#define W1 2841 /* 2048*sqrt (2)*cos (1*pi/16) */
+#define W2 2676 /* 2048*sqrt (2)*cos (2*pi/16) */
+#define W3 2408 /* 2048*sqrt (2)*cos (3*pi/16) */
+#define W5 1609 /* 2048*sqrt (2)*cos (5*pi/16) */
+#define W6 1108 /* 2048*sqrt (2)*cos (6*pi/16) */
+#define W7 565 /* 2048*sqrt (2)*cos (7*pi/16) */
+
+// --------------------------------------------------------------------------------------
+//  Reference implementations (conforming, do not optimise)
+// --------------------------------------------------------------------------------------
+
+/*
+ * In legal streams, the IDCT output should be between -384 and +384.
+ * In corrupted streams, it is possible to force the IDCT output to go
+ * to +-3826 - this is the worst case for a column IDCT where the
+ * column inputs are 16-bit values.
+ */
+static constexpr std::array<u8, 1024> ComputeClipLUT()
+{
+	std::array<u8, 1024> ret = {};
+	for (int i = -384; i < 640; ++i)
+		ret[i + 384] = (i < 0) ? 0 : ((i > 255) ? 255 : i);
+	return ret;
+}
+static constexpr __aligned16 std::array<u8, 1024> clip_lut = ComputeClipLUT();
+
+static __fi void BUTTERFLY(int& t0, int& t1, int w0, int w1, int d0, int d1)
+{
+#if 0
+    t0 = w0*d0 + w1*d1;
+    t1 = w0*d1 - w1*d0;
+#else
+	int tmp = w0 * (d0 + d1);
+	t0 = tmp + (w1 - w0) * d1;
+	t1 = tmp - (w1 + w0) * d0;
+#endif
+}
+
+void mpeg2_idct_reference(s16* block)
+{
+	for (int i = 0; i < 8; ++i)
+	{
+		s16* const rblock = block + 8 * i;
+		if (!(rblock[1] | ((s32*)rblock)[1] | ((s32*)rblock)[2] |
+				((s32*)rblock)[3]))
+		{
+			u32 tmp = (u16)(rblock[0] << 3);
+			tmp |= tmp << 16;
+			((s32*)rblock)[0] = tmp;
+			((s32*)rblock)[1] = tmp;
+			((s32*)rblock)[2] = tmp;
+			((s32*)rblock)[3] = tmp;
+			continue;
+		}
+
+		int a0, a1, a2, a3;
+		{
+			const int d0 = (rblock[0] << 11) + 128;
+			const int d1 = rblock[1];
+			const int d2 = rblock[2] << 11;
+			const int d3 = rblock[3];
+			int t0 = d0 + d2;
+			int t1 = d0 - d2;
+			int t2, t3;
+			BUTTERFLY(t2, t3, W6, W2, d3, d1);
+			a0 = t0 + t2;
+			a1 = t1 + t3;
+			a2 = t1 - t3;
+			a3 = t0 - t2;
+		}
+
+		int b0, b1, b2, b3;
+		{
+			const int d0 = rblock[4];
+			const int d1 = rblock[5];
+			const int d2 = rblock[6];
+			const int d3 = rblock[7];
+			int t0, t1, t2, t3;
+			BUTTERFLY(t0, t1, W7, W1, d3, d0);
+			BUTTERFLY(t2, t3, W3, W5, d1, d2);
+			b0 = t0 + t2;
+			b3 = t1 + t3;
+			t0 -= t2;
+			t1 -= t3;
+			b1 = ((t0 + t1) * 181) >> 8;
+			b2 = ((t0 - t1) * 181) >> 8;
+		}
+
+		rblock[0] = (a0 + b0) >> 8;
+		rblock[1] = (a1 + b1) >> 8;
+		rblock[2] = (a2 + b2) >> 8;
+		rblock[3] = (a3 + b3) >> 8;
+		rblock[4] = (a3 - b3) >> 8;
+		rblock[5] = (a2 - b2) >> 8;
+		rblock[6] = (a1 - b1) >> 8;
+		rblock[7] = (a0 - b0) >> 8;
+	}
+
+	for (int i = 0; i < 8; ++i)
+	{
+		s16* const cblock = block + i;
+
+		int a0, a1, a2, a3;
+		{
+			const int d0 = (cblock[8 * 0] << 11) + 65536;
+			const int d1 = cblock[8 * 1];
+			const int d2 = cblock[8 * 2] << 11;
+			const int d3 = cblock[8 * 3];
+			const int t0 = d0 + d2;
+			const int t1 = d0 - d2;
+			int t2;
+			int t3;
+			BUTTERFLY(t2, t3, W6, W2, d3, d1);
+			a0 = t0 + t2;
+			a1 = t1 + t3;
+			a2 = t1 - t3;
+			a3 = t0 - t2;
+		}
+
+		int b0, b1, b2, b3;
+		{
+			const int d0 = cblock[8 * 4];
+			const int d1 = cblock[8 * 5];
+			const int d2 = cblock[8 * 6];
+			const int d3 = cblock[8 * 7];
+			int t0, t1, t2, t3;
+			BUTTERFLY(t0, t1, W7, W1, d3, d0);
+			BUTTERFLY(t2, t3, W3, W5, d1, d2);
+			b0 = t0 + t2;
+			b3 = t1 + t3;
+			t0 = (t0 - t2) >> 8;
+			t1 = (t1 - t3) >> 8;
+			b1 = (t0 + t1) * 181;
+			b2 = (t0 - t1) * 181;
+		}
+
+		cblock[8 * 0] = (a0 + b0) >> 17;
+		cblock[8 * 1] = (a1 + b1) >> 17;
+		cblock[8 * 2] = (a2 + b2) >> 17;
+		cblock[8 * 3] = (a3 + b3) >> 17;
+		cblock[8 * 4] = (a3 - b3) >> 17;
+		cblock[8 * 5] = (a2 - b2) >> 17;
+		cblock[8 * 6] = (a1 - b1) >> 17;
+		cblock[8 * 7] = (a0 - b0) >> 17;
+	}
+}
+
+void mpeg2_idct_copy_reference(s16* block, u8* dest, const int stride)
+{
+	mpeg2_idct_reference(block);
+
+	for (int i = 0; i < 8; ++i)
+	{
+		for (int j = 0; j < 8; ++j)
+			dest[j] = (clip_lut.data() + 384)[block[j]];
+
+		std::memset(block, 0, 16);
+
+		dest += stride;
+		block += 8;
+	}
+}
+
+void mpeg2_idct_add_reference(const int last, s16* block, s16* dest, const int stride)
+{
+	if (last != 129 || (block[0] & 7) == 4)
+	{
+		mpeg2_idct_reference(block);
+
+		for (int i = 0; i < 8; ++i)
+		{
+			std::memcpy(dest, block, 16);
+			std::memset(block, 0, 16);
+
+			dest += stride;
+			block += 8;
+		}
+	}
+	else
+	{
+		const s16 DC = ((int)block[0] + 4) >> 3;
+		block[0] = block[63] = 0;
+
+		for (int i = 0; i < 8; ++i)
+			std::fill_n(dest + (stride * i), 8, DC);
+	}
+}
+
+void ipu_dither_reference(const macroblock_rgb32& rgb32, macroblock_rgb16& rgb16, int dte)
+{
+	if (dte) {
+		// I'm guessing values are rounded down when clamping.
+		const int dither_coefficient[4][4] = {
+				{-4, 0, -3, 1},
+				{2, -2, 3, -1},
+				{-3, 1, -4, 0},
+				{3, -1, 2, -2},
+		};
+		for (int i = 0; i < 16; ++i) {
+			for (int j = 0; j < 16; ++j) {
+				const int dither = dither_coefficient[i & 3][j & 3];
+				const int r = std::max(0, std::min(rgb32.c[i][j].r + dither, 255));
+				const int g = std::max(0, std::min(rgb32.c[i][j].g + dither, 255));
+				const int b = std::max(0, std::min(rgb32.c[i][j].b + dither, 255));
+
+				rgb16.c[i][j].r = r >> 3;
+				rgb16.c[i][j].g = g >> 3;
+				rgb16.c[i][j].b = b >> 3;
+				rgb16.c[i][j].a = rgb32.c[i][j].a == 0x40;
+			}
+		}
+	}
+	else {
+		for (int i = 0; i < 16; ++i) {
+			for (int j = 0; j < 16; ++j) {
+				rgb16.c[i][j].r = rgb32.c[i][j].r >> 3;
+				rgb16.c[i][j].g = rgb32.c[i][j].g >> 3;
+				rgb16.c[i][j].b = rgb32.c[i][j].b >> 3;
+				rgb16.c[i][j].a = rgb32.c[i][j].a == 0x40;
+			}
+		}
+	}
+}
+
+void ipu_vq_reference(const macroblock_rgb16& rgb16, const rgb16_t* clut, u8* indx4)
+{
+	const auto closest_index = [&](int i, int j) {
+		u8 index = 0;
+		int min_distance = std::numeric_limits<int>::max();
+		for (u8 k = 0; k < 16; ++k)
+		{
+			const int dr = rgb16.c[i][j].r - clut[k].r;
+			const int dg = rgb16.c[i][j].g - clut[k].g;
+			const int db = rgb16.c[i][j].b - clut[k].b;
+			const int distance = dr * dr + dg * dg + db * db;
+
+			// XXX: If two distances are the same which index is used?
+			if (min_distance > distance)
+			{
+				index = k;
+				min_distance = distance;
+			}
+		}
+
+		return index;
+	};
+
+	for (int i = 0; i < 16; ++i)
+		for (int j = 0; j < 8; ++j)
+			indx4[i * 8 + j] = closest_index(i, 2 * j + 1) << 4 | closest_index(i, 2 * j);
+}
+
+// --------------------------------------------------------------------------------------
+//  Vectorised implementations
+// --------------------------------------------------------------------------------------
+
+// Two 16-bit multipliers for madd(), lo applies to the first element of each interleaved pair.
+static __fi GSVector4i idct_pair(int lo, int hi)
+{
+	return GSVector4i(static_cast<int>((static_cast<u32>(lo) & 0xffff) | (static_cast<u32>(hi) << 16)));
+}
+
+// The scalar code stores intermediates through s16, so wrap instead of saturating before packing
+static __fi GSVector4i idct_pack(const GSVector4i& lo, const GSVector4i& hi)
+{
+	return lo.sll32(16).sra32(16).ps32(hi.sll32(16).sra32(16));
+}
+
+static __fi void idct_transpose(GSVector4i (&v)[8])
+{
+	const GSVector4i t0 = v[0].upl16(v[1]);
+	const GSVector4i t1 = v[0].uph16(v[1]);
+	const GSVector4i t2 = v[2].upl16(v[3]);
+	const GSVector4i t3 = v[2].uph16(v[3]);
+	const GSVector4i t4 = v[4].upl16(v[5]);
+	const GSVector4i t5 = v[4].uph16(v[5]);
+	const GSVector4i t6 = v[6].upl16(v[7]);
+	const GSVector4i t7 = v[6].uph16(v[7]);
+
+	const GSVector4i u0 = t0.upl32(t2);
+	const GSVector4i u1 = t0.uph32(t2);
+	const GSVector4i u2 = t1.upl32(t3);
+	const GSVector4i u3 = t1.uph32(t3);
+	const GSVector4i u4 = t4.upl32(t6);
+	const GSVector4i u5 = t4.uph32(t6);
+	const GSVector4i u6 = t5.upl32(t7);
+	const GSVector4i u7 = t5.uph32(t7);
+
+	v[0] = u0.upl64(u4);
+	v[1] = u0.uph64(u4);
+	v[2] = u1.upl64(u5);
+	v[3] = u1.uph64(u5);
+	v[4] = u2.upl64(u6);
+	v[5] = u2.uph64(u6);
+	v[6] = u3.upl64(u7);
+	v[7] = u3.uph64(u7);
+}
+
+// One 1-D pass over eight independent lanes, v[n] holding coefficient n of each lane.
+// BUTTERFLY() becomes a pair of madds on interleaved inputs, which is the same integer
+// maths as the #if 0 form above.  The row pass skips all-zero AC rows, but the full
+// formula gives the same result for those so there's no need to special case them.
+template <bool column>
+static __fi void idct_pass(GSVector4i (&v)[8])
+{
+	const GSVector4i bias(column ? 65536 : 128);
+	const GSVector4i w_even_sum = idct_pair(2048, 2048);
+	const GSVector4i w_even_diff = idct_pair(2048, -2048);
+	const GSVector4i w_62 = idct_pair(W6, W2);
+	const GSVector4i w_26 = idct_pair(-W2, W6);
+	const GSVector4i w_71 = idct_pair(W7, W1);
+	const GSVector4i w_17 = idct_pair(-W1, W7);
+	const GSVector4i w_35 = idct_pair(W3, W5);
+	const GSVector4i w_53 = idct_pair(-W5, W3);
+	const GSVector4i w_181(181);
+	constexpr int shift = column ? 17 : 8;
+
+	GSVector4i out[2][8];
+	for (int half = 0; half < 2; ++half)
+	{
+		const auto pair = [&](int a, int b) { return half ? v[a].uph16(v[b]) : v[a].upl16(v[b]); };
+		const GSVector4i p02 = pair(0, 2);
+		const GSVector4i p31 = pair(3, 1);
+		const GSVector4i p74 = pair(7, 4);
+		const GSVector4i p56 = pair(5, 6);
+
+		GSVector4i t0 = p02.madd(w_even_sum).add32(bias);
+		GSVector4i t1 = p02.madd(w_even_diff).add32(bias);
+		GSVector4i t2 = p31.madd(w_62);
+		GSVector4i t3 = p31.madd(w_26);
+		const GSVector4i a0 = t0.add32(t2);
+		const GSVector4i a1 = t1.add32(t3);
+		const GSVector4i a2 = t1.sub32(t3);
+		const GSVector4i a3 = t0.sub32(t2);
+
+		t0 = p74.madd(w_71);
+		t1 = p74.madd(w_17);
+		t2 = p56.madd(w_35);
+		t3 = p56.madd(w_53);
+		const GSVector4i b0 = t0.add32(t2);
+		const GSVector4i b3 = t1.add32(t3);
+		t0 = t0.sub32(t2);
+		t1 = t1.sub32(t3);
+		GSVector4i b1, b2;
+		if (column)
+		{
+			t0 = t0.sra32(8);
+			t1 = t1.sra32(8);
+			b1 = t0.add32(t1).mul32l(w_181);
+			b2 = t0.sub32(t1).mul32l(w_181);
+		}
+		else
+		{
+			b1 = t0.add32(t1).mul32l(w_181).sra32(8);
+			b2 = t0.sub32(t1).mul32l(w_181).sra32(8);
+		}
+
+		out[half][0] = a0.add32(b0).sra32(shift);
+		out[half][1] = a1.add32(b1).sra32(shift);
+		out[half][2] = a2.add32(b2).sra32(shift);
+		out[half][3] = a3.add32(b3).sra32(shift);
+		out[half][4] = a3.sub32(b3).sra32(shift);
+		out[half][5] = a2.sub32(b2).sra32(shift);
+		out[half][6] = a1.sub32(b1).sra32(shift);
+		out[half][7] = a0.sub32(b0).sra32(shift);
+	}
+
+	for (int i = 0; i < 8; ++i)
+		v[i] = idct_pack(out[0][i], out[1][i]);
+}
+
+// Leaves row i of the transformed block in v[i]
+static __fi void idct_rows(const s16* block, GSVector4i (&v)[8])
+{
+	for (int i = 0; i < 8; ++i)
+		v[i] = GSVector4i::load<true>(block + 8 * i);
+
+	// rows are done lane-parallel on the transposed block, the columns then fall out naturally
+	idct_transpose(v);
+	idct_pass<false>(v);
+	idct_transpose(v);
+	idct_pass<true>(v);
+}
+
+void mpeg2_idct(s16* block)
+{
+	GSVector4i v[8];
+	idct_rows(block, v);
+
+	for (int i = 0; i < 8; ++i)
+		GSVector4i::store<true>(block + 8 * i, v[i]);
+}
+
+void mpeg2_idct_copy(s16* block, u8* dest, const int stride)
+{
+	GSVector4i v[8];
+	idct_rows(block, v);
+
+	const GSVector4i zero = GSVector4i::zero();
+	for (int i = 0; i < 8; ++i)
+	{
+		// Saturating pack matches clip_lut over its whole range
+		GSVector4i::storel(dest, v[i].pu16());
+		GSVector4i::store<true>(block, zero);
+
+		dest += stride;
+		block += 8;
+	}
+}
+
+void mpeg2_idct_add(const int last, s16* block, s16* dest, const int stride)
+{
+	// on the IPU, stride is always assured to be multiples of QWC (bottom 3 bits are 0).
+
+	if (last != 129 || (block[0] & 7) == 4)
+	{
+		GSVector4i v[8];
+		idct_rows(block, v);
+
+		const GSVector4i zero = GSVector4i::zero();
+		for (int i = 0; i < 8; ++i)
+		{
+			GSVector4i::store<true>(dest, v[i]);
+			GSVector4i::store<true>(block, zero);
+
+			dest += stride;
+			block += 8;
+		}
+	}
+	else
+	{
+		const s16 DC = ((int)block[0] + 4) >> 3;
+		block[0] = block[63] = 0;
+
+		const GSVector4i dc128(static_cast<int>((static_cast<u32>(static_cast<u16>(DC)) * 0x10001)));
+		for (int i = 0; i < 8; ++i)
+			GSVector4i::store<true>(dest + (stride * i), dc128);
+	}
+}
+
+void ipu_dither(const macroblock_rgb32& rgb32, macroblock_rgb16& rgb16, int dte)
+{
+	const GSVector4i alpha_test = GSVector4i(0x00400040);
+	const GSVector4i dither_add_matrix[] = {
+			GSVector4i(0x00000000, 0x00000000, 0x00000000, 0x00010101),
+			GSVector4i(0x00020202, 0x00000000, 0x00030303, 0x00000000),
+			GSVector4i(0x00000000, 0x00010101, 0x00000000, 0x00000000),
+			GSVector4i(0x00030303, 0x00000000, 0x00020202, 0x00000000),
+	};
+	const GSVector4i dither_sub_matrix[] = {
+			GSVector4i(0x00040404, 0x00000000, 0x00030303, 0x00000000),
+			GSVector4i(0x00000000, 0x00020202, 0x00000000, 0x00010101),
+			GSVector4i(0x00030303, 0x00000000, 0x00040404, 0x00000000),
+			GSVector4i(0x00000000, 0x00010101, 0x00000000, 0x00020202),
+	};
+	const GSVector4i zero = GSVector4i::zero();
+	for (int i = 0; i < 16; ++i) {
+		const GSVector4i dither_add = dither_add_matrix[i & 3];
+		const GSVector4i dither_sub = dither_sub_matrix[i & 3];
+		for (int n = 0; n < 2; ++n) {
+			GSVector4i rgba_8_0123 = GSVector4i::load<true>(&rgb32.c[i][n * 8]);
+			GSVector4i rgba_8_4567 = GSVector4i::load<true>(&rgb32.c[i][n * 8 + 4]);
+
+			// Dither and clamp
+			if (dte) {
+				rgba_8_0123 = rgba_8_0123.addus8(dither_add).subus8(dither_sub);
+				rgba_8_4567 = rgba_8_4567.addus8(dither_add).subus8(dither_sub);
+			}
+
+			// Split into channel components and extend to 16 bits
+			const GSVector4i rgba_16_0415 = rgba_8_0123.upl8(rgba_8_4567);
+			const GSVector4i rgba_16_2637 = rgba_8_0123.uph8(rgba_8_4567);
+			const GSVector4i rgba_32_0246 = rgba_16_0415.upl8(rgba_16_2637);
+			const GSVector4i rgba_32_1357 = rgba_16_0415.uph8(rgba_16_2637);
+			const GSVector4i rg_64_01234567 = rgba_32_0246.upl8(rgba_32_1357);
+			const GSVector4i ba_64_01234567 = rgba_32_0246.uph8(rgba_32_1357);
+
+			const GSVector4i r = rg_64_01234567.upl8(zero).srl16(3);
+			const GSVector4i g = rg_64_01234567.uph8(zero).srl16(3).sll16(5);
+			const GSVector4i b = ba_64_01234567.upl8(zero).srl16(3).sll16(10);
+			const GSVector4i a = ba_64_01234567.uph8(zero).eq16(alpha_test).sll16(15);
+
+			GSVector4i::store<true>(&rgb16.c[i][n * 8], r | g | b | a);
+		}
+	}
+}
+
+void ipu_vq(const macroblock_rgb16& rgb16, const rgb16_t* clut, u8* indx4)
+{
+	// Eight pixels per vector against one clut entry at a time.  Distances are at most
+	// 3 * 31 * 31, so everything fits in 16-bit lanes, and the strict compare keeps the
+	// lowest index on ties, like the reference.
+	GSVector4i clut_r[16], clut_g[16], clut_b[16], clut_index[16];
+	for (int k = 0; k < 16; ++k)
+	{
+		clut_r[k] = GSVector4i(static_cast<int>(clut[k].r * 0x10001u));
+		clut_g[k] = GSVector4i(static_cast<int>(clut[k].g * 0x10001u));
+		clut_b[k] = GSVector4i(static_cast<int>(clut[k].b * 0x10001u));
+		clut_index[k] = GSVector4i(static_cast<int>(k * 0x10001u));
+	}
+
+	const GSVector4i mask = GSVector4i(0x001f001f);
+	const GSVector4i max_distance = GSVector4i(0x7fff7fff);
+	for (int i = 0; i < 16; ++i)
+	{
+		GSVector4i index[2];
+		for (int n = 0; n < 2; ++n)
+		{
+			const GSVector4i pixels = GSVector4i::load<true>(&rgb16.c[i][n * 8]);
+			const GSVector4i r = pixels & mask;
+			const GSVector4i g = pixels.srl16(5) & mask;
+			const GSVector4i b = pixels.srl16(10) & mask;
+
+			GSVector4i min_distance = max_distance;
+			GSVector4i min_index = GSVector4i::zero();
+			for (int k = 0; k < 16; ++k)
+			{
+				const GSVector4i dr = r.sub16(clut_r[k]);
+				const GSVector4i dg = g.sub16(clut_g[k]);
+				const GSVector4i db = b.sub16(clut_b[k]);
+				const GSVector4i distance = dr.mul16l(dr).add16(dg.mul16l(dg)).add16(db.mul16l(db));
+				const GSVector4i closer = distance.lt16(min_distance);
+
+				min_distance = min_distance.blend8(distance, closer);
+				min_index = min_index.blend8(clut_index[k], closer);
+			}
+			index[n] = min_index;
+		}
+
+		// indices are 0-15, pack to bytes then merge each even/odd pair into a nibble pair
+		const GSVector4i bytes = index[0].pu16(index[1]);
+		const GSVector4i nibbles = (bytes & GSVector4i(0x000f000f)) | (bytes.srl16(4) & GSVector4i(0x00f000f0));
+		GSVector4i::storel(&indx4[i * 8], nibbles.pu16());
+	}
+}
@@ -0,0 +1,58 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Stateless per-block/per-macroblock kernels of the IPU decoder.  They're kept apart from IPU.cpp
+// so the vectorised versions can be checked against the reference ones (tests/ctest/IPU).
+// Every kernel must give bit-identical results to its _reference version.
+
+struct macroblock_rgb32
+{
+	struct
+	{
+		u8 r, g, b, a;
+	} c[16][16];
+};
+
+struct rgb16_t
+{
+	u16 r : 5, g : 5, b : 5, a : 1;
+};
+
+struct macroblock_rgb16
+{
+	rgb16_t c[16][16];
+};
+
+// In-place 8x8 inverse DCT, block must be 16 byte aligned.
+extern void mpeg2_idct(s16* block);
+extern void mpeg2_idct_reference(s16* block);
+
+// IDCT, then clamp into dest (intra blocks).  Clears block.
+extern void mpeg2_idct_copy(s16* block, u8* dest, int stride);
+extern void mpeg2_idct_copy_reference(s16* block, u8* dest, int stride);
+
+// IDCT into a 16-bit destination (non-intra blocks).  Clears block.
+// stride = increment for dest in 16-bit units (typically either 8 [128 bits] or 16 [256 bits]).
+extern void mpeg2_idct_add(int last, s16* block, s16* dest, int stride);
+extern void mpeg2_idct_add_reference(int last, s16* block, s16* dest, int stride);
+
+extern void ipu_dither(const macroblock_rgb32& rgb32, macroblock_rgb16& rgb16, int dte);
+extern void ipu_dither_reference(const macroblock_rgb32& rgb32, macroblock_rgb16& rgb16, int dte);
+
+// Maps every pixel to the closest of the 16 clut colours, two 4-bit indices per byte.
+extern void ipu_vq(const macroblock_rgb16& rgb16, const rgb16_t* clut, u8* indx4);
+extern void ipu_vq_reference(const macroblock_rgb16& rgb16, const rgb16_t* clut, u8* indx4);
@@ -104,6 +104,7 @@ static __fi int IPU1chain() {
 
 int IPU1dma()
 {
+	ipuThreadSync();
 	int ipu1cycles = 0;
 	int totalqwc = 0;
 
@@ -198,6 +199,7 @@ int IPU1dma()
 
 void IPU0dma()
 {
+	ipuThreadSync();
 	if(!ipuRegs.ctrl.OFC) 
 	{
 		IPUProcessInterrupt();
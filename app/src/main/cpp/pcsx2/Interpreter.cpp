@@ -24,7 +24,7 @@
 
 #include "Elfheader.h"
 
-//#include "DebugTools/Breakpoints.h"
+#include "DebugTools/Breakpoints.h"
 
 #include <float.h>
 
@@ -35,6 +35,7 @@ extern int vu0branch, vu1branch;
 static int branch2 = 0;
 static u32 cpuBlockCycles = 0;		// 3 bit fixed point version of cycle count
 static std::string disOut;
+static bool s_memchecks_enabled = false;	// latched on reset, CBreakPoints::Update() resets the cpu
 
 static void intEventTest();
 
@@ -49,7 +50,6 @@ static void debugI()
 
 void intBreakpoint(bool memcheck)
 {
-#if 0
 	u32 pc = cpuRegs.pc;
  	if (CBreakPoints::CheckSkipFirst(BREAKPOINT_EE, pc) != 0)
 		return;
@@ -62,55 +62,61 @@ void intBreakpoint(bool memcheck)
 	}
 
 	CBreakPoints::SetBreakpointTriggered(true);
-#endif
 #ifndef PCSX2_CORE
 	GetCoreThread().PauseSelfDebug();
+#else
+	// There's no debugger to step past it, so let the instruction through once resumed.
+	CBreakPoints::SetSkipFirst(BREAKPOINT_EE, pc);
+	VMManager::SetPaused(true);
 #endif
 	throw Exception::ExitCpuExecute();
 }
 
 void intMemcheck(u32 op, u32 bits, bool store)
 {
-#if 0
 	// compute accessed address
-	u32 start = cpuRegs.GPR.r[(op >> 21) & 0x1F].UD[0];
+	u32 start = cpuRegs.GPR.r[(op >> 21) & 0x1F].UL[0];
 	if ((s16)op != 0)
 		start += (s16)op;
 	if (bits == 128)
 		start &= ~0x0F;
 
-	start = standardizeBreakpointAddress(BREAKPOINT_EE, start);
-	u32 end = start + bits/8;
-	
-	auto checks = CBreakPoints::GetMemChecks();
-	for (size_t i = 0; i < checks.size(); ++i)
-	{
-		auto& check = checks[i];
+	if (CBreakPoints::CheckMemAccess(BREAKPOINT_EE, start, bits / 8, store, cpuRegs.pc))
+		intBreakpoint(true);
+}
 
-		if (check.cpu != BREAKPOINT_EE)
-			continue;
-		if (check.result == 0)
-			continue;
-		if ((check.cond & MEMCHECK_WRITE) == 0 && store)
-			continue;
-		if ((check.cond & MEMCHECK_READ) == 0 && !store)
-			continue;
+// Reads an opcode without going through memRead32, which could raise a TLB miss before
+// execI has advanced the pc.
+static bool intPeekCode(u32 addr, u32& op)
+{
+	const vtlb_private::VTLBVirtual& vmv = vtlb_private::vtlbdata.vmap[addr >> vtlb_private::VTLB_PAGE_BITS];
+	if ((addr & 3) || vmv.isHandler(addr))
+		return false;
 
-		if (start < check.end && check.start < end)
-			intBreakpoint(true);
-	}
-#endif
+	op = *reinterpret_cast<const u32*>(vmv.assumePtr(addr));
+	return true;
 }
 
+// Checks the access made by the instruction at pc. Branches check their delay slot instead,
+// it runs from inside the branch handler where the cpu can't be stopped cleanly.
 void intCheckMemcheck()
 {
 	u32 pc = cpuRegs.pc;
-	int needed = isMemcheckNeeded(pc);
-	if (needed == 0)
+	u32 op;
+	if (!intPeekCode(pc, op))
 		return;
 
-	u32 op = memRead32(needed == 2 ? pc+4 : pc);
+	const OPCODE* branch = &GetInstruction(op);
+	const u32 branch_type = branch->flags & BRANCHTYPE_MASK;
+	if ((branch->flags & IS_BRANCH) && branch_type != BRANCHTYPE_SYSCALL && branch_type != BRANCHTYPE_ERET)
+	{
+		if (!intPeekCode(pc + 4, op))
+			return;
+	}
+
 	const OPCODE& opcode = GetInstruction(op);
+	if (!(opcode.flags & IS_MEMORY))
+		return;
 
 	bool store = (opcode.flags & IS_STORE) != 0;
 	switch (opcode.flags & MEMTYPE_MASK)
@@ -133,8 +139,197 @@ void intCheckMemcheck()
 	}
 }
 
+// --------------------------------------------------------------------------------------
+//  Decoded block cache
+// --------------------------------------------------------------------------------------
+// Optional fast path (EnableEEDecodeCache): every basic block is fetched and decoded once
+// into an array of handler pointers plus opcode words, then replayed without going through
+// memRead32 and the opcode tables. Cycles are added per instruction and events are tested
+// by the branch handlers exactly as with execI, so timing is unchanged.
+//
+// Blocks are keyed by their host offset in eeMem rather than by pc, so TLB aliases of the
+// same physical page share one decode and remaps don't need any invalidation. RAM pages
+// are guarded the same way as the recompiler does it: write protected through the mmap
+// page tracking (faults end up in intClear), or compared against memory at block entry
+// for manual pages and the scratchpad.
+
+namespace
+{
+	struct DecodedInsn
+	{
+		void (*interpret)();
+		u32 code;
+		u32 cycles;
+	};
+
+	struct DecodedBlock
+	{
+		u32 offset; // of the first instruction, relative to eeMem
+		std::vector<DecodedInsn> insns;
+	};
+
+	struct DecodedPage
+	{
+		u16 entries[0x400] = {}; // index + 1 of the block starting at each word, 0 if none
+		std::vector<std::unique_ptr<DecodedBlock>> blocks;
+		bool verify = false;
+		u16 manual_runs = 0;
+	};
+} // namespace
+
+// Main RAM, scratchpad and the ROMs. Code anywhere else takes the execI path.
+static constexpr u32 DECODE_CACHE_SIZE = offsetof(EEVM_MemoryAllocMess, ZeroRead);
+
+static std::unique_ptr<DecodedPage> s_decoded_pages[DECODE_CACHE_SIZE >> 12];
+static std::vector<std::unique_ptr<DecodedPage>> s_dropped_pages;
+static u8 s_reprotect_count[Ps2MemSize::MainRam >> 12];
+static u32 s_invalidations = 0;
+static bool s_decode_cache_enabled = false;
+
+// Next instruction of the running block, picked up by execI when a branch runs its delay slot
+static const DecodedInsn* s_delay_slot = nullptr;
+static u32 s_delay_slot_pc = 0;
+
+static const u32* DecodedCodePtr(u32 offset)
+{
+	return reinterpret_cast<const u32*>(reinterpret_cast<const u8*>(eeMem) + offset);
+}
+
+// Blocks of a dropped page may still be running (a store can hit its own page), so the
+// page is only freed once the dispatcher is back in control.
+static void DropDecodedPage(uptr offset)
+{
+	if (offset >= DECODE_CACHE_SIZE || !s_decoded_pages[offset >> 12])
+		return;
+
+	s_dropped_pages.push_back(std::move(s_decoded_pages[offset >> 12]));
+	s_delay_slot = nullptr;
+	s_invalidations++;
+}
+
+static DecodedPage& GetDecodedPage(u32 offset)
+{
+	std::unique_ptr<DecodedPage>& page = s_decoded_pages[offset >> 12];
+	if (page)
+		return *page;
+
+	page = std::make_unique<DecodedPage>();
+	if (offset < Ps2MemSize::MainRam)
+	{
+		// The kernel and EENULL thread contexts share pages 0x1 and 0x81 with code, see
+		// memory_protect_recompiled_code() in the recompiler.
+		const u32 rampage = offset >> 12;
+		if (rampage == 0x1 || rampage == 0x81 || mmap_GetRamPageInfo(offset) == ProtMode_Manual)
+			page->verify = true;
+		else
+			mmap_MarkCountedRamPage(offset);
+	}
+	else if (offset < offsetof(EEVM_MemoryAllocMess, ROM))
+	{
+		page->verify = true; // scratchpad can't be protected
+	}
+
+	return *page;
+}
+
+static const DecodedBlock* DecodeBlock(DecodedPage& page, u32 offset)
+{
+	std::unique_ptr<DecodedBlock> block = std::make_unique<DecodedBlock>();
+	block->offset = offset;
+
+	// Blocks end after a branch and its delay slot, or at the page boundary
+	const u32* mem = DecodedCodePtr(offset);
+	for (u32 pos = offset & 0xfff; pos < 0x1000; pos += 4)
+	{
+		const u32 code = *mem++;
+		const OPCODE& opcode = GetInstruction(code);
+		block->insns.push_back({opcode.interpret, code, opcode.cycles});
+
+		if (opcode.flags & IS_BRANCH)
+		{
+			const u32 type = opcode.flags & BRANCHTYPE_MASK;
+			if (type != BRANCHTYPE_SYSCALL && type != BRANCHTYPE_ERET && pos + 4 < 0x1000)
+			{
+				const u32 delay_code = *mem;
+				const OPCODE& delay_slot = GetInstruction(delay_code);
+				block->insns.push_back({delay_slot.interpret, delay_code, delay_slot.cycles});
+			}
+			break;
+		}
+	}
+
+	page.blocks.push_back(std::move(block));
+	page.entries[(offset & 0xfff) >> 2] = static_cast<u16>(page.blocks.size());
+	return page.blocks.back().get();
+}
+
+static bool VerifyBlock(const DecodedBlock& block)
+{
+	const u32* mem = DecodedCodePtr(block.offset);
+	for (const DecodedInsn& insn : block.insns)
+	{
+		if (*mem++ != insn.code)
+			return false;
+	}
+	return true;
+}
+
+static const DecodedBlock* LookupBlock(u32 pc)
+{
+	const vtlb_private::VTLBVirtual& vmv = vtlb_private::vtlbdata.vmap[pc >> vtlb_private::VTLB_PAGE_BITS];
+	if ((pc & 3) || vmv.isHandler(pc))
+		return nullptr;
+
+	const uptr offset = vmv.assumePtr(pc) - reinterpret_cast<uptr>(eeMem);
+	if (offset >= DECODE_CACHE_SIZE)
+		return nullptr;
+
+	if (DecodedPage* page = s_decoded_pages[offset >> 12].get())
+	{
+		if (const u16 index = page->entries[(offset & 0xfff) >> 2])
+		{
+			const DecodedBlock* block = page->blocks[index - 1].get();
+			if (!page->verify)
+				return block;
+
+			if (VerifyBlock(*block))
+			{
+				// Same heuristic as the recompiler: a manual page that keeps running unmodified
+				// goes back to write protection, up to three times before it stays manual.
+				const u32 rampage = offset >> 12;
+				if (offset >= Ps2MemSize::MainRam || rampage == 0x1 || rampage == 0x81 || s_reprotect_count[rampage] > 3)
+					return block;
+
+				const u32 runs = page->manual_runs + static_cast<u32>(block->insns.size());
+				page->manual_runs = static_cast<u16>(runs);
+				if (runs <= 0xffff)
+					return block;
+
+				s_reprotect_count[rampage]++;
+				mmap_MarkCountedRamPage(offset);
+			}
+
+			DropDecodedPage(offset);
+		}
+	}
+
+	return DecodeBlock(GetDecodedPage(offset), offset);
+}
+
 static void execI()
 {
+	// Delay slot of a branch running from the decoded block cache
+	if (s_delay_slot && cpuRegs.pc == s_delay_slot_pc)
+	{
+		const DecodedInsn& insn = *s_delay_slot;
+		s_delay_slot = nullptr;
+		cpuRegs.pc += 4;
+		cpuRegs.code = insn.code;
+		cpuBlockCycles += insn.cycles;
+		insn.interpret();
+		return;
+	}
+
 	// execI is called for every instruction so it must remains as light as possible.
 	// If you enable the next define, Interpreter will be much slower (around
 	// ~4fps on 3.9GHz Haswell vs ~8fps (even 10fps on dev build))
@@ -147,6 +342,10 @@ static void execI()
 		intBreakpoint(false);
 
 	intCheckMemcheck();
+#else
+	// delay slots were checked along with their branch
+	if (s_memchecks_enabled && !cpuRegs.branch)
+		intCheckMemcheck();
 #endif
 
 	u32 pc = cpuRegs.pc;
@@ -200,6 +399,42 @@ static void execI()
 	opcode.interpret();
 }
 
+// Runs one block from the decoded block cache, or a single instruction when the cache is off
+// or the pc isn't cacheable. Stops before stop_pc so the intExecute hooks still see it.
+static void execBlock(u32 stop_pc)
+{
+	if (!s_dropped_pages.empty())
+		s_dropped_pages.clear();
+
+	const DecodedBlock* block = s_decode_cache_enabled ? LookupBlock(cpuRegs.pc) : nullptr;
+	if (!block)
+	{
+		execI();
+		return;
+	}
+
+	u32 pc = cpuRegs.pc;
+	const DecodedInsn* insn = block->insns.data();
+	const DecodedInsn* end = insn + block->insns.size();
+	if (stop_pc > pc && (stop_pc - pc) / 4 < block->insns.size())
+		end = insn + (stop_pc - pc) / 4;
+
+	const u32 invalidations = s_invalidations;
+	do
+	{
+		pc += 4;
+		cpuRegs.pc = pc;
+		cpuRegs.code = insn->code;
+		s_delay_slot = (insn + 1 != end) ? insn + 1 : nullptr;
+		s_delay_slot_pc = pc;
+		cpuBlockCycles += insn->cycles;
+		insn->interpret();
+		insn++;
+	} while (insn != end && cpuRegs.pc == pc && s_invalidations == invalidations);
+
+	s_delay_slot = nullptr;
+}
+
 static __fi void _doBranch_shared(u32 tar)
 {
 	branch2 = cpuRegs.branch = 1;
@@ -509,6 +744,21 @@ static void intReset()
 {
 	cpuRegs.branch = 0;
 	branch2 = 0;
+
+	// intReset can come from inside a block, so the pages go through the dropped list as well
+	for (std::unique_ptr<DecodedPage>& page : s_decoded_pages)
+	{
+		if (page)
+			s_dropped_pages.push_back(std::move(page));
+	}
+	std::memset(s_reprotect_count, 0, sizeof(s_reprotect_count));
+	s_delay_slot = nullptr;
+	s_invalidations++;
+
+	// Memchecks are tested in execI, blocks would skip them
+	s_memchecks_enabled = CBreakPoints::HasMemChecks(BREAKPOINT_EE);
+	s_decode_cache_enabled = CHECK_EEDECODECACHE && !CHECK_CACHE && !s_memchecks_enabled;
+	mmap_ResetBlockTracking();
 }
 
 static void intEventTest()
@@ -534,7 +784,7 @@ static void intExecute()
 			switch (state) {
 				case RESET:
 					do
-						execI();
+						execBlock(g_eeloadMain ? g_eeloadMain : EELOAD_START);
 					while (cpuRegs.pc != (g_eeloadMain ? g_eeloadMain : EELOAD_START));
 					if (cpuRegs.pc == EELOAD_START)
 					{
@@ -572,7 +822,7 @@ static void intExecute()
 				case GAME_LOADING:
 					if (ElfEntry != 0xFFFFFFFF) {
 						do
-							execI();
+							execBlock(ElfEntry);
 						while (cpuRegs.pc != ElfEntry);
 						eeGameStarting();
 					}
@@ -580,11 +830,11 @@ static void intExecute()
 
 				case GAME_RUNNING:
 					while (true)
-						execI();
+						execBlock(0);
 			}
 		}
-		catch( Exception::ExitCpuExecute& ) { }
-		catch( Exception::CancelInstruction& ) { instruction_was_cancelled = true; }
+		catch( Exception::ExitCpuExecute& ) { s_delay_slot = nullptr; }
+		catch( Exception::CancelInstruction& ) { s_delay_slot = nullptr; instruction_was_cancelled = true; }
 
 		// For example a tlb miss will throw an exception. Cpu must be resumed
 		// to execute the handler
@@ -609,6 +859,20 @@ static void intStep()
 
 static void intClear(u32 Addr, u32 Size)
 {
+	if (!s_decode_cache_enabled)
+		return;
+
+	// Callers pass either a virtual address (TLB changes) or a physical one (page faults)
+	const u32 pages = ((Addr & 0xfff) + Size * 4 + 0xfff) >> 12;
+	for (u32 i = 0; i < pages; i++)
+	{
+		const u32 addr = (Addr & ~0xfffu) + (i << 12);
+		const vtlb_private::VTLBVirtual& vmv = vtlb_private::vtlbdata.vmap[addr >> vtlb_private::VTLB_PAGE_BITS];
+		if (!vmv.isHandler(addr))
+			DropDecodedPage(vmv.assumePtr(addr) - reinterpret_cast<uptr>(eeMem));
+		if (const uptr ptr = reinterpret_cast<uptr>(PSM(addr)))
+			DropDecodedPage(ptr - reinterpret_cast<uptr>(eeMem));
+	}
 }
 
 static void intShutdown() {
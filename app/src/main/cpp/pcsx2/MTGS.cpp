@@ -20,6 +20,7 @@
 #include <wx/datetime.h>
 
 #include "common/StringUtil.h"
+#include "common/Timer.h"
 
 #include "GS.h"
 #include "Gif_Unit.h"
@@ -92,6 +93,8 @@ void SysMtgsThread::StartThread()
     m_SignalRingPosition = 0;
 
     m_CopyDataTally = 0;
+    m_idle_spin.Reset();
+    m_stall_spin.Reset();
     PerformanceMetrics::Reset();
 
     ////
@@ -288,7 +291,11 @@ void SysMtgsThread::MainLoop()
 		// to avoid it.
 
         mtvu_lock.unlock();
-        m_sem_event.WaitForWork();
+        const Common::Timer::Value idle_start = Common::Timer::GetCurrentValue();
+        m_sem_event.WaitForWorkWithSpin(m_idle_spin.Budget());
+        const u64 idle_ns = static_cast<u64>(Common::Timer::ConvertValueToNanoseconds(Common::Timer::GetCurrentValue() - idle_start));
+        m_idle_spin.Update(idle_ns);
+        PerformanceMetrics::AddGSIdleTime(idle_ns);
         mtvu_lock.lock();
 
         if (!m_open_flag.load(std::memory_order_acquire))
@@ -625,8 +632,11 @@ void SysMtgsThread::WaitGS(bool syncRegs, bool weakWait, bool isMTVU)
     }
     else
     {
+        const Common::Timer::Value stall_start = Common::Timer::GetCurrentValue();
         if (!m_sem_event.WaitForEmpty())
             pxFailRel("MTGS Thread Died");
+        if (!isMTVU)
+            PerformanceMetrics::AddEEStallTime(static_cast<u64>(Common::Timer::ConvertValueToNanoseconds(Common::Timer::GetCurrentValue() - stall_start)));
     }
 
     if (syncRegs)
@@ -722,11 +732,32 @@ void SysMtgsThread::GenericStall(uint size)
 		if (somedone < size + 1)
 			somedone = size + 1;
 
+		const Common::Timer::Value stall_start = Common::Timer::GetCurrentValue();
+
 		// FMV Optimization: FMVs typically send *very* little data to the GS, in some cases
 		// every other frame is nothing more than a page swap.  Sleeping the EEcore is a
 		// waste of time, and we get better results using a spinwait.
+		// How long we spin is learned from recent stalls, if the GS doesn't catch up within
+		// that we fall back to sleeping until it does.
+
+		const bool spin = (somedone <= 0x80);
+		if (spin)
+		{
+			//Console.WriteLn( Color_StrongGray, "(EEcore Spin) PrepDataPacket!" );
+			SetEvent();
+			const u32 budget = m_stall_spin.Budget();
+			for (u32 waited = 0; waited < budget && freeroom <= size; waited += ShortSpin())
+			{
+				readpos = m_ReadPos.load(std::memory_order_acquire);
+
+				if (writepos < readpos)
+					freeroom = readpos - writepos;
+				else
+					freeroom = RingBufferSize - (writepos - readpos);
+			}
+		}
 
-		if (somedone > 0x80)
+		if (freeroom <= size)
 		{
 			pxAssertDev(m_SignalRingEnable == 0, "MTGS Thread Synchronization Error");
 
@@ -752,27 +783,39 @@ void SysMtgsThread::GenericStall(uint size)
 			}
 			pxAssertDev(m_SignalRingPosition <= 0, "MTGS Thread Synchronization Error");
 		}
-		else
-		{
-			//Console.WriteLn( Color_StrongGray, "(EEcore Spin) PrepDataPacket!" );
-			SetEvent();
-			while (true)
-			{
-				SpinWait();
-				readpos = m_ReadPos.load(std::memory_order_acquire);
-
-				if (writepos < readpos)
-					freeroom = readpos - writepos;
-				else
-					freeroom = RingBufferSize - (writepos - readpos);
 
-				if (freeroom > size)
-					break;
-			}
-		}
+		const u64 stall_ns = static_cast<u64>(Common::Timer::ConvertValueToNanoseconds(Common::Timer::GetCurrentValue() - stall_start));
+		if (spin)
+			m_stall_spin.Update(stall_ns);
+		PerformanceMetrics::AddEEStallTime(stall_ns);
 	}
 }
 
+void SysMtgsThread::AdaptiveSpin::Reset()
+{
+	average_ns = SPIN_TIME_NS / 4;
+	spinning = true;
+}
+
+u32 SysMtgsThread::AdaptiveSpin::Budget() const
+{
+	// Give the average wait some headroom, but never spin for longer than the global spin limit
+	static constexpr u32 MIN_SPIN_NS = 2000;
+	return spinning ? std::min(SPIN_TIME_NS, std::max(average_ns * 2, MIN_SPIN_NS)) : 0;
+}
+
+void SysMtgsThread::AdaptiveSpin::Update(u64 waited_ns)
+{
+	// Clamp so one long wait (pause, loading screen) decays in a few samples instead of dozens
+	const s64 sample = static_cast<s64>(std::min<u64>(waited_ns, static_cast<u64>(SPIN_TIME_NS) * 4));
+	average_ns = static_cast<u32>(average_ns + (sample - static_cast<s64>(average_ns)) / 8);
+
+	if (spinning && average_ns > SPIN_TIME_NS)
+		spinning = false;
+	else if (!spinning && average_ns < SPIN_TIME_NS / 2)
+		spinning = true;
+}
+
 void SysMtgsThread::PrepDataPacket(MTGS_RingCommand cmd, u32 size)
 {
 	m_packet_size = size;
@@ -1001,3 +1044,27 @@ bool SysMtgsThread::SaveMemorySnapshot(u32 width, u32 height, std::vector<u32>*
 	WaitGS(false, false, false);
 	return result;
 }
+
+bool SysMtgsThread::BeginCapture()
+{
+	pxAssertRel(IsOpen(), "MTGS is running");
+
+	// frames are handed to the capture in VSync, the audio file name is only used by the desktop frontend
+	bool result = false;
+	RunOnGSThread([&result]() {
+		std::string audio_filename;
+		result = GSsetupRecording(audio_filename);
+	});
+	WaitGS(false, false, false);
+	return result;
+}
+
+void SysMtgsThread::EndCapture()
+{
+	pxAssertRel(IsOpen(), "MTGS is running");
+
+	RunOnGSThread([]() {
+		GSendRecording();
+	});
+	WaitGS(false, false, false);
+}
@@ -22,6 +22,8 @@
 #include "System.h"
 #include "Config.h"
 
+#include "common/PersistentThread.h"
+
 #include "yaml-cpp/yaml.h"
 
 #include "svnrev.h"
@@ -96,6 +98,9 @@ void FolderMemoryCard::Open(const bool enableFiltering, const wxString& filter)
 
 void FolderMemoryCard::Open(const wxString& fullPath, const Pcsx2Config::McdOptions& mcdOptions, const u32 sizeInClusters, const bool enableFiltering, const wxString& filter, bool simulateFileWrites)
 {
+	// the folder has to be up to date before it's indexed again
+	m_writer.WaitForIdle();
+
 	InitializeInternalData();
 	m_performFileWrites = !simulateFileWrites;
 
@@ -158,6 +163,9 @@ void FolderMemoryCard::Close(bool flush)
 		Flush();
 	}
 
+	// make sure everything has reached the host file system before the card goes away
+	m_writer.Shutdown();
+
 	m_cache.clear();
 	m_oldDataCache.clear();
 	m_lastAccessedFile.CloseAll();
@@ -881,6 +889,9 @@ bool FolderMemoryCard::ReadFromFile(u8* dest, u32 adr, u32 dataLength)
 	auto it = m_fileMetadataQuickAccess.find(fatCluster);
 	if (it != m_fileMetadataQuickAccess.end())
 	{
+		// the file may still be rewritten by a previous flush
+		m_writer.WaitForIdle();
+
 		const u32 clusterNumber = it->second.consecutiveCluster;
 		wxFFile* file = m_lastAccessedFile.ReOpen(m_folderName, &it->second);
 		if (file->IsOpened())
@@ -1045,13 +1056,38 @@ void FolderMemoryCard::Flush()
 		return;
 	}
 
+	Console.WriteLn(L"(FolderMcd) Writing data for slot %u to file system...", m_slot);
+	const u64 timeFlushStart = wxGetLocalTimeMillis().GetValue();
+
+	if (m_performFileWrites)
+	{
+		m_flushBatch = std::make_unique<FolderMemoryCardFlushBatch>(m_slot);
+	}
+
+	FlushCache();
+
+	// Files may get replaced by the writer, so don't keep reading from the old ones.
+	m_lastAccessedFile.CloseAll();
+
+	const u64 timeFlushEnd = wxGetLocalTimeMillis().GetValue();
+	if (m_flushBatch && !m_flushBatch->IsEmpty())
+	{
+		Console.WriteLn(L"(FolderMcd) Queued %zu KB of data in %u ms.", m_flushBatch->GetDataSize() / 1024, timeFlushEnd - timeFlushStart);
+		m_writer.Submit(std::move(m_flushBatch));
+	}
+	else
+	{
+		Console.WriteLn(L"(FolderMcd) Done! Took %u ms.", timeFlushEnd - timeFlushStart);
+	}
+	m_flushBatch.reset();
+}
+
+void FolderMemoryCard::FlushCache()
+{
 #ifdef DEBUG_WRITE_FOLDER_CARD_IN_MEMORY_TO_FILE_ON_CHANGE
 	WriteToFile(m_folderName.GetFullPath().RemoveLast() + L"-debug_" + wxDateTime::Now().Format(L"%Y-%m-%d-%H-%M-%S") + L"_pre-flush.ps2");
 #endif
 
-	Console.WriteLn(L"(FolderMcd) Writing data for slot %u to file system...", m_slot);
-	const u64 timeFlushStart = wxGetLocalTimeMillis().GetValue();
-
 	// Keep a copy of the old file entries so we can figure out which files and directories, if any, have been deleted from the memory card.
 	std::vector<MemoryCardFileEntryTreeNode> oldFileEntryTree;
 	if (IsFormatted())
@@ -1113,13 +1149,8 @@ void FolderMemoryCard::Flush()
 		FlushPage(i);
 	}
 
-	m_lastAccessedFile.FlushAll();
-	m_lastAccessedFile.ClearMetadataWriteState();
 	m_oldDataCache.clear();
 
-	const u64 timeFlushEnd = wxGetLocalTimeMillis().GetValue();
-	Console.WriteLn(L"(FolderMcd) Done! Took %u ms.", timeFlushEnd - timeFlushStart);
-
 #ifdef DEBUG_WRITE_FOLDER_CARD_IN_MEMORY_TO_FILE_ON_CHANGE
 	WriteToFile(m_folderName.GetFullPath().RemoveLast() + L"-debug_" + wxDateTime::Now().Format(L"%Y-%m-%d-%H-%M-%S") + L"_post-flush.ps2");
 #endif
@@ -1168,14 +1199,10 @@ bool FolderMemoryCard::FlushBlock(const u32 block)
 
 void FolderMemoryCard::FlushSuperBlock()
 {
-	if (FlushBlock(0) && m_performFileWrites)
+	if (FlushBlock(0) && m_flushBatch)
 	{
 		wxFileName superBlockFileName(m_folderName.GetPath(), L"_pcsx2_superblock");
-		wxFFile superBlockFile(superBlockFileName.GetFullPath().c_str(), L"wb");
-		if (superBlockFile.IsOpened())
-		{
-			superBlockFile.Write(&m_superBlock.raw, sizeof(m_superBlock.raw));
-		}
+		m_flushBatch->StoreFile(superBlockFileName.GetFullPath(), &m_superBlock.raw, sizeof(m_superBlock.raw));
 	}
 }
 
@@ -1214,46 +1241,25 @@ void FolderMemoryCard::FlushFileEntries(const u32 dirCluster, const u32 remainin
 					const wxString subDirName = wxString::FromAscii((const char*)cleanName);
 					const wxString subDirPath = dirPath + L"/" + subDirName;
 
-					if (m_performFileWrites)
+					if (m_flushBatch)
 					{
 						// if this directory has nonstandard metadata, write that to the file system
 						wxFileName metaFileName(m_folderName.GetFullPath() + subDirPath, L"_pcsx2_meta_directory");
-						if (!metaFileName.DirExists())
-						{
-							metaFileName.Mkdir();
-						}
+						m_flushBatch->MakeDirectory(metaFileName.GetPath());
 
 						if (filenameCleaned || entry->entry.data.mode != MemoryCardFileEntry::DefaultDirMode || entry->entry.data.attr != 0)
 						{
-							wxFFile metaFile(metaFileName.GetFullPath(), L"wb");
-							if (metaFile.IsOpened())
-							{
-								metaFile.Write(entry->entry.raw, sizeof(entry->entry.raw));
-							}
+							m_flushBatch->StoreFile(metaFileName.GetFullPath(), entry->entry.raw, sizeof(entry->entry.raw));
 						}
 						else
 						{
 							// if metadata is standard make sure to remove a possibly existing metadata file
-							if (metaFileName.FileExists())
-							{
-								wxRemoveFile(metaFileName.GetFullPath());
-							}
+							m_flushBatch->RemoveFile(metaFileName.GetFullPath());
 						}
 
 						// write the directory index
 						metaFileName.SetName(L"_pcsx2_index");
-						YAML::Node index = LoadYAMLFromFile(metaFileName.GetFullPath());
-						YAML::Node entryNode = index["%ROOT"];
-
-						entryNode["timeCreated"] = entry->entry.data.timeCreated.ToTime();
-						entryNode["timeModified"] = entry->entry.data.timeModified.ToTime();
-
-						// Write out the changes
-						wxFFile indexFile;
-						if (indexFile.Open(metaFileName.GetFullPath(), L"w"))
-						{
-							indexFile.Write(YAML::Dump(index));
-						}
+						m_flushBatch->UpdateIndexRoot(metaFileName.GetFullPath(), entry->entry.data.timeCreated.ToTime(), entry->entry.data.timeModified.ToTime());
 					}
 
 					MemoryCardFileMetadataReference* dirRef = AddDirEntryToMetadataQuickAccess(entry, parent);
@@ -1268,29 +1274,20 @@ void FolderMemoryCard::FlushFileEntries(const u32 dirCluster, const u32 remainin
 				if (entry->entry.data.length == 0)
 				{
 					// empty files need to be explicitly created, as there will be no data cluster referencing it later
-					if (m_performFileWrites)
+					if (m_flushBatch)
 					{
 						char cleanName[sizeof(entry->entry.data.name)];
 						memcpy(cleanName, (const char*)entry->entry.data.name, sizeof(cleanName));
 						FileAccessHelper::CleanMemcardFilename(cleanName);
 						const wxString filePath = dirPath + L"/" + wxString::FromAscii((const char*)cleanName);
 						wxFileName fn(m_folderName.GetFullPath() + filePath);
-
-						if (!fn.FileExists())
-						{
-							if (!fn.DirExists())
-							{
-								fn.Mkdir(0777, wxPATH_MKDIR_FULL);
-							}
-							wxFFile createEmptyFile(fn.GetFullPath(), L"wb");
-							createEmptyFile.Close();
-						}
+						m_flushBatch->CreateEmptyFile(fn.GetFullPath());
 					}
 				}
 
-				if (m_performFileWrites)
+				if (m_flushBatch)
 				{
-					FileAccessHelper::WriteIndex(m_folderName.GetFullPath() + dirPath, entry, parent);
+					FileAccessHelper::WriteIndex(m_flushBatch.get(), m_folderName.GetFullPath() + dirPath, entry, parent);
 				}
 			}
 		}
@@ -1330,14 +1327,12 @@ void FolderMemoryCard::FlushDeletedFilesAndRemoveUnchangedDataFromCache(const st
 				const wxString fileName = wxString::FromAscii(cleanName);
 				const wxString filePath = m_folderName.GetFullPath() + dirPath + L"/" + fileName;
 				m_lastAccessedFile.CloseMatching(filePath);
-				const wxString newFilePath = m_folderName.GetFullPath() + dirPath + L"/_pcsx2_deleted_" + fileName;
-				if (wxFileName::DirExists(newFilePath))
+				if (m_flushBatch)
 				{
-					// wxRenameFile doesn't overwrite directories, so we have to remove the old one first
-					RemoveDirectory(newFilePath);
+					const wxString newFilePath = m_folderName.GetFullPath() + dirPath + L"/_pcsx2_deleted_" + fileName;
+					m_flushBatch->Rename(filePath, newFilePath);
+					DeleteFromIndex(m_folderName.GetFullPath() + dirPath, fileName);
 				}
-				wxRenameFile(filePath, newFilePath);
-				DeleteFromIndex(m_folderName.GetFullPath() + dirPath, fileName);
 			}
 			else if (entry->IsDir())
 			{
@@ -1461,42 +1456,21 @@ bool FolderMemoryCard::WriteToFile(const u8* src, u32 adr, u32 dataLength)
 		const MemoryCardFileEntry* const entry = it->second.entry;
 		const u32 clusterNumber = it->second.consecutiveCluster;
 
-		if (m_performFileWrites)
+		if (m_flushBatch)
 		{
-			wxFFile* file = m_lastAccessedFile.ReOpen(m_folderName, &it->second, true);
-			if (file->IsOpened())
-			{
-				const u32 clusterOffset = (page % 2) * PageSize + offset;
-				const u32 fileSize = entry->entry.data.length;
-				const u32 fileOffsetStart = std::min(clusterNumber * ClusterSize + clusterOffset, fileSize);
-				const u32 fileOffsetEnd = std::min(fileOffsetStart + dataLength, fileSize);
-				const u32 bytesToWrite = fileOffsetEnd - fileOffsetStart;
-
-				wxFileOffset actualFileSize = file->Length();
-				if (actualFileSize < fileOffsetStart)
-				{
-					file->Seek(actualFileSize);
-					const u32 diff = fileOffsetStart - actualFileSize;
-					u8 temp = 0xFF;
-					for (u32 i = 0; i < diff; ++i)
-					{
-						file->Write(&temp, 1);
-					}
-				}
+			const u32 clusterOffset = (page % 2) * PageSize + offset;
+			const u32 fileSize = entry->entry.data.length;
+			const u32 fileOffsetStart = std::min(clusterNumber * ClusterSize + clusterOffset, fileSize);
+			const u32 fileOffsetEnd = std::min(fileOffsetStart + dataLength, fileSize);
+			const u32 bytesToWrite = fileOffsetEnd - fileOffsetStart;
 
-				const wxFileOffset fileOffset = file->Tell();
-				if (fileOffset != fileOffsetStart)
-				{
-					file->Seek(fileOffsetStart);
-				}
-				if (bytesToWrite > 0)
-				{
-					file->Write(src, bytesToWrite);
-				}
-			}
-			else
+			wxFileName fn(m_folderName);
+			it->second.GetPath(&fn);
+
+			// only the data is copied here, the writer thread merges it into the file
+			if (m_flushBatch->WriteFileData(fn.GetFullPath(), fileOffsetStart, src, bytesToWrite))
 			{
-				return false;
+				FileAccessHelper::WriteMetadata(m_flushBatch.get(), m_folderName, &it->second);
 			}
 		}
 
@@ -1739,17 +1713,8 @@ void FolderMemoryCard::DeleteFromIndex(const wxString& filePath, const wxString&
 {
 	const wxString indexName = wxFileName(filePath, "_pcsx2_index").GetFullPath();
 
-	YAML::Node index = LoadYAMLFromFile(indexName);
-
 	const wxCharTypeBuffer entryUTF8(entry.ToUTF8());
-	index.remove(entryUTF8.data());
-
-	// Write out the changes
-	wxFFile indexFile;
-	if (indexFile.Open(indexName, L"w"))
-	{
-		indexFile.Write(YAML::Dump(index));
-	}
+	m_flushBatch->RemoveFromIndex(indexName, entryUTF8.data());
 }
 
 // from http://www.oocities.org/siliconvalley/station/8269/sma02/sma02.html#ECC
@@ -1815,6 +1780,346 @@ void FolderMemoryCard::WriteToFile(const wxString& filename)
 }
 
 
+FolderMemoryCardFlushBatch::FolderMemoryCardFlushBatch(uint slot)
+	: m_slot(slot)
+{
+}
+
+FolderMemoryCardFlushBatch::Operation& FolderMemoryCardFlushBatch::AddOperation(Operation::Type type, const wxString& path)
+{
+	Operation& op = m_operations.emplace_back();
+	op.type = type;
+	op.path = path;
+	return op;
+}
+
+void FolderMemoryCardFlushBatch::MakeDirectory(const wxString& path)
+{
+	AddOperation(Operation::Type::MakeDirectory, path);
+}
+
+void FolderMemoryCardFlushBatch::StoreFile(const wxString& path, const void* data, size_t size)
+{
+	Operation& op = AddOperation(Operation::Type::StoreFile, path);
+	op.data.assign(static_cast<const u8*>(data), static_cast<const u8*>(data) + size);
+	m_dataSize += size;
+}
+
+void FolderMemoryCardFlushBatch::RemoveFile(const wxString& path, bool removeEmptyDir)
+{
+	AddOperation(removeEmptyDir ? Operation::Type::RemoveFileAndEmptyDir : Operation::Type::RemoveFile, path);
+	m_fileDataOperations.clear();
+}
+
+void FolderMemoryCardFlushBatch::CreateEmptyFile(const wxString& path)
+{
+	AddOperation(Operation::Type::CreateEmptyFile, path);
+}
+
+bool FolderMemoryCardFlushBatch::WriteFileData(const wxString& path, u32 offset, const u8* data, u32 size)
+{
+	auto it = m_fileDataOperations.find(path);
+	const bool firstWrite = (it == m_fileDataOperations.end());
+	if (firstWrite)
+	{
+		AddOperation(Operation::Type::WriteFileData, path);
+		it = m_fileDataOperations.emplace(path, m_operations.size() - 1).first;
+	}
+
+	Operation& op = m_operations[it->second];
+	if (!op.writes.empty() && op.writes.back().first + op.writes.back().second == offset)
+	{
+		// continues the previous write, which is the usual case when a file is flushed page by page
+		op.writes.back().second += size;
+	}
+	else
+	{
+		op.writes.emplace_back(offset, size);
+	}
+	op.data.insert(op.data.end(), data, data + size);
+	m_dataSize += size;
+
+	return firstWrite;
+}
+
+void FolderMemoryCardFlushBatch::Rename(const wxString& path, const wxString& newPath)
+{
+	Operation& op = AddOperation(Operation::Type::Rename, path);
+	op.newPath = newPath;
+	m_fileDataOperations.clear();
+}
+
+void FolderMemoryCardFlushBatch::UpdateIndex(const wxString& indexPath, const std::string& name, time_t timeCreated, time_t timeModified)
+{
+	m_indexEdits[indexPath].push_back({IndexEdit::Type::Update, name, timeCreated, timeModified});
+}
+
+void FolderMemoryCardFlushBatch::UpdateIndexRoot(const wxString& indexPath, time_t timeCreated, time_t timeModified)
+{
+	m_indexEdits[indexPath].push_back({IndexEdit::Type::UpdateRoot, "%ROOT", timeCreated, timeModified});
+}
+
+void FolderMemoryCardFlushBatch::RemoveFromIndex(const wxString& indexPath, const std::string& name)
+{
+	m_indexEdits[indexPath].push_back({IndexEdit::Type::Remove, name, 0, 0});
+}
+
+bool FolderMemoryCardFlushBatch::WriteFileReplacing(const wxString& path, const void* data, size_t size)
+{
+	// write next to the target, the _pcsx2_ prefix keeps a leftover from being picked up as a save
+	wxFileName tempFileName(path);
+	tempFileName.SetFullName(L"_pcsx2_tmp_" + tempFileName.GetFullName());
+	const wxString tempPath(tempFileName.GetFullPath());
+
+	{
+		wxFFile tempFile(tempPath, L"wb");
+		if (!tempFile.IsOpened() || (size > 0 && !tempFile.Write(data, size)) || !tempFile.Close())
+		{
+			wxRemoveFile(tempPath);
+			return false;
+		}
+	}
+
+	return wxRenameFile(tempPath, path, true);
+}
+
+void FolderMemoryCardFlushBatch::ApplyFileData(const Operation& op) const
+{
+	wxFileName fn(op.path);
+	if (!fn.DirExists())
+	{
+		fn.Mkdir(0777, wxPATH_MKDIR_FULL);
+	}
+
+	std::vector<u8> contents;
+	if (fn.FileExists())
+	{
+		wxFFile file(op.path, L"rb");
+		if (file.IsOpened())
+		{
+			contents.resize(static_cast<size_t>(file.Length()));
+			contents.resize(file.Read(contents.data(), contents.size()));
+		}
+	}
+
+	size_t dataOffset = 0;
+	for (const auto& [fileOffset, length] : op.writes)
+	{
+		// pad files which are shorter than the write position, then write over the old contents
+		if (contents.size() < fileOffset)
+		{
+			contents.resize(fileOffset, 0xFF);
+		}
+		if (contents.size() < fileOffset + length)
+		{
+			contents.resize(fileOffset + length);
+		}
+		memcpy(&contents[fileOffset], &op.data[dataOffset], length);
+		dataOffset += length;
+	}
+
+	if (!WriteFileReplacing(op.path, contents.data(), contents.size()))
+	{
+		Console.Error(L"(FolderMcd) Failed to write %s for slot %u.", WX_STR(op.path), m_slot);
+	}
+}
+
+void FolderMemoryCardFlushBatch::Apply() const
+{
+	for (const Operation& op : m_operations)
+	{
+		switch (op.type)
+		{
+			case Operation::Type::MakeDirectory:
+			{
+				if (!wxFileName::DirExists(op.path))
+				{
+					wxFileName::Mkdir(op.path, 0777, wxPATH_MKDIR_FULL);
+				}
+				break;
+			}
+			case Operation::Type::StoreFile:
+			{
+				if (!WriteFileReplacing(op.path, op.data.data(), op.data.size()))
+				{
+					Console.Error(L"(FolderMcd) Failed to write %s for slot %u.", WX_STR(op.path), m_slot);
+				}
+				break;
+			}
+			case Operation::Type::RemoveFile:
+			case Operation::Type::RemoveFileAndEmptyDir:
+			{
+				if (wxFileName::FileExists(op.path))
+				{
+					wxRemoveFile(op.path);
+
+					if (op.type == Operation::Type::RemoveFileAndEmptyDir)
+					{
+						const wxString dirPath(wxFileName(op.path).GetPath());
+						wxDir dir(dirPath);
+						if (dir.IsOpened() && !dir.HasFiles())
+						{
+							dir.Close();
+							wxRmdir(dirPath);
+						}
+					}
+				}
+				break;
+			}
+			case Operation::Type::CreateEmptyFile:
+			{
+				wxFileName fn(op.path);
+				if (!fn.FileExists())
+				{
+					if (!fn.DirExists())
+					{
+						fn.Mkdir(0777, wxPATH_MKDIR_FULL);
+					}
+					wxFFile createEmptyFile(op.path, L"wb");
+					createEmptyFile.Close();
+				}
+				break;
+			}
+			case Operation::Type::WriteFileData:
+			{
+				ApplyFileData(op);
+				break;
+			}
+			case Operation::Type::Rename:
+			{
+				if (wxFileName::DirExists(op.newPath))
+				{
+					// wxRenameFile doesn't overwrite directories, so we have to remove the old one first
+					RemoveDirectory(op.newPath);
+				}
+				wxRenameFile(op.path, op.newPath);
+				break;
+			}
+		}
+	}
+
+	for (const auto& [indexPath, edits] : m_indexEdits)
+	{
+		YAML::Node index = LoadYAMLFromFile(indexPath);
+
+		for (const IndexEdit& edit : edits)
+		{
+			if (edit.type == IndexEdit::Type::Remove)
+			{
+				index.remove(edit.name);
+				continue;
+			}
+
+			YAML::Node entryNode = index[edit.name];
+			if (edit.type == IndexEdit::Type::Update && !entryNode.IsDefined())
+			{
+				// Newly added file - figure out the sort order as the entry should be added to the end of the list
+				unsigned int order = 0;
+				for (const auto& node : index)
+				{
+					order = std::max(order, node.second["order"].as<unsigned int>(0));
+				}
+
+				entryNode["order"] = order + 1;
+			}
+
+			entryNode["timeCreated"] = edit.timeCreated;
+			entryNode["timeModified"] = edit.timeModified;
+		}
+
+		// Write out the changes
+		const std::string contents(YAML::Dump(index));
+		if (!WriteFileReplacing(indexPath, contents.data(), contents.size()))
+		{
+			Console.Error(L"(FolderMcd) Failed to write %s for slot %u.", WX_STR(indexPath), m_slot);
+		}
+	}
+}
+
+FolderMemoryCardWriter::~FolderMemoryCardWriter()
+{
+	Shutdown();
+}
+
+void FolderMemoryCardWriter::Submit(std::unique_ptr<FolderMemoryCardFlushBatch> batch)
+{
+	{
+		std::unique_lock lock(m_mutex);
+		m_queue.push_back(std::move(batch));
+		m_busy.store(true, std::memory_order_release);
+
+		if (!m_thread.joinable())
+		{
+			m_shutdown = false;
+			m_thread = std::thread(&FolderMemoryCardWriter::ThreadProc, this);
+		}
+	}
+
+	m_workCv.notify_one();
+}
+
+void FolderMemoryCardWriter::WaitForIdle()
+{
+	if (!IsBusy())
+	{
+		return;
+	}
+
+	std::unique_lock lock(m_mutex);
+	m_idleCv.wait(lock, [this]() { return !m_busy.load(std::memory_order_acquire); });
+}
+
+void FolderMemoryCardWriter::Shutdown()
+{
+	{
+		std::unique_lock lock(m_mutex);
+		if (!m_thread.joinable())
+		{
+			return;
+		}
+		m_shutdown = true;
+	}
+
+	m_workCv.notify_one();
+	m_thread.join();
+}
+
+void FolderMemoryCardWriter::ThreadProc()
+{
+	Threading::SetNameOfCurrentThread("FolderMcd Writer");
+
+	std::unique_lock lock(m_mutex);
+	for (;;)
+	{
+		m_workCv.wait(lock, [this]() { return !m_queue.empty() || m_shutdown; });
+		if (m_queue.empty())
+		{
+			break;
+		}
+
+		// everything which piled up is written in one go
+		std::deque<std::unique_ptr<FolderMemoryCardFlushBatch>> batches;
+		batches.swap(m_queue);
+		lock.unlock();
+
+		for (const auto& batch : batches)
+		{
+			const u64 timeStart = wxGetLocalTimeMillis().GetValue();
+			batch->Apply();
+			const u64 timeEnd = wxGetLocalTimeMillis().GetValue();
+			Console.WriteLn(L"(FolderMcd) Wrote %zu KB for slot %u in %u ms.", batch->GetDataSize() / 1024, batch->GetSlot(), timeEnd - timeStart);
+		}
+		batches.clear();
+
+		lock.lock();
+		if (m_queue.empty())
+		{
+			m_busy.store(false, std::memory_order_release);
+			m_idleCv.notify_all();
+		}
+	}
+}
+
 FileAccessHelper::FileAccessHelper()
 {
 }
@@ -1824,7 +2129,7 @@ FileAccessHelper::~FileAccessHelper()
 	this->CloseAll();
 }
 
-wxFFile* FileAccessHelper::Open(const wxFileName& folderName, MemoryCardFileMetadataReference* fileRef, bool writeMetadata)
+wxFFile* FileAccessHelper::Open(const wxFileName& folderName, MemoryCardFileMetadataReference* fileRef)
 {
 	wxFileName fn(folderName);
 	fileRef->GetPath(&fn);
@@ -1849,15 +2154,10 @@ wxFFile* FileAccessHelper::Open(const wxFileName& folderName, MemoryCardFileMeta
 	handleStruct.fileRef = fileRef;
 	m_files.emplace(std::move(internalPath), std::move(handleStruct));
 
-	if (writeMetadata)
-	{
-		WriteMetadata(folderName, fileRef);
-	}
-
 	return file;
 }
 
-void FileAccessHelper::WriteMetadata(wxFileName folderName, const MemoryCardFileMetadataReference* fileRef)
+void FileAccessHelper::WriteMetadata(FolderMemoryCardFlushBatch* batch, wxFileName folderName, const MemoryCardFileMetadataReference* fileRef)
 {
 	const bool cleanedFilename = fileRef->GetPath(&folderName);
 	folderName.AppendDir(L"_pcsx2_meta");
@@ -1868,34 +2168,17 @@ void FileAccessHelper::WriteMetadata(wxFileName folderName, const MemoryCardFile
 	if (metadataIsNonstandard)
 	{
 		// write metadata of file if it's nonstandard
-		if (!folderName.DirExists())
-		{
-			folderName.Mkdir();
-		}
-		wxFFile metaFile(folderName.GetFullPath(), L"wb");
-		if (metaFile.IsOpened())
-		{
-			metaFile.Write(entry->raw, sizeof(entry->raw));
-		}
+		batch->MakeDirectory(folderName.GetPath());
+		batch->StoreFile(folderName.GetFullPath(), entry->raw, sizeof(entry->raw));
 	}
 	else
 	{
-		// if metadata is standard remove metadata file if it exists
-		if (folderName.FileExists())
-		{
-			wxRemoveFile(folderName.GetFullPath());
-
-			// and remove the metadata dir if it's now empty
-			wxDir metaDir(folderName.GetPath());
-			if (metaDir.IsOpened() && !metaDir.HasFiles())
-			{
-				wxRmdir(folderName.GetPath());
-			}
-		}
+		// if metadata is standard remove metadata file if it exists, and the metadata dir if it's now empty
+		batch->RemoveFile(folderName.GetFullPath(), true);
 	}
 }
 
-void FileAccessHelper::WriteIndex(wxFileName folderName, MemoryCardFileEntry* const entry, MemoryCardFileMetadataReference* const parent)
+void FileAccessHelper::WriteIndex(FolderMemoryCardFlushBatch* batch, wxFileName folderName, const MemoryCardFileEntry* const entry, const MemoryCardFileMetadataReference* const parent)
 {
 	parent->GetPath(&folderName);
 	char cleanName[sizeof(entry->entry.data.name)];
@@ -1914,35 +2197,12 @@ void FileAccessHelper::WriteIndex(wxFileName folderName, MemoryCardFileEntry* co
 	const wxCharTypeBuffer fileName(folderName.GetName().ToUTF8());
 	folderName.SetName(L"_pcsx2_index");
 
-	YAML::Node index = LoadYAMLFromFile(folderName.GetFullPath());
-	YAML::Node entryNode = index[fileName.data()];
-
-	if (!entryNode.IsDefined())
-	{
-		// Newly added file - figure out the sort order as the entry should be added to the end of the list
-		unsigned int order = 0;
-		for (const auto& node : index)
-		{
-			order = std::max(order, node.second["order"].as<unsigned int>(0));
-		}
-
-		entryNode["order"] = order + 1;
-	}
-
 	// Update timestamps basing on internal data
 	const auto* e = &entry->entry.data;
-	entryNode["timeCreated"] = e->timeCreated.ToTime();
-	entryNode["timeModified"] = e->timeModified.ToTime();
-
-	// Write out the changes
-	wxFFile indexFile;
-	if (indexFile.Open(folderName.GetFullPath(), L"w"))
-	{
-		indexFile.Write(YAML::Dump(index));
-	}
+	batch->UpdateIndex(folderName.GetFullPath(), fileName.data(), e->timeCreated.ToTime(), e->timeModified.ToTime());
 }
 
-wxFFile* FileAccessHelper::ReOpen(const wxFileName& folderName, MemoryCardFileMetadataReference* fileRef, bool writeMetadata)
+wxFFile* FileAccessHelper::ReOpen(const wxFileName& folderName, MemoryCardFileMetadataReference* fileRef)
 {
 	std::string internalPath;
 	fileRef->GetInternalPath(&internalPath);
@@ -1951,23 +2211,6 @@ wxFFile* FileAccessHelper::ReOpen(const wxFileName& folderName, MemoryCardFileMe
 	{
 		// we already have a handle to this file
 
-		// if the caller wants to write metadata and we haven't done this recently, do so and remember that we did
-		if (writeMetadata)
-		{
-			if (m_lastWrittenFileRef != fileRef)
-			{
-				WriteMetadata(folderName, fileRef);
-				m_lastWrittenFileRef = fileRef;
-			}
-		}
-		else
-		{
-			if (m_lastWrittenFileRef != nullptr)
-			{
-				m_lastWrittenFileRef = nullptr;
-			}
-		}
-
 		// update the fileRef in the map since it might have been modified or deleted
 		it->second.fileRef = fileRef;
 
@@ -1975,7 +2218,7 @@ wxFFile* FileAccessHelper::ReOpen(const wxFileName& folderName, MemoryCardFileMe
 	}
 	else
 	{
-		return this->Open(folderName, fileRef, writeMetadata);
+		return this->Open(folderName, fileRef);
 	}
 }
 
@@ -2015,18 +2258,6 @@ void FileAccessHelper::CloseAll()
 	m_files.clear();
 }
 
-void FileAccessHelper::FlushAll()
-{
-	for (auto it = m_files.begin(); it != m_files.end(); ++it)
-	{
-		it->second.fileHandle->Flush();
-	}
-}
-
-void FileAccessHelper::ClearMetadataWriteState()
-{
-	m_lastWrittenFileRef = nullptr;
-}
 
 bool FileAccessHelper::CleanMemcardFilename(char* name)
 {
@@ -18,7 +18,14 @@
 #include <wx/file.h>
 #include <wx/dir.h>
 #include <wx/ffile.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "Config.h"
@@ -238,6 +245,132 @@ struct MemoryCardFileHandleStructure
 	wxFFile* fileHandle;
 };
 
+// --------------------------------------------------------------------------------------
+//  FolderMemoryCardFlushBatch
+// --------------------------------------------------------------------------------------
+// Host file system changes collected by one flush of a FolderMemoryCard. All data the changes need
+// is copied in while recording, so the batch can be applied on another thread while the memory card
+// keeps being used. Files are rewritten through a temporary file and renamed over the old one, so a
+// crash in the middle of applying a batch can't leave a half written save behind.
+class FolderMemoryCardFlushBatch
+{
+public:
+	explicit FolderMemoryCardFlushBatch(uint slot);
+
+	// create a directory, including missing parents
+	void MakeDirectory(const wxString& path);
+	// replace the whole file with data
+	void StoreFile(const wxString& path, const void* data, size_t size);
+	// remove the file if it exists, and if removeEmptyDir is set its directory too when nothing else is left in it
+	void RemoveFile(const wxString& path, bool removeEmptyDir = false);
+	// create the file if it doesn't exist, otherwise leave it alone
+	void CreateEmptyFile(const wxString& path);
+	// write data at offset into a file of the memory card, filling any gap before offset with 0xFF
+	// writes to the same file are merged so the file is only rewritten once per batch
+	// returns true on the first write to the file
+	bool WriteFileData(const wxString& path, u32 offset, const u8* data, u32 size);
+	// rename a file or directory, an existing directory at newPath is removed first
+	void Rename(const wxString& path, const wxString& newPath);
+
+	// set the timestamps of name in the given index file, new entries are added at the end of the sort order
+	void UpdateIndex(const wxString& indexPath, const std::string& name, time_t timeCreated, time_t timeModified);
+	// set the timestamps of the directory the given index file belongs to
+	void UpdateIndexRoot(const wxString& indexPath, time_t timeCreated, time_t timeModified);
+	void RemoveFromIndex(const wxString& indexPath, const std::string& name);
+
+	bool IsEmpty() const { return m_operations.empty() && m_indexEdits.empty(); }
+	uint GetSlot() const { return m_slot; }
+	// amount of file data copied into the batch
+	size_t GetDataSize() const { return m_dataSize; }
+
+	// apply all changes in the order they were recorded, index files are updated last
+	void Apply() const;
+
+private:
+	struct Operation
+	{
+		enum class Type
+		{
+			MakeDirectory,
+			StoreFile,
+			RemoveFile,
+			RemoveFileAndEmptyDir,
+			CreateEmptyFile,
+			WriteFileData,
+			Rename,
+		};
+
+		Type type;
+		wxString path;
+		wxString newPath;
+		std::vector<u8> data;
+		// WriteFileData: file offset and length of every write, their data is stored back to back in data
+		std::vector<std::pair<u32, u32>> writes;
+	};
+
+	struct IndexEdit
+	{
+		enum class Type
+		{
+			Update,
+			UpdateRoot,
+			Remove,
+		};
+
+		Type type;
+		std::string name;
+		time_t timeCreated;
+		time_t timeModified;
+	};
+
+	Operation& AddOperation(Operation::Type type, const wxString& path);
+	void ApplyFileData(const Operation& op) const;
+	static bool WriteFileReplacing(const wxString& path, const void* data, size_t size);
+
+	uint m_slot;
+	size_t m_dataSize = 0;
+	std::vector<Operation> m_operations;
+	// edits of each index file, applied in order with a single read and write per file
+	std::map<wxString, std::vector<IndexEdit>> m_indexEdits;
+	// WriteFileData operation of each file, reset whenever an operation could move or remove files
+	std::map<wxString, size_t> m_fileDataOperations;
+};
+
+// --------------------------------------------------------------------------------------
+//  FolderMemoryCardWriter
+// --------------------------------------------------------------------------------------
+// Applies flush batches of a FolderMemoryCard on a background thread, in the order they were submitted.
+// The thread is started on the first submit and stopped again by Shutdown().
+class FolderMemoryCardWriter
+{
+public:
+	FolderMemoryCardWriter() = default;
+	~FolderMemoryCardWriter();
+
+	FolderMemoryCardWriter(const FolderMemoryCardWriter&) = delete;
+	FolderMemoryCardWriter& operator=(const FolderMemoryCardWriter&) = delete;
+
+	void Submit(std::unique_ptr<FolderMemoryCardFlushBatch> batch);
+
+	// true while submitted batches haven't been fully applied yet
+	bool IsBusy() const { return m_busy.load(std::memory_order_acquire); }
+	// block until all submitted batches are applied, needed before reading from the host file system
+	void WaitForIdle();
+	// apply everything still pending and stop the thread
+	void Shutdown();
+
+private:
+	void ThreadProc();
+
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_workCv;
+	std::condition_variable m_idleCv;
+	std::deque<std::unique_ptr<FolderMemoryCardFlushBatch>> m_queue;
+	std::atomic_bool m_busy{false};
+	bool m_shutdown = false;
+};
+
 // --------------------------------------------------------------------------------------
 //  FileAccessHelper
 // --------------------------------------------------------------------------------------
@@ -246,41 +379,34 @@ class FileAccessHelper
 {
 private:
 	std::map<std::string, MemoryCardFileHandleStructure> m_files;
-	MemoryCardFileMetadataReference* m_lastWrittenFileRef = nullptr; // we remember this to reduce redundant metadata checks/writes
 
 public:
 	FileAccessHelper();
 	~FileAccessHelper();
 
 	// Get an already opened file if possible, or open a new one and remember it
-	wxFFile* ReOpen(const wxFileName& folderName, MemoryCardFileMetadataReference* fileRef, bool writeMetadata = false);
+	wxFFile* ReOpen(const wxFileName& folderName, MemoryCardFileMetadataReference* fileRef);
 	// Close all open files that start with the given path, so either a file if a filename is given or all files in a directory and its subdirectories when a directory is given
 	void CloseMatching(const wxString& path);
 	// Close all open files
 	void CloseAll();
-	// Flush the written data of all open files to the file system
-	void FlushAll();
-
-	// Force metadata to be written on next file access, not sure if this is necessary but it can't hurt.
-	void ClearMetadataWriteState();
 
 	// removes characters from a PS2 file name that would be illegal in a Windows file system
 	// returns true if any changes were made
 	static bool CleanMemcardFilename(char* name);
 
-	static void WriteIndex(wxFileName folderName, MemoryCardFileEntry* const entry, MemoryCardFileMetadataReference* const parent);
+	static void WriteIndex(FolderMemoryCardFlushBatch* batch, wxFileName folderName, const MemoryCardFileEntry* const entry, const MemoryCardFileMetadataReference* const parent);
+	static void WriteMetadata(FolderMemoryCardFlushBatch* batch, wxFileName folderName, const MemoryCardFileMetadataReference* fileRef);
 
 private:
 	// helper function for CleanMemcardFilename()
 	static bool CleanMemcardFilenameEndDotOrSpace(char* name, size_t length);
 
 	// Open a new file and remember it for later
-	wxFFile* Open(const wxFileName& folderName, MemoryCardFileMetadataReference* fileRef, bool writeMetadata = false);
+	wxFFile* Open(const wxFileName& folderName, MemoryCardFileMetadataReference* fileRef);
 	// Close a file and delete its handle
 	// If entry is given, it also attempts to set the created and modified timestamps of the file according to the entry
 	void CloseFileHandle(wxFFile* file, const MemoryCardFileEntry* entry = nullptr);
-
-	void WriteMetadata(wxFileName folderName, const MemoryCardFileMetadataReference* fileRef);
 };
 
 // --------------------------------------------------------------------------------------
@@ -354,6 +480,11 @@ protected:
 	// remembers and keeps the last accessed file open for further access
 	FileAccessHelper m_lastAccessedFile;
 
+	// host file system changes of the flush in progress, only set during Flush()
+	std::unique_ptr<FolderMemoryCardFlushBatch> m_flushBatch;
+	// applies flushed changes to the host file system in the background
+	FolderMemoryCardWriter m_writer;
+
 	// path to the folder that contains the files of this memory card
 	wxFileName m_folderName;
 
@@ -528,9 +659,12 @@ protected:
 	bool WriteToFile(const u8* src, u32 adr, u32 dataLength);
 
 
-	// flush the whole cache to the internal data and/or host file system
+	// flush the whole cache to the internal data and hand the host file system changes to the writer thread
 	void Flush();
 
+	// flush the whole cache to the internal data and record the host file system changes in m_flushBatch
+	void FlushCache();
+
 	// flush a single page of the cache to the internal data and/or host file system
 	bool FlushPage(const u32 page);
 
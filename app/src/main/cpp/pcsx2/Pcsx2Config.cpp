@@ -126,6 +126,7 @@ void Pcsx2Config::SpeedhackOptions::LoadSave(SettingsWrapper& wrap)
 	SettingsWrapBitBool(vuFlagHack);
 	SettingsWrapBitBool(vuThread);
 	SettingsWrapBitBool(vu1Instant);
+	SettingsWrapBitBool(ipuThread);
 }
 
 void Pcsx2Config::ProfilerOptions::LoadSave(SettingsWrapper& wrap)
@@ -215,6 +216,7 @@ void Pcsx2Config::RecompilerOptions::LoadSave(SettingsWrapper& wrap)
 	SettingsWrapBitBool(EnableVU0);
 	SettingsWrapBitBool(EnableVU1);
 	SettingsWrapBitBool(EnableFastmem);
+	SettingsWrapBitBool(EnableEEDecodeCache);
 
 #ifndef __ANDROID__
 	SettingsWrapBitBool(vuOverflow);
@@ -766,6 +768,11 @@ Pcsx2Config::Pcsx2Config()
 	}
 
 	GzipIsoIndexTemplate = "$(f).pindex.tmp";
+	CdvdReadaheadThreads = 2;
+	CdvdReadaheadDepth = 8;
+	GzipIsoCacheSize = 200;
+	RewindFrequency = 30;
+	RewindBufferSize = 256;
 }
 
 void Pcsx2Config::LoadSave(SettingsWrapper& wrap)
@@ -786,6 +793,7 @@ void Pcsx2Config::LoadSave(SettingsWrapper& wrap)
 	SettingsWrapBitBool(HostFs);
 
 	SettingsWrapBitBool(BackupSavestate);
+	SettingsWrapBitBool(EnableRewind);
 	SettingsWrapBitBool(McdEnableEjection);
 	SettingsWrapBitBool(McdFolderAutoManage);
 	SettingsWrapBitBool(MultitapPort0_Enabled);
@@ -804,6 +812,11 @@ void Pcsx2Config::LoadSave(SettingsWrapper& wrap)
 	Trace.LoadSave(wrap);
 
 	SettingsWrapEntry(GzipIsoIndexTemplate);
+	SettingsWrapEntry(CdvdReadaheadThreads);
+	SettingsWrapEntry(CdvdReadaheadDepth);
+	SettingsWrapEntry(GzipIsoCacheSize);
+	SettingsWrapEntry(RewindFrequency);
+	SettingsWrapEntry(RewindBufferSize);
 
 	// For now, this in the derived config for backwards ini compatibility.
 #ifdef PCSX2_CORE
@@ -878,7 +891,12 @@ bool Pcsx2Config::operator==(const Pcsx2Config& right) const
 		OpEqu(Framerate) &&
 		OpEqu(Trace) &&
 		OpEqu(BaseFilenames) &&
-		OpEqu(GzipIsoIndexTemplate);
+		OpEqu(GzipIsoIndexTemplate) &&
+		OpEqu(CdvdReadaheadThreads) &&
+		OpEqu(CdvdReadaheadDepth) &&
+		OpEqu(GzipIsoCacheSize) &&
+		OpEqu(RewindFrequency) &&
+		OpEqu(RewindBufferSize);
 	for (u32 i = 0; i < sizeof(Mcd) / sizeof(Mcd[0]); ++i)
 	{
 		equal &= OpEqu(Mcd[i].Enabled);
@@ -908,6 +926,11 @@ void Pcsx2Config::CopyConfig(const Pcsx2Config& cfg)
 	}
 
 	GzipIsoIndexTemplate = cfg.GzipIsoIndexTemplate;
+	CdvdReadaheadThreads = cfg.CdvdReadaheadThreads;
+	CdvdReadaheadDepth = cfg.CdvdReadaheadDepth;
+	GzipIsoCacheSize = cfg.GzipIsoCacheSize;
+	RewindFrequency = cfg.RewindFrequency;
+	RewindBufferSize = cfg.RewindBufferSize;
 
 	CdvdVerboseReads = cfg.CdvdVerboseReads;
 	CdvdDumpBlocks = cfg.CdvdDumpBlocks;
@@ -921,6 +944,7 @@ void Pcsx2Config::CopyConfig(const Pcsx2Config& cfg)
 #endif
 	UseBOOT2Injection = cfg.UseBOOT2Injection;
 	BackupSavestate = cfg.BackupSavestate;
+	EnableRewind = cfg.EnableRewind;
 	McdEnableEjection = cfg.McdEnableEjection;
 	McdFolderAutoManage = cfg.McdFolderAutoManage;
 	MultitapPort0_Enabled = cfg.MultitapPort0_Enabled;
@@ -1251,6 +1275,8 @@ Pcsx2Config2::GSOptions::GSOptions()
     UseDebugDevice = false;
     UseBlitSwapChain = false;
     DisableShaderCache = false;
+    PrecompileShaders = true;
+    AsyncShaderCompile = false;
     DisableFramebufferFetch = false;
     ThreadedPresentation = false;
     SkipDuplicateFrames = true;
@@ -1279,6 +1305,7 @@ Pcsx2Config2::GSOptions::GSOptions()
 
     HWSpinCPUForReadbacks = true;
     HWDisableReadbacks = false;
+    HWDeferReadbacks = false;
     AccurateDATE = true;
     GPUPaletteConversion = false;
     ConservativeFramebuffer = true;
@@ -1394,6 +1421,7 @@ bool Pcsx2Config2::GSOptions::RestartOptionsAreEqual(const GSOptions& right) con
            OpEqu(UseDebugDevice) &&
            OpEqu(UseBlitSwapChain) &&
            OpEqu(DisableShaderCache) &&
+           OpEqu(PrecompileShaders) &&
            OpEqu(DisableDualSourceBlend) &&
            OpEqu(DisableFramebufferFetch) &&
            OpEqu(ThreadedPresentation) &&
@@ -1477,6 +1505,8 @@ void Pcsx2Config2::GSOptions::LoadSaveIniSettings(SettingsWrapper& wrap)
     GSSettingBool(UseDebugDevice);
     GSSettingBool(UseBlitSwapChain);
     GSSettingBoolEx(DisableShaderCache, "disable_shader_cache");
+    GSSettingBool(PrecompileShaders);
+    GSSettingBool(AsyncShaderCompile);
     GSSettingBool(DisableDualSourceBlend);
     GSSettingBool(DisableFramebufferFetch);
     GSSettingBool(ThreadedPresentation);
@@ -1491,6 +1521,7 @@ void Pcsx2Config2::GSOptions::LoadSaveIniSettings(SettingsWrapper& wrap)
     GSSettingBool(OsdShowIndicators);
 
     GSSettingBool(HWDisableReadbacks);
+    GSSettingBool(HWDeferReadbacks);
     GSSettingBoolEx(AccurateDATE, "accurate_date");
     GSSettingBoolEx(GPUPaletteConversion, "paltex");
     GSSettingBoolEx(ConservativeFramebuffer, "conservative_framebuffer");
@@ -15,6 +15,7 @@
 
 #include "PrecompiledHeader.h"
 
+#include <atomic>
 #include <chrono>
 #include <vector>
 
@@ -79,6 +80,18 @@ static float s_accumulated_gpu_time = 0.0f;
 static float s_gpu_usage = 0.0f;
 static u32 s_presents_since_last_update = 0;
 
+// EE <-> GS handoff, written by the EE and MTGS threads
+static std::atomic<u64> s_ee_stall_ns_accumulator{0};
+static std::atomic<u64> s_gs_idle_ns_accumulator{0};
+static float s_ee_stall_time = 0.0f;
+static float s_gs_idle_time = 0.0f;
+
+// written by the CDVD thread
+static std::atomic<u64> s_disc_cache_hits{0};
+static std::atomic<u64> s_disc_cache_misses{0};
+static std::atomic<u64> s_disc_cache_bytes_evicted{0};
+static std::atomic<u64> s_disc_decompress_time_us{0};
+
 void PerformanceMetrics::Clear()
 {
 	Reset();
@@ -99,6 +112,14 @@ void PerformanceMetrics::Clear()
 	s_average_gpu_time = 0.0f;
 	s_gpu_usage = 0.0f;
 
+	s_ee_stall_time = 0.0f;
+	s_gs_idle_time = 0.0f;
+
+	s_disc_cache_hits.store(0, std::memory_order_relaxed);
+	s_disc_cache_misses.store(0, std::memory_order_relaxed);
+	s_disc_cache_bytes_evicted.store(0, std::memory_order_relaxed);
+	s_disc_decompress_time_us.store(0, std::memory_order_relaxed);
+
 	s_frame_number = 0;
 }
 
@@ -113,6 +134,9 @@ void PerformanceMetrics::Reset()
 	s_accumulated_gpu_time = 0.0f;
 	s_presents_since_last_update = 0;
 
+	s_ee_stall_ns_accumulator.store(0, std::memory_order_relaxed);
+	s_gs_idle_ns_accumulator.store(0, std::memory_order_relaxed);
+
 	s_last_update_time.Reset();
 	s_last_frame_time.Reset();
 
@@ -150,6 +174,10 @@ void PerformanceMetrics::Update(bool gs_register_write, bool fb_blit)
 	s_average_gpu_time = s_accumulated_gpu_time / static_cast<float>(s_frames_since_last_update);
 	s_gpu_usage = s_accumulated_gpu_time / (time * 10.0f);
 	s_accumulated_gpu_time = 0.0f;
+	s_ee_stall_time = static_cast<float>(s_ee_stall_ns_accumulator.exchange(0, std::memory_order_relaxed)) /
+					  (1000000.0f * static_cast<float>(s_frames_since_last_update));
+	s_gs_idle_time = static_cast<float>(s_gs_idle_ns_accumulator.exchange(0, std::memory_order_relaxed)) /
+					 (1000000.0f * static_cast<float>(s_frames_since_last_update));
 
 	// prefer privileged register write based framerate detection, it's less likely to have false positives
 	if (s_gs_privileged_register_writes_since_last_update > 0 && !EmuConfig2.Gamefixes.BlitInternalFPSHack)
@@ -335,3 +363,58 @@ float PerformanceMetrics::GetGPUAverageTime()
 {
 	return s_average_gpu_time;
 }
+
+void PerformanceMetrics::AddEEStallTime(u64 nanoseconds)
+{
+	s_ee_stall_ns_accumulator.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+void PerformanceMetrics::AddGSIdleTime(u64 nanoseconds)
+{
+	s_gs_idle_ns_accumulator.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+float PerformanceMetrics::GetEEStallTime()
+{
+	return s_ee_stall_time;
+}
+
+float PerformanceMetrics::GetGSIdleTime()
+{
+	return s_gs_idle_time;
+}
+
+void PerformanceMetrics::AddDiscCacheLookup(bool hit)
+{
+	(hit ? s_disc_cache_hits : s_disc_cache_misses).fetch_add(1, std::memory_order_relaxed);
+}
+
+void PerformanceMetrics::AddDiscCacheEviction(u32 bytes)
+{
+	s_disc_cache_bytes_evicted.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void PerformanceMetrics::AddDiscDecompressTime(u64 microseconds)
+{
+	s_disc_decompress_time_us.fetch_add(microseconds, std::memory_order_relaxed);
+}
+
+u64 PerformanceMetrics::GetDiscCacheHits()
+{
+	return s_disc_cache_hits.load(std::memory_order_relaxed);
+}
+
+u64 PerformanceMetrics::GetDiscCacheMisses()
+{
+	return s_disc_cache_misses.load(std::memory_order_relaxed);
+}
+
+u64 PerformanceMetrics::GetDiscCacheBytesEvicted()
+{
+	return s_disc_cache_bytes_evicted.load(std::memory_order_relaxed);
+}
+
+double PerformanceMetrics::GetDiscDecompressTime()
+{
+	return static_cast<double>(s_disc_decompress_time_us.load(std::memory_order_relaxed)) / 1000.0;
+}
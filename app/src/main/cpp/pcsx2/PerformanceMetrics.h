@@ -64,4 +64,24 @@ namespace PerformanceMetrics
 
 	float GetGPUUsage();
 	float GetGPUAverageTime();
+
+	/// EE <-> GS handoff, accumulated from the EE and MTGS threads.
+	void AddEEStallTime(u64 nanoseconds);
+	void AddGSIdleTime(u64 nanoseconds);
+
+	/// Average time per frame the EE spent waiting on the GS ring buffer, in milliseconds.
+	float GetEEStallTime();
+	/// Average time per frame the GS thread spent waiting for work, in milliseconds.
+	float GetGSIdleTime();
+
+	/// Decompressed chunk cache of compressed disc images, updated from the CDVD reader.
+	void AddDiscCacheLookup(bool hit);
+	void AddDiscCacheEviction(u32 bytes);
+	void AddDiscDecompressTime(u64 microseconds);
+
+	u64 GetDiscCacheHits();
+	u64 GetDiscCacheMisses();
+	u64 GetDiscCacheBytesEvicted();
+	/// Total time spent extracting chunks that missed the cache, in milliseconds.
+	double GetDiscDecompressTime();
 } // namespace PerformanceMetrics
@@ -22,6 +22,11 @@
 #include "R5900OpcodeTables.h"
 //#include "DebugTools/Breakpoints.h"
 
+#include <array>
+#include <bitset>
+#include <memory>
+#include <utility>
+
 using namespace R3000A;
 
 // Used to flag delay slot instructions when throwig exceptions.
@@ -32,6 +37,48 @@ static u32 branchPC;
 
 static void doBranch(s32 tar);	// forward declared prototype
 
+// --------------------------------------------------------------------------------------
+//  Block cache
+// --------------------------------------------------------------------------------------
+// Every IOP basic block is fetched and decoded once into a run of pre-resolved handlers,
+// terminated by a null handler, so executing it skips the memory read and the two-level
+// opcode table walk of execI().  Blocks are kept per 4KB page of physical RAM/ROM and never
+// cross a page, so psxInt.Clear only has to look at the pages it's given.
+
+struct IopInstruction
+{
+	void (*handler)();
+	u32 code;
+};
+
+struct IopCodePage
+{
+	static constexpr u32 WORDS = 0x1000 / 4;
+
+	// A page gets this many decoded instructions at most before it's thrown away and started over,
+	// blocks entered halfway through each other would otherwise grow it without bound.
+	static constexpr size_t MAX_INSTRUCTIONS = 0x4000;
+
+	// offset + 1 into insts of the block starting at each word, 0 when it hasn't been decoded yet
+	std::array<u32, WORDS> blocks = {};
+	// words which belong to a decoded block, writing to any of them drops the page
+	std::bitset<WORDS> code;
+	std::vector<IopInstruction> insts;
+};
+
+static constexpr u32 IOP_RAM_CODE_PAGES = 0x200000 / 0x1000;
+static constexpr u32 IOP_ROM_CODE_PAGES = 0x400000 / 0x1000;
+static std::unique_ptr<IopCodePage> s_code_pages[IOP_RAM_CODE_PAGES + IOP_ROM_CODE_PAGES];
+
+// Instructions of dropped pages, kept alive until the block that was running when they were dropped has returned.
+static std::vector<std::vector<IopInstruction>> s_retired_code;
+
+// Set when a page is dropped, the running block has to stop as it may have been overwritten.
+static bool s_block_cleared = false;
+
+// Next instruction of the running block, so doBranch() can take the delay slot from the cache.
+static const IopInstruction* s_delay_slot = nullptr;
+
 /*********************************************************
 * Register branch logic                                  *
 * Format:  OP rs, offset                                 *
@@ -217,18 +264,8 @@ void psxCheckMemcheck()
 ///////////////////////////////////////////
 // These macros are used to assemble the repassembler functions
 
-static __fi void execI()
+static __fi void psxInjectIrx()
 {
-	// This function is called for every instruction.
-	// Enabling the define below will probably, no, will cause the interpretor to be slower.
-//#define EXTRA_DEBUG
-#ifdef EXTRA_DEBUG
-	if (psxIsBreakpointNeeded(psxRegs.pc))
-		psxBreakpoint(false);
-
-	psxCheckMemcheck();
-#endif
-
 	// Inject IRX hack
 	if (psxRegs.pc == 0x1630 && EmuConfig.CurrentIRX.length() > 3) {
 		if (iopMemRead32(0x20018) == 0x1F) {
@@ -236,11 +273,10 @@ static __fi void execI()
 			iopMemWrite32(0x20094, 0xbffc0000);
 		}
 	}
+}
 
-	psxRegs.code = iopMemRead32(psxRegs.pc);
-#ifdef PCSX2_DEBUG
-	PSXCPU_LOG("%s", disR3000AF(psxRegs.code, psxRegs.pc));
-#endif
+static __fi void psxAdvancePC()
+{
 	psxRegs.pc+= 4;
 	psxRegs.cycle++;
 
@@ -253,9 +289,178 @@ static __fi void execI()
 	{   //default ps2 mode value
 		iopCycleEE-=8;
 	}
+}
+
+static __fi void execI()
+{
+	// This function is called for every instruction.
+	// Enabling the define below will probably, no, will cause the interpretor to be slower.
+//#define EXTRA_DEBUG
+#ifdef EXTRA_DEBUG
+	if (psxIsBreakpointNeeded(psxRegs.pc))
+		psxBreakpoint(false);
+
+	psxCheckMemcheck();
+#endif
+
+	psxInjectIrx();
+
+	psxRegs.code = iopMemRead32(psxRegs.pc);
+#ifdef PCSX2_DEBUG
+	PSXCPU_LOG("%s", disR3000AF(psxRegs.code, psxRegs.pc));
+#endif
+	psxAdvancePC();
 	psxBSC[psxRegs.code >> 26]();
 }
 
+static __fi void execCached(const IopInstruction& inst)
+{
+	psxRegs.code = inst.code;
+#ifdef PCSX2_DEBUG
+	PSXCPU_LOG("%s", disR3000AF(psxRegs.code, psxRegs.pc));
+#endif
+	psxAdvancePC();
+	inst.handler();
+}
+
+// Resolves the whole psxBSC -> psxSPC/psxREG/psxCP0/psxCP2 walk up front.
+static void (*psxResolveHandler(u32 code))()
+{
+	switch (code >> 26)
+	{
+		case 0x00: return psxSPC[code & 0x3f];
+		case 0x01: return psxREG[(code >> 16) & 0x1f];
+		case 0x10: return psxCP0[(code >> 21) & 0x1f];
+		case 0x12: return (code & 0x3f) ? psxCP2[code & 0x3f] : psxCP2BSC[(code >> 21) & 0x1f];
+		default:   return psxBSC[code >> 26];
+	}
+}
+
+// Branches and jumps, which are followed by a delay slot.
+static bool psxIsBranch(u32 code)
+{
+	switch (code >> 26)
+	{
+		case 0x00: return (code & 0x3f) == 0x08 || (code & 0x3f) == 0x09; // JR, JALR
+		case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06: case 0x07:
+			return true;
+		default:
+			return false;
+	}
+}
+
+// SYSCALL and BREAK always leave the block through an exception.
+static bool psxIsException(u32 code)
+{
+	return (code >> 26) == 0x00 && ((code & 0x3f) == 0x0c || (code & 0x3f) == 0x0d);
+}
+
+static std::unique_ptr<IopCodePage>* psxGetCodePage(u32 pc)
+{
+	const u32 phys = pc & 0x1fffffff;
+	if (phys < 0x00800000)
+		return &s_code_pages[(phys & 0x1fffff) >> 12];
+	if (phys >= 0x1fc00000)
+		return &s_code_pages[IOP_RAM_CODE_PAGES + ((phys - 0x1fc00000) >> 12)];
+	return nullptr;
+}
+
+static void psxDropCodePage(IopCodePage& page)
+{
+	s_retired_code.push_back(std::move(page.insts));
+	page.insts = {};
+	page.blocks.fill(0);
+	page.code.reset();
+	s_block_cleared = true;
+}
+
+static void psxClearCodePages()
+{
+	for (std::unique_ptr<IopCodePage>& page : s_code_pages)
+	{
+		if (page)
+			psxDropCodePage(*page);
+	}
+}
+
+// Returns the decoded block starting at pc, or nullptr if pc isn't in RAM or ROM.
+static const IopInstruction* psxLookupBlock(u32 pc)
+{
+	std::unique_ptr<IopCodePage>* slot = psxGetCodePage(pc);
+	if (!slot)
+		return nullptr;
+	if (!*slot)
+		*slot = std::make_unique<IopCodePage>();
+
+	IopCodePage& page = **slot;
+	const u32 start = (pc >> 2) & (IopCodePage::WORDS - 1);
+	if (const u32 offset = page.blocks[start])
+		return &page.insts[offset - 1];
+
+	if (page.insts.size() >= IopCodePage::MAX_INSTRUCTIONS)
+		psxDropCodePage(page);
+
+	const size_t offset = page.insts.size();
+	for (u32 word = start, addr = pc; word < IopCodePage::WORDS; word++, addr += 4)
+	{
+		// the IRX hack in psxInjectIrx() has to see 0x1630 at the start of a block
+		if ((addr & 0x1fffff) == 0x1630 && word != start)
+			break;
+
+		const u32 code = iopMemRead32(addr);
+		page.insts.push_back({psxResolveHandler(code), code});
+		page.code.set(word);
+
+		if (psxIsException(code))
+			break;
+
+		if (psxIsBranch(code))
+		{
+			// take the delay slot along if it's in the same page, doBranch() falls back to execI() otherwise
+			if (word + 1 < IopCodePage::WORDS && ((addr + 4) & 0x1fffff) != 0x1630)
+			{
+				const u32 delay_code = iopMemRead32(addr + 4);
+				page.insts.push_back({psxResolveHandler(delay_code), delay_code});
+				page.code.set(word + 1);
+			}
+			break;
+		}
+	}
+	page.insts.push_back({nullptr, 0});
+	page.blocks[start] = static_cast<u32>(offset + 1);
+	return &page.insts[offset];
+}
+
+// Runs one block, stopping early when the block branches away, an exception moves the pc,
+// or the block has been overwritten.
+static void execBlock()
+{
+	s_retired_code.clear();
+
+	psxInjectIrx();
+
+	const IopInstruction* inst = psxLookupBlock(psxRegs.pc);
+	if (!inst)
+	{
+		execI();
+		return;
+	}
+
+	s_block_cleared = false;
+	for (; inst->handler; inst++)
+	{
+		const u32 next_pc = psxRegs.pc + 4;
+
+		// doBranch() takes the delay slot from here, a not-taken branch runs it as the next instruction
+		s_delay_slot = inst[1].handler ? &inst[1] : nullptr;
+		execCached(*inst);
+		s_delay_slot = nullptr;
+
+		if (branch2 || s_block_cleared || psxRegs.pc != next_pc)
+			break;
+	}
+}
+
 static void doBranch(s32 tar) {
 #ifdef PCSX2_DEBUG
 	if (tar == 0x0) {
@@ -264,7 +469,10 @@ static void doBranch(s32 tar) {
 #endif
 	branch2 = iopIsDelaySlot = true;
 	branchPC = tar;
-	execI();
+	if (const IopInstruction* delay_slot = std::exchange(s_delay_slot, nullptr))
+		execCached(*delay_slot);
+	else
+		execI();
 	PSXCPU_LOG( "\n" );
 	iopIsDelaySlot = false;
 	psxRegs.pc = branchPC;
@@ -280,10 +488,12 @@ static void intAlloc() {
 
 static void intReset() {
 	intAlloc();
+	psxClearCodePages();
 }
 
 static void intExecute() {
-	for (;;) execI();
+	s_delay_slot = nullptr;
+	for (;;) execBlock();
 }
 
 static s32 intExecuteBlock( s32 eeCycles )
@@ -291,22 +501,52 @@ static s32 intExecuteBlock( s32 eeCycles )
 	iopBreak = 0;
 	iopCycleEE = eeCycles;
 
+	// may be left over if the last block was interrupted by an exception
+	s_delay_slot = nullptr;
+
 	while (iopCycleEE > 0){
 		if ((psxHu32(HW_ICFG) & 8) && ((psxRegs.pc & 0x1fffffffU) == 0xa0 || (psxRegs.pc & 0x1fffffffU) == 0xb0 || (psxRegs.pc & 0x1fffffffU) == 0xc0))
 			psxBiosCall();
 
 		branch2 = 0;
 		while (!branch2) {
-			execI();
+			execBlock();
         }
 	}
 	return iopBreak + iopCycleEE;
 }
 
 static void intClear(u32 Addr, u32 Size) {
+	const u32 end = Addr + Size * 4;
+	for (u32 addr = Addr & ~3u; addr < end;)
+	{
+		const u32 page_end = (addr | 0xfff) + 1;
+		std::unique_ptr<IopCodePage>* slot = psxGetCodePage(addr);
+		if (slot && *slot)
+		{
+			// plain data writes into a page with code in it are common, only drop it if code was hit
+			IopCodePage& page = **slot;
+			const u32 last = std::min(end, page_end) - 4;
+			for (u32 word_addr = addr; word_addr <= last; word_addr += 4)
+			{
+				if (page.code.test((word_addr >> 2) & (IopCodePage::WORDS - 1)))
+				{
+					psxDropCodePage(page);
+					break;
+				}
+			}
+		}
+
+		if (page_end == 0)
+			break;
+		addr = page_end;
+	}
 }
 
 static void intShutdown() {
+	for (std::unique_ptr<IopCodePage>& page : s_code_pages)
+		page.reset();
+	s_retired_code.clear();
 }
 
 static void intSetCacheReserve( uint reserveInMegs )
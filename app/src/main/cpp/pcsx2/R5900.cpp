@@ -287,6 +287,9 @@ static __fi void TESTINT( u8 n, void (*callback)() )
 // being included into R5900.cpp.
 static __fi void _cpuTestInterrupts()
 {
+	// Not a DMAC event, the IPU keeps decoding with the DMAC disabled
+	TESTINT(IPU_PROCESS, ipuThreadSync);
+
 	if (!dmacRegs.ctrl.DMAE || (psHu8(DMAC_ENABLER+2) & 1))
 	{
 		//Console.Write("DMAC Disabled or suspended");
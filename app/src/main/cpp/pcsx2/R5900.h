@@ -425,7 +425,8 @@ enum EE_EventType
 	
 	DMAC_GIF_UNIT,
 	VIF_VU0_FINISH,
-	VIF_VU1_FINISH
+	VIF_VU1_FINISH,
+	IPU_PROCESS // Threaded IPU sync point
 };
 
 extern void CPU_INT( EE_EventType n, s32 ecycle );
@@ -0,0 +1,179 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+
+#include "Config.h"
+#include "Rewind.h"
+#include "SaveState.h"
+#include "SaveStateContainer.h"
+
+// Snapshots share unchanged chunks with the previous one, so they are kept a lot smaller than
+// on disk. This way a snapshot costs about as much as the memory the game touched since the last.
+static constexpr u32 REWIND_CHUNK_SIZE = 16 * 1024;
+static constexpr int REWIND_COMPRESSION_LEVEL = 1;
+
+namespace
+{
+	struct PendingSnapshot
+	{
+		std::unique_ptr<SaveStateSnapshot> snapshot;
+		std::unique_ptr<ArchiveEntryList> list;
+	};
+} // namespace
+
+// Guards everything below, the pending capture's worker only touches what it was handed.
+static std::mutex s_mutex;
+
+static bool s_enabled = false;
+static u32 s_frequency = 1;
+static size_t s_budget = 0;
+static u32 s_frames_until_capture = 1;
+
+// Oldest first, every snapshot is a delta against the one before it.
+static std::deque<std::unique_ptr<SaveStateSnapshot>> s_snapshots;
+static size_t s_memory_usage = 0;
+
+// The last capture is compressed on a worker while the game runs, and collected on the next capture.
+// Its buffer is recycled afterwards, so the machine state isn't reallocated every time.
+static std::future<PendingSnapshot> s_pending;
+static std::unique_ptr<ArchiveEntryList> s_free_list;
+
+static void DropOldest()
+{
+	const SaveStateSnapshot* next = (s_snapshots.size() > 1) ? s_snapshots[1].get() : nullptr;
+	s_memory_usage -= s_snapshots.front()->GetCompressedSize(next);
+	s_snapshots.pop_front();
+}
+
+static void DropNewest()
+{
+	const SaveStateSnapshot* prev = (s_snapshots.size() > 1) ? s_snapshots[s_snapshots.size() - 2].get() : nullptr;
+	s_memory_usage -= s_snapshots.back()->GetCompressedSize(prev);
+	s_snapshots.pop_back();
+}
+
+static void CollectPending()
+{
+	if (!s_pending.valid())
+		return;
+
+	PendingSnapshot pending(s_pending.get());
+	s_free_list = std::move(pending.list);
+
+	const SaveStateSnapshot* prev = s_snapshots.empty() ? nullptr : s_snapshots.back().get();
+	s_memory_usage += pending.snapshot->GetCompressedSize(prev);
+	s_snapshots.push_back(std::move(pending.snapshot));
+
+	// The newest snapshot is always kept, even if it doesn't fit on its own.
+	while (s_memory_usage > s_budget && s_snapshots.size() > 1)
+		DropOldest();
+}
+
+void Rewind::Reset()
+{
+	std::unique_lock lock(s_mutex);
+	CollectPending();
+	s_snapshots.clear();
+	s_memory_usage = 0;
+
+	s_enabled = EmuConfig.EnableRewind;
+	s_frequency = std::max(EmuConfig.RewindFrequency, 1u);
+	s_budget = static_cast<size_t>(EmuConfig.RewindBufferSize) * _1mb;
+	s_frames_until_capture = s_frequency;
+
+	if (!s_enabled)
+		s_free_list.reset();
+}
+
+void Rewind::Shutdown()
+{
+	std::unique_lock lock(s_mutex);
+	CollectPending();
+	s_snapshots.clear();
+	s_memory_usage = 0;
+	s_free_list.reset();
+	s_enabled = false;
+}
+
+void Rewind::OnVSync()
+{
+	std::unique_lock lock(s_mutex);
+	if (!s_enabled || --s_frames_until_capture > 0)
+		return;
+
+	s_frames_until_capture = s_frequency;
+	CollectPending();
+
+	std::unique_ptr<ArchiveEntryList> list(std::move(s_free_list));
+	if (!list)
+		list = std::make_unique<ArchiveEntryList>(new VmStateBuffer(L"Rewind Snapshot"));
+	list->Clear();
+
+	try
+	{
+		SaveState_DownloadState(list.get());
+	}
+	catch (Exception::BaseException& e)
+	{
+		Console.Error("(Rewind) Failed to capture snapshot: %s", static_cast<const char*>(e.DiagMsg().c_str()));
+		s_free_list = std::move(list);
+		return;
+	}
+
+	// The base stays alive until the result is collected, nothing drops snapshots before that.
+	const SaveStateSnapshot* base = s_snapshots.empty() ? nullptr : s_snapshots.back().get();
+	s_pending = std::async(std::launch::async, [list = std::move(list), base]() mutable {
+		PendingSnapshot pending;
+		pending.snapshot = SaveStateSnapshot::Create(*list, g_SaveVersion, base, REWIND_COMPRESSION_LEVEL, REWIND_CHUNK_SIZE);
+		pending.list = std::move(list);
+		return pending;
+	});
+}
+
+bool Rewind::LoadSnapshot(u32 steps)
+{
+	std::unique_lock lock(s_mutex);
+	CollectPending();
+	if (steps == 0 || steps > s_snapshots.size())
+		return false;
+
+	while (--steps > 0)
+		DropNewest();
+
+	SaveState_LoadSnapshot(*s_snapshots.back(), L"Rewind Snapshot");
+	DropNewest();
+
+	s_frames_until_capture = s_frequency;
+	return true;
+}
+
+u32 Rewind::GetSnapshotCount()
+{
+	std::unique_lock lock(s_mutex);
+	return static_cast<u32>(s_snapshots.size()) + (s_pending.valid() ? 1 : 0);
+}
+
+size_t Rewind::GetMemoryUsage()
+{
+	std::unique_lock lock(s_mutex);
+	return s_memory_usage;
+}
@@ -0,0 +1,41 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "common/Pcsx2Defs.h"
+
+// Keeps compressed in-memory snapshots of the last few seconds, each one a delta against the
+// one before it. Captures run on the CPU thread. Snapshots are loaded by whoever loads save
+// states, e.g. the frontend while the CPU thread is parked, so every call takes the same lock.
+namespace Rewind
+{
+	/// Drops all snapshots and picks up the rewind settings.
+	void Reset();
+
+	/// Drops all snapshots and frees the capture buffers.
+	void Shutdown();
+
+	/// Captures a snapshot every RewindFrequency frames.
+	void OnVSync();
+
+	/// Restores the snapshot taken steps captures ago (1 being the newest) and forgets it and
+	/// everything newer. The CPU must not be executing. Throws if the state can't be loaded.
+	bool LoadSnapshot(u32 steps);
+
+	u32 GetSnapshotCount();
+
+	/// Compressed size of all snapshots, chunks shared between them are counted once.
+	size_t GetMemoryUsage();
+} // namespace Rewind
@@ -15,11 +15,10 @@
 
 #include "PrecompiledHeader.h"
 #include "Global.h"
+#include "MixerVoices.h"
 
 void ADMAOutLogWrite(void* lpData, u32 ulSize);
 
-#include "interpolate_table.h"
-
 static const s32 tbl_XA_Factor[16][2] =
 	{
 		{0, 0},
@@ -29,24 +28,6 @@ static const s32 tbl_XA_Factor[16][2] =
 		{122, -60}};
 
 
-// Performs a 64-bit multiplication between two values and returns the
-// high 32 bits as a result (discarding the fractional 32 bits).
-// The combined fractional bits of both inputs must be 32 bits for this
-// to work properly.
-//
-// This is meant to be a drop-in replacement for times when the 'div' part
-// of a MulDiv is a constant.  (example: 1<<8, or 4096, etc)
-//
-// [Air] Performance breakdown: This is over 10 times faster than MulDiv in
-//   a *worst case* scenario.  It's also more accurate since it forces the
-//   caller to  extend the inputs so that they make use of all 32 bits of
-//   precision.
-//
-static __forceinline s32 MulShr32(s32 srcval, s32 mulval)
-{
-	return (s64)srcval * mulval >> 32;
-}
-
 __forceinline s32 clamp_mix(s32 x, u8 bitshift)
 {
 	assert(bitshift <= 15);
@@ -291,15 +272,6 @@ static __forceinline void GetNextDataDummy(V_Core& thiscore, uint voiceidx)
 /////////////////////////////////////////////////////////////////////////////////////////
 //                                                                                     //
 
-// Data is expected to be 16 bit signed (typical stuff!).
-// volume is expected to be 32 bit signed (31 bits with reverse phase)
-// Data is shifted up by 1 bit to give the output an effective 16 bit range.
-static __forceinline s32 ApplyVolume(s32 data, s32 volume)
-{
-	//return (volume * data) >> 15;
-	return MulShr32(data << 1, volume);
-}
-
 static __forceinline StereoOut32 ApplyVolume(const StereoOut32& data, const V_VolumeLR& volume)
 {
 	return StereoOut32(
@@ -356,94 +328,9 @@ static __forceinline void CalculateADSR(V_Core& thiscore, uint voiceidx)
 }
 
 
-__forceinline static s32 GaussianInterpolate(s32 pv4, s32 pv3, s32 pv2, s32 pv1, s32 i)
-{
-	s32 out = 0;
-	out =  (interpTable[0x0FF - i] * pv4) >> 15;
-	out += (interpTable[0x1FF - i] * pv3) >> 15;
-	out += (interpTable[0x100 + i] * pv2) >> 15;
-	out += (interpTable[0x000 + i] * pv1) >> 15;
-
-	return out;
-}
-
-/*
-   Tension: 65535 is high, 32768 is normal, 0 is low
-*/
-
-template <s32 i_tension>
-__forceinline static s32 HermiteInterpolate(
-	s32 y0, // 16.0
-	s32 y1, // 16.0
-	s32 y2, // 16.0
-	s32 y3, // 16.0
-	s32 mu  //  0.12
-)
-{
-	s32 m00 = ((y1 - y0) * i_tension) >> 16; // 16.0
-	s32 m01 = ((y2 - y1) * i_tension) >> 16; // 16.0
-	s32 m0 = m00 + m01;
-
-	s32 m10 = ((y2 - y1) * i_tension) >> 16; // 16.0
-	s32 m11 = ((y3 - y2) * i_tension) >> 16; // 16.0
-	s32 m1 = m10 + m11;
-
-	s32 val = ((2 * y1 + m0 + m1 - 2 * y2) * mu) >> 12;       // 16.0
-	val = ((val - 3 * y1 - 2 * m0 - m1 + 3 * y2) * mu) >> 12; // 16.0
-	val = ((val + m0) * mu) >> 12;                            // 16.0
-
-	return (val + (y1));
-}
-
-__forceinline static s32 CatmullRomInterpolate(
-	s32 y0, // 16.0
-	s32 y1, // 16.0
-	s32 y2, // 16.0
-	s32 y3, // 16.0
-	s32 mu  //  0.12
-)
-{
-	//q(t) = 0.5 *(    	(2 * P1) +
-	//	(-P0 + P2) * t +
-	//	(2*P0 - 5*P1 + 4*P2 - P3) * t2 +
-	//	(-P0 + 3*P1- 3*P2 + P3) * t3)
-
-	s32 a3 = (-y0 + 3 * y1 - 3 * y2 + y3);
-	s32 a2 = (2 * y0 - 5 * y1 + 4 * y2 - y3);
-	s32 a1 = (-y0 + y2);
-	s32 a0 = (2 * y1);
-
-	s32 val = ((a3)*mu) >> 12;
-	val = ((a2 + val) * mu) >> 12;
-	val = ((a1 + val) * mu) >> 12;
-
-	return (a0 + val) >> 1;
-}
-
-__forceinline static s32 CubicInterpolate(
-	s32 y0, // 16.0
-	s32 y1, // 16.0
-	s32 y2, // 16.0
-	s32 y3, // 16.0
-	s32 mu  //  0.12
-)
-{
-	const s32 a0 = y3 - y2 - y0 + y1;
-	const s32 a1 = y0 - y1 - a0;
-	const s32 a2 = y2 - y0;
-
-	s32 val = ((a0)*mu) >> 12;
-	val = ((val + a1) * mu) >> 12;
-	val = ((val + a2) * mu) >> 12;
-
-	return (val + y1);
-}
-
-// Returns a 16 bit result in Value.
-// Uses standard template-style optimization techniques to statically generate five different
-// versions of this function (one for each type of interpolation).
+// Advances the voice to the current sample position and returns the fractional position (mu).
 template <int InterpType>
-static __forceinline s32 GetVoiceValues(V_Core& thiscore, uint voiceidx)
+static __forceinline s32 FetchVoiceSamples(V_Core& thiscore, uint voiceidx)
 {
 	V_Voice& vc(thiscore.Voices[voiceidx]);
 
@@ -459,28 +346,19 @@ static __forceinline s32 GetVoiceValues(V_Core& thiscore, uint voiceidx)
 		vc.SP -= 4096;
 	}
 
-	const s32 mu = vc.SP + 4096;
+	return vc.SP + 4096;
+}
 
-	switch (InterpType)
-	{
-		case 0:
-			return vc.PV1;
-		case 1:
-			return (vc.PV1) - (((vc.PV2 - vc.PV1) * mu) >> 12);
-
-		case 2:
-			return CubicInterpolate(vc.PV4, vc.PV3, vc.PV2, vc.PV1, mu);
-		case 3:
-			return HermiteInterpolate<16384>(vc.PV4, vc.PV3, vc.PV2, vc.PV1, mu);
-		case 4:
-			return CatmullRomInterpolate(vc.PV4, vc.PV3, vc.PV2, vc.PV1, mu);
-		case 5:
-			return GaussianInterpolate(vc.PV4, vc.PV3, vc.PV2, vc.PV1, (mu & 0x0ff0) >> 4);
-
-			jNO_DEFAULT;
-	}
+// Returns a 16 bit result in Value.
+// Uses standard template-style optimization techniques to statically generate five different
+// versions of this function (one for each type of interpolation).
+template <int InterpType>
+static __forceinline s32 GetVoiceValues(V_Core& thiscore, uint voiceidx)
+{
+	V_Voice& vc(thiscore.Voices[voiceidx]);
+	const s32 mu = FetchVoiceSamples<InterpType>(thiscore, voiceidx);
 
-	return 0; // technically unreachable!
+	return InterpolateVoice<InterpType>(vc.PV4, vc.PV3, vc.PV2, vc.PV1, mu);
 }
 
 // This is Dr. Hell's noise algorithm as implemented in pcsxr
@@ -642,12 +520,145 @@ static __forceinline StereoOut32 MixVoice(uint coreidx, uint voiceidx)
 	return voiceOut;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////
+//  Vectorized voice mixing
+//
+// The voices of a core are mixed in three passes.  Everything with side effects (ADPCM
+// decoding, IRQs, ENDX, ADSR state, volume slides) still runs in voice order on the scalar
+// side and leaves its results in structure-of-arrays form.  Interpolation, envelope and
+// volume are then done four voices per vector, and the final pass stores OutX and the
+// voice 1/3 output write-back.  The results are bit-identical to MixVoice.
+//
+// Two things make later voices depend on the output of earlier ones within the same
+// sample, and cores using them take the MixVoice path instead: pitch modulation (reads
+// the previous voice's OutX) and voices that play from the voice 1/3 output buffers
+// (which MixVoice writes part way through the loop).
+
+static __forceinline bool CanMixCoreVoicesVectorized(const V_Core& thiscore)
+{
+	// Voice 1 and 3 output buffers, plus the block before them which a voice can advance out of
+	const u32 outbuf = ((thiscore.Index == 0) ? 0x400 : 0xc00) - 8;
+
+	for (uint voiceidx = 0; voiceidx < V_Core::NumVoices; ++voiceidx)
+	{
+		const V_Voice& vc(thiscore.Voices[voiceidx]);
+		if (voiceidx > 0 && vc.Modulated)
+			return false;
+		// A voice only ever reads from NextA's block, the one after it, or jumps to LoopStartA
+		if (voiceidx > 1 && (((vc.NextA & 0xFFFF8) - outbuf) < 0x408 || ((vc.LoopStartA & 0xFFFF8) - outbuf) < 0x408))
+			return false;
+	}
+
+	return true;
+}
+
+template <int InterpType>
+static __forceinline void FetchVoiceLanes(V_Core& thiscore, VoiceLanes& lanes)
+{
+	const s32 noise = GetNoiseValues(thiscore);
+
+	for (uint voiceidx = 0; voiceidx < V_Core::NumVoices; ++voiceidx)
+	{
+		V_Voice& vc(thiscore.Voices[voiceidx]);
+
+		pxAssertMsg((vc.SCurrent <= 28) && (vc.SCurrent != 0), "Current sample should always range from 1->28");
+
+		vc.Volume.Update();
+		UpdatePitch(thiscore.Index, voiceidx);
+
+		const bool active = (vc.ADSR.Phase > 0);
+		s32 mu = 0;
+		if (active)
+		{
+			if (!vc.Noise)
+				mu = FetchVoiceSamples<InterpType>(thiscore, voiceidx);
+
+			CalculateADSR(thiscore, voiceidx);
+		}
+		else
+		{
+			while (vc.SP > 0)
+				GetNextDataDummy(thiscore, voiceidx);
+		}
+
+		lanes.Active[voiceidx] = active;
+		lanes.NoiseMask[voiceidx] = (active && vc.Noise) ? -1 : 0;
+		lanes.PV1[voiceidx] = lanes.NoiseMask[voiceidx] ? noise : vc.PV1;
+		lanes.PV2[voiceidx] = vc.PV2;
+		lanes.PV3[voiceidx] = vc.PV3;
+		lanes.PV4[voiceidx] = vc.PV4;
+		SetVoiceLaneMu<InterpType>(lanes, voiceidx, mu);
+		// Inactive voices output silence, a zero envelope takes care of that
+		lanes.Envelope[voiceidx] = active ? vc.ADSR.Value : 0;
+		lanes.VolumeL[voiceidx] = vc.Volume.Left.Value;
+		lanes.VolumeR[voiceidx] = vc.Volume.Right.Value;
+		lanes.DryL[voiceidx] = thiscore.VoiceGates[voiceidx].DryL;
+		lanes.DryR[voiceidx] = thiscore.VoiceGates[voiceidx].DryR;
+		lanes.WetL[voiceidx] = thiscore.VoiceGates[voiceidx].WetL;
+		lanes.WetR[voiceidx] = thiscore.VoiceGates[voiceidx].WetR;
+	}
+}
+
+template <int InterpType>
+static __forceinline void MixCoreVoicesVectorized(VoiceMixSet& dest, const uint coreidx)
+{
+	V_Core& thiscore(Cores[coreidx]);
+	VoiceLanes lanes;
+
+	FetchVoiceLanes<InterpType>(thiscore, lanes);
+
+	MixVoiceLanes<InterpType>(lanes, dest);
+
+	for (uint voiceidx = 0; voiceidx < V_Core::NumVoices; ++voiceidx)
+	{
+		if (!lanes.Active[voiceidx])
+			continue;
+
+		thiscore.Voices[voiceidx].OutX = lanes.Value[voiceidx];
+
+		if (IsDevBuild)
+			DebugCores[coreidx].Voices[voiceidx].displayPeak = std::max(DebugCores[coreidx].Voices[voiceidx].displayPeak, lanes.Value[voiceidx]);
+	}
+
+	// Write-back of raw voice data (post ADSR applied)
+	spu2M_WriteFast(((0 == coreidx) ? 0x400 : 0xc00) + OutPos, lanes.Value[1]);
+	spu2M_WriteFast(((0 == coreidx) ? 0x600 : 0xe00) + OutPos, lanes.Value[3]);
+}
+
 const VoiceMixSet VoiceMixSet::Empty((StereoOut32()), (StereoOut32())); // Don't use SteroOut32::Empty because C++ doesn't make any dep/order checks on global initializers.
 
 static __forceinline void MixCoreVoices(VoiceMixSet& dest, const uint coreidx)
 {
 	V_Core& thiscore(Cores[coreidx]);
 
+	if (CanMixCoreVoicesVectorized(thiscore))
+	{
+		switch (Interpolation)
+		{
+			case 0:
+				MixCoreVoicesVectorized<0>(dest, coreidx);
+				break;
+			case 1:
+				MixCoreVoicesVectorized<1>(dest, coreidx);
+				break;
+			case 2:
+				MixCoreVoicesVectorized<2>(dest, coreidx);
+				break;
+			case 3:
+				MixCoreVoicesVectorized<3>(dest, coreidx);
+				break;
+			case 4:
+				MixCoreVoicesVectorized<4>(dest, coreidx);
+				break;
+			case 5:
+				MixCoreVoicesVectorized<5>(dest, coreidx);
+				break;
+
+				jNO_DEFAULT;
+		}
+		return;
+	}
+
 	for (uint voiceidx = 0; voiceidx < V_Core::NumVoices; ++voiceidx)
 	{
 		StereoOut32 VVal(MixVoice(coreidx, voiceidx));
@@ -0,0 +1,305 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Voice interpolation and volume math, shared by MixVoice and the four-voice mixer in
+// Mixer.cpp.  Nothing in here touches emulator state.
+
+#include "Global.h"
+#include "GS/GSVector.h"
+#include "interpolate_table.h"
+
+// Performs a 64-bit multiplication between two values and returns the
+// high 32 bits as a result (discarding the fractional 32 bits).
+// The combined fractional bits of both inputs must be 32 bits for this
+// to work properly.
+//
+// This is meant to be a drop-in replacement for times when the 'div' part
+// of a MulDiv is a constant.  (example: 1<<8, or 4096, etc)
+//
+// [Air] Performance breakdown: This is over 10 times faster than MulDiv in
+//   a *worst case* scenario.  It's also more accurate since it forces the
+//   caller to  extend the inputs so that they make use of all 32 bits of
+//   precision.
+//
+static __forceinline s32 MulShr32(s32 srcval, s32 mulval)
+{
+	return (s64)srcval * mulval >> 32;
+}
+
+// Data is expected to be 16 bit signed (typical stuff!).
+// volume is expected to be 32 bit signed (31 bits with reverse phase)
+// Data is shifted up by 1 bit to give the output an effective 16 bit range.
+static __forceinline s32 ApplyVolume(s32 data, s32 volume)
+{
+	//return (volume * data) >> 15;
+	return MulShr32(data << 1, volume);
+}
+
+__forceinline static s32 GaussianInterpolate(s32 pv4, s32 pv3, s32 pv2, s32 pv1, s32 i)
+{
+	s32 out = 0;
+	out =  (interpTable[0x0FF - i] * pv4) >> 15;
+	out += (interpTable[0x1FF - i] * pv3) >> 15;
+	out += (interpTable[0x100 + i] * pv2) >> 15;
+	out += (interpTable[0x000 + i] * pv1) >> 15;
+
+	return out;
+}
+
+/*
+   Tension: 65535 is high, 32768 is normal, 0 is low
+*/
+
+template <s32 i_tension>
+__forceinline static s32 HermiteInterpolate(
+	s32 y0, // 16.0
+	s32 y1, // 16.0
+	s32 y2, // 16.0
+	s32 y3, // 16.0
+	s32 mu  //  0.12
+)
+{
+	s32 m00 = ((y1 - y0) * i_tension) >> 16; // 16.0
+	s32 m01 = ((y2 - y1) * i_tension) >> 16; // 16.0
+	s32 m0 = m00 + m01;
+
+	s32 m10 = ((y2 - y1) * i_tension) >> 16; // 16.0
+	s32 m11 = ((y3 - y2) * i_tension) >> 16; // 16.0
+	s32 m1 = m10 + m11;
+
+	s32 val = ((2 * y1 + m0 + m1 - 2 * y2) * mu) >> 12;       // 16.0
+	val = ((val - 3 * y1 - 2 * m0 - m1 + 3 * y2) * mu) >> 12; // 16.0
+	val = ((val + m0) * mu) >> 12;                            // 16.0
+
+	return (val + (y1));
+}
+
+__forceinline static s32 CatmullRomInterpolate(
+	s32 y0, // 16.0
+	s32 y1, // 16.0
+	s32 y2, // 16.0
+	s32 y3, // 16.0
+	s32 mu  //  0.12
+)
+{
+	//q(t) = 0.5 *(    	(2 * P1) +
+	//	(-P0 + P2) * t +
+	//	(2*P0 - 5*P1 + 4*P2 - P3) * t2 +
+	//	(-P0 + 3*P1- 3*P2 + P3) * t3)
+
+	s32 a3 = (-y0 + 3 * y1 - 3 * y2 + y3);
+	s32 a2 = (2 * y0 - 5 * y1 + 4 * y2 - y3);
+	s32 a1 = (-y0 + y2);
+	s32 a0 = (2 * y1);
+
+	s32 val = ((a3)*mu) >> 12;
+	val = ((a2 + val) * mu) >> 12;
+	val = ((a1 + val) * mu) >> 12;
+
+	return (a0 + val) >> 1;
+}
+
+__forceinline static s32 CubicInterpolate(
+	s32 y0, // 16.0
+	s32 y1, // 16.0
+	s32 y2, // 16.0
+	s32 y3, // 16.0
+	s32 mu  //  0.12
+)
+{
+	const s32 a0 = y3 - y2 - y0 + y1;
+	const s32 a1 = y0 - y1 - a0;
+	const s32 a2 = y2 - y0;
+
+	s32 val = ((a0)*mu) >> 12;
+	val = ((val + a1) * mu) >> 12;
+	val = ((val + a2) * mu) >> 12;
+
+	return (val + y1);
+}
+
+// Returns a 16 bit result, y0..y3 = PV4..PV1 of the voice.
+template <int InterpType>
+static __forceinline s32 InterpolateVoice(s32 pv4, s32 pv3, s32 pv2, s32 pv1, s32 mu)
+{
+	switch (InterpType)
+	{
+		case 0:
+			return pv1;
+		case 1:
+			return (pv1) - (((pv2 - pv1) * mu) >> 12);
+
+		case 2:
+			return CubicInterpolate(pv4, pv3, pv2, pv1, mu);
+		case 3:
+			return HermiteInterpolate<16384>(pv4, pv3, pv2, pv1, mu);
+		case 4:
+			return CatmullRomInterpolate(pv4, pv3, pv2, pv1, mu);
+		case 5:
+			return GaussianInterpolate(pv4, pv3, pv2, pv1, (mu & 0x0ff0) >> 4);
+
+			jNO_DEFAULT;
+	}
+
+	return 0; // technically unreachable!
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//  Four-voice mixing, see MixCoreVoicesVectorized()
+
+struct alignas(16) VoiceLanes
+{
+	s32 PV1[V_Core::NumVoices];
+	s32 PV2[V_Core::NumVoices];
+	s32 PV3[V_Core::NumVoices];
+	s32 PV4[V_Core::NumVoices];
+	s32 Mu[V_Core::NumVoices];
+	s32 Gaussian[4][V_Core::NumVoices]; // interpTable coefficients for PV4..PV1
+	s32 NoiseMask[V_Core::NumVoices];
+	s32 Envelope[V_Core::NumVoices];
+	s32 VolumeL[V_Core::NumVoices];
+	s32 VolumeR[V_Core::NumVoices];
+	s32 DryL[V_Core::NumVoices];
+	s32 DryR[V_Core::NumVoices];
+	s32 WetL[V_Core::NumVoices];
+	s32 WetR[V_Core::NumVoices];
+	s32 Value[V_Core::NumVoices];
+	bool Active[V_Core::NumVoices];
+};
+
+template <int InterpType>
+static __forceinline void SetVoiceLaneMu(VoiceLanes& lanes, uint voiceidx, s32 mu)
+{
+	lanes.Mu[voiceidx] = mu;
+	if (InterpType == 5)
+	{
+		const s32 i = (mu & 0x0ff0) >> 4;
+		lanes.Gaussian[0][voiceidx] = interpTable[0x0FF - i];
+		lanes.Gaussian[1][voiceidx] = interpTable[0x1FF - i];
+		lanes.Gaussian[2][voiceidx] = interpTable[0x100 + i];
+		lanes.Gaussian[3][voiceidx] = interpTable[0x000 + i];
+	}
+}
+
+// Same as the scalar interpolators with y0..y3 = PV4..PV1
+template <int InterpType>
+static __forceinline GSVector4i InterpolateLanes(const VoiceLanes& lanes, uint i)
+{
+	const GSVector4i y3 = GSVector4i::load<true>(&lanes.PV1[i]);
+	if (InterpType == 0)
+		return y3;
+
+	const GSVector4i y2 = GSVector4i::load<true>(&lanes.PV2[i]);
+	const GSVector4i mu = GSVector4i::load<true>(&lanes.Mu[i]);
+	if (InterpType == 1)
+		return y3.sub32(y2.sub32(y3).mul32l(mu).sra32(12));
+
+	const GSVector4i y1 = GSVector4i::load<true>(&lanes.PV3[i]);
+	const GSVector4i y0 = GSVector4i::load<true>(&lanes.PV4[i]);
+	const GSVector4i three(3);
+
+	switch (InterpType)
+	{
+		case 2:
+		{
+			const GSVector4i a0 = y3.sub32(y2).sub32(y0).add32(y1);
+			const GSVector4i a1 = y0.sub32(y1).sub32(a0);
+			const GSVector4i a2 = y2.sub32(y0);
+
+			GSVector4i val = a0.mul32l(mu).sra32(12);
+			val = val.add32(a1).mul32l(mu).sra32(12);
+			val = val.add32(a2).mul32l(mu).sra32(12);
+			return val.add32(y1);
+		}
+		case 3:
+		{
+			// HermiteInterpolate<16384>, the multiply by the tension is a shift
+			const GSVector4i m00 = y1.sub32(y0).sll32(14).sra32(16);
+			const GSVector4i m01 = y2.sub32(y1).sll32(14).sra32(16);
+			const GSVector4i m0 = m00.add32(m01);
+			const GSVector4i m11 = y3.sub32(y2).sll32(14).sra32(16);
+			const GSVector4i m1 = m01.add32(m11);
+
+			GSVector4i val = y1.add32(y1).add32(m0).add32(m1).sub32(y2.add32(y2)).mul32l(mu).sra32(12);
+			val = val.sub32(y1.mul32l(three)).sub32(m0.add32(m0)).sub32(m1).add32(y2.mul32l(three)).mul32l(mu).sra32(12);
+			val = val.add32(m0).mul32l(mu).sra32(12);
+			return val.add32(y1);
+		}
+		case 4:
+		{
+			const GSVector4i a3 = y1.mul32l(three).sub32(y0).sub32(y2.mul32l(three)).add32(y3);
+			const GSVector4i a2 = y0.add32(y0).sub32(y1.mul32l(GSVector4i(5))).add32(y2.sll32(2)).sub32(y3);
+			const GSVector4i a1 = y2.sub32(y0);
+			const GSVector4i a0 = y1.add32(y1);
+
+			GSVector4i val = a3.mul32l(mu).sra32(12);
+			val = a2.add32(val).mul32l(mu).sra32(12);
+			val = a1.add32(val).mul32l(mu).sra32(12);
+			return a0.add32(val).sra32(1);
+		}
+		case 5:
+		{
+			GSVector4i out = GSVector4i::load<true>(&lanes.Gaussian[0][i]).mul32l(y0).sra32(15);
+			out = out.add32(GSVector4i::load<true>(&lanes.Gaussian[1][i]).mul32l(y1).sra32(15));
+			out = out.add32(GSVector4i::load<true>(&lanes.Gaussian[2][i]).mul32l(y2).sra32(15));
+			out = out.add32(GSVector4i::load<true>(&lanes.Gaussian[3][i]).mul32l(y3).sra32(15));
+			return out;
+		}
+
+			jNO_DEFAULT;
+	}
+
+	return GSVector4i::zero(); // technically unreachable!
+}
+
+// Fills lanes.Value with the enveloped voice outputs (OutX) and adds the gated, panned
+// outputs of all voices to dest.
+template <int InterpType>
+static __forceinline void MixVoiceLanes(VoiceLanes& lanes, VoiceMixSet& dest)
+{
+	GSVector4i dry_l = GSVector4i::zero();
+	GSVector4i dry_r = GSVector4i::zero();
+	GSVector4i wet_l = GSVector4i::zero();
+	GSVector4i wet_r = GSVector4i::zero();
+
+	for (uint i = 0; i < V_Core::NumVoices; i += 4)
+	{
+		const GSVector4i noise_mask = GSVector4i::load<true>(&lanes.NoiseMask[i]);
+		GSVector4i value = InterpolateLanes<InterpType>(lanes, i).blend8(GSVector4i::load<true>(&lanes.PV1[i]), noise_mask);
+
+		// ApplyVolume(): MulShr32(data << 1, volume)
+		value = value.sll32(1).mul32hs(GSVector4i::load<true>(&lanes.Envelope[i]));
+		GSVector4i::store<true>(&lanes.Value[i], value);
+
+		const GSVector4i value2 = value.sll32(1);
+		const GSVector4i out_l = value2.mul32hs(GSVector4i::load<true>(&lanes.VolumeL[i]));
+		const GSVector4i out_r = value2.mul32hs(GSVector4i::load<true>(&lanes.VolumeR[i]));
+
+		dry_l = dry_l.add32(out_l & GSVector4i::load<true>(&lanes.DryL[i]));
+		dry_r = dry_r.add32(out_r & GSVector4i::load<true>(&lanes.DryR[i]));
+		wet_l = wet_l.add32(out_l & GSVector4i::load<true>(&lanes.WetL[i]));
+		wet_r = wet_r.add32(out_r & GSVector4i::load<true>(&lanes.WetR[i]));
+	}
+
+	const auto hsum = [](const GSVector4i& v) {
+		return v.extract32<0>() + v.extract32<1>() + v.extract32<2>() + v.extract32<3>();
+	};
+	dest.Dry.Left += hsum(dry_l);
+	dest.Dry.Right += hsum(dry_r);
+	dest.Wet.Left += hsum(wet_l);
+	dest.Wet.Right += hsum(wet_r);
+}
@@ -32,7 +32,9 @@
 //#include "DebugTools/Breakpoints.h"
 #include "Host.h"
 #include "GS.h"
+#include "SaveStateContainer.h"
 
+#include "common/FileSystem.h"
 #include "common/pxStreams.h"
 #include "common/SafeArray.inl"
 #include "common/ScopedGuard.h"
@@ -58,6 +60,7 @@
 #endif
 
 #include "common/pxStreams.h"
+#include <wx/mstream.h>
 #include <wx/wfstream.h>
 #include <wx/zipstrm.h>
 
@@ -686,25 +689,60 @@ static const std::unique_ptr<BaseSavestateEntry> SavestateEntries[] = {
 //
 static Mutex mtx_CompressToDisk;
 
-static void CheckVersion(pxInputStream& thr)
+static void CheckVersion(u32 savever, const wxString& streamname)
 {
-	u32 savever;
-	thr.Read(savever);
-
 	// Major version mismatch.  Means we can't load this savestate at all.  Support for it
 	// was removed entirely.
 	if (savever > g_SaveVersion)
-		throw Exception::SaveStateLoadError(thr.GetStreamName())
+		throw Exception::SaveStateLoadError(streamname)
 		.SetDiagMsg(pxsFmt(L"Savestate uses an unsupported or unknown savestate version.\n(PCSX2 ver=%x, state ver=%x)", g_SaveVersion, savever))
 		.SetUserMsg(_("Cannot load this savestate. The state is an unsupported version."));
 
 	// check for a "minor" version incompatibility; which happens if the savestate being loaded is a newer version
 	// than the emulator recognizes.  99% chance that trying to load it will just corrupt emulation or crash.
 	if ((savever >> 16) != (g_SaveVersion >> 16))
-		throw Exception::SaveStateLoadError(thr.GetStreamName())
+		throw Exception::SaveStateLoadError(streamname)
 		.SetDiagMsg(pxsFmt(L"Savestate uses an unknown savestate version.\n(PCSX2 ver=%x, state ver=%x)", g_SaveVersion, savever))
 		.SetUserMsg(_("Cannot load this savestate. The state is an unsupported version."));
-};
+}
+
+static void CheckVersion(pxInputStream& thr)
+{
+	u32 savever;
+	thr.Read(savever);
+	CheckVersion(savever, thr.GetStreamName());
+}
+
+// Throws if the version or internal structures are missing, or any required entry wasn't found.
+static void CheckRequiredEntries(const wxString& filename, bool foundVersion, bool foundInternal, const bool* foundEntry)
+{
+	if (!foundVersion || !foundInternal)
+	{
+		throw Exception::SaveStateLoadError(filename)
+			.SetDiagMsg(pxsFmt(L"Savestate file does not contain '%s'",
+								  !foundVersion ? EntryFilename_StateVersion : EntryFilename_InternalStructures))
+			.SetUserMsg(_("This file is not a valid PCSX2 savestate.  See the logfile for details."));
+	}
+
+	// Log any parts and pieces that are missing, and then generate an exception.
+	bool throwIt = false;
+	for (uint i = 0; i < ArraySize(SavestateEntries); ++i)
+	{
+		if (foundEntry[i])
+			continue;
+
+		if (SavestateEntries[i]->IsRequired())
+		{
+			throwIt = true;
+			Console.WriteLn(Color_Red, " ... not found '%s'!", WX_STR(SavestateEntries[i]->GetFilename()));
+		}
+	}
+
+	if (throwIt)
+		throw Exception::SaveStateLoadError(filename)
+			.SetDiagMsg(L"Savestate cannot be loaded: some required components were not found or are incomplete.")
+			.SetUserMsg(_("This savestate cannot be loaded due to missing critical components.  See the log file for details."));
+}
 
 void SaveState_DownloadState(ArchiveEntryList* destlist)
 {
@@ -754,21 +792,16 @@ std::unique_ptr<SaveStateScreenshotData> SaveState_SaveScreenshot()
 	return data;
 }
 
-static bool SaveState_CompressScreenshot(SaveStateScreenshotData* data, wxZipOutputStream* gzfp)
+static bool SaveState_CompressScreenshot(SaveStateScreenshotData* data, std::vector<u8>* png)
 {
 	png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
 	png_infop info_ptr = nullptr;
 	if (!png_ptr)
 		return false;
 
-	wxZipEntry* const vent = new wxZipEntry(EntryFilename_Screenshot);
-	vent->SetMethod(wxZIP_METHOD_STORE);
-	gzfp->PutNextEntry(vent);
-
-	ScopedGuard cleanup([&png_ptr, &info_ptr, gzfp]() {
+	ScopedGuard cleanup([&png_ptr, &info_ptr]() {
 		if (png_ptr)
 			png_destroy_write_struct(&png_ptr, info_ptr ? &info_ptr : nullptr);
-		gzfp->CloseEntry();
 	});
 
 	info_ptr = png_create_info_struct(png_ptr);
@@ -778,8 +811,9 @@ static bool SaveState_CompressScreenshot(SaveStateScreenshotData* data, wxZipOut
 	if (setjmp(png_jmpbuf(png_ptr)))
 		return false;
 
-	png_set_write_fn(png_ptr, gzfp, [](png_structp png_ptr, png_bytep data_ptr, png_size_t size) {
-		((wxZipOutputStream*)png_get_io_ptr(png_ptr))->Write(data_ptr, size);
+	png_set_write_fn(png_ptr, png, [](png_structp png_ptr, png_bytep data_ptr, png_size_t size) {
+		std::vector<u8>* out = static_cast<std::vector<u8>*>(png_get_io_ptr(png_ptr));
+		out->insert(out->end(), data_ptr, data_ptr + size);
 	}, [](png_structp png_ptr) {});
 	png_set_compression_level(png_ptr, 5);
 	png_set_IHDR(png_ptr, info_ptr, data->width, data->height, 8, PNG_COLOR_TYPE_RGBA,
@@ -803,60 +837,40 @@ static bool SaveState_CompressScreenshot(SaveStateScreenshotData* data, wxZipOut
 // --------------------------------------------------------------------------------------
 //  CompressThread_VmState
 // --------------------------------------------------------------------------------------
-static void ZipStateToDiskOnThread(std::unique_ptr<ArchiveEntryList> srclist, std::unique_ptr<SaveStateScreenshotData> screenshot, std::unique_ptr<wxFFileOutputStream> outbase, wxString filename, wxString tempfile, s32 slot_for_message)
+static void CompressStateToDiskOnThread(std::unique_ptr<ArchiveEntryList> srclist, std::unique_ptr<SaveStateScreenshotData> screenshot, FileSystem::ManagedCFilePtr fp, wxString filename, wxString tempfile, s32 slot_for_message)
 {
 #ifndef PCSX2_CORE
 	wxGetApp().StartPendingSave();
 #endif
 
-	std::unique_ptr<pxOutputStream> out(new pxOutputStream(tempfile, new wxZipOutputStream(outbase.release())));
-	wxZipOutputStream* gzfp = (wxZipOutputStream*)out->GetWxStreamBase();
+	std::unique_ptr<SaveStateSnapshot> snapshot(SaveStateSnapshot::Create(*srclist, g_SaveVersion));
 
-	{
-		wxZipEntry* vent = new wxZipEntry(EntryFilename_StateVersion);
-		vent->SetMethod(wxZIP_METHOD_STORE);
-		gzfp->PutNextEntry(vent);
-		out->Write(g_SaveVersion);
-		gzfp->CloseEntry();
-	}
+	std::vector<u8> png;
+	if (screenshot && SaveState_CompressScreenshot(screenshot.get(), &png))
+		snapshot->AddStoredSection(StringUtil::wxStringToUTF8String(EntryFilename_Screenshot), std::move(png));
 
-	if (screenshot)
-		SaveState_CompressScreenshot(screenshot.get(), gzfp);
+	const bool written = snapshot->WriteToFile(fp.get());
+	fp.reset();
 
-	uint listlen = srclist->GetLength();
-	for (uint i = 0; i < listlen; ++i)
+	if (!written)
 	{
-		const ArchiveEntry& entry = (*srclist)[i];
-		if (!entry.GetDataSize())
-			continue;
-
-		gzfp->PutNextEntry(entry.GetFilename());
-
-		static const uint BlockSize = 0x64000;
-		uint curidx = 0;
-
-		do
-		{
-			uint thisBlockSize = std::min(BlockSize, entry.GetDataSize() - curidx);
-			gzfp->Write(srclist->GetPtr(entry.GetDataIndex() + curidx), thisBlockSize);
-			curidx += thisBlockSize;
-		} while (curidx < entry.GetDataSize());
-
-		gzfp->CloseEntry();
+		Console.Error("Failed to write save state '%s'", static_cast<const char*>(tempfile.c_str()));
+		FileSystem::DeleteFilePath(StringUtil::wxStringToUTF8String(tempfile).c_str());
+#ifndef PCSX2_CORE
+		Msgbox::Alert(_("The savestate was not properly saved. The temporary file could not be written."));
+#endif
 	}
-
-	gzfp->Close();
-
-	if (!wxRenameFile(out->GetStreamName(), filename, true))
+	else if (!wxRenameFile(tempfile, filename, true))
 	{
-		Console.Error("Failed to rename save state '%s' to '%s'", static_cast<const char*>(out->GetStreamName().c_str()), static_cast<const char*>(filename.c_str()));
+		Console.Error("Failed to rename save state '%s' to '%s'", static_cast<const char*>(tempfile.c_str()), static_cast<const char*>(filename.c_str()));
 #ifndef PCSX2_CORE
 		Msgbox::Alert(_("The savestate was not properly saved. The temporary file was created successfully but could not be moved to its final resting place."));
 #endif
 	}
 	else
 	{
-		Console.WriteLn("(gzipThread) Data saved to disk without error.");
+		Console.WriteLn("(CompressThread) Data saved to disk without error (%zu KB, %zu KB uncompressed).",
+			snapshot->GetCompressedSize() / 1024, snapshot->GetUncompressedSize() / 1024);
 	}
 
 #ifdef PCSX2_CORE
@@ -875,21 +889,100 @@ void SaveState_ZipToDisk(ArchiveEntryList* srclist, std::unique_ptr<SaveStateScr
 	std::unique_ptr<ArchiveEntryList> elist(srclist);
 
 	wxString tempfile(filename + L".tmp");
-	std::unique_ptr<wxFFileOutputStream> out = std::make_unique<wxFFileOutputStream>(tempfile);
-	if (!out->IsOk())
+	FileSystem::ManagedCFilePtr fp(FileSystem::OpenManagedCFile(StringUtil::wxStringToUTF8String(tempfile).c_str(), "wb"));
+	if (!fp)
 		throw Exception::CannotCreateStream(tempfile);
 
-//	std::thread threaded_save(ZipStateToDiskOnThread, std::move(elist), std::move(screenshot), std::move(out), filename, tempfile, slot_for_message);
+//	std::thread threaded_save(CompressStateToDiskOnThread, std::move(elist), std::move(screenshot), std::move(fp), filename, tempfile, slot_for_message);
 //	threaded_save.detach();
 
-    // zip work
-    ZipStateToDiskOnThread(std::move(elist), std::move(screenshot), std::move(out), filename, tempfile, slot_for_message);
+    // compress work
+    CompressStateToDiskOnThread(std::move(elist), std::move(screenshot), std::move(fp), filename, tempfile, slot_for_message);
+}
+
+void SaveState_LoadSnapshot(const SaveStateSnapshot& snapshot, const wxString& filename)
+{
+	CheckVersion(snapshot.GetVersion(), filename);
+
+	const std::vector<SaveStateSnapshot::Section>& sections = snapshot.GetSections();
+	const auto find_section = [&snapshot, &sections](const wxString& name) {
+		const SaveStateSnapshot::Section* section = snapshot.FindSection(StringUtil::wxStringToUTF8String(name));
+		return section ? static_cast<int>(section - sections.data()) : -1;
+	};
+
+	const int foundInternal = find_section(EntryFilename_InternalStructures);
+	int foundEntry[ArraySize(SavestateEntries)];
+	bool haveEntry[ArraySize(SavestateEntries)];
+	for (uint i = 0; i < ArraySize(SavestateEntries); ++i)
+	{
+		foundEntry[i] = find_section(SavestateEntries[i]->GetFilename());
+		haveEntry[i] = (foundEntry[i] >= 0);
+	}
+
+	CheckRequiredEntries(filename, true, foundInternal >= 0, haveEntry);
+
+	// Decompress everything before touching the VM, so a damaged state leaves it running.
+	std::vector<std::vector<u8>> data;
+	if (!snapshot.Decompress(&data))
+	{
+		throw Exception::SaveStateLoadError(filename)
+			.SetDiagMsg(L"Savestate data failed to decompress or does not match its chunk hashes.")
+			.SetUserMsg(_("This savestate cannot be loaded because its data is corrupted."));
+	}
+
+#ifndef PCSX2_CORE
+	PatchesVerboseReset();
+#endif
+	SysClearExecutionCache();
+
+	for (uint i = 0; i < ArraySize(SavestateEntries); ++i)
+	{
+		if (!haveEntry[i])
+			continue;
+
+		Threading::pxTestCancel();
+
+		std::vector<u8>& entry = data[foundEntry[i]];
+		pxInputStream reader(filename, new wxMemoryInputStream(entry.data(), entry.size()));
+		SavestateEntries[i]->FreezeIn(reader);
+	}
+
+	// Load all the internal data
+
+	const std::vector<u8>& internal = data[foundInternal];
+	VmStateBuffer buffer(internal.size(), L"StateBuffer_LoadSnapshot");
+	std::memcpy(buffer.GetPtr(), internal.data(), internal.size());
+
+	memLoadingState(buffer).FreezeBios().FreezeInternals();
 }
 
 void SaveState_UnzipFromDisk(const wxString& filename)
 {
 	ScopedLock lock(mtx_CompressToDisk);
 
+	{
+		FileSystem::ManagedCFilePtr fp(FileSystem::OpenManagedCFile(StringUtil::wxStringToUTF8String(filename).c_str(), "rb"));
+		if (!fp)
+			throw Exception::CannotCreateStream(filename).SetDiagMsg(L"Cannot open file for reading.");
+
+		if (SaveStateSnapshot::IsSnapshotFile(fp.get()))
+		{
+			std::unique_ptr<SaveStateSnapshot> snapshot(SaveStateSnapshot::ReadFromFile(fp.get()));
+			if (!snapshot)
+			{
+				throw Exception::SaveStateLoadError(filename)
+					.SetDiagMsg(L"Savestate file is truncated or has an invalid chunk table.")
+					.SetUserMsg(_("This savestate cannot be loaded because it is corrupted."));
+			}
+
+			fp.reset();
+			SaveState_LoadSnapshot(*snapshot, filename);
+			return;
+		}
+	}
+
+	// Savestates from older versions are zip archives.
+
 	// Ugh.  Exception handling made crappy because wxWidgets classes don't support scoped pointers yet.
 
 	std::unique_ptr<wxFFileInputStream> woot(new wxFFileInputStream(filename));
@@ -958,32 +1051,11 @@ void SaveState_UnzipFromDisk(const wxString& filename)
 		}
 	}
 
-	if (!foundVersion || !foundInternal)
-	{
-		throw Exception::SaveStateLoadError(filename)
-			.SetDiagMsg(pxsFmt(L"Savestate file does not contain '%s'",
-								  !foundVersion ? EntryFilename_StateVersion : EntryFilename_InternalStructures))
-			.SetUserMsg(_("This file is not a valid PCSX2 savestate.  See the logfile for details."));
-	}
-
-	// Log any parts and pieces that are missing, and then generate an exception.
-	bool throwIt = false;
+	bool haveEntry[ArraySize(SavestateEntries)];
 	for (uint i = 0; i < ArraySize(SavestateEntries); ++i)
-	{
-		if (foundEntry[i])
-			continue;
+		haveEntry[i] = static_cast<bool>(foundEntry[i]);
 
-		if (SavestateEntries[i]->IsRequired())
-		{
-			throwIt = true;
-			Console.WriteLn(Color_Red, " ... not found '%s'!", WX_STR(SavestateEntries[i]->GetFilename()));
-		}
-	}
-
-	if (throwIt)
-		throw Exception::SaveStateLoadError(filename)
-			.SetDiagMsg(L"Savestate cannot be loaded: some required components were not found or are incomplete.")
-			.SetUserMsg(_("This savestate cannot be loaded due to missing critical components.  See the log file for details."));
+	CheckRequiredEntries(filename, foundVersion, static_cast<bool>(foundInternal), haveEntry);
 
 #ifndef PCSX2_CORE
 	PatchesVerboseReset();
@@ -1010,3 +1082,38 @@ void SaveState_UnzipFromDisk(const wxString& filename)
 
 	memLoadingState(buffer).FreezeBios().FreezeInternals();
 }
+
+bool SaveState_ReadScreenshot(const std::string& filename, std::vector<u8>* png)
+{
+	{
+		FileSystem::ManagedCFilePtr fp(FileSystem::OpenManagedCFile(filename.c_str(), "rb"));
+		if (!fp)
+			return false;
+
+		if (SaveStateSnapshot::IsSnapshotFile(fp.get()))
+			return SaveStateSnapshot::ReadSectionFromFile(fp.get(), StringUtil::wxStringToUTF8String(EntryFilename_Screenshot), png);
+	}
+
+	std::unique_ptr<wxZipInputStream> gzreader(new wxZipInputStream(new wxFFileInputStream(StringUtil::UTF8StringToWxString(filename))));
+	if (!gzreader->IsOk())
+		return false;
+
+	while (true)
+	{
+		std::unique_ptr<wxZipEntry> entry(gzreader->GetNextEntry());
+		if (!entry)
+			break;
+
+		if (entry->GetName().CmpNoCase(EntryFilename_Screenshot) != 0)
+			continue;
+
+		if (!gzreader->OpenEntry(*entry))
+			return false;
+
+		png->resize(entry->GetSize());
+		gzreader->Read(png->data(), png->size());
+		return gzreader->LastRead() == png->size();
+	}
+
+	return false;
+}
@@ -53,6 +53,7 @@ struct SaveStateScreenshotData
 };
 
 class ArchiveEntryList;
+class SaveStateSnapshot;
 
 // Wrappers to generate a save state compatible across all frontends.
 // These functions assume that the caller has paused the core thread.
@@ -60,6 +61,10 @@ extern void SaveState_DownloadState(ArchiveEntryList* destlist);
 extern std::unique_ptr<SaveStateScreenshotData> SaveState_SaveScreenshot();
 extern void SaveState_ZipToDisk(ArchiveEntryList* srclist, std::unique_ptr<SaveStateScreenshotData> screenshot, const wxString& filename, s32 slot_for_message);
 extern void SaveState_UnzipFromDisk(const wxString& filename);
+// Loads a state which was captured with SaveStateSnapshot::Create(), name is only used for error messages.
+extern void SaveState_LoadSnapshot(const SaveStateSnapshot& snapshot, const wxString& name);
+// Reads the screenshot PNG stored in a savestate file, without loading the state.
+extern bool SaveState_ReadScreenshot(const std::string& filename, std::vector<u8>* png);
 
 // --------------------------------------------------------------------------------------
 //  SaveStateBase class
@@ -290,6 +295,12 @@ public:
 		return *this;
 	}
 
+	// Forgets the entries, but keeps the buffer around so it can be filled again.
+	void Clear()
+	{
+		m_list.clear();
+	}
+
 	size_t GetLength() const
 	{
 		return m_list.size();
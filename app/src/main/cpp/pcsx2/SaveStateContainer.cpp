@@ -0,0 +1,505 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+
+#include "SaveStateContainer.h"
+#include "SaveState.h"
+
+#include "common/FileSystem.h"
+#include "common/StringUtil.h"
+
+#include "3rdparty/zstd/zstd/lib/zstd.h"
+
+#define XXH_STATIC_LINKING_ONLY 1
+#define XXH_INLINE_ALL 1
+#include "xxhash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <unordered_set>
+
+// File layout:
+//   header     magic, container version, savestate version, section count
+//   sections   name length, name, uncompressed size, chunk count
+//   chunks     hash, uncompressed size, data size (top bit set when stored uncompressed)
+//   data       chunk data, in the same order as the chunk table
+static constexpr u32 SNAPSHOT_MAGIC = 0x53533250; // P2SS
+static constexpr u32 SNAPSHOT_CONTAINER_VERSION = 1;
+static constexpr u32 SNAPSHOT_CHUNK_STORED = 0x80000000u;
+
+static constexpr u32 MAX_SECTIONS = 256;
+static constexpr u32 MAX_SECTION_NAME_LENGTH = 256;
+// Far more than any machine state, they only keep corrupt headers from asking for huge tables.
+static constexpr u32 MAX_SECTION_SIZE = 256 * _1mb;
+static constexpr u64 MAX_SNAPSHOT_SIZE = 512 * _1mb;
+
+namespace
+{
+	struct FileHeader
+	{
+		u32 magic;
+		u32 container_version;
+		u32 version;
+		u32 section_count;
+	};
+	static_assert(sizeof(FileHeader) == 16);
+} // namespace
+
+static u32 GetWorkerCount(size_t jobs)
+{
+	const u32 threads = std::clamp(std::thread::hardware_concurrency(), 1u, 8u);
+	return static_cast<u32>(std::min<size_t>(threads, std::max<size_t>(jobs, 1)));
+}
+
+// Runs job(worker, index) for every index in [0, count), spread over workers threads.
+// The calling thread is worker 0.
+static void RunJobs(size_t count, u32 workers, const std::function<void(u32, size_t)>& job)
+{
+	std::atomic<size_t> next{0};
+	const auto run = [&next, &job, count](u32 worker) {
+		for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count; i = next.fetch_add(1, std::memory_order_relaxed))
+			job(worker, i);
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(workers - 1);
+	for (u32 i = 1; i < workers; i++)
+		threads.emplace_back(run, i);
+
+	run(0);
+
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+static bool SectionNameEquals(const SaveStateSnapshot::Section& section, const std::string_view& name)
+{
+	return section.name.length() == name.length() &&
+		   StringUtil::Strncasecmp(section.name.data(), name.data(), name.length()) == 0;
+}
+
+SaveStateSnapshot::SaveStateSnapshot(u32 version)
+	: m_version(version)
+{
+}
+
+SaveStateSnapshot::~SaveStateSnapshot() = default;
+
+std::unique_ptr<SaveStateSnapshot> SaveStateSnapshot::Create(const ArchiveEntryList& list, u32 version,
+	const SaveStateSnapshot* base, int level, u32 chunk_size)
+{
+	pxAssert(chunk_size >= MIN_CHUNK_SIZE && chunk_size <= MAX_CHUNK_SIZE);
+
+	struct Job
+	{
+		u32 section;
+		u32 chunk;
+		const u8* src;
+		const Chunk* base_chunk;
+	};
+
+	std::unique_ptr<SaveStateSnapshot> snapshot = std::make_unique<SaveStateSnapshot>(version);
+	std::vector<Job> jobs;
+
+	snapshot->m_sections.reserve(list.GetLength());
+	for (size_t i = 0; i < list.GetLength(); i++)
+	{
+		const ArchiveEntry& entry = list[i];
+		Section& section = snapshot->m_sections.emplace_back();
+		section.name = StringUtil::wxStringToUTF8String(entry.GetFilename());
+		section.size = entry.GetDataSize();
+		section.chunks.resize((section.size + chunk_size - 1) / chunk_size);
+		if (section.chunks.empty())
+			continue;
+
+		const Section* base_section = base ? base->FindSection(section.name) : nullptr;
+		const u8* src = list.GetPtr(entry.GetDataIndex());
+		for (u32 j = 0; j < static_cast<u32>(section.chunks.size()); j++)
+		{
+			const Chunk* base_chunk = (base_section && j < base_section->chunks.size()) ? &base_section->chunks[j] : nullptr;
+			jobs.push_back({static_cast<u32>(i), j, src + static_cast<size_t>(j) * chunk_size, base_chunk});
+		}
+	}
+
+	const u32 workers = GetWorkerCount(jobs.size());
+	std::vector<ZSTD_CCtx*> cctxs(workers);
+	std::vector<std::vector<u8>> scratch(workers);
+	for (u32 i = 0; i < workers; i++)
+	{
+		cctxs[i] = ZSTD_createCCtx();
+		scratch[i].resize(ZSTD_compressBound(chunk_size));
+	}
+
+	RunJobs(jobs.size(), workers, [&](u32 worker, size_t index) {
+		const Job& job = jobs[index];
+		const Section& section = snapshot->m_sections[job.section];
+		Chunk& chunk = snapshot->m_sections[job.section].chunks[job.chunk];
+		chunk.size = std::min(chunk_size, section.size - job.chunk * chunk_size);
+		chunk.hash = XXH3_64bits(job.src, chunk.size);
+
+		// Unchanged since the base snapshot, no need to compress it again.
+		if (job.base_chunk && job.base_chunk->size == chunk.size && job.base_chunk->hash == chunk.hash)
+		{
+			chunk.compressed = job.base_chunk->compressed;
+			chunk.data = job.base_chunk->data;
+			return;
+		}
+
+		std::vector<u8>& out = scratch[worker];
+		const size_t res = cctxs[worker] ? ZSTD_compressCCtx(cctxs[worker], out.data(), out.size(), job.src, chunk.size, level) : 0;
+		chunk.compressed = (cctxs[worker] && !ZSTD_isError(res) && res < chunk.size);
+		if (chunk.compressed)
+			chunk.data = std::make_shared<const std::vector<u8>>(out.begin(), out.begin() + res);
+		else
+			chunk.data = std::make_shared<const std::vector<u8>>(job.src, job.src + chunk.size);
+	});
+
+	for (ZSTD_CCtx* cctx : cctxs)
+		ZSTD_freeCCtx(cctx);
+
+	return snapshot;
+}
+
+void SaveStateSnapshot::AddStoredSection(std::string name, std::vector<u8> data)
+{
+	Section& section = m_sections.emplace_back();
+	section.name = std::move(name);
+	section.size = static_cast<u32>(data.size());
+
+	for (u32 offset = 0; offset < section.size; offset += CHUNK_SIZE)
+	{
+		Chunk& chunk = section.chunks.emplace_back();
+		chunk.size = std::min(CHUNK_SIZE, section.size - offset);
+		chunk.hash = XXH3_64bits(&data[offset], chunk.size);
+		chunk.compressed = false;
+		chunk.data = std::make_shared<const std::vector<u8>>(data.begin() + offset, data.begin() + offset + chunk.size);
+	}
+}
+
+const SaveStateSnapshot::Section* SaveStateSnapshot::FindSection(const std::string_view& name) const
+{
+	for (const Section& section : m_sections)
+	{
+		if (SectionNameEquals(section, name))
+			return &section;
+	}
+
+	return nullptr;
+}
+
+bool SaveStateSnapshot::DecompressChunk(void* dctx, const Chunk& chunk, u8* dest)
+{
+	if (!chunk.compressed)
+	{
+		if (chunk.data->size() != chunk.size)
+			return false;
+
+		std::memcpy(dest, chunk.data->data(), chunk.size);
+	}
+	else
+	{
+		const size_t res = ZSTD_decompressDCtx(static_cast<ZSTD_DCtx*>(dctx), dest, chunk.size, chunk.data->data(), chunk.data->size());
+		if (ZSTD_isError(res) || res != chunk.size)
+			return false;
+	}
+
+	// The frames are written without a zstd checksum, and stored chunks have none at all,
+	// so damaged data is only caught by comparing against the hash taken when it was saved.
+	return XXH3_64bits(dest, chunk.size) == chunk.hash;
+}
+
+bool SaveStateSnapshot::Decompress(std::vector<std::vector<u8>>* sections) const
+{
+	struct Job
+	{
+		const Chunk* chunk;
+		u8* dest;
+	};
+
+	std::vector<Job> jobs;
+	sections->resize(m_sections.size());
+	for (size_t i = 0; i < m_sections.size(); i++)
+	{
+		const Section& section = m_sections[i];
+		std::vector<u8>& dest = (*sections)[i];
+		dest.resize(section.size);
+
+		size_t offset = 0;
+		for (const Chunk& chunk : section.chunks)
+		{
+			jobs.push_back({&chunk, dest.data() + offset});
+			offset += chunk.size;
+		}
+	}
+
+	const u32 workers = GetWorkerCount(jobs.size());
+	std::vector<ZSTD_DCtx*> dctxs(workers);
+	for (u32 i = 0; i < workers; i++)
+		dctxs[i] = ZSTD_createDCtx();
+
+	std::atomic_bool okay{true};
+	RunJobs(jobs.size(), workers, [&](u32 worker, size_t index) {
+		if (!dctxs[worker] || !DecompressChunk(dctxs[worker], *jobs[index].chunk, jobs[index].dest))
+			okay.store(false, std::memory_order_relaxed);
+	});
+
+	for (ZSTD_DCtx* dctx : dctxs)
+		ZSTD_freeDCtx(dctx);
+
+	return okay.load();
+}
+
+size_t SaveStateSnapshot::GetCompressedSize(const SaveStateSnapshot* base) const
+{
+	std::unordered_set<const std::vector<u8>*> shared;
+	if (base)
+	{
+		for (const Section& section : base->m_sections)
+		{
+			for (const Chunk& chunk : section.chunks)
+				shared.insert(chunk.data.get());
+		}
+	}
+
+	size_t size = 0;
+	for (const Section& section : m_sections)
+	{
+		for (const Chunk& chunk : section.chunks)
+		{
+			if (shared.find(chunk.data.get()) == shared.end())
+				size += chunk.data->size();
+		}
+	}
+
+	return size;
+}
+
+size_t SaveStateSnapshot::GetUncompressedSize() const
+{
+	size_t size = 0;
+	for (const Section& section : m_sections)
+		size += section.size;
+
+	return size;
+}
+
+bool SaveStateSnapshot::WriteToFile(std::FILE* fp) const
+{
+	std::vector<u8> table;
+	const auto append = [&table](const void* data, size_t size) {
+		const u8* bytes = static_cast<const u8*>(data);
+		table.insert(table.end(), bytes, bytes + size);
+	};
+
+	const FileHeader header = {SNAPSHOT_MAGIC, SNAPSHOT_CONTAINER_VERSION, m_version, static_cast<u32>(m_sections.size())};
+	append(&header, sizeof(header));
+
+	for (const Section& section : m_sections)
+	{
+		const u32 name_length = static_cast<u32>(section.name.length());
+		const u32 chunk_count = static_cast<u32>(section.chunks.size());
+		append(&name_length, sizeof(name_length));
+		append(section.name.data(), name_length);
+		append(&section.size, sizeof(section.size));
+		append(&chunk_count, sizeof(chunk_count));
+	}
+
+	for (const Section& section : m_sections)
+	{
+		for (const Chunk& chunk : section.chunks)
+		{
+			const u32 data_size = static_cast<u32>(chunk.data->size()) | (chunk.compressed ? 0 : SNAPSHOT_CHUNK_STORED);
+			append(&chunk.hash, sizeof(chunk.hash));
+			append(&chunk.size, sizeof(chunk.size));
+			append(&data_size, sizeof(data_size));
+		}
+	}
+
+	if (std::fwrite(table.data(), table.size(), 1, fp) != 1)
+		return false;
+
+	for (const Section& section : m_sections)
+	{
+		for (const Chunk& chunk : section.chunks)
+		{
+			if (!chunk.data->empty() && std::fwrite(chunk.data->data(), chunk.data->size(), 1, fp) != 1)
+				return false;
+		}
+	}
+
+	return std::fflush(fp) == 0;
+}
+
+bool SaveStateSnapshot::IsSnapshotFile(std::FILE* fp)
+{
+	u32 magic = 0;
+	const bool okay = std::fread(&magic, sizeof(magic), 1, fp) == 1 && magic == SNAPSHOT_MAGIC;
+	FileSystem::FSeek64(fp, 0, SEEK_SET);
+	return okay;
+}
+
+// Reads the header and tables, leaving the file positioned at the start of the chunk data.
+// Chunks are returned without data, data_sizes holds the stored size of each in file order.
+static bool ReadSnapshotTable(std::FILE* fp, u32* version, std::vector<SaveStateSnapshot::Section>* sections, std::vector<u32>* data_sizes)
+{
+	const auto read = [fp](void* data, size_t size) {
+		return size == 0 || std::fread(data, size, 1, fp) == 1;
+	};
+
+	FileHeader header;
+	if (!read(&header, sizeof(header)) || header.magic != SNAPSHOT_MAGIC ||
+		header.container_version != SNAPSHOT_CONTAINER_VERSION || header.section_count > MAX_SECTIONS)
+	{
+		return false;
+	}
+
+	*version = header.version;
+	sections->resize(header.section_count);
+	u64 snapshot_size = 0;
+	for (SaveStateSnapshot::Section& section : *sections)
+	{
+		u32 name_length, chunk_count;
+		if (!read(&name_length, sizeof(name_length)) || name_length > MAX_SECTION_NAME_LENGTH)
+			return false;
+
+		section.name.resize(name_length);
+		if (!read(section.name.data(), name_length) || !read(&section.size, sizeof(section.size)) ||
+			!read(&chunk_count, sizeof(chunk_count)))
+		{
+			return false;
+		}
+
+		// All chunks but the last of a section are the chunk size it was created with, which is
+		// between MIN_CHUNK_SIZE and MAX_CHUNK_SIZE. Checked before the table is allocated.
+		snapshot_size += section.size;
+		if (section.size > MAX_SECTION_SIZE || snapshot_size > MAX_SNAPSHOT_SIZE ||
+			chunk_count < (section.size + SaveStateSnapshot::MAX_CHUNK_SIZE - 1) / SaveStateSnapshot::MAX_CHUNK_SIZE ||
+			chunk_count > (section.size + SaveStateSnapshot::MIN_CHUNK_SIZE - 1) / SaveStateSnapshot::MIN_CHUNK_SIZE)
+		{
+			return false;
+		}
+
+		section.chunks.resize(chunk_count);
+	}
+
+	const size_t max_data_size = ZSTD_compressBound(SaveStateSnapshot::MAX_CHUNK_SIZE);
+	for (SaveStateSnapshot::Section& section : *sections)
+	{
+		u64 total = 0;
+		for (SaveStateSnapshot::Chunk& chunk : section.chunks)
+		{
+			u32 data_size;
+			if (!read(&chunk.hash, sizeof(chunk.hash)) || !read(&chunk.size, sizeof(chunk.size)) ||
+				!read(&data_size, sizeof(data_size)))
+			{
+				return false;
+			}
+
+			chunk.compressed = !(data_size & SNAPSHOT_CHUNK_STORED);
+			data_size &= ~SNAPSHOT_CHUNK_STORED;
+			if (chunk.size == 0 || chunk.size > SaveStateSnapshot::MAX_CHUNK_SIZE || data_size > max_data_size ||
+				(!chunk.compressed && data_size != chunk.size))
+			{
+				return false;
+			}
+
+			data_sizes->push_back(data_size);
+			total += chunk.size;
+		}
+
+		if (total != section.size)
+			return false;
+	}
+
+	return true;
+}
+
+static bool ReadChunkData(std::FILE* fp, SaveStateSnapshot::Chunk* chunk, u32 data_size)
+{
+	std::vector<u8> data(data_size);
+	if (data_size > 0 && std::fread(data.data(), data_size, 1, fp) != 1)
+		return false;
+
+	chunk->data = std::make_shared<const std::vector<u8>>(std::move(data));
+	return true;
+}
+
+std::unique_ptr<SaveStateSnapshot> SaveStateSnapshot::ReadFromFile(std::FILE* fp)
+{
+	u32 version;
+	std::vector<Section> sections;
+	std::vector<u32> data_sizes;
+	if (!ReadSnapshotTable(fp, &version, &sections, &data_sizes))
+		return nullptr;
+
+	size_t index = 0;
+	for (Section& section : sections)
+	{
+		for (Chunk& chunk : section.chunks)
+		{
+			if (!ReadChunkData(fp, &chunk, data_sizes[index++]))
+				return nullptr;
+		}
+	}
+
+	std::unique_ptr<SaveStateSnapshot> snapshot = std::make_unique<SaveStateSnapshot>(version);
+	snapshot->m_sections = std::move(sections);
+	return snapshot;
+}
+
+bool SaveStateSnapshot::ReadSectionFromFile(std::FILE* fp, const std::string_view& name, std::vector<u8>* data)
+{
+	u32 version;
+	std::vector<Section> sections;
+	std::vector<u32> data_sizes;
+	if (!ReadSnapshotTable(fp, &version, &sections, &data_sizes))
+		return false;
+
+	size_t index = 0;
+	for (Section& section : sections)
+	{
+		if (!SectionNameEquals(section, name))
+		{
+			for (size_t i = 0; i < section.chunks.size(); i++)
+			{
+				if (FileSystem::FSeek64(fp, data_sizes[index++], SEEK_CUR) != 0)
+					return false;
+			}
+			continue;
+		}
+
+		ZSTD_DCtx* dctx = ZSTD_createDCtx();
+		if (!dctx)
+			return false;
+
+		bool okay = true;
+		size_t offset = 0;
+		data->resize(section.size);
+		for (Chunk& chunk : section.chunks)
+		{
+			okay = okay && ReadChunkData(fp, &chunk, data_sizes[index++]) && DecompressChunk(dctx, chunk, data->data() + offset);
+			offset += chunk.size;
+		}
+
+		ZSTD_freeDCtx(dctx);
+		return okay;
+	}
+
+	return false;
+}
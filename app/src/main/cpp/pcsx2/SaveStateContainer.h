@@ -0,0 +1,99 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/Pcsx2Defs.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ArchiveEntryList;
+
+/// Compressed savestate, split into named sections which are in turn split into fixed size chunks.
+/// Chunks are compressed independently with zstd, so they can be compressed and decompressed on
+/// several threads at once, and a snapshot created against a base snapshot shares the compressed
+/// data of every chunk which didn't change. Snapshots are immutable once created.
+class SaveStateSnapshot
+{
+public:
+	static constexpr u32 CHUNK_SIZE = 256 * 1024;
+	static constexpr u32 MIN_CHUNK_SIZE = 4 * 1024;
+	static constexpr u32 MAX_CHUNK_SIZE = 1024 * 1024;
+	static constexpr int DEFAULT_COMPRESSION_LEVEL = 3;
+
+	struct Chunk
+	{
+		u64 hash;
+		u32 size;
+		bool compressed;
+		std::shared_ptr<const std::vector<u8>> data;
+	};
+
+	struct Section
+	{
+		std::string name;
+		u32 size;
+		std::vector<Chunk> chunks;
+	};
+
+	SaveStateSnapshot(u32 version);
+	~SaveStateSnapshot();
+
+	SaveStateSnapshot(const SaveStateSnapshot&) = delete;
+	SaveStateSnapshot& operator=(const SaveStateSnapshot&) = delete;
+
+	/// Compresses every entry of list into its own section. When base is given, chunks which are
+	/// identical to the chunk at the same place in base reuse its compressed data. Smaller chunks
+	/// share more between snapshots, at the cost of compression ratio and per chunk overhead.
+	static std::unique_ptr<SaveStateSnapshot> Create(const ArchiveEntryList& list, u32 version,
+		const SaveStateSnapshot* base = nullptr, int level = DEFAULT_COMPRESSION_LEVEL, u32 chunk_size = CHUNK_SIZE);
+
+	/// Returns true if the file starts with the container signature. Leaves the file position at the start.
+	static bool IsSnapshotFile(std::FILE* fp);
+
+	/// Reads a whole snapshot from a file written by WriteToFile(). Returns nullptr if it's invalid.
+	static std::unique_ptr<SaveStateSnapshot> ReadFromFile(std::FILE* fp);
+
+	/// Reads and decompresses a single section without loading the rest of the file.
+	static bool ReadSectionFromFile(std::FILE* fp, const std::string_view& name, std::vector<u8>* data);
+
+	/// Adds a section which is stored as-is, for data which is already compressed.
+	void AddStoredSection(std::string name, std::vector<u8> data);
+
+	bool WriteToFile(std::FILE* fp) const;
+
+	u32 GetVersion() const { return m_version; }
+	const std::vector<Section>& GetSections() const { return m_sections; }
+	const Section* FindSection(const std::string_view& name) const;
+
+	/// Decompresses all sections, one buffer per section in the order of GetSections().
+	/// Returns false if any chunk fails to decode or doesn't match its hash.
+	bool Decompress(std::vector<std::vector<u8>>* sections) const;
+
+	/// Size of the compressed data which isn't shared with base.
+	size_t GetCompressedSize(const SaveStateSnapshot* base = nullptr) const;
+	size_t GetUncompressedSize() const;
+
+private:
+	/// Decodes chunk into dest and checks it against the chunk hash.
+	static bool DecompressChunk(void* dctx, const Chunk& chunk, u8* dest);
+
+	u32 m_version;
+	std::vector<Section> m_sections;
+};
@@ -38,11 +38,13 @@
 #include "HostDisplay.h"
 #include "HostSettings.h"
 #include "IopBios.h"
+#include "IPU/IPU.h"
 #include "MTVU.h"
 #include "MemoryCardFile.h"
 #include "Patch.h"
 #include "PerformanceMetrics.h"
 #include "R5900.h"
+#include "Rewind.h"
 #include "SPU2/spu2.h"
 #include "DEV9/DEV9.h"
 #include "System/SysThreads.h"
@@ -651,6 +653,7 @@ bool VMManager::Initialize(const VMBootParameters& boot_params)
     SetEmuThreadAffinities(true);
 
     PerformanceMetrics::Clear();
+	Rewind::Reset();
 
 	// do we want to load state?
 	if (!boot_params.save_state.empty())
@@ -676,6 +679,7 @@ void VMManager::Shutdown(bool allow_save_resume_state /* = true */)
         vu1Thread.WaitVU();
     }
 	GetMTGS().WaitGS();
+	ipuThreadShutdown();
 
 	if (allow_save_resume_state && ShouldSaveResumeState())
 	{
@@ -705,6 +709,7 @@ void VMManager::Shutdown(bool allow_save_resume_state /* = true */)
 	a64_setfpcr(s_mxcsr_saved);
 #endif
 
+	Rewind::Shutdown();
 	ForgetLoadedPatches();
 	R3000A::ioman::reset();
 	USBclose();
@@ -735,6 +740,7 @@ void VMManager::Reset()
 	UpdateVSyncRate();
 	frameLimitReset();
 	cpuReset();
+	Rewind::Reset();
 
 	// gameid change, so apply settings
 	if (game_was_started)
@@ -807,6 +813,7 @@ bool VMManager::DoLoadState(const char* filename)
 	{
 		SaveState_UnzipFromDisk(wxString::FromUTF8(filename));
 		UpdateRunningGame(false);
+		Rewind::Reset();
 		return true;
 	}
 	catch (Exception::BaseException& e) {
@@ -841,6 +848,24 @@ bool VMManager::LoadState(const char* filename)
 	return false;
 }
 
+bool VMManager::RewindState(u32 steps)
+{
+	try
+	{
+		if (!Rewind::LoadSnapshot(steps))
+			return false;
+
+		UpdateRunningGame(false);
+		return true;
+	}
+	catch (Exception::BaseException& e)
+	{
+		Host::AddFormattedOSDMessage(15.0f, "Failed to rewind: %s", static_cast<const char*>(e.DiagMsg().c_str()));
+		Rewind::Reset();
+		return false;
+	}
+}
+
 bool VMManager::LoadStateFromSlot(s32 slot)
 {
 	std::string filename(GetCurrentSaveStateFileNameSerial(slot));
@@ -988,6 +1013,7 @@ void VMManager::Internal::VSyncOnCPUThread()
 	// TODO: Move frame limiting here to reduce CPU usage after sleeping...
 	ApplyLoadedPatches(PPT_CONTINUOUSLY);
 	ApplyLoadedPatches(PPT_COMBINED_0_1);
+	Rewind::OnVSync();
 
 	Host::PumpMessagesOnCPUThread();
     PAD::PollDevices();
@@ -1009,6 +1035,10 @@ void VMManager::CheckForCPUConfigChanges(const Pcsx2Config& old_config)
 	SetCPUState(EmuConfig.Cpu.sseMXCSR, EmuConfig.Cpu.sseVUMXCSR);
 	SysClearExecutionCache();
 	memBindConditionalHandlers();
+
+	// Don't keep the decoder thread around until shutdown once it's no longer used
+	if (old_config.Speedhacks.ipuThread && !EmuConfig.Speedhacks.ipuThread)
+		ipuThreadShutdown();
 }
 
 void VMManager::CheckForGSConfigChanges(const Pcsx2Config& old_config)
@@ -1160,6 +1190,12 @@ void VMManager::CheckForConfigChanges(const Pcsx2Config& old_config)
 
 	if (EmuConfig.EnableCheats != old_config.EnableCheats || EmuConfig.EnableWideScreenPatches != old_config.EnableWideScreenPatches)
 		VMManager::ReloadPatches(true);
+
+	if (EmuConfig.EnableRewind != old_config.EnableRewind || EmuConfig.RewindFrequency != old_config.RewindFrequency ||
+		EmuConfig.RewindBufferSize != old_config.RewindBufferSize)
+	{
+		Rewind::Reset();
+	}
 }
 
 void VMManager::ApplySettings()
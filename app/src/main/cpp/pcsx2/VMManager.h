@@ -117,6 +117,9 @@ namespace VMManager
 	/// Loads state from the specified slot.
 	bool LoadStateFromSlot(s32 slot);
 
+	/// Steps back to the rewind snapshot taken steps captures ago, 1 being the newest.
+	bool RewindState(u32 steps);
+
 	/// Saves state to the specified filename.
 	bool SaveState(const char* filename);
 
@@ -18,104 +18,37 @@
 #include "Vif.h"
 #include "Vif_Dma.h"
 #include "MTVU.h"
+#include "Vif_UnpackKernels.h"
 
-enum UnpackOffset {
-	OFFSET_X = 0,
-	OFFSET_Y = 1,
-	OFFSET_Z = 2,
-	OFFSET_W = 3
-};
-
-static __fi u32 setVifRow(vifStruct& vif, u32 reg, u32 data) {
-	vif.MaskRow._u32[reg] = data;
-	return data;
-}
-
-// cycle derives from vif.cl
-// mode derives from vifRegs.mode
-template< uint idx, uint mode, bool doMask >
-static __ri void writeXYZW(u32 offnum, u32 &dest, u32 data) {
-	int n = 0;
-
+// The kernels themselves live in Vif_UnpackKernels.h, these bind them to the VIF they run on.
+template< uint idx, bool doMask >
+static __fi VifUnpackContext getUnpackContext() {
 	vifStruct& vif = MTVU_VifX;
-
-	if (doMask) {
-		const VIFregisters& regs = MTVU_VifXRegs;
-		switch (vif.cl) {
-			case 0:  n = (regs.mask >> (offnum * 2)) & 0x3;		break;
-			case 1:  n = (regs.mask >> ( 8 + (offnum * 2))) & 0x3;	break;
-			case 2:  n = (regs.mask >> (16 + (offnum * 2))) & 0x3;	break;
-			default: n = (regs.mask >> (24 + (offnum * 2))) & 0x3;	break;
-		}
-	}
-
-	// Four possible types of masking are handled below:
-	//   0 - Data
-	//   1 - MaskRow
-	//   2 - MaskCol
-	//   3 - Write protect
-
-	switch (n) {
-		case 0:
-			switch (mode) {
-				case 1:  dest = data + vif.MaskRow._u32[offnum]; break;
-				case 2:  dest = setVifRow(vif, offnum, vif.MaskRow._u32[offnum] + data); break;
-				case 3:  dest = setVifRow(vif, offnum, data); break;
-				default: dest = data; break;
-			}
-			break;
-		case 1: dest = vif.MaskRow._u32[offnum]; break;
-		case 2: dest = vif.MaskCol._u32[std::min(vif.cl,3)]; break;
-		case 3: break;
-	}
+	return { &vif.MaskRow, &vif.MaskCol, doMask ? MTVU_VifXRegs.mask : 0, vif.cl };
 }
-#define tParam idx,mode,doMask
 
 template < uint idx, uint mode, bool doMask, class T >
 static void __fastcall UNPACK_S(u32* dest, const T* src)
 {
-	u32 data = *src;
-
-	//S-# will always be a complete packet, no matter what. So we can skip the offset bits
-	writeXYZW<tParam>(OFFSET_X, *(dest+0), data);
-	writeXYZW<tParam>(OFFSET_Y, *(dest+1), data);
-	writeXYZW<tParam>(OFFSET_Z, *(dest+2), data);
-	writeXYZW<tParam>(OFFSET_W, *(dest+3), data);
+	VifUnpack::UNPACK_S<mode, doMask>(getUnpackContext<idx, doMask>(), dest, src);
 }
 
-// The PS2 console actually writes v1v0v1v0 for all V2 unpacks -- the second v1v0 pair
-// being officially "indeterminate" but some games very much depend on it.
 template < uint idx, uint mode, bool doMask, class T >
 static void __fastcall UNPACK_V2(u32* dest, const T* src)
 {
-	writeXYZW<tParam>(OFFSET_X, *(dest+0), *(src+0));
-	writeXYZW<tParam>(OFFSET_Y, *(dest+1), *(src+1));
-	writeXYZW<tParam>(OFFSET_Z, *(dest+2), *(src+0));
-	writeXYZW<tParam>(OFFSET_W, *(dest+3), *(src+1));
+	VifUnpack::UNPACK_V2<mode, doMask>(getUnpackContext<idx, doMask>(), dest, src);
 }
 
-// V3 and V4 unpacks both use the V4 unpack logic, even though most of the OFFSET_W fields
-// during V3 unpacking end up being overwritten by the next unpack.  This is confirmed real
-// hardware behavior that games such as Ape Escape 3 depend on.
 template < uint idx, uint mode, bool doMask, class T >
 static void __fastcall UNPACK_V4(u32* dest, const T* src)
 {
-	writeXYZW<tParam>(OFFSET_X, *(dest+0), *(src+0));
-	writeXYZW<tParam>(OFFSET_Y, *(dest+1), *(src+1));
-	writeXYZW<tParam>(OFFSET_Z, *(dest+2), *(src+2));
-	writeXYZW<tParam>(OFFSET_W, *(dest+3), *(src+3));
+	VifUnpack::UNPACK_V4<mode, doMask>(getUnpackContext<idx, doMask>(), dest, src);
 }
 
-// V4_5 unpacks do not support the MODE register, and act as mode==0 always.
 template< uint idx, bool doMask >
 static void __fastcall UNPACK_V4_5(u32 *dest, const u32* src)
 {
-	u32 data = *src;
-
-	writeXYZW<idx,0,doMask>(OFFSET_X, *(dest+0),	((data & 0x001f) << 3));
-	writeXYZW<idx,0,doMask>(OFFSET_Y, *(dest+1),	((data & 0x03e0) >> 2));
-	writeXYZW<idx,0,doMask>(OFFSET_Z, *(dest+2),	((data & 0x7c00) >> 7));
-	writeXYZW<idx,0,doMask>(OFFSET_W, *(dest+3),	((data & 0x8000) >> 8));
+	VifUnpack::UNPACK_V4_5<doMask>(getUnpackContext<idx, doMask>(), dest, src);
 }
 
 // =====================================================================================================
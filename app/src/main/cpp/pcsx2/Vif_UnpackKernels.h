@@ -0,0 +1,201 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "GS/GSVector.h"
+#include <algorithm>
+#include <cstring>
+
+// Interpreter VIF unpack kernels, one call unpacks one element into one quadword of VU memory.
+// They only see the VIF state they need, so the vectorised versions can be checked against the
+// reference ones outside of the emulator (tests/ctest/VIF).
+// Every kernel must give bit-identical results to its _reference version.
+
+struct VifUnpackContext
+{
+	u128* row;       // MaskRow, added by the offset (1) and difference (2) modes, written by modes 2 and 3
+	const u128* col; // MaskCol
+	u32 mask;        // MASK register, only read by the masked kernels
+	int cl;          // write cycle, selects the mask bits and the column
+};
+
+namespace VifUnpack
+{
+	// Four possible types of masking:
+	//   0 - Data
+	//   1 - MaskRow
+	//   2 - MaskCol
+	//   3 - Write protect
+	template <uint mode, bool doMask>
+	static __fi void writeXYZW(const VifUnpackContext& ctx, u32* dest, const GSVector4i& data)
+	{
+		const GSVector4i row = GSVector4i::load<true>(ctx.row);
+		const GSVector4i value = (mode == 1 || mode == 2) ? data.add32(row) : data;
+
+		const u32 n = doMask ? (ctx.mask >> (std::min(ctx.cl, 3) * 8)) & 0xff : 0;
+		if (n == 0)
+		{
+			// all lanes take the data, which is also what an unmasked unpack does
+			if (mode == 2 || mode == 3)
+				GSVector4i::store<true>(ctx.row, value);
+			GSVector4i::store<false>(dest, value);
+			return;
+		}
+
+		const GSVector4i sel(n & 3, (n >> 2) & 3, (n >> 4) & 3, n >> 6);
+		const GSVector4i is_data = sel.eq32(GSVector4i::zero());
+
+		// the row only changes in lanes which took the data, so the MaskRow lanes see the old row
+		if (mode == 2 || mode == 3)
+			GSVector4i::store<true>(ctx.row, row.blend8(value, is_data));
+
+		const GSVector4i col(static_cast<int>(ctx.col->_u32[std::min(ctx.cl, 3)]));
+		GSVector4i out = GSVector4i::load<false>(dest);
+		out = out.blend8(value, is_data);
+		out = out.blend8(row, sel.eq32(GSVector4i(1)));
+		out = out.blend8(col, sel.eq32(GSVector4i(2)));
+		GSVector4i::store<false>(dest, out);
+	}
+
+	// V4 source elements sign or zero extended to 32 bits, the same way the scalar u32 conversion does
+	template <class T>
+	static __fi GSVector4i loadV4(const T* src);
+
+	template <>
+	__fi GSVector4i loadV4(const u32* src) { return GSVector4i::load<false>(src); }
+	template <>
+	__fi GSVector4i loadV4(const s16* src) { return GSVector4i::loadl(src).i16to32(); }
+	template <>
+	__fi GSVector4i loadV4(const u16* src) { return GSVector4i::loadl(src).u16to32(); }
+	template <>
+	__fi GSVector4i loadV4(const s8* src)
+	{
+		int v;
+		std::memcpy(&v, src, sizeof(v));
+		return GSVector4i::load(v).i8to32();
+	}
+	template <>
+	__fi GSVector4i loadV4(const u8* src)
+	{
+		int v;
+		std::memcpy(&v, src, sizeof(v));
+		return GSVector4i::load(v).u8to32();
+	}
+
+	template <uint mode, bool doMask, class T>
+	static __fi void UNPACK_S(const VifUnpackContext& ctx, u32* dest, const T* src)
+	{
+		//S-# will always be a complete packet, no matter what. So we can skip the offset bits
+		writeXYZW<mode, doMask>(ctx, dest, GSVector4i(static_cast<int>(*src)));
+	}
+
+	// The PS2 console actually writes v1v0v1v0 for all V2 unpacks -- the second v1v0 pair
+	// being officially "indeterminate" but some games very much depend on it.
+	template <uint mode, bool doMask, class T>
+	static __fi void UNPACK_V2(const VifUnpackContext& ctx, u32* dest, const T* src)
+	{
+		const int x = static_cast<int>(src[0]);
+		const int y = static_cast<int>(src[1]);
+		writeXYZW<mode, doMask>(ctx, dest, GSVector4i(x, y, x, y));
+	}
+
+	// V3 and V4 unpacks both use the V4 unpack logic, even though most of the OFFSET_W fields
+	// during V3 unpacking end up being overwritten by the next unpack.  This is confirmed real
+	// hardware behavior that games such as Ape Escape 3 depend on.
+	template <uint mode, bool doMask, class T>
+	static __fi void UNPACK_V4(const VifUnpackContext& ctx, u32* dest, const T* src)
+	{
+		writeXYZW<mode, doMask>(ctx, dest, loadV4(src));
+	}
+
+	// V4_5 unpacks do not support the MODE register, and act as mode==0 always.
+	template <bool doMask>
+	static __fi void UNPACK_V4_5(const VifUnpackContext& ctx, u32* dest, const u32* src)
+	{
+		const u32 data = *src;
+		const GSVector4i v(data << 3, data >> 2, data >> 7, data >> 8);
+		writeXYZW<0, doMask>(ctx, dest, v & GSVector4i(0xf8, 0xf8, 0xf8, 0x80));
+	}
+
+	// ----------------------------------------------------------------------------------
+	//  Reference kernels, one element at a time
+	// ----------------------------------------------------------------------------------
+
+	template <uint mode, bool doMask>
+	static __fi void writeXYZW_reference(const VifUnpackContext& ctx, u32 offnum, u32& dest, u32 data)
+	{
+		int n = 0;
+
+		if (doMask)
+		{
+			switch (ctx.cl)
+			{
+				case 0:  n = (ctx.mask >> (offnum * 2)) & 0x3;        break;
+				case 1:  n = (ctx.mask >> ( 8 + (offnum * 2))) & 0x3; break;
+				case 2:  n = (ctx.mask >> (16 + (offnum * 2))) & 0x3; break;
+				default: n = (ctx.mask >> (24 + (offnum * 2))) & 0x3; break;
+			}
+		}
+
+		switch (n)
+		{
+			case 0:
+				switch (mode)
+				{
+					case 1:  dest = data + ctx.row->_u32[offnum]; break;
+					case 2:  dest = ctx.row->_u32[offnum] = ctx.row->_u32[offnum] + data; break;
+					case 3:  dest = ctx.row->_u32[offnum] = data; break;
+					default: dest = data; break;
+				}
+				break;
+			case 1: dest = ctx.row->_u32[offnum]; break;
+			case 2: dest = ctx.col->_u32[std::min(ctx.cl, 3)]; break;
+			case 3: break;
+		}
+	}
+
+	template <uint mode, bool doMask, class T>
+	static __fi void UNPACK_S_reference(const VifUnpackContext& ctx, u32* dest, const T* src)
+	{
+		const u32 data = *src;
+		for (u32 i = 0; i < 4; i++)
+			writeXYZW_reference<mode, doMask>(ctx, i, dest[i], data);
+	}
+
+	template <uint mode, bool doMask, class T>
+	static __fi void UNPACK_V2_reference(const VifUnpackContext& ctx, u32* dest, const T* src)
+	{
+		for (u32 i = 0; i < 4; i++)
+			writeXYZW_reference<mode, doMask>(ctx, i, dest[i], src[i & 1]);
+	}
+
+	template <uint mode, bool doMask, class T>
+	static __fi void UNPACK_V4_reference(const VifUnpackContext& ctx, u32* dest, const T* src)
+	{
+		for (u32 i = 0; i < 4; i++)
+			writeXYZW_reference<mode, doMask>(ctx, i, dest[i], src[i]);
+	}
+
+	template <bool doMask>
+	static __fi void UNPACK_V4_5_reference(const VifUnpackContext& ctx, u32* dest, const u32* src)
+	{
+		const u32 data = *src;
+		writeXYZW_reference<0, doMask>(ctx, 0, dest[0], (data & 0x001f) << 3);
+		writeXYZW_reference<0, doMask>(ctx, 1, dest[1], (data & 0x03e0) >> 2);
+		writeXYZW_reference<0, doMask>(ctx, 2, dest[2], (data & 0x7c00) >> 7);
+		writeXYZW_reference<0, doMask>(ctx, 3, dest[3], (data & 0x8000) >> 8);
+	}
+} // namespace VifUnpack
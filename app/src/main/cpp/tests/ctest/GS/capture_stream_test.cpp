@@ -0,0 +1,192 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "GS/GSCaptureStream.h"
+#include "common/FileSystem.h"
+#include "3rdparty/zstd/zstd/lib/zstd.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+
+static constexpr int TEST_PITCH_PADDING = 16;
+
+// Frame with every pixel set to c0, c1, c2, c3, rows padded so the stream has to honour the pitch
+static std::vector<u8> makeFrame(int width, int height, u8 c0, u8 c1, u8 c2, u8 c3)
+{
+	const int pitch = width * 4 + TEST_PITCH_PADDING;
+	std::vector<u8> pixels(static_cast<size_t>(pitch) * height, 0xcd);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			u8* px = &pixels[static_cast<size_t>(y) * pitch + x * 4];
+			px[0] = c0;
+			px[1] = c1;
+			px[2] = c2;
+			px[3] = c3;
+		}
+	}
+	return pixels;
+}
+
+// Frame where every pixel holds its own index, to check ordering and channel swaps
+static std::vector<u8> makeGradientFrame(int width, int height)
+{
+	const int pitch = width * 4 + TEST_PITCH_PADDING;
+	std::vector<u8> pixels(static_cast<size_t>(pitch) * height, 0xcd);
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			for (int c = 0; c < 4; c++)
+				pixels[static_cast<size_t>(y) * pitch + x * 4 + c] = static_cast<u8>((y * width + x) * 4 + c);
+	return pixels;
+}
+
+static std::vector<u8> readAndDelete(const std::string& filename)
+{
+	std::optional<std::vector<u8>> data = FileSystem::ReadBinaryFile(filename.c_str());
+	FileSystem::DeleteFilePath(filename.c_str());
+	return data.value_or(std::vector<u8>());
+}
+
+template <typename T>
+static T readValue(const std::vector<u8>& data, size_t offset)
+{
+	T value;
+	std::memcpy(&value, &data[offset], sizeof(value));
+	return value;
+}
+
+TEST(GSCaptureStreamTest, Y4M)
+{
+	constexpr int width = 8;
+	constexpr int height = 4;
+	const std::string filename("capture_stream_test.y4m");
+
+	GSCaptureStream stream;
+	ASSERT_TRUE(stream.Open(filename, GSCaptureStream::Format::Y4M, width, height, 59.94f));
+	EXPECT_TRUE(stream.PushFrame(makeFrame(width, height, 255, 255, 255, 255).data(), width * 4 + TEST_PITCH_PADDING, true));
+	EXPECT_TRUE(stream.PushFrame(makeFrame(width, height, 0, 0, 0, 255).data(), width * 4 + TEST_PITCH_PADDING, true));
+	EXPECT_TRUE(stream.PushFrame(makeFrame(width, height, 255, 0, 0, 255).data(), width * 4 + TEST_PITCH_PADDING, true));
+	EXPECT_TRUE(stream.PushFrame(makeFrame(width, height, 0, 0, 255, 255).data(), width * 4 + TEST_PITCH_PADDING, false));
+	stream.Close();
+
+	const GSCaptureStream::Stats stats = stream.GetStats();
+	EXPECT_EQ(stats.frames_captured, 4u);
+	EXPECT_EQ(stats.frames_written, 4u);
+	EXPECT_EQ(stats.frames_dropped, 0u);
+
+	const std::vector<u8> data = readAndDelete(filename);
+	const std::string header("YUV4MPEG2 W8 H4 F59940:1000 Ip A1:1 C420 XCOLORRANGE=LIMITED\n");
+	ASSERT_GE(data.size(), header.size());
+	EXPECT_EQ(std::string(data.begin(), data.begin() + header.size()), header);
+
+	// white, black, then red given as RGBA and as BGRA, in BT.601 limited range
+	static constexpr u8 expected[4][3] = {{235, 128, 128}, {16, 128, 128}, {82, 90, 240}, {82, 90, 240}};
+	constexpr size_t y_size = width * height;
+	constexpr size_t frame_size = y_size * 3 / 2;
+	static constexpr char frame_header[] = "FRAME\n";
+	ASSERT_EQ(data.size(), header.size() + std::size(expected) * (sizeof(frame_header) - 1 + frame_size));
+
+	size_t pos = header.size();
+	for (size_t i = 0; i < std::size(expected); i++)
+	{
+		EXPECT_EQ(std::memcmp(&data[pos], frame_header, sizeof(frame_header) - 1), 0) << "frame " << i;
+		pos += sizeof(frame_header) - 1;
+		for (size_t j = 0; j < frame_size; j++)
+		{
+			const int plane = (j < y_size) ? 0 : (j < y_size + y_size / 4) ? 1 : 2;
+			ASSERT_EQ(data[pos + j], expected[i][plane]) << "frame " << i << " byte " << j;
+		}
+		pos += frame_size;
+	}
+}
+
+static void testRaw(GSCaptureStream::Format format)
+{
+	constexpr int width = 4;
+	constexpr int height = 2;
+	constexpr u32 frame_size = width * height * 4;
+	const std::string filename("capture_stream_test.p2raw");
+
+	const std::vector<u8> frame = makeGradientFrame(width, height);
+
+	GSCaptureStream stream;
+	ASSERT_TRUE(stream.Open(filename, format, width, height, 50.0f));
+	EXPECT_TRUE(stream.PushFrame(frame.data(), width * 4 + TEST_PITCH_PADDING, true));
+	EXPECT_TRUE(stream.PushFrame(frame.data(), width * 4 + TEST_PITCH_PADDING, false));
+	stream.Close();
+
+	const std::vector<u8> data = readAndDelete(filename);
+	ASSERT_GE(data.size(), 32u + 24u);
+
+	// header
+	EXPECT_EQ(std::memcmp(&data[0], "P2CAPRAW", 8), 0);
+	EXPECT_EQ(readValue<u32>(data, 8), 1u);
+	EXPECT_EQ(readValue<u32>(data, 12), static_cast<u32>(width));
+	EXPECT_EQ(readValue<u32>(data, 16), static_cast<u32>(height));
+	EXPECT_EQ(readValue<u32>(data, 20), 50000u);
+	EXPECT_EQ(readValue<u32>(data, 24), 1000u);
+	EXPECT_EQ(readValue<u32>(data, 28), (format == GSCaptureStream::Format::RawZstd) ? 1u : 0u);
+
+	// trailer and index
+	const size_t trailer = data.size() - 24;
+	EXPECT_EQ(std::memcmp(&data[trailer + 16], "P2CAPIDX", 8), 0);
+	const u32 frame_count = readValue<u32>(data, trailer + 8);
+	const u64 index_offset = readValue<u64>(data, trailer);
+	ASSERT_EQ(frame_count, 2u);
+	ASSERT_EQ(index_offset + frame_count * sizeof(u64), trailer);
+
+	// frames, the second one was BGRA and has to come out as RGBA too
+	u64 expected_offset = 32;
+	for (u32 i = 0; i < frame_count; i++)
+	{
+		const u64 offset = readValue<u64>(data, index_offset + i * sizeof(u64));
+		ASSERT_EQ(offset, expected_offset) << "frame " << i;
+		const u32 size = readValue<u32>(data, offset);
+		ASSERT_LE(offset + sizeof(u32) + size, index_offset);
+
+		std::vector<u8> pixels(frame_size);
+		if (format == GSCaptureStream::Format::RawZstd)
+		{
+			ASSERT_EQ(ZSTD_decompress(pixels.data(), pixels.size(), &data[offset + sizeof(u32)], size), frame_size) << "frame " << i;
+		}
+		else
+		{
+			ASSERT_EQ(size, frame_size);
+			std::memcpy(pixels.data(), &data[offset + sizeof(u32)], size);
+		}
+
+		for (u32 p = 0; p < frame_size; p++)
+		{
+			const u32 c = p & 3;
+			const u32 src_c = (i == 0 || c == 1 || c == 3) ? c : (2 - c);
+			ASSERT_EQ(pixels[p], static_cast<u8>((p & ~3u) + src_c)) << "frame " << i << " byte " << p;
+		}
+
+		expected_offset = offset + sizeof(u32) + size;
+	}
+	EXPECT_EQ(expected_offset, index_offset);
+}
+
+TEST(GSCaptureStreamTest, Raw)
+{
+	testRaw(GSCaptureStream::Format::Raw);
+}
+
+TEST(GSCaptureStreamTest, RawZstd)
+{
+	testRaw(GSCaptureStream::Format::RawZstd);
+}
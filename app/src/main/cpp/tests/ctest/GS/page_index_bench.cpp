@@ -0,0 +1,240 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Texture cache target lookups, linear list walk vs GSPageIndex.
+// Usage: page_index_bench [targets] [trace]
+//
+// Without a trace a frame is synthesized: a double buffered framebuffer and its depth buffer, plus
+// `targets` small render targets (shadow maps, post processing) which are looked up and drawn to, and
+// a few EE transfers. A trace recorded from a GS dump can be replayed instead, one operation per line:
+//   L <bp>              LookupTarget at bp, creates the target on a miss
+//   D <bp> <end_block>  draw to the target at bp, which now ends at end_block
+//   W <bp> <bw> <rows>  InvalidateVideoMem of `rows` pages high at bp
+
+#include "PrecompiledHeader.h"
+#include "GS/Renderers/Common/GSPageIndex.h"
+#include "common/Timer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct Op
+	{
+		char type;
+		u32 bp;
+		u32 a;
+		u32 b;
+	};
+
+	struct Target
+	{
+		u32 bp;
+		u32 end_block;
+		u16 list_it;
+		GSPageIndexEntry m_page_entry;
+	};
+
+	std::vector<Op> LoadTrace(const char* path)
+	{
+		std::vector<Op> ops;
+		std::FILE* fp = std::fopen(path, "r");
+		if (!fp)
+		{
+			std::fprintf(stderr, "Can't open %s\n", path);
+			return ops;
+		}
+
+		char type;
+		Op op = {};
+		while (std::fscanf(fp, " %c", &type) == 1)
+		{
+			op = {type, 0, 0, 0};
+			if (type == 'L' && std::fscanf(fp, "%x", &op.bp) == 1)
+				ops.push_back(op);
+			else if (type == 'D' && std::fscanf(fp, "%x %x", &op.bp, &op.a) == 2)
+				ops.push_back(op);
+			else if (type == 'W' && std::fscanf(fp, "%x %u %u", &op.bp, &op.a, &op.b) == 3)
+				ops.push_back(op);
+			else
+				break;
+		}
+
+		std::fclose(fp);
+		return ops;
+	}
+
+	std::vector<Op> SynthesizeFrames(u32 targets, u32 frames)
+	{
+		std::mt19937 rng(1);
+		std::vector<Op> ops;
+
+		// 640x448 32 bits framebuffers are 0x1180 blocks.
+		const u32 fb[3] = {0x0000, 0x1180, 0x2300};
+		std::vector<u32> small;
+		for (u32 i = 0; i < targets; i++)
+			small.push_back((rng() % MAX_PAGES) * 32);
+
+		for (u32 frame = 0; frame < frames; frame++)
+		{
+			const u32 front = fb[frame & 1];
+			for (int draw = 0; draw < 400; draw++)
+			{
+				if (draw & 1)
+				{
+					const u32 bp = small[rng() % small.size()];
+					ops.push_back({'L', bp, 0, 0});
+					ops.push_back({'D', bp, bp + 0x1f + (rng() % 4) * 32, 0});
+				}
+				else
+				{
+					ops.push_back({'L', front, 0, 0});
+					ops.push_back({'D', front, front + 0x117f, 0});
+					ops.push_back({'L', fb[2], 0, 0});
+				}
+
+				// Texture uploads, usually in free memory, sometimes over a target.
+				if ((draw % 10) == 0)
+				{
+					const u32 bp = (draw % 40) ? (rng() % MAX_PAGES) * 32 : small[rng() % small.size()];
+					ops.push_back({'W', bp, 1u << (rng() % 4), 1 + rng() % 8});
+				}
+			}
+		}
+
+		return ops;
+	}
+
+	/// Replays the ops against a list, optionally with the index, and returns a checksum of the hits.
+	template <bool indexed>
+	u64 Replay(const std::vector<Op>& ops)
+	{
+		FastList<Target*> list;
+		GSPageIndex<Target> index;
+		std::vector<std::unique_ptr<Target>> storage;
+		u64 checksum = 0;
+
+		auto find = [&](u32 bp) -> Target* {
+			if (indexed)
+			{
+				for (Target* t : index.Starting(bp >> 5))
+				{
+					if (t->bp == bp)
+						return t;
+				}
+			}
+			else
+			{
+				for (Target* t : list)
+				{
+					if (t->bp == bp)
+						return t;
+				}
+			}
+			return nullptr;
+		};
+
+		for (const Op& op : ops)
+		{
+			if (op.type == 'L')
+			{
+				Target* t = find(op.bp);
+				if (t)
+				{
+					list.MoveFront(t->list_it);
+					if (indexed)
+						index.MoveFront(t, t->bp);
+				}
+				else
+				{
+					t = new Target{op.bp, 0, 0, {}};
+					storage.emplace_back(t);
+					t->list_it = list.InsertFront(t);
+					if (indexed)
+						index.Insert(t, t->bp, t->end_block);
+				}
+				checksum = checksum * 31 + t->bp;
+			}
+			else if (op.type == 'D')
+			{
+				Target* t = find(op.bp);
+				if (t && t->end_block != op.a)
+				{
+					t->end_block = op.a;
+					if (indexed)
+						index.Cover(t, t->bp, t->end_block);
+				}
+			}
+			else if (op.type == 'W')
+			{
+				// Same candidates as InvalidateVideoMem: starting in the rows of the write, or containing bp.
+				const u32 last = std::min(op.bp + op.a * 32 * op.b, MAX_BLOCKS - 1);
+				u32 hits = 0;
+				if (indexed)
+				{
+					for (u32 page = op.bp >> 5; page <= (last >> 5); page++)
+					{
+						for (Target* t : index.Starting(page))
+							hits += (t->bp >= op.bp && t->bp <= last);
+					}
+					for (Target* t : index.Covering(op.bp >> 5))
+						hits += (t->bp < op.bp && op.bp <= t->end_block);
+				}
+				else
+				{
+					for (Target* t : list)
+						hits += (t->bp >= op.bp && t->bp <= last) || (t->bp < op.bp && op.bp <= t->end_block);
+				}
+				checksum = checksum * 31 + hits;
+			}
+		}
+
+		return checksum;
+	}
+
+	template <bool indexed>
+	double Measure(const std::vector<Op>& ops, u64* checksum)
+	{
+		Common::Timer timer;
+		*checksum = Replay<indexed>(ops);
+		return timer.GetTimeNanoseconds() / ops.size();
+	}
+} // namespace
+
+int main(int argc, char** argv)
+{
+	const u32 targets = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 256;
+	const std::vector<Op> ops = (argc > 2) ? LoadTrace(argv[2]) : SynthesizeFrames(std::max(targets, 1u), 600);
+	if (ops.empty())
+		return EXIT_FAILURE;
+
+	u64 linear_sum, indexed_sum;
+	const double linear = Measure<false>(ops, &linear_sum);
+	const double indexed = Measure<true>(ops, &indexed_sum);
+
+	std::printf("%zu ops, linear %7.1f ns/op, indexed %7.1f ns/op  %5.2fx\n", ops.size(), linear, indexed, linear / indexed);
+	if (linear_sum != indexed_sum)
+	{
+		std::printf("Results differ!\n");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
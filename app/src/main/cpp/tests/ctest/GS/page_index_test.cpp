@@ -0,0 +1,164 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "GS/Renderers/Common/GSPageIndex.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+static constexpr int ITERATIONS = 20000;
+
+namespace
+{
+	struct Surface
+	{
+		u32 bp;
+		u32 end_block;
+		u16 list_it;
+		GSPageIndexEntry m_page_entry;
+	};
+
+	/// Owner side of the index, the way the texture cache keeps its targets.
+	struct Cache
+	{
+		FastList<Surface*> list;
+		GSPageIndex<Surface> index;
+		std::vector<std::unique_ptr<Surface>> storage;
+
+		void Create(u32 bp, u32 end_block)
+		{
+			Surface* s = new Surface{bp, end_block, 0, {}};
+			storage.emplace_back(s);
+			s->list_it = list.InsertFront(s);
+			index.Insert(s, bp, end_block);
+		}
+
+		void MoveFront(Surface* s)
+		{
+			list.MoveFront(s->list_it);
+			index.MoveFront(s, s->bp);
+		}
+
+		void Resize(Surface* s, u32 end_block)
+		{
+			s->end_block = end_block;
+			index.Cover(s, s->bp, end_block);
+		}
+
+		void Remove(Surface* s)
+		{
+			list.EraseIndex(s->list_it);
+			index.Remove(s, s->bp);
+			storage.erase(std::find_if(storage.begin(), storage.end(), [s](const auto& p) { return p.get() == s; }));
+		}
+
+		Surface* Random(std::mt19937& rng) const
+		{
+			return storage[rng() % storage.size()].get();
+		}
+	};
+
+	u32 RandomBlock(std::mt19937& rng)
+	{
+		// Mostly page aligned like real framebuffers, with a few odd ones.
+		return (rng() & 3) ? (rng() % MAX_PAGES) * 32 : rng() % MAX_BLOCKS;
+	}
+
+	u32 RandomEnd(std::mt19937& rng, u32 bp)
+	{
+		switch (rng() % 8)
+		{
+			case 0: return 0; // not drawn yet
+			case 1: return bp + 0x3000 + rng() % 0x1000; // wraps around the end of memory
+			default: return bp + rng() % 0x1000;
+		}
+	}
+} // namespace
+
+TEST(PageIndex, MatchesLinearScan)
+{
+	std::mt19937 rng(1);
+	Cache cache;
+
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		const u32 op = rng() % 10;
+		if (cache.storage.empty() || op < 3)
+		{
+			const u32 bp = RandomBlock(rng);
+			cache.Create(bp, RandomEnd(rng, bp));
+		}
+		else if (op < 5)
+		{
+			cache.MoveFront(cache.Random(rng));
+		}
+		else if (op < 7)
+		{
+			Surface* s = cache.Random(rng);
+			cache.Resize(s, (rng() & 1) ? s->end_block + rng() % 0x200 : RandomEnd(rng, s->bp));
+		}
+		else if (op < 8 || cache.storage.size() > 300)
+		{
+			cache.Remove(cache.Random(rng));
+		}
+
+		const u32 bp = (rng() & 1) && !cache.storage.empty() ? cache.Random(rng)->bp : RandomBlock(rng);
+		const u32 page = bp >> 5;
+
+		// First exact hit in list order, what LookupTarget wants.
+		Surface* expected_hit = nullptr;
+		for (Surface* s : cache.list)
+		{
+			if (s->bp == bp)
+			{
+				expected_hit = s;
+				break;
+			}
+		}
+		Surface* hit = nullptr;
+		for (Surface* s : cache.index.Starting(page))
+		{
+			if (s->bp == bp)
+			{
+				hit = s;
+				break;
+			}
+		}
+		ASSERT_EQ(expected_hit, hit) << "iteration " << i;
+
+		// Everything containing the page, what InvalidateVideoMem wants.
+		std::vector<Surface*> expected_cover, cover;
+		for (Surface* s : cache.list)
+		{
+			if (s->end_block >= s->bp && (s->bp >> 5) <= page && page <= (std::min(s->end_block, MAX_BLOCKS - 1) >> 5))
+				expected_cover.push_back(s);
+		}
+		for (Surface* s : cache.index.Covering(page))
+			cover.push_back(s);
+		std::sort(expected_cover.begin(), expected_cover.end());
+		std::sort(cover.begin(), cover.end());
+		ASSERT_EQ(expected_cover, cover) << "iteration " << i;
+	}
+
+	cache.index.Clear();
+	for (u32 page = 0; page < MAX_PAGES; page++)
+	{
+		ASSERT_TRUE(cache.index.Starting(page).empty());
+		ASSERT_TRUE(cache.index.Covering(page).empty());
+	}
+}
@@ -0,0 +1,125 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Macroblock throughput of the IPU kernels, reference vs vectorised.
+// Usage: ipu_kernel_bench [macroblocks]
+
+#include "PrecompiledHeader.h"
+#include "IPU_Kernels.h"
+#include "common/Timer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// What one macroblock of a 4:2:0 intra picture costs the IPU: 6 coded blocks,
+	// then the CSC output stage converted to 16 bit and indexed.
+	struct MacroblockInput
+	{
+		alignas(16) s16 blocks[6][64];
+		alignas(16) macroblock_rgb32 rgb32;
+	};
+
+	struct MacroblockOutput
+	{
+		alignas(16) u8 Y[16][16];
+		alignas(16) u8 C[2][8][16];
+		alignas(16) macroblock_rgb16 rgb16;
+		alignas(16) u8 indx4[16 * 8];
+	};
+
+	struct Kernels
+	{
+		const char* name;
+		void (*idct_copy)(s16*, u8*, int);
+		void (*dither)(const macroblock_rgb32&, macroblock_rgb16&, int);
+		void (*vq)(const macroblock_rgb16&, const rgb16_t*, u8*);
+	};
+} // namespace
+
+static void generate(std::vector<MacroblockInput>& input, rgb16_t* clut)
+{
+	std::mt19937 rng(0x1b3);
+	std::uniform_int_distribution<int> dc(-256, 255);
+	std::uniform_int_distribution<int> ac(-64, 63);
+	std::uniform_int_distribution<int> count(0, 10);
+	std::uniform_int_distribution<int> low_freq(1, 20);
+
+	for (MacroblockInput& mb : input)
+	{
+		for (s16* block : mb.blocks)
+		{
+			std::fill_n(block, 64, 0);
+			block[0] = dc(rng);
+			for (int n = count(rng); n > 0; --n)
+				block[low_freq(rng)] = ac(rng);
+		}
+		u8* p = &mb.rgb32.c[0][0].r;
+		for (size_t i = 0; i < sizeof(mb.rgb32); ++i)
+			p[i] = static_cast<u8>(rng());
+	}
+
+	for (int k = 0; k < 16; ++k)
+	{
+		clut[k].r = rng();
+		clut[k].g = rng();
+		clut[k].b = rng();
+		clut[k].a = 0;
+	}
+}
+
+static double run(const Kernels& kernels, const std::vector<MacroblockInput>& input, const rgb16_t* clut)
+{
+	std::vector<MacroblockInput> work(input);
+	MacroblockOutput out;
+
+	Common::Timer timer;
+	for (MacroblockInput& mb : work)
+	{
+		for (int i = 0; i < 4; ++i)
+			kernels.idct_copy(mb.blocks[i], &out.Y[(i >> 1) * 8][(i & 1) * 8], 16);
+		kernels.idct_copy(mb.blocks[4], &out.C[0][0][0], 16);
+		kernels.idct_copy(mb.blocks[5], &out.C[1][0][0], 16);
+		kernels.dither(mb.rgb32, out.rgb16, 1);
+		kernels.vq(out.rgb16, clut, out.indx4);
+	}
+	const double seconds = timer.GetTimeSeconds();
+
+	const double rate = static_cast<double>(work.size()) / seconds;
+	std::printf("%-10s %10.0f macroblocks/s (%.3f ms)\n", kernels.name, rate, seconds * 1000.0);
+	return rate;
+}
+
+int main(int argc, char** argv)
+{
+	const size_t count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+	std::vector<MacroblockInput> input(count);
+	rgb16_t clut[16];
+	generate(input, clut);
+
+	const Kernels reference = {"reference", mpeg2_idct_copy_reference, ipu_dither_reference, ipu_vq_reference};
+	const Kernels vector = {"vector", mpeg2_idct_copy, ipu_dither, ipu_vq};
+
+	// first pass warms the caches
+	run(reference, input, clut);
+	const double reference_rate = run(reference, input, clut);
+	const double vector_rate = run(vector, input, clut);
+	std::printf("speedup    %10.2fx\n", vector_rate / reference_rate);
+	return 0;
+}
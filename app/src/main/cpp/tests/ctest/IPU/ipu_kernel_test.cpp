@@ -0,0 +1,183 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "IPU_Kernels.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <string.h>
+
+static constexpr int ITERATIONS = 4096;
+
+// Mostly zero blocks with a few low frequency coefficients, like real streams
+static void randomSparseBlock(std::mt19937& rng, s16* block, int range)
+{
+	std::uniform_int_distribution<int> value(-range, range - 1);
+	std::uniform_int_distribution<int> count(0, 12);
+	std::uniform_int_distribution<int> pos(0, 63);
+	memset(block, 0, 128);
+	block[0] = value(rng);
+	for (int n = count(rng); n > 0; --n)
+		block[pos(rng) & (rng() & 1 ? 0x1b : 0x3f)] = value(rng);
+}
+
+static void randomDenseBlock(std::mt19937& rng, s16* block)
+{
+	for (int i = 0; i < 64; ++i)
+		block[i] = static_cast<s16>(rng());
+}
+
+static bool idctOutputInClipRange(const s16* block)
+{
+	alignas(16) s16 tmp[64];
+	memcpy(tmp, block, sizeof(tmp));
+	mpeg2_idct_reference(tmp);
+	for (s16 v : tmp)
+	{
+		if (v < -384 || v >= 640)
+			return false;
+	}
+	return true;
+}
+
+TEST(IDCTTest, Sparse)
+{
+	std::mt19937 rng(1);
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		alignas(16) s16 expected[64], actual[64];
+		randomSparseBlock(rng, expected, 2048);
+		memcpy(actual, expected, sizeof(actual));
+		mpeg2_idct_reference(expected);
+		mpeg2_idct(actual);
+		ASSERT_EQ(0, memcmp(expected, actual, sizeof(actual))) << "iteration " << i;
+	}
+}
+
+TEST(IDCTTest, FullRange)
+{
+	// Corrupted streams, intermediates overflow 16 bits and have to wrap the same way
+	std::mt19937 rng(2);
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		alignas(16) s16 expected[64], actual[64];
+		randomDenseBlock(rng, expected);
+		memcpy(actual, expected, sizeof(actual));
+		mpeg2_idct_reference(expected);
+		mpeg2_idct(actual);
+		ASSERT_EQ(0, memcmp(expected, actual, sizeof(actual))) << "iteration " << i;
+	}
+}
+
+TEST(IDCTTest, Copy)
+{
+	std::mt19937 rng(3);
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		alignas(16) s16 expected_block[64], actual_block[64];
+		randomSparseBlock(rng, expected_block, 256);
+		if (!idctOutputInClipRange(expected_block))
+			continue;
+		memcpy(actual_block, expected_block, sizeof(actual_block));
+
+		alignas(16) u8 expected[8][16], actual[8][16];
+		memset(expected, 0xcc, sizeof(expected));
+		memset(actual, 0xcc, sizeof(actual));
+		mpeg2_idct_copy_reference(expected_block, &expected[0][0], 16);
+		mpeg2_idct_copy(actual_block, &actual[0][0], 16);
+		ASSERT_EQ(0, memcmp(expected, actual, sizeof(actual))) << "iteration " << i;
+		ASSERT_EQ(0, memcmp(expected_block, actual_block, sizeof(actual_block))) << "iteration " << i;
+	}
+}
+
+TEST(IDCTTest, Add)
+{
+	std::mt19937 rng(4);
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		alignas(16) s16 expected_block[64], actual_block[64];
+		randomSparseBlock(rng, expected_block, 2048);
+		// last == 129 takes the DC only path unless the DC has the odd rounding case
+		const int last = (i & 1) ? 129 : 63;
+		if (last == 129)
+			expected_block[63] = (rng() & 1);
+		memcpy(actual_block, expected_block, sizeof(actual_block));
+
+		alignas(16) s16 expected[8][16], actual[8][16];
+		memset(expected, 0xcc, sizeof(expected));
+		memset(actual, 0xcc, sizeof(actual));
+		mpeg2_idct_add_reference(last, expected_block, &expected[0][0], 16);
+		mpeg2_idct_add(last, actual_block, &actual[0][0], 16);
+		ASSERT_EQ(0, memcmp(expected, actual, sizeof(actual))) << "iteration " << i;
+		ASSERT_EQ(0, memcmp(expected_block, actual_block, sizeof(actual_block))) << "iteration " << i;
+	}
+}
+
+static void randomMacroblock(std::mt19937& rng, macroblock_rgb32& rgb32)
+{
+	u8* p = &rgb32.c[0][0].r;
+	for (size_t i = 0; i < sizeof(rgb32); ++i)
+		p[i] = static_cast<u8>(rng());
+	// make sure both sides of the alpha test and the clamps get hit
+	for (int i = 0; i < 16; ++i)
+	{
+		rgb32.c[i][i].a = 0x40;
+		rgb32.c[i][15 - i].r = (i & 1) ? 0xff : 0x00;
+	}
+}
+
+TEST(DitherTest, Dither)
+{
+	std::mt19937 rng(5);
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		alignas(16) macroblock_rgb32 rgb32;
+		alignas(16) macroblock_rgb16 expected, actual;
+		randomMacroblock(rng, rgb32);
+		const int dte = i & 1;
+		ipu_dither_reference(rgb32, expected, dte);
+		ipu_dither(rgb32, actual, dte);
+		ASSERT_EQ(0, memcmp(&expected, &actual, sizeof(actual))) << "iteration " << i << " dte " << dte;
+	}
+}
+
+TEST(VQTest, VQ)
+{
+	std::mt19937 rng(6);
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		alignas(16) macroblock_rgb32 rgb32;
+		alignas(16) macroblock_rgb16 rgb16;
+		randomMacroblock(rng, rgb32);
+		ipu_dither_reference(rgb32, rgb16, 0);
+
+		rgb16_t clut[16];
+		for (int k = 0; k < 16; ++k)
+		{
+			clut[k].r = rng();
+			clut[k].g = rng();
+			clut[k].b = rng();
+			clut[k].a = 0;
+		}
+		// duplicate entries check that ties pick the lowest index
+		if (i & 1)
+			clut[rng() & 15] = clut[rng() & 15];
+
+		alignas(16) u8 expected[16 * 8], actual[16 * 8];
+		ipu_vq_reference(rgb16, clut, expected);
+		ipu_vq(rgb16, clut, actual);
+		ASSERT_EQ(0, memcmp(expected, actual, sizeof(actual))) << "iteration " << i;
+	}
+}
@@ -0,0 +1,165 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "SPU2/MixerVoices.h"
+#include <gtest/gtest.h>
+#include <random>
+
+static constexpr int ITERATIONS = 4096;
+
+// One core tick of voices, with everything MixVoice would have fetched
+struct TestVoice
+{
+	bool active;
+	bool noise;
+	s32 pv1, pv2, pv3, pv4;
+	s32 mu;
+	s32 envelope;
+	s32 volume_l, volume_r;
+	s16 dry_l, dry_r, wet_l, wet_r;
+};
+
+static TestVoice randomVoice(std::mt19937& rng)
+{
+	std::uniform_int_distribution<int> sample(-0x8000, 0x7fff);
+	std::uniform_int_distribution<int> mu(0, 4095);
+	std::uniform_int_distribution<s32> envelope(0, 0x7fffffff);
+	std::uniform_int_distribution<s32> volume(INT32_MIN, INT32_MAX);
+	std::uniform_int_distribution<int> gate(-0x8000, 0x7fff);
+	std::uniform_int_distribution<int> percent(0, 99);
+
+	TestVoice vc;
+	vc.active = percent(rng) < 80;
+	vc.noise = vc.active && percent(rng) < 10;
+	vc.pv1 = sample(rng);
+	vc.pv2 = sample(rng);
+	vc.pv3 = sample(rng);
+	vc.pv4 = sample(rng);
+	// FetchVoiceLanes leaves mu at 0 unless the voice advanced through its samples
+	vc.mu = (vc.active && !vc.noise) ? mu(rng) : 0;
+	vc.envelope = vc.active ? envelope(rng) : 0;
+	vc.volume_l = volume(rng);
+	vc.volume_r = volume(rng);
+	// Games only write 0 or 0xffff, any other pattern has to mask the same way too
+	vc.dry_l = static_cast<s16>(gate(rng));
+	vc.dry_r = static_cast<s16>(gate(rng));
+	vc.wet_l = static_cast<s16>(gate(rng));
+	vc.wet_r = static_cast<s16>(gate(rng));
+	return vc;
+}
+
+// Same as MixVoice, and MixCoreVoices summing its output
+template <int InterpType>
+static s32 mixVoiceScalar(const TestVoice& vc, VoiceMixSet& dest)
+{
+	if (!vc.active)
+		return 0;
+
+	s32 value = vc.noise ? vc.pv1 : InterpolateVoice<InterpType>(vc.pv4, vc.pv3, vc.pv2, vc.pv1, vc.mu);
+	value = ApplyVolume(value, vc.envelope);
+
+	const s32 out_l = ApplyVolume(value, vc.volume_l);
+	const s32 out_r = ApplyVolume(value, vc.volume_r);
+	dest.Dry.Left += out_l & vc.dry_l;
+	dest.Dry.Right += out_r & vc.dry_r;
+	dest.Wet.Left += out_l & vc.wet_l;
+	dest.Wet.Right += out_r & vc.wet_r;
+	return value;
+}
+
+// Same as FetchVoiceLanes
+template <int InterpType>
+static void setVoiceLane(VoiceLanes& lanes, uint voiceidx, const TestVoice& vc)
+{
+	lanes.Active[voiceidx] = vc.active;
+	lanes.NoiseMask[voiceidx] = vc.noise ? -1 : 0;
+	lanes.PV1[voiceidx] = vc.pv1;
+	lanes.PV2[voiceidx] = vc.pv2;
+	lanes.PV3[voiceidx] = vc.pv3;
+	lanes.PV4[voiceidx] = vc.pv4;
+	SetVoiceLaneMu<InterpType>(lanes, voiceidx, vc.mu);
+	lanes.Envelope[voiceidx] = vc.envelope;
+	lanes.VolumeL[voiceidx] = vc.volume_l;
+	lanes.VolumeR[voiceidx] = vc.volume_r;
+	lanes.DryL[voiceidx] = vc.dry_l;
+	lanes.DryR[voiceidx] = vc.dry_r;
+	lanes.WetL[voiceidx] = vc.wet_l;
+	lanes.WetR[voiceidx] = vc.wet_r;
+}
+
+template <int InterpType>
+static void testMixVoiceLanes()
+{
+	std::mt19937 rng(InterpType + 1);
+
+	for (int i = 0; i < ITERATIONS; i++)
+	{
+		const VoiceMixSet start(StereoOut32(rng(), rng()), StereoOut32(rng(), rng()));
+		VoiceMixSet expected(start);
+		VoiceMixSet actual(start);
+		s32 expected_values[V_Core::NumVoices];
+		VoiceLanes lanes;
+
+		for (uint voiceidx = 0; voiceidx < V_Core::NumVoices; voiceidx++)
+		{
+			const TestVoice vc = randomVoice(rng);
+			expected_values[voiceidx] = mixVoiceScalar<InterpType>(vc, expected);
+			setVoiceLane<InterpType>(lanes, voiceidx, vc);
+		}
+
+		MixVoiceLanes<InterpType>(lanes, actual);
+
+		for (uint voiceidx = 0; voiceidx < V_Core::NumVoices; voiceidx++)
+		{
+			// OutX is only stored for active voices, but inactive ones must still be silent
+			ASSERT_EQ(lanes.Value[voiceidx], expected_values[voiceidx]) << "iteration " << i << " voice " << voiceidx;
+		}
+		ASSERT_EQ(actual.Dry.Left, expected.Dry.Left) << "iteration " << i;
+		ASSERT_EQ(actual.Dry.Right, expected.Dry.Right) << "iteration " << i;
+		ASSERT_EQ(actual.Wet.Left, expected.Wet.Left) << "iteration " << i;
+		ASSERT_EQ(actual.Wet.Right, expected.Wet.Right) << "iteration " << i;
+	}
+}
+
+TEST(SPU2MixerTest, Nearest)
+{
+	testMixVoiceLanes<0>();
+}
+
+TEST(SPU2MixerTest, Linear)
+{
+	testMixVoiceLanes<1>();
+}
+
+TEST(SPU2MixerTest, Cubic)
+{
+	testMixVoiceLanes<2>();
+}
+
+TEST(SPU2MixerTest, Hermite)
+{
+	testMixVoiceLanes<3>();
+}
+
+TEST(SPU2MixerTest, CatmullRom)
+{
+	testMixVoiceLanes<4>();
+}
+
+TEST(SPU2MixerTest, Gaussian)
+{
+	testMixVoiceLanes<5>();
+}
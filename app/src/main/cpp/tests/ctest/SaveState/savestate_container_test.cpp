@@ -0,0 +1,264 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "SaveState.h"
+#include "SaveStateContainer.h"
+#include "common/FileSystem.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <random>
+
+static constexpr u32 TEST_VERSION = 0x12345678;
+static constexpr u32 TEST_CHUNK_SIZE = 4096;
+
+struct TestSection
+{
+	const wchar_t* name;
+	std::vector<u8> data;
+};
+
+// One section which compresses well and one which doesn't, neither a multiple of the chunk size
+static std::vector<TestSection> makeSections()
+{
+	std::mt19937 rng(1);
+	std::vector<TestSection> sections(2);
+
+	sections[0].name = L"Compressible.bin";
+	sections[0].data.resize(TEST_CHUNK_SIZE * 5 + 123);
+	for (size_t i = 0; i < sections[0].data.size(); i++)
+		sections[0].data[i] = static_cast<u8>((i / 64) & 0x0f);
+
+	sections[1].name = L"Random.bin";
+	sections[1].data.resize(TEST_CHUNK_SIZE * 3 + 7);
+	for (u8& v : sections[1].data)
+		v = static_cast<u8>(rng());
+
+	return sections;
+}
+
+static std::unique_ptr<SaveStateSnapshot> createSnapshot(const std::vector<TestSection>& sections)
+{
+	ArchiveEntryList list(new ArchiveDataBuffer(L"SaveStateContainerTest"));
+	for (const TestSection& section : sections)
+	{
+		VmStateBuffer& buffer = *list.GetBuffer();
+		const int pos = buffer.GetSizeInBytes();
+		buffer.MakeRoomFor(pos + static_cast<int>(section.data.size()));
+		std::memcpy(buffer.GetPtr(pos), section.data.data(), section.data.size());
+		list.Add(ArchiveEntry(section.name).SetDataIndex(pos).SetDataSize(section.data.size()));
+	}
+
+	return SaveStateSnapshot::Create(list, TEST_VERSION, nullptr, SaveStateSnapshot::DEFAULT_COMPRESSION_LEVEL, TEST_CHUNK_SIZE);
+}
+
+static void expectSections(const std::vector<TestSection>& expected, const std::vector<std::vector<u8>>& actual)
+{
+	ASSERT_EQ(actual.size(), expected.size());
+	for (size_t i = 0; i < expected.size(); i++)
+		EXPECT_EQ(actual[i], expected[i].data) << "section " << i;
+}
+
+// Flips one bit of the byte at offset from the end of the file
+static void corruptFile(std::FILE* fp, s64 offset_from_end)
+{
+	ASSERT_EQ(FileSystem::FSeek64(fp, -offset_from_end, SEEK_END), 0);
+	const int value = std::fgetc(fp);
+	ASSERT_NE(value, EOF);
+	ASSERT_EQ(FileSystem::FSeek64(fp, -1, SEEK_CUR), 0);
+	ASSERT_NE(std::fputc(value ^ 0x10, fp), EOF);
+	ASSERT_EQ(std::fflush(fp), 0);
+	ASSERT_EQ(FileSystem::FSeek64(fp, 0, SEEK_SET), 0);
+}
+
+static std::vector<u8> readFile(std::FILE* fp)
+{
+	std::vector<u8> data;
+	EXPECT_EQ(FileSystem::FSeek64(fp, 0, SEEK_END), 0);
+	data.resize(static_cast<size_t>(FileSystem::FTell64(fp)));
+	EXPECT_EQ(FileSystem::FSeek64(fp, 0, SEEK_SET), 0);
+	EXPECT_EQ(std::fread(data.data(), 1, data.size(), fp), data.size());
+	EXPECT_EQ(FileSystem::FSeek64(fp, 0, SEEK_SET), 0);
+	return data;
+}
+
+static std::FILE* writeTempFile(const u8* data, size_t size)
+{
+	std::FILE* fp = std::tmpfile();
+	if (fp && (std::fwrite(data, 1, size, fp) != size || std::fflush(fp) != 0 || FileSystem::FSeek64(fp, 0, SEEK_SET) != 0))
+	{
+		std::fclose(fp);
+		return nullptr;
+	}
+	return fp;
+}
+
+TEST(SaveStateContainerTest, RoundTrip)
+{
+	const std::vector<TestSection> sections = makeSections();
+	std::unique_ptr<SaveStateSnapshot> snapshot = createSnapshot(sections);
+	ASSERT_TRUE(snapshot);
+	EXPECT_LT(snapshot->GetCompressedSize(), snapshot->GetUncompressedSize());
+
+	std::vector<std::vector<u8>> data;
+	ASSERT_TRUE(snapshot->Decompress(&data));
+	expectSections(sections, data);
+
+	std::FILE* fp = std::tmpfile();
+	ASSERT_TRUE(fp);
+	ASSERT_TRUE(snapshot->WriteToFile(fp));
+	ASSERT_EQ(FileSystem::FSeek64(fp, 0, SEEK_SET), 0);
+	ASSERT_TRUE(SaveStateSnapshot::IsSnapshotFile(fp));
+
+	std::unique_ptr<SaveStateSnapshot> loaded = SaveStateSnapshot::ReadFromFile(fp);
+	ASSERT_TRUE(loaded);
+	EXPECT_EQ(loaded->GetVersion(), TEST_VERSION);
+	ASSERT_TRUE(loaded->Decompress(&data));
+	expectSections(sections, data);
+
+	std::vector<u8> section;
+	ASSERT_EQ(FileSystem::FSeek64(fp, 0, SEEK_SET), 0);
+	ASSERT_TRUE(SaveStateSnapshot::ReadSectionFromFile(fp, "random.bin", &section));
+	EXPECT_EQ(section, sections[1].data);
+
+	std::fclose(fp);
+}
+
+TEST(SaveStateContainerTest, CorruptStoredChunk)
+{
+	const std::vector<TestSection> sections = makeSections();
+	std::unique_ptr<SaveStateSnapshot> snapshot = createSnapshot(sections);
+	ASSERT_TRUE(snapshot);
+	// Random data doesn't compress, so the last chunk in the file is stored as-is and
+	// decoding it can't fail by itself.
+	ASSERT_FALSE(snapshot->GetSections().back().chunks.back().compressed);
+
+	std::FILE* fp = std::tmpfile();
+	ASSERT_TRUE(fp);
+	ASSERT_TRUE(snapshot->WriteToFile(fp));
+	corruptFile(fp, 1);
+
+	std::unique_ptr<SaveStateSnapshot> loaded = SaveStateSnapshot::ReadFromFile(fp);
+	ASSERT_TRUE(loaded);
+	std::vector<std::vector<u8>> data;
+	EXPECT_FALSE(loaded->Decompress(&data));
+
+	std::vector<u8> section;
+	ASSERT_EQ(FileSystem::FSeek64(fp, 0, SEEK_SET), 0);
+	EXPECT_FALSE(SaveStateSnapshot::ReadSectionFromFile(fp, "Random.bin", &section));
+	ASSERT_EQ(FileSystem::FSeek64(fp, 0, SEEK_SET), 0);
+	EXPECT_TRUE(SaveStateSnapshot::ReadSectionFromFile(fp, "Compressible.bin", &section));
+
+	std::fclose(fp);
+}
+
+TEST(SaveStateContainerTest, CorruptCompressedChunk)
+{
+	std::vector<TestSection> sections = makeSections();
+	std::swap(sections[0], sections[1]);
+	std::unique_ptr<SaveStateSnapshot> snapshot = createSnapshot(sections);
+	ASSERT_TRUE(snapshot);
+	ASSERT_TRUE(snapshot->GetSections().back().chunks.back().compressed);
+
+	// Every byte of the last frame, whether zstd notices the damage or not. A few bits of a
+	// frame don't affect its output, those may load but must still give back the original data.
+	const s64 frame_size = static_cast<s64>(snapshot->GetSections().back().chunks.back().data->size());
+	s64 rejected = 0;
+	for (s64 offset = 1; offset <= frame_size; offset++)
+	{
+		std::FILE* fp = std::tmpfile();
+		ASSERT_TRUE(fp);
+		ASSERT_TRUE(snapshot->WriteToFile(fp));
+		corruptFile(fp, offset);
+
+		std::unique_ptr<SaveStateSnapshot> loaded = SaveStateSnapshot::ReadFromFile(fp);
+		ASSERT_TRUE(loaded);
+		std::vector<std::vector<u8>> data;
+		if (loaded->Decompress(&data))
+			expectSections(sections, data);
+		else
+			rejected++;
+
+		std::fclose(fp);
+	}
+	EXPECT_GT(rejected, frame_size / 2);
+}
+
+TEST(SaveStateContainerTest, TruncatedFile)
+{
+	const std::vector<TestSection> sections = makeSections();
+	std::unique_ptr<SaveStateSnapshot> snapshot = createSnapshot(sections);
+	ASSERT_TRUE(snapshot);
+
+	std::FILE* fp = std::tmpfile();
+	ASSERT_TRUE(fp);
+	ASSERT_TRUE(snapshot->WriteToFile(fp));
+	const std::vector<u8> file = readFile(fp);
+	std::fclose(fp);
+
+	// Every cut inside the header and tables, then a sample of the chunk data
+	for (size_t size = 0; size < file.size(); size += (size < 256) ? 1 : 97)
+	{
+		fp = writeTempFile(file.data(), size);
+		ASSERT_TRUE(fp);
+		EXPECT_FALSE(SaveStateSnapshot::ReadFromFile(fp)) << "size " << size;
+		std::fclose(fp);
+	}
+}
+
+TEST(SaveStateContainerTest, CorruptSectionHeader)
+{
+	const std::vector<TestSection> sections = makeSections();
+	std::unique_ptr<SaveStateSnapshot> snapshot = createSnapshot(sections);
+	ASSERT_TRUE(snapshot);
+
+	std::FILE* fp = std::tmpfile();
+	ASSERT_TRUE(fp);
+	ASSERT_TRUE(snapshot->WriteToFile(fp));
+	const std::vector<u8> file = readFile(fp);
+	std::fclose(fp);
+
+	// The first section's size and chunk count follow the 16 byte file header and its name
+	u32 name_length;
+	std::memcpy(&name_length, &file[16], sizeof(name_length));
+	const size_t size_offset = 16 + sizeof(u32) + name_length;
+	ASSERT_LT(size_offset + 8, file.size());
+
+	u32 section_size;
+	u32 chunk_count;
+	std::memcpy(&section_size, &file[size_offset], sizeof(section_size));
+	std::memcpy(&chunk_count, &file[size_offset + 4], sizeof(chunk_count));
+	ASSERT_EQ(section_size, sections[0].data.size());
+
+	const std::pair<u32, u32> corruptions[] = {
+		{0xFFFFFFFFu, 0xFFFFFFFFu},
+		{0xFFFFFFFFu, chunk_count},
+		{section_size, 0xFFFFFFFFu},
+		{section_size, 0},
+		{section_size, chunk_count + 1},
+		{section_size * 300, chunk_count * 300},
+	};
+	for (const auto& [size, count] : corruptions)
+	{
+		std::vector<u8> corrupt(file);
+		std::memcpy(&corrupt[size_offset], &size, sizeof(size));
+		std::memcpy(&corrupt[size_offset + 4], &count, sizeof(count));
+
+		fp = writeTempFile(corrupt.data(), corrupt.size());
+		ASSERT_TRUE(fp);
+		EXPECT_FALSE(SaveStateSnapshot::ReadFromFile(fp)) << "size " << size << " chunks " << count;
+		std::fclose(fp);
+	}
+}
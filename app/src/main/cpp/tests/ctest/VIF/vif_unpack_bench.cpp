@@ -0,0 +1,124 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Unpack throughput of every VIF unpack type, reference vs vectorised.
+// Usage: vif_unpack_bench [elements]
+
+#include "PrecompiledHeader.h"
+#include "Vif_UnpackKernels.h"
+#include "common/Timer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace VifUnpack;
+
+namespace
+{
+	template <class T>
+	using UnpackFn = void (*)(const VifUnpackContext&, u32*, const T*);
+
+	struct Packet
+	{
+		std::vector<u8> data;
+		u128 row;
+		u128 col;
+		u32 mask;
+	};
+
+	// VU1 data memory, the unpack target wraps around it like a real transfer does
+	alignas(16) u32 s_vu_mem[1024][4];
+} // namespace
+
+// Runs the elements of a synthetic packet through one kernel, cycling cl the way a 4/4 CYCLE setting does
+template <class T>
+static double run(UnpackFn<T> unpack, const Packet& packet, size_t count, size_t element_size)
+{
+	alignas(16) u128 row = packet.row;
+	VifUnpackContext ctx = {&row, &packet.col, packet.mask, 0};
+
+	Common::Timer timer;
+	const u8* src = packet.data.data();
+	for (size_t i = 0; i < count; ++i)
+	{
+		ctx.cl = static_cast<int>(i & 3);
+		unpack(ctx, s_vu_mem[i & 1023], reinterpret_cast<const T*>(src + i * element_size));
+	}
+	return static_cast<double>(count) / timer.GetTimeSeconds();
+}
+
+template <class T>
+static void bench(const char* name, UnpackFn<T> vector, UnpackFn<T> reference, const Packet& packet, size_t count, size_t element_size)
+{
+	// first pass warms the caches
+	run(reference, packet, count, element_size);
+	const double reference_rate = run(reference, packet, count, element_size);
+	const double vector_rate = run(vector, packet, count, element_size);
+	std::printf("%-14s %8.1f Mel/s reference %8.1f Mel/s vector  %5.2fx\n", name,
+		reference_rate / 1e6, vector_rate / 1e6, vector_rate / reference_rate);
+}
+
+template <uint mode, bool doMask>
+static void benchMode(const Packet& packet, size_t count)
+{
+	std::printf("mode %u, %s\n", mode, doMask ? "masked" : "unmasked");
+
+#define BENCH_UNPACK(name, vt, T, elements) \
+	bench<T>(name, UNPACK_##vt<mode, doMask, T>, UNPACK_##vt##_reference<mode, doMask, T>, packet, count, sizeof(T) * elements)
+
+	BENCH_UNPACK("S-u32", S, u32, 1);
+	BENCH_UNPACK("S-s16", S, s16, 1);
+	BENCH_UNPACK("S-u8", S, u8, 1);
+	BENCH_UNPACK("V2-u32", V2, u32, 2);
+	BENCH_UNPACK("V2-s16", V2, s16, 2);
+	BENCH_UNPACK("V2-u8", V2, u8, 2);
+	BENCH_UNPACK("V3-u32", V4, u32, 3);
+	BENCH_UNPACK("V4-u32", V4, u32, 4);
+	BENCH_UNPACK("V4-s16", V4, s16, 4);
+	BENCH_UNPACK("V4-u16", V4, u16, 4);
+	BENCH_UNPACK("V4-s8", V4, s8, 4);
+	BENCH_UNPACK("V4-u8", V4, u8, 4);
+	if (mode == 0)
+		bench<u32>("V4-5", UNPACK_V4_5<doMask>, UNPACK_V4_5_reference<doMask>, packet, count, sizeof(u16));
+
+#undef BENCH_UNPACK
+}
+
+int main(int argc, char** argv)
+{
+	const size_t count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+	std::mt19937 rng(0x41f);
+	Packet packet;
+	// room for the largest element, V4-32, plus the over-read of the last one
+	packet.data.resize(count * 16 + 16);
+	for (u8& v : packet.data)
+		v = static_cast<u8>(rng());
+	for (int i = 0; i < 4; ++i)
+	{
+		packet.row._u32[i] = rng();
+		packet.col._u32[i] = rng();
+	}
+	// mostly data, with the odd row/column/protected lane like a typical skinning mask
+	packet.mask = 0x00400100;
+
+	benchMode<0, false>(packet, count);
+	benchMode<1, false>(packet, count);
+	benchMode<0, true>(packet, count);
+	benchMode<2, true>(packet, count);
+	return 0;
+}
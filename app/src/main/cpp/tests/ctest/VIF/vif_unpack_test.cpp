@@ -0,0 +1,105 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "Vif_UnpackKernels.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <string.h>
+
+using namespace VifUnpack;
+
+static constexpr int ITERATIONS = 2048;
+
+template <class T>
+using UnpackFn = void (*)(const VifUnpackContext&, u32*, const T*);
+
+template <class T>
+static void checkUnpack(const char* name, uint mode, UnpackFn<T> vector, UnpackFn<T> reference, bool doMask)
+{
+	std::mt19937 rng(doMask ? 2 : 1);
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		alignas(16) u128 row[2], col;
+		alignas(16) u32 dest[2][4];
+		alignas(16) u8 src[16];
+
+		for (u32& v : row[0]._u32)
+			v = rng();
+		for (u32& v : col._u32)
+			v = rng();
+		for (u32& v : dest[0])
+			v = rng();
+		for (u8& v : src)
+			v = static_cast<u8>(rng());
+		row[1] = row[0];
+		memcpy(dest[1], dest[0], sizeof(dest[0]));
+
+		// an all-data mask takes a separate path, make sure it's hit often
+		const u32 mask = (doMask && (i & 3)) ? static_cast<u32>(rng()) : 0;
+		const int cl = i % 5;
+		const VifUnpackContext expected_ctx = {&row[0], &col, mask, cl};
+		const VifUnpackContext actual_ctx = {&row[1], &col, mask, cl};
+
+		reference(expected_ctx, dest[0], reinterpret_cast<const T*>(src));
+		vector(actual_ctx, dest[1], reinterpret_cast<const T*>(src));
+
+		ASSERT_EQ(0, memcmp(dest[0], dest[1], sizeof(dest[0]))) << name << " mode " << mode << " iteration " << i;
+		ASSERT_EQ(0, memcmp(&row[0], &row[1], sizeof(row[0]))) << name << " mode " << mode << " row, iteration " << i;
+	}
+}
+
+template <uint mode, bool doMask>
+static void checkMode()
+{
+#define CHECK_UNPACK(vt, T) \
+	checkUnpack<T>(#vt "-" #T, mode, UNPACK_##vt<mode, doMask, T>, UNPACK_##vt##_reference<mode, doMask, T>, doMask)
+
+	CHECK_UNPACK(S, u32);
+	CHECK_UNPACK(S, s16);
+	CHECK_UNPACK(S, u16);
+	CHECK_UNPACK(S, s8);
+	CHECK_UNPACK(S, u8);
+	CHECK_UNPACK(V2, u32);
+	CHECK_UNPACK(V2, s16);
+	CHECK_UNPACK(V2, u16);
+	CHECK_UNPACK(V2, s8);
+	CHECK_UNPACK(V2, u8);
+	CHECK_UNPACK(V4, u32);
+	CHECK_UNPACK(V4, s16);
+	CHECK_UNPACK(V4, u16);
+	CHECK_UNPACK(V4, s8);
+	CHECK_UNPACK(V4, u8);
+
+#undef CHECK_UNPACK
+}
+
+TEST(VifUnpackTest, Unmasked)
+{
+	checkMode<0, false>();
+	checkMode<1, false>();
+	checkMode<2, false>();
+	checkMode<3, false>();
+	checkUnpack<u32>("V4-5", 0, UNPACK_V4_5<false>, UNPACK_V4_5_reference<false>, false);
+}
+
+TEST(VifUnpackTest, Masked)
+{
+	checkMode<0, true>();
+	checkMode<1, true>();
+	checkMode<2, true>();
+	checkMode<3, true>();
+	checkUnpack<u32>("V4-5", 0, UNPACK_V4_5<true>, UNPACK_V4_5_reference<true>, true);
+}
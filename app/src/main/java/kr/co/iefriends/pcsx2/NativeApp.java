@@ -55,6 +55,9 @@ public class NativeApp {
 	public static native void renderGpu(int value);
 	public static native void renderPreloading(int value);
 
+	public static native boolean startCapture();
+	public static native void stopCapture();
+
 	public static native void onNativeSurfaceCreated();
 	public static native void onNativeSurfaceChanged(Surface surface, int w, int h);
 	public static native void onNativeSurfaceDestroyed();
@@ -67,6 +70,7 @@ public class NativeApp {
 
 	public static native boolean saveStateToSlot(int slot);
 	public static native boolean loadStateFromSlot(int slot);
+	public static native boolean rewind(int steps);
 	public static native String getGamePathSlot(int slot);
 	public static native byte[] getImageSlot(int slot);
 }